@@ -0,0 +1,122 @@
+// K 线聚合基准
+// 合成行情生成的成交流同时聚合 1 分钟时间 K 线、成交量 / 笔数 / 成交额 K 线，测每笔成交的聚合开销，
+// 并用逐笔保存的成交重新计算每根 K 线的 OHLCV 和 VWAP 进行核对。
+// 用法: bar_builder_bench [成交笔数]
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include <spdlog/spdlog.h>
+
+#include "bar_builder.h"
+#include "symbol_registry.h"
+#include "synthetic_feed_generator.h"
+
+using namespace crypto_quant;
+
+namespace {
+
+inline uint64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+bool near(double a, double b) {
+    return std::fabs(a - b) <= 1e-9 * std::fmax(1.0, std::fabs(b));
+}
+
+// 按成交序号区间 [begin, end) 重新计算 K 线并比较
+bool verify(const bar_t& bar, const std::vector<trade_t>& trades, size_t begin, size_t end) {
+    double high = trades[begin].price;
+    double low = trades[begin].price;
+    double volume = 0.0;
+    double quote_volume = 0.0;
+    double buy_volume = 0.0;
+    for (size_t i = begin; i < end; ++i) {
+        high = std::fmax(high, trades[i].price);
+        low = std::fmin(low, trades[i].price);
+        volume += trades[i].quantity;
+        quote_volume += trades[i].price * trades[i].quantity;
+        if (trades[i].is_buyer_maker == 0) {
+            buy_volume += trades[i].quantity;
+        }
+    }
+    return bar.trade_count == end - begin && bar.open == trades[begin].price && bar.close == trades[end - 1].price &&
+           bar.high == high && bar.low == low && near(bar.volume, volume) && near(bar.quote_volume, quote_volume) &&
+           near(bar.buy_volume, buy_volume) && near(bar.vwap, quote_volume / volume);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    size_t count = argc > 1 ? static_cast<size_t>(atol(argv[1])) : 2000000;
+    if (count == 0) {
+        count = 1;
+    }
+    spdlog::set_level(spdlog::level::err);
+
+    // 单个交易对的成交流，每个事件都伴随成交
+    symbol_t symbol = SymbolRegistry::instance().registerSymbol("BARBENCHUSDT");
+    SyntheticFeedConfig feed;
+    feed.event_rate = 200.0;
+    feed.trade_probability = 1.0;
+    SyntheticFeedGenerator generator(feed);
+    generator.setTime(1700000000000ULL * 1000000ULL);
+    generator.addSymbol(symbol);
+    std::vector<trade_t> trades;
+    trades.reserve(count);
+    while (trades.size() < count) {
+        generator.next();
+        if (generator.trade()) {
+            trades.push_back(*generator.trade());
+        }
+    }
+
+    const char* names[] = {"time 60s", "volume 50", "tick 100", "dollar 5M"};
+    BarBuilder builder;
+    builder.addSpec(BarSpec(BarType::TIME, 60000.0));
+    builder.addSpec(BarSpec(BarType::VOLUME, 50.0));
+    builder.addSpec(BarSpec(BarType::TICK, 100.0));
+    builder.addSpec(BarSpec(BarType::DOLLAR, 5000000.0));
+
+    // 收盘时记录该规格 K 线覆盖的成交区间，计时结束后核对
+    struct ClosedBar {
+        bar_t bar;
+        size_t begin;
+        size_t end;
+    };
+    std::vector<std::vector<ClosedBar> > closed(builder.specCount());
+    std::vector<size_t> open_begin(builder.specCount(), 0);
+    size_t position = 0;
+    builder.setBarCallback([&](const bar_t& bar) {
+        // 阈值 K 线在加入当前成交后收盘；时间 K 线在下一根的第一笔成交到来时收盘
+        size_t end = bar.type == BarType::TIME ? position : position + 1;
+        ClosedBar entry = {bar, open_begin[bar.spec], end};
+        closed[bar.spec].push_back(entry);
+        open_begin[bar.spec] = end;
+    });
+
+    uint64_t begin = nowNs();
+    for (position = 0; position < trades.size(); ++position) {
+        builder.onTrade(trades[position]);
+    }
+    uint64_t elapsed = nowNs() - begin;
+    position = trades.size();
+    builder.flush(trades.back().trade_time + 60000);
+
+    printf("bar builder %zu trades x %zu specs %8.1f ns/trade %12.0f trades/s\n", trades.size(),
+           builder.specCount(), static_cast<double>(elapsed) / trades.size(), trades.size() / (elapsed / 1e9));
+    for (size_t spec = 0; spec < closed.size(); ++spec) {
+        size_t mismatched = 0;
+        for (size_t i = 0; i < closed[spec].size(); ++i) {
+            const ClosedBar& entry = closed[spec][i];
+            if (entry.begin >= entry.end || !verify(entry.bar, trades, entry.begin, entry.end)) {
+                ++mismatched;
+            }
+        }
+        printf("  %-10s bars=%-8zu avg trades/bar %8.1f mismatched=%zu\n", names[spec], closed[spec].size(),
+               closed[spec].empty() ? 0.0 : static_cast<double>(trades.size()) / closed[spec].size(), mismatched);
+    }
+    return 0;
+}
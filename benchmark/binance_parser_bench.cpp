@@ -0,0 +1,241 @@
+// 币安行情消息解析基准
+// 对比专用解析器 BinanceMessageParser 与原 nlohmann::json DOM 路径（json::parse 后逐字段取值），
+// 消息为币安文档格式的 depth20 / depthUpdate / trade / aggTrade（原始流和组合流各一半），
+// 价格、数量取自真实 BTCUSDT 盘口的量级。同时统计每条消息的堆分配次数，并校验两条路径结果一致。
+// 用法: binance_parser_bench [每类消息的解析轮数]
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include <spdlog/spdlog.h>
+
+#include "binance_message_parser.h"
+#include "fixed_point.h"
+#include "symbol_registry.h"
+
+using namespace crypto_quant;
+using json = nlohmann::json;
+
+// 统计全局 operator new 调用次数（noinline 避免 GCC 内联后误报 new/free 不匹配）
+static size_t g_allocations = 0;
+// 防止计时循环被优化掉
+static volatile double g_sink = 0.0;
+
+__attribute__((noinline)) void* operator new(size_t size) {
+    ++g_allocations;
+    void* p = malloc(size ? size : 1);
+    if (!p) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+__attribute__((noinline)) void operator delete(void* p) noexcept {
+    free(p);
+}
+
+namespace {
+
+struct Sample {
+    const char* name;
+    std::vector<std::string> messages;
+};
+
+std::string decimal(int64_t value, int decimals) {
+    char buf[32];
+    formatDecimalFixed(value, decimals, buf);
+    return buf;
+}
+
+std::string levels(int64_t best, int direction, int count, uint32_t seed) {
+    std::string out = "[";
+    for (int i = 0; i < count; ++i) {
+        seed = seed * 1103515245u + 12345u;
+        if (i > 0) {
+            out += ",";
+        }
+        out += "[\"" + decimal(best + direction * i, 2) + "\",\"" +
+               decimal(static_cast<int64_t>(seed >> 12) % 300000, 5) + "\"]";
+    }
+    return out + "]";
+}
+
+std::string wrap(const std::string& stream, const std::string& payload, bool combined) {
+    return combined ? "{\"stream\":\"" + stream + "\",\"data\":" + payload + "}" : payload;
+}
+
+std::vector<Sample> makeSamples() {
+    std::vector<Sample> samples(4);
+    samples[0].name = "depth20";
+    samples[1].name = "depthUpdate";
+    samples[2].name = "trade";
+    samples[3].name = "aggTrade";
+    uint64_t update_id = 73000000000ULL;
+    uint64_t event_time = 1760000000000ULL;
+    for (int i = 0; i < 64; ++i) {
+        const bool combined = (i & 1) != 0;
+        int64_t best_bid = 6500000 + (i % 7) - 3;
+        samples[0].messages.push_back(wrap("btcusdt@depth20@100ms",
+            "{\"lastUpdateId\":" + std::to_string(update_id + i * 40) +
+            ",\"bids\":" + levels(best_bid, -1, 20, i) +
+            ",\"asks\":" + levels(best_bid + 1, 1, 20, i + 1000) + "}", combined));
+        // 增量深度每侧档位数在 1~30 之间变化
+        int bid_levels = 1 + (i * 7) % 30;
+        int ask_levels = 1 + (i * 11) % 30;
+        samples[1].messages.push_back(wrap("btcusdt@depth@100ms",
+            "{\"e\":\"depthUpdate\",\"E\":" + std::to_string(event_time + i * 100) +
+            ",\"s\":\"BTCUSDT\",\"U\":" + std::to_string(update_id + i * 40) +
+            ",\"u\":" + std::to_string(update_id + i * 40 + 39) +
+            ",\"b\":" + levels(best_bid, -1, bid_levels, i + 2000) +
+            ",\"a\":" + levels(best_bid + 1, 1, ask_levels, i + 3000) + "}", combined));
+        samples[2].messages.push_back(wrap("btcusdt@trade",
+            "{\"e\":\"trade\",\"E\":" + std::to_string(event_time + i) +
+            ",\"s\":\"BTCUSDT\",\"t\":" + std::to_string(5300000000ULL + i) +
+            ",\"p\":\"" + decimal(best_bid, 2) + "\",\"q\":\"" + decimal(100 + i * 37, 5) +
+            "\",\"T\":" + std::to_string(event_time + i - 1) +
+            ",\"m\":" + (i % 3 ? "true" : "false") + ",\"M\":true}", combined));
+        samples[3].messages.push_back(wrap("btcusdt@aggTrade",
+            "{\"e\":\"aggTrade\",\"E\":" + std::to_string(event_time + i) +
+            ",\"s\":\"BTCUSDT\",\"a\":" + std::to_string(3000000000ULL + i) +
+            ",\"p\":\"" + decimal(best_bid + 1, 2) + "\",\"q\":\"" + decimal(50 + i * 13, 5) +
+            "\",\"f\":" + std::to_string(5300000000ULL + i * 3) +
+            ",\"l\":" + std::to_string(5300000000ULL + i * 3 + 2) +
+            ",\"T\":" + std::to_string(event_time + i - 1) +
+            ",\"m\":" + (i % 2 ? "true" : "false") + ",\"M\":true}", combined));
+    }
+    return samples;
+}
+
+double decimalField(const json& value) {
+    const std::string& text = value.get_ref<const std::string&>();
+    double out = 0.0;
+    parseDecimalDouble(text.data(), text.data() + text.size(), out);
+    return out;
+}
+
+// 原 WebSocketClient 的 nlohmann 路径：构建 DOM 后逐字段取值，返回价格数量之和用于校验
+double parseWithJson(const std::string& message, std::vector<price_level_t>& bids,
+                     std::vector<price_level_t>& asks) {
+    json j = json::parse(message.data(), message.data() + message.size());
+    const bool combined = j.contains("stream") && j.contains("data");
+    const json& payload = combined ? j["data"] : j;
+    double sum = 0.0;
+    if (payload.contains("e") && (payload["e"] == "trade" || payload["e"] == "aggTrade")) {
+        return decimalField(payload["p"]) + decimalField(payload["q"]);
+    }
+    const char* keys[2] = {"bids", "asks"};
+    if (payload.contains("e") && payload["e"] == "depthUpdate") {
+        keys[0] = "b";
+        keys[1] = "a";
+    }
+    std::vector<price_level_t>* buffers[2] = {&bids, &asks};
+    for (int side = 0; side < 2; ++side) {
+        buffers[side]->clear();
+        for (const auto& entry : payload[keys[side]]) {
+            price_level_t level;
+            level.price = decimalField(entry[0]);
+            level.quantity = decimalField(entry[1]);
+            level.timestamp = 0;
+            buffers[side]->push_back(level);
+            sum += level.price + level.quantity;
+        }
+    }
+    return sum;
+}
+
+double parseWithParser(BinanceMessageParser& parser, const std::string& message) {
+    double sum = 0.0;
+    switch (parser.parse(message.data(), message.size())) {
+    case BinanceMessageType::DEPTH: {
+        const orderbook_t& book = parser.orderbook();
+        for (uint32_t i = 0; i < book.bid_count; ++i) {
+            sum += book.bids[i].price + book.bids[i].quantity;
+        }
+        for (uint32_t i = 0; i < book.ask_count; ++i) {
+            sum += book.asks[i].price + book.asks[i].quantity;
+        }
+        break;
+    }
+    case BinanceMessageType::DEPTH_UPDATE: {
+        const depth_diff_t& diff = parser.depthDiff();
+        for (uint32_t i = 0; i < diff.bid_count; ++i) {
+            sum += diff.bids[i].price + diff.bids[i].quantity;
+        }
+        for (uint32_t i = 0; i < diff.ask_count; ++i) {
+            sum += diff.asks[i].price + diff.asks[i].quantity;
+        }
+        break;
+    }
+    case BinanceMessageType::TRADE:
+    case BinanceMessageType::AGG_TRADE:
+        sum = parser.trade().price + parser.trade().quantity;
+        break;
+    default:
+        fprintf(stderr, "parse failed: %s\n", parser.error());
+        exit(1);
+    }
+    return sum;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    int rounds = argc > 1 ? atoi(argv[1]) : 2000;
+    if (rounds <= 0) {
+        rounds = 1;
+    }
+    spdlog::set_level(spdlog::level::warn);
+    SymbolRegistry::instance().registerSymbol("BTCUSDT");
+
+    std::vector<Sample> samples = makeSamples();
+    BinanceMessageParser parser;
+    std::vector<price_level_t> bids;
+    std::vector<price_level_t> asks;
+    bids.reserve(1000);
+    asks.reserve(1000);
+
+    printf("%-12s %8s %12s %12s %10s %12s %12s\n", "message", "bytes", "json ns", "parser ns", "speedup",
+           "json allocs", "parser allocs");
+    for (size_t s = 0; s < samples.size(); ++s) {
+        const std::vector<std::string>& messages = samples[s].messages;
+        size_t bytes = 0;
+        for (size_t m = 0; m < messages.size(); ++m) {
+            bytes += messages[m].size();
+            double expected = parseWithJson(messages[m], bids, asks);
+            double actual = parseWithParser(parser, messages[m]);
+            if (expected != actual) {
+                fprintf(stderr, "%s message %zu mismatch: %.10f vs %.10f\n", samples[s].name, m, expected, actual);
+                return 1;
+            }
+        }
+        const double count = static_cast<double>(rounds) * messages.size();
+
+        size_t allocations = g_allocations;
+        auto start = std::chrono::steady_clock::now();
+        for (int r = 0; r < rounds; ++r) {
+            for (size_t m = 0; m < messages.size(); ++m) {
+                g_sink += parseWithJson(messages[m], bids, asks);
+            }
+        }
+        double json_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / count;
+        double json_allocs = (g_allocations - allocations) / count;
+
+        allocations = g_allocations;
+        start = std::chrono::steady_clock::now();
+        for (int r = 0; r < rounds; ++r) {
+            for (size_t m = 0; m < messages.size(); ++m) {
+                g_sink += parseWithParser(parser, messages[m]);
+            }
+        }
+        double parser_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / count;
+        double parser_allocs = (g_allocations - allocations) / count;
+
+        printf("%-12s %8zu %12.1f %12.1f %9.1fx %12.1f %12.2f\n", samples[s].name, bytes / messages.size(),
+               json_ns, parser_ns, json_ns / parser_ns, json_allocs, parser_allocs);
+    }
+    return 0;
+}
@@ -0,0 +1,98 @@
+// 深度核函数基准
+// 对比标量 / SSE2 / AVX2 实现在20档 SoA 订单薄上的单次调用耗时，
+// 并与原 AoS 逐档遍历对比。用法: depth_kernels_bench [迭代次数]
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "depth_kernels.h"
+
+using namespace crypto_quant;
+
+namespace {
+
+const int kBooks = 64;
+
+void makeBooks(std::vector<orderbook_t>& books, std::vector<orderbook_soa_t>& soas) {
+    books.resize(kBooks);
+    soas.resize(kBooks);
+    for (int b = 0; b < kBooks; ++b) {
+        orderbook_t& orderbook = books[b];
+        memset(&orderbook, 0, sizeof(orderbook));
+        orderbook.bid_count = 20;
+        orderbook.ask_count = 20;
+        double mid = 50000.0 + b;
+        for (int i = 0; i < 20; ++i) {
+            orderbook.bids[i].price = mid - 0.5 - i;
+            orderbook.bids[i].quantity = 0.1 * (1 + (b + i) % 7);
+            orderbook.asks[i].price = mid + 0.5 + i;
+            orderbook.asks[i].quantity = 0.1 * (1 + (b * 3 + i) % 5);
+        }
+        orderbookToSoa(orderbook, soas[b]);
+    }
+}
+
+// 返回每次调用的纳秒数
+template <typename Fn>
+double timeIt(uint64_t iterations, Fn fn) {
+    double sink = 0.0;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < iterations; ++i) {
+        sink += fn(static_cast<int>(i % kBooks));
+    }
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+    if (sink == 42.0) {
+        printf(" ");
+    }
+    return std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+}
+
+double aosDepth(const orderbook_t& orderbook, int levels) {
+    double depth = 0.0;
+    for (int i = 0; i < levels; ++i) {
+        depth += orderbook.bids[i].quantity;
+    }
+    return depth;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    uint64_t iterations = argc > 1 ? strtoull(argv[1], nullptr, 10) : 20000000ULL;
+    if (iterations == 0) {
+        iterations = 20000000ULL;
+    }
+
+    std::vector<orderbook_t> books;
+    std::vector<orderbook_soa_t> soas;
+    makeBooks(books, soas);
+
+    printf("dispatch: %s\n", depthKernels().isa);
+    printf("aos depth(20):       %8.2f ns\n", timeIt(iterations, [&](int b) {
+        return aosDepth(books[b], 20);
+    }));
+
+    const DepthKernels* variants[] = {&scalarDepthKernels(), &sse2DepthKernels(), &avx2DepthKernels()};
+    printf("%-8s %12s %12s %12s %12s\n", "isa", "depth(20)", "within(bps)", "vwap(10)", "cost(2.0)");
+    for (const DepthKernels* kernels : variants) {
+        double depth = timeIt(iterations, [&](int b) {
+            return kernels->cumulativeQuantity(soas[b].bid_quantities, 20);
+        });
+        double within = timeIt(iterations, [&](int b) {
+            double mid = (soas[b].bid_prices[0] + soas[b].ask_prices[0]) / 2.0;
+            return kernels->quantityWithinPrice(soas[b].bid_prices, soas[b].bid_quantities, 20,
+                                                mid * (1.0 - 0.001), true);
+        });
+        double vwap = timeIt(iterations, [&](int b) {
+            return kernels->vwap(soas[b].ask_prices, soas[b].ask_quantities, 10);
+        });
+        double cost = timeIt(iterations, [&](int b) {
+            double filled = 0.0;
+            return kernels->costToFill(soas[b].ask_prices, soas[b].ask_quantities, 20, 2.0, &filled);
+        });
+        printf("%-8s %9.2f ns %9.2f ns %9.2f ns %9.2f ns\n", kernels->isa, depth, within, vwap, cost);
+    }
+    return 0;
+}
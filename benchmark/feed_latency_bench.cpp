@@ -0,0 +1,120 @@
+// 行情延迟直方图基准
+// 1. 单线程记录一个样本的耗时，以及多个线程同时记录同一直方图时的耗时（原子计数争用）
+// 2. 对数正态分布的样本与精确排序结果比较分位数误差（桶中点近似，相对误差应不超过 1/64）
+// 3. FeedLatencyMonitor 按（交易对，流）记录三段延迟的开销
+// 用法: feed_latency_bench [样本数]
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <thread>
+#include <vector>
+#include <spdlog/spdlog.h>
+
+#include "feed_latency_monitor.h"
+#include "symbol_registry.h"
+
+using namespace crypto_quant;
+
+namespace {
+
+inline uint64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+double recordThreads(LatencyHistogram& histogram, const std::vector<uint64_t>& samples, unsigned threads) {
+    histogram.reset();
+    std::vector<std::thread> workers;
+    uint64_t start = nowNs();
+    for (unsigned t = 0; t < threads; ++t) {
+        workers.push_back(std::thread([&histogram, &samples]() {
+            for (size_t i = 0; i < samples.size(); ++i) {
+                histogram.record(samples[i]);
+            }
+        }));
+    }
+    for (size_t t = 0; t < workers.size(); ++t) {
+        workers[t].join();
+    }
+    return static_cast<double>(nowNs() - start) / samples.size();
+}
+
+double relativeError(uint64_t approx, uint64_t exact) {
+    return exact == 0 ? 0.0 : std::fabs(static_cast<double>(approx) - exact) / exact;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    size_t count = argc > 1 ? static_cast<size_t>(atol(argv[1])) : 2000000;
+    if (count == 0) {
+        count = 1;
+    }
+    spdlog::set_level(spdlog::level::warn);
+
+    // 中位数约 50us、长尾到几十毫秒的延迟分布
+    std::mt19937_64 rng(42);
+    std::lognormal_distribution<double> distribution(std::log(50000.0), 1.2);
+    std::vector<uint64_t> samples(count);
+    for (size_t i = 0; i < count; ++i) {
+        samples[i] = static_cast<uint64_t>(distribution(rng));
+    }
+
+    LatencyHistogram* histogram = new LatencyHistogram();
+    printf("samples=%zu, buckets=%u (%zu KB per histogram)\n", count, LatencyHistogram::kBucketCount,
+           sizeof(LatencyHistogram) >> 10);
+    printf("%-28s %12.1f ns/record\n", "record, 1 thread", recordThreads(*histogram, samples, 1));
+    unsigned threads = std::max(2u, std::min(4u, std::thread::hardware_concurrency()));
+    char name[64];
+    snprintf(name, sizeof(name), "record, %u threads", threads);
+    printf("%-28s %12.1f ns/record (wall / samples per thread)\n", name, recordThreads(*histogram, samples, threads));
+
+    // 分位数精度
+    recordThreads(*histogram, samples, 1);
+    LatencySummary summary = histogram->summary();
+    std::vector<uint64_t> sorted(samples);
+    std::sort(sorted.begin(), sorted.end());
+    const double quantiles[4] = {0.5, 0.9, 0.99, 0.999};
+    const uint64_t approx[4] = {summary.p50, summary.p90, summary.p99, summary.p999};
+    const char* names[4] = {"p50", "p90", "p99", "p99.9"};
+    for (size_t i = 0; i < 4; ++i) {
+        size_t rank = static_cast<size_t>(std::ceil(quantiles[i] * count));
+        uint64_t exact = sorted[rank == 0 ? 0 : rank - 1];
+        printf("  %-6s exact=%10llu hist=%10llu error=%.4f\n", names[i],
+               static_cast<unsigned long long>(exact), static_cast<unsigned long long>(approx[i]),
+               relativeError(approx[i], exact));
+    }
+    printf("  min=%llu max=%llu (exact %llu / %llu)\n", static_cast<unsigned long long>(summary.min),
+           static_cast<unsigned long long>(summary.max), static_cast<unsigned long long>(sorted.front()),
+           static_cast<unsigned long long>(sorted.back()));
+    delete histogram;
+
+    // 监视器：8 个交易对的增量深度，每条消息记录三段
+    FeedLatencyMonitor monitor;
+    std::vector<symbol_t> symbols;
+    const char* symbol_names[8] = {"BTCUSDT", "ETHUSDT", "SOLUSDT", "BNBUSDT",
+                                   "XRPUSDT", "ADAUSDT", "DOGEUSDT", "AVAXUSDT"};
+    for (size_t i = 0; i < 8; ++i) {
+        symbols.push_back(SymbolRegistry::instance().registerSymbol(symbol_names[i]));
+    }
+    const uint64_t base_ns = 1700000000000ULL * 1000000;
+    uint64_t start = nowNs();
+    for (size_t i = 0; i < count; ++i) {
+        symbol_t symbol = symbols[i & 7];
+        uint64_t receive_ns = base_ns + i * 1000 + samples[i];
+        monitor.recordFeed(symbol, LatencyStream::DEPTH_DIFF, (base_ns + i * 1000) / 1000000,
+                           receive_ns, receive_ns + 2000);
+        monitor.recordCallback(symbol, LatencyStream::DEPTH_DIFF, receive_ns + 2000, receive_ns + 2000 + samples[i] / 10);
+    }
+    printf("%-28s %12.1f ns/message (3 stages)\n", "monitor, 8 symbols",
+           static_cast<double>(nowNs() - start) / count);
+    LatencySummary exchange;
+    if (monitor.getSummary(symbols[0], LatencyStream::DEPTH_DIFF, LatencyStage::EXCHANGE_TO_RECEIVE, exchange)) {
+        printf("  %s exchange->receive count=%llu p50=%.1fus p99=%.1fus\n", symbol_names[0],
+               static_cast<unsigned long long>(exchange.count), exchange.p50 / 1e3, exchange.p99 / 1e3);
+    }
+    return 0;
+}
@@ -0,0 +1,172 @@
+// 逐笔委托（L3）订单薄基准
+// 预先模拟一段逐笔事件流（在最优价附近挂单，随机撤单、改单、成交），
+// 分别测量单个 L3Orderbook 的事件吞吐，以及经 L3OrderbookManager 批量应用并把聚合订单薄
+// 发布到 OrderbookManager 的吞吐。用法: l3_orderbook_bench [事件数] [批大小]
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <vector>
+#include <spdlog/spdlog.h>
+
+#include "l3_orderbook.h"
+#include "l3_orderbook_manager.h"
+#include "orderbook_manager.h"
+
+using namespace crypto_quant;
+
+namespace {
+
+struct LiveOrder {
+    uint64_t order_id;
+    uint32_t side;
+    double price;
+    double quantity;
+};
+
+class Random {
+public:
+    explicit Random(uint64_t seed) : state_(seed) {}
+    uint32_t next() {
+        state_ ^= state_ << 13;
+        state_ ^= state_ >> 7;
+        state_ ^= state_ << 17;
+        return static_cast<uint32_t>(state_ >> 16);
+    }
+    // [0, n)
+    uint32_t below(uint32_t n) { return next() % n; }
+
+private:
+    uint64_t state_;
+};
+
+// 事件比例大致为 新增45%、撤单35%、改单10%、成交10%，挂单保持在约 target_live 笔
+std::vector<l3_event_t> makeEvents(size_t count, size_t target_live) {
+    std::vector<l3_event_t> events;
+    events.reserve(count);
+    std::vector<LiveOrder> live;
+    live.reserve(target_live * 2);
+    Random random(88172645463325252ULL);
+    uint64_t next_id = 1;
+    const double mid = 50000.0;
+
+    for (size_t i = 0; i < count; ++i) {
+        l3_event_t event;
+        memset(&event, 0, sizeof(event));
+        event.symbol = SYMBOL_BTC_USDT;
+        event.timestamp = 1000000 + i;
+        uint32_t roll = random.below(100);
+        if (live.size() < target_live / 2) {
+            roll = 0;
+        }
+
+        if (roll < 45 || live.empty()) {
+            LiveOrder order;
+            order.order_id = next_id++;
+            order.side = random.below(2) == 0 ? ORDER_SIDE_BUY : ORDER_SIDE_SELL;
+            // 价格集中在最优价附近的200个tick内
+            double offset = 0.01 * (1 + random.below(200));
+            order.price = order.side == ORDER_SIDE_BUY ? mid - offset : mid + offset;
+            order.quantity = 0.001 * (1 + random.below(1000));
+            live.push_back(order);
+            event.type = L3_EVENT_ADD;
+            event.order_id = order.order_id;
+            event.side = order.side;
+            event.price = order.price;
+            event.quantity = order.quantity;
+        } else {
+            size_t index = random.below(static_cast<uint32_t>(live.size()));
+            LiveOrder& order = live[index];
+            event.order_id = order.order_id;
+            event.price = order.price;
+            if (roll < 80) {
+                event.type = L3_EVENT_CANCEL;
+                live[index] = live.back();
+                live.pop_back();
+            } else if (roll < 90) {
+                event.type = L3_EVENT_MODIFY;
+                order.quantity *= 0.5;
+                event.quantity = order.quantity;
+            } else {
+                event.type = L3_EVENT_EXECUTE;
+                event.quantity = order.quantity;
+                live[index] = live.back();
+                live.pop_back();
+            }
+        }
+        events.push_back(event);
+    }
+    return events;
+}
+
+double seconds(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    size_t count = argc > 1 ? static_cast<size_t>(atol(argv[1])) : 5000000;
+    size_t batch = argc > 2 ? static_cast<size_t>(atol(argv[2])) : 64;
+    if (batch == 0) {
+        batch = 1;
+    }
+    spdlog::set_level(spdlog::level::warn);
+
+    std::vector<l3_event_t> events = makeEvents(count, 20000);
+    printf("events=%zu\n", events.size());
+
+    // 单个 L3 订单薄：第一遍预热对象池和哈希表，第二遍计时
+    {
+        L3Orderbook book(SYMBOL_BTC_USDT, 0.01);
+        for (size_t i = 0; i < events.size(); ++i) {
+            book.apply(events[i]);
+        }
+        book.clear();
+        size_t rejected = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < events.size(); ++i) {
+            rejected += book.apply(events[i]) ? 0 : 1;
+        }
+        double elapsed = seconds(start);
+        printf("L3Orderbook::apply: %.2f M events/s (%.1f ns/event), live orders=%zu, rejected=%zu\n",
+               events.size() / elapsed / 1e6, elapsed * 1e9 / events.size(),
+               book.orderCount(), rejected);
+
+        orderbook_t orderbook;
+        const int kDerive = 1000000;
+        start = std::chrono::steady_clock::now();
+        double sink = 0.0;
+        for (int i = 0; i < kDerive; ++i) {
+            book.toOrderbook(orderbook);
+            sink += orderbook.bids[0].price;
+        }
+        elapsed = seconds(start);
+        printf("L3Orderbook::toOrderbook: %.1f ns/call (best bid %.2f)\n",
+               elapsed * 1e9 / kDerive, sink / kDerive);
+    }
+
+    // 管理器批量应用并发布聚合订单薄
+    {
+        std::shared_ptr<OrderbookManager> target(new OrderbookManager());
+        // 模拟事件的时间戳不是本地时钟，关闭过期检查
+        OrderbookValidatorConfig validator_config;
+        validator_config.max_age_ms = 0;
+        target->setValidatorConfig(validator_config);
+        L3OrderbookManager manager(target);
+        manager.setTickSize(SYMBOL_BTC_USDT, 0.01);
+        auto start = std::chrono::steady_clock::now();
+        size_t applied = 0;
+        for (size_t i = 0; i < events.size(); i += batch) {
+            size_t n = events.size() - i < batch ? events.size() - i : batch;
+            applied += manager.applyBatch(&events[i], n);
+        }
+        double elapsed = seconds(start);
+        printf("L3OrderbookManager::applyBatch(batch=%zu) + L2 publish: %.2f M events/s, applied=%zu\n",
+               batch, events.size() / elapsed / 1e6, applied);
+        printf("L2 best bid/ask: %.2f / %.2f\n",
+               target->getBestBid(SYMBOL_BTC_USDT), target->getBestAsk(SYMBOL_BTC_USDT));
+    }
+    return 0;
+}
@@ -0,0 +1,117 @@
+// 行情分发队列基准
+// 生产者线程模拟网络线程按固定间隔发布订单薄，处理线程取出后记录交接延迟（发布到处理函数开始执行）。
+// 分别测试忙轮询、阻塞等待两种模式，以及处理函数变慢时 DROP_NEWEST / BLOCK 两种溢出策略下
+// 生产者单次 publish 的耗时、丢弃数和背压等待时间。
+// 用法: market_data_dispatcher_bench [事件数]
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+#include <spdlog/spdlog.h>
+
+#include "market_data_dispatcher.h"
+
+using namespace crypto_quant;
+
+namespace {
+
+inline uint64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void spinFor(uint64_t ns) {
+    uint64_t until = nowNs() + ns;
+    while (nowNs() < until) {
+        cpu_relax();
+    }
+}
+
+struct Result {
+    double publish_ns;
+    uint64_t p50_ns;
+    uint64_t p99_ns;
+    MarketDataDispatcherStats stats;
+};
+
+// interval_ns：生产者发布间隔；handler_ns：处理函数耗时
+Result run(const MarketDataDispatcherConfig& config, size_t events, uint64_t interval_ns, uint64_t handler_ns) {
+    std::vector<uint64_t> latencies;
+    latencies.reserve(events);
+    MarketDataDispatcher dispatcher(config);
+    dispatcher.setOrderbookHandler([&latencies, handler_ns](const orderbook_t& orderbook) {
+        latencies.push_back(nowNs() - orderbook.timestamp);
+        if (handler_ns > 0) {
+            spinFor(handler_ns);
+        }
+    });
+    dispatcher.start();
+
+    orderbook_t orderbook;
+    memset(&orderbook, 0, sizeof(orderbook));
+    orderbook.bid_count = 20;
+    orderbook.ask_count = 20;
+    uint64_t publish_total = 0;
+    for (size_t i = 0; i < events; ++i) {
+        if (interval_ns > 0) {
+            spinFor(interval_ns);
+        }
+        orderbook.last_update_id = i;
+        uint64_t start = nowNs();
+        orderbook.timestamp = start;
+        dispatcher.publish(orderbook);
+        publish_total += nowNs() - start;
+    }
+    dispatcher.stop();
+
+    Result result;
+    result.publish_ns = static_cast<double>(publish_total) / events;
+    result.stats = dispatcher.getStats();
+    std::sort(latencies.begin(), latencies.end());
+    result.p50_ns = latencies.empty() ? 0 : latencies[latencies.size() / 2];
+    result.p99_ns = latencies.empty() ? 0 : latencies[latencies.size() * 99 / 100];
+    return result;
+}
+
+void print(const char* name, const Result& result) {
+    printf("%-28s %10.1f %10llu %10llu %10llu %10llu %12.2f\n", name, result.publish_ns,
+           static_cast<unsigned long long>(result.p50_ns), static_cast<unsigned long long>(result.p99_ns),
+           static_cast<unsigned long long>(result.stats.dropped),
+           static_cast<unsigned long long>(result.stats.max_depth),
+           result.stats.backpressure_wait_ns / 1e6);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    size_t events = argc > 1 ? static_cast<size_t>(atol(argv[1])) : 200000;
+    if (events == 0) {
+        events = 1;
+    }
+    spdlog::set_level(spdlog::level::warn);
+    printf("events=%zu, hardware threads=%u\n", events, std::thread::hardware_concurrency());
+    printf("%-28s %10s %10s %10s %10s %10s %12s\n", "scenario", "publish ns", "p50 ns", "p99 ns",
+           "dropped", "max depth", "blocked ms");
+
+    MarketDataDispatcherConfig config;
+    // 忙轮询需要独占的CPU核，单核机器上与生产者争抢，只在多核上测试
+    if (std::thread::hardware_concurrency() > 1) {
+        config.wait_mode = DispatchWaitMode::BUSY_POLL;
+        print("busy_poll, 2us interval", run(config, events, 2000, 0));
+    }
+    config.wait_mode = DispatchWaitMode::BLOCKING;
+    print("blocking, 2us interval", run(config, events, 2000, 0));
+    print("blocking, burst", run(config, events, 0, 0));
+
+    // 处理函数比发布间隔慢：队列很快填满
+    config.capacity = 1024;
+    config.overflow_policy = DispatchOverflowPolicy::DROP_NEWEST;
+    print("slow consumer, drop", run(config, events / 10, 1000, 2000));
+    config.overflow_policy = DispatchOverflowPolicy::BLOCK;
+    print("slow consumer, block", run(config, events / 10, 1000, 2000));
+    return 0;
+}
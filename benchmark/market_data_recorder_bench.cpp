@@ -0,0 +1,194 @@
+// 行情录制基准
+// 模拟数百个交易对的全深度流：原始消息、20档订单薄、增量深度（每侧若干档）分别写入内存映射的段文件，
+// 统计每条记录的写入耗时（平均、p99、最大值，最大值包含切换段）、吞吐和切换段时的等待次数；
+// 并与每条消息一次 write(2) 追加到普通文件对比，最后用读取器顺序读回校验条数。
+// 用法: market_data_recorder_bench [记录数] [目录]
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <spdlog/spdlog.h>
+
+#include "market_data_recorder.h"
+#include "symbol_registry.h"
+
+using namespace crypto_quant;
+
+namespace {
+
+const size_t kSymbols = 300;
+const size_t kDiffLevels = 40;
+
+inline uint64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+struct Result {
+    double avg_ns;
+    uint64_t p99_ns;
+    uint64_t max_ns;
+    double mb_per_s;
+};
+
+Result summarize(std::vector<uint64_t>& samples, uint64_t total_ns, uint64_t bytes) {
+    Result result;
+    std::sort(samples.begin(), samples.end());
+    result.avg_ns = static_cast<double>(total_ns) / samples.size();
+    result.p99_ns = samples[samples.size() * 99 / 100];
+    result.max_ns = samples.back();
+    result.mb_per_s = bytes / 1048576.0 / (total_ns / 1e9);
+    return result;
+}
+
+void print(const char* name, const Result& result, uint64_t stalls) {
+    printf("%-26s %10.1f %10llu %12llu %10.1f %8llu\n", name, result.avg_ns,
+           static_cast<unsigned long long>(result.p99_ns), static_cast<unsigned long long>(result.max_ns),
+           result.mb_per_s, static_cast<unsigned long long>(stalls));
+}
+
+void removeRecordings(const std::string& directory) {
+    std::vector<std::string> files = MarketDataRecordReader::listSegments(directory, "bench");
+    for (size_t i = 0; i < files.size(); ++i) {
+        unlink(files[i].c_str());
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    size_t records = argc > 1 ? static_cast<size_t>(atol(argv[1])) : 300000;
+    std::string directory = argc > 2 ? argv[2] : "/tmp/crypto_quant_recorder_bench";
+    if (records == 0) {
+        records = 1;
+    }
+    spdlog::set_level(spdlog::level::warn);
+
+    std::vector<symbol_t> symbols;
+    for (size_t i = 0; i < kSymbols; ++i) {
+        char name[16];
+        snprintf(name, sizeof(name), "BENCH%zuUSDT", i);
+        symbols.push_back(SymbolRegistry::instance().registerSymbol(name));
+    }
+
+    // 典型的组合流增量深度消息长度
+    std::string raw = "{\"stream\":\"btcusdt@depth@100ms\",\"data\":{\"e\":\"depthUpdate\",\"E\":1700000000000,"
+                      "\"s\":\"BTCUSDT\",\"U\":100,\"u\":120,\"b\":[";
+    for (int i = 0; i < 12; ++i) {
+        raw += "[\"43000.01000000\",\"0.25000000\"],";
+    }
+    raw += "[\"43000.00000000\",\"1.00000000\"]],\"a\":[]}}";
+
+    orderbook_t orderbook;
+    memset(&orderbook, 0, sizeof(orderbook));
+    orderbook.bid_count = 20;
+    orderbook.ask_count = 20;
+    for (int i = 0; i < 20; ++i) {
+        orderbook.bids[i].price = 43000.0 - i * 0.01;
+        orderbook.bids[i].quantity = 1.0 + i;
+        orderbook.asks[i].price = 43000.01 + i * 0.01;
+        orderbook.asks[i].quantity = 1.0 + i;
+    }
+    std::vector<price_level_t> levels(kDiffLevels * 2, orderbook.bids[0]);
+    depth_diff_t diff;
+    memset(&diff, 0, sizeof(diff));
+    diff.bids = levels.data();
+    diff.bid_count = kDiffLevels;
+    diff.asks = levels.data() + kDiffLevels;
+    diff.ask_count = kDiffLevels;
+
+    MarketDataRecorderConfig config;
+    config.directory = directory;
+    config.prefix = "bench";
+    config.segment_size = 64 * 1024 * 1024;
+
+    printf("records=%zu per scenario, symbols=%zu, raw message=%zu bytes, directory=%s\n",
+           records, kSymbols, raw.size(), directory.c_str());
+    printf("%-26s %10s %10s %12s %10s %8s\n", "scenario", "avg ns", "p99 ns", "max ns", "MB/s", "stalls");
+
+    std::vector<uint64_t> samples(records);
+    uint64_t total_records = 0;
+    MarketDataRecorder recorder(config);
+    if (!recorder.open()) {
+        fprintf(stderr, "failed to open recorder in %s\n", directory.c_str());
+        return 1;
+    }
+
+    for (int scenario = 0; scenario < 3; ++scenario) {
+        MarketDataRecorderStats before = recorder.getStats();
+        uint64_t begin = nowNs();
+        for (size_t i = 0; i < records; ++i) {
+            uint64_t start = nowNs();
+            uint64_t timestamp = MarketDataRecorder::nowNs();
+            if (scenario == 0) {
+                recorder.recordRaw(raw.data(), raw.size(), timestamp);
+            } else if (scenario == 1) {
+                orderbook.symbol = symbols[i % kSymbols];
+                orderbook.last_update_id = i;
+                recorder.recordOrderbook(orderbook, timestamp);
+            } else {
+                diff.symbol = symbols[i % kSymbols];
+                diff.first_update_id = i;
+                diff.final_update_id = i;
+                recorder.recordDepthDiff(diff, timestamp);
+            }
+            samples[i] = nowNs() - start;
+        }
+        uint64_t total = nowNs() - begin;
+        MarketDataRecorderStats after = recorder.getStats();
+        static const char* const names[] = {"mmap raw", "mmap orderbook", "mmap depth diff (40x2)"};
+        print(names[scenario], summarize(samples, total, after.bytes - before.bytes),
+              after.rotation_stalls - before.rotation_stalls);
+        total_records += after.records - before.records;
+    }
+    recorder.close();
+
+    // 对照：每条原始消息一次 write(2)
+    {
+        std::string path = directory + "/bench-write-baseline.dat";
+        int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0644);
+        if (fd >= 0) {
+            uint64_t begin = nowNs();
+            for (size_t i = 0; i < records; ++i) {
+                uint64_t start = nowNs();
+                if (write(fd, raw.data(), raw.size()) < 0) {
+                    break;
+                }
+                samples[i] = nowNs() - start;
+            }
+            uint64_t total = nowNs() - begin;
+            print("write(2) raw", summarize(samples, total, records * raw.size()), 0);
+            ::close(fd);
+            unlink(path.c_str());
+        }
+    }
+
+    // 顺序读回
+    std::vector<std::string> segments = MarketDataRecordReader::listSegments(directory, "bench");
+    uint64_t read_records = 0;
+    uint64_t begin = nowNs();
+    MarketDataRecordReader reader;
+    MarketDataRecord record;
+    for (size_t i = 0; i < segments.size(); ++i) {
+        if (!reader.open(segments[i])) {
+            continue;
+        }
+        while (reader.next(record)) {
+            ++read_records;
+        }
+    }
+    uint64_t read_ns = nowNs() - begin;
+    printf("read back %llu / %llu records from %zu segments, %.1f ns/record\n",
+           static_cast<unsigned long long>(read_records), static_cast<unsigned long long>(total_records),
+           segments.size(), read_records ? static_cast<double>(read_ns) / read_records : 0.0);
+    reader.close();
+    removeRecordings(directory);
+    return read_records == total_records ? 0 : 1;
+}
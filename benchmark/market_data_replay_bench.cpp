@@ -0,0 +1,118 @@
+// 行情回放基准
+// 先录制一段合成的增量深度流（多个交易对，记录间隔固定），再用 ReplayMarketDataFetcher 回放：
+// 尽快回放测回调路径能达到的消息速率和相对录制时长的倍速；按倍速回放测实际倍速和最大落后时间。
+// 用法: market_data_replay_bench [记录数] [目录]
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include <spdlog/spdlog.h>
+
+#include "market_data_recorder.h"
+#include "replay_market_data_fetcher.h"
+#include "symbol_registry.h"
+
+using namespace crypto_quant;
+
+namespace {
+
+const size_t kSymbols = 100;
+const size_t kLevels = 10;
+// 录制中相邻记录的间隔（纳秒），即录制速率 2 万条/秒
+const uint64_t kIntervalNs = 50000;
+
+void run(const char* name, const std::string& directory, ReplaySpeedMode mode, double speed,
+         const std::vector<symbol_t>& symbols) {
+    ReplayConfig config;
+    config.directory = directory;
+    config.prefix = "replay";
+    config.mode = mode;
+    config.speed = speed;
+    ReplayMarketDataFetcher replay(config);
+    uint64_t levels = 0;
+    replay.setDepthDiffCallback([&levels](const depth_diff_t& diff) {
+        levels += diff.bid_count + diff.ask_count;
+    });
+    if (!replay.initialize()) {
+        return;
+    }
+    for (size_t i = 1; i < symbols.size(); ++i) {
+        replay.subscribe(symbols[i], 0);
+    }
+    replay.start(symbols[0]);
+    replay.waitUntilFinished(600000);
+    replay.stop();
+
+    ReplayStats stats = replay.getStats();
+    double seconds = stats.wall_time_ns / 1e9;
+    printf("%-22s %10llu %12.0f %10.1f %12.1f\n", name, static_cast<unsigned long long>(stats.depth_diffs),
+           seconds > 0 ? stats.depth_diffs / seconds : 0.0,
+           stats.wall_time_ns ? static_cast<double>(stats.replay_time_ns) / stats.wall_time_ns : 0.0,
+           stats.max_lag_ns / 1000.0);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    size_t records = argc > 1 ? static_cast<size_t>(atol(argv[1])) : 200000;
+    std::string directory = argc > 2 ? argv[2] : "/tmp/crypto_quant_replay_bench";
+    if (records == 0) {
+        records = 1;
+    }
+    spdlog::set_level(spdlog::level::warn);
+
+    std::vector<symbol_t> symbols;
+    for (size_t i = 0; i < kSymbols; ++i) {
+        char name[16];
+        snprintf(name, sizeof(name), "REPLAY%zuUSDT", i);
+        symbols.push_back(SymbolRegistry::instance().registerSymbol(name));
+    }
+
+    MarketDataRecorderConfig recorder_config;
+    recorder_config.directory = directory;
+    recorder_config.prefix = "replay";
+    recorder_config.segment_size = 64 * 1024 * 1024;
+    {
+        MarketDataRecorder recorder(recorder_config);
+        if (!recorder.open()) {
+            fprintf(stderr, "failed to open recorder in %s\n", directory.c_str());
+            return 1;
+        }
+        std::vector<price_level_t> levels(kLevels * 2);
+        for (size_t i = 0; i < levels.size(); ++i) {
+            levels[i].price = 100.0 + i * 0.01;
+            levels[i].quantity = 1.0;
+            levels[i].timestamp = 0;
+        }
+        depth_diff_t diff;
+        memset(&diff, 0, sizeof(diff));
+        diff.bids = levels.data();
+        diff.bid_count = kLevels;
+        diff.asks = levels.data() + kLevels;
+        diff.ask_count = kLevels;
+        uint64_t timestamp = MarketDataRecorder::nowNs();
+        for (size_t i = 0; i < records; ++i) {
+            diff.symbol = symbols[i % kSymbols];
+            diff.first_update_id = i + 1;
+            diff.final_update_id = i + 1;
+            recorder.recordDepthDiff(diff, timestamp + i * kIntervalNs);
+        }
+        recorder.close();
+    }
+
+    printf("records=%zu, symbols=%zu, recorded span=%.1f s\n", records, kSymbols, records * kIntervalNs / 1e9);
+    printf("%-22s %10s %12s %10s %12s\n", "mode", "diffs", "diffs/s", "speed x", "max lag us");
+    run("as fast as possible", directory, ReplaySpeedMode::AS_FAST_AS_POSSIBLE, 1.0, symbols);
+    run("scaled 100x", directory, ReplaySpeedMode::SCALED, 100.0, symbols);
+    run("scaled 10x", directory, ReplaySpeedMode::SCALED, 10.0, symbols);
+
+    std::vector<std::string> files = MarketDataRecordReader::listSegments(directory, "replay");
+    for (size_t i = 0; i < files.size(); ++i) {
+        unlink(files[i].c_str());
+    }
+    return 0;
+}
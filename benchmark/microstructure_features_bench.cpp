@@ -0,0 +1,100 @@
+// 微观结构特征引擎基准
+// 预先生成一段最优价随机游走的20档订单薄序列，测量每次增量更新特征的耗时，
+// 以及读者无锁读取特征的耗时。用法: microstructure_features_bench [更新次数]
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <spdlog/spdlog.h>
+
+#include "microstructure_features.h"
+
+using namespace crypto_quant;
+
+namespace {
+
+class Random {
+public:
+    explicit Random(uint64_t seed) : state_(seed) {}
+    uint32_t next() {
+        state_ ^= state_ << 13;
+        state_ ^= state_ >> 7;
+        state_ ^= state_ << 17;
+        return static_cast<uint32_t>(state_ >> 16);
+    }
+    uint32_t below(uint32_t n) { return next() % n; }
+
+private:
+    uint64_t state_;
+};
+
+std::vector<orderbook_t> makeBooks(size_t count) {
+    std::vector<orderbook_t> books(count);
+    Random random(88172645463325252ULL);
+    int64_t best_bid = 5000000;
+    for (size_t i = 0; i < count; ++i) {
+        orderbook_t& book = books[i];
+        memset(&book, 0, sizeof(book));
+        book.symbol = SYMBOL_BTC_USDT;
+        book.timestamp = 1000000 + i * 10;
+        book.last_update_id = i + 1;
+        // 最优价偶尔移动一个tick，价差1~3个tick
+        uint32_t roll = random.below(10);
+        if (roll == 0) {
+            --best_bid;
+        } else if (roll == 1) {
+            ++best_bid;
+        }
+        int64_t best_ask = best_bid + 1 + random.below(3);
+        book.bid_count = 20;
+        book.ask_count = 20;
+        for (int l = 0; l < 20; ++l) {
+            book.bids[l].price = (best_bid - l) / 100.0;
+            book.bids[l].quantity = 0.001 * (1 + random.below(1000));
+            book.asks[l].price = (best_ask + l) / 100.0;
+            book.asks[l].quantity = 0.001 * (1 + random.below(1000));
+        }
+    }
+    return books;
+}
+
+double seconds(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    size_t count = argc > 1 ? static_cast<size_t>(atol(argv[1])) : 2000000;
+    if (count == 0) {
+        count = 1;
+    }
+    spdlog::set_level(spdlog::level::warn);
+
+    std::vector<orderbook_t> books = makeBooks(count);
+    MicrostructureFeatureEngine engine;
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < books.size(); ++i) {
+        engine.update(books[i]);
+    }
+    double elapsed = seconds(start);
+    printf("update: %.1f ns/update (%.2f M updates/s)\n",
+           elapsed * 1e9 / books.size(), books.size() / elapsed / 1e6);
+
+    microstructure_features_t features;
+    const size_t kReads = 10000000;
+    double sink = 0.0;
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < kReads; ++i) {
+        engine.getFeatures(SYMBOL_BTC_USDT, features);
+        sink += features.microprice;
+    }
+    elapsed = seconds(start);
+    printf("getFeatures: %.1f ns/read (microprice %.2f)\n", elapsed * 1e9 / kReads, sink / kReads);
+    printf("last: ofi_flow=%.3f imbalance_l1=%.3f imbalance_multi=%.3f depletion bid/ask=%.3f/%.3f regime=%u\n",
+           features.ofi_flow, features.imbalance_l1, features.imbalance_multi,
+           features.bid_depletion_rate, features.ask_depletion_rate, features.spread_regime);
+    return 0;
+}
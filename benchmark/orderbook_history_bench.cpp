@@ -0,0 +1,189 @@
+// 订单薄历史环基准
+// 按四种变化模式（合成行情、盘口少量变化、部分档位变化、整盘变化）记录 2N 条订单薄，统计记录耗时、
+// 每条占用的内存和平均差分档位数，再用 getAt 逐条查询并与写入时的订单薄逐档比较：
+// 所有可查询的记录都必须完整重建，变化在差分预算内的模式（合成行情、盘口）须保留最近 N 条。
+// 用法: orderbook_history_bench [记录数]
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+#include <spdlog/spdlog.h>
+
+#include "orderbook_history.h"
+#include "orderbook_manager.h"
+#include "synthetic_feed_generator.h"
+
+using namespace crypto_quant;
+
+namespace {
+
+inline uint64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+enum ChurnMode {
+    CHURN_SYNTHETIC = 0,  // 合成行情生成器的订单薄序列
+    CHURN_TOP,       // 每次改动买一卖一附近的1~2档数量
+    CHURN_PARTIAL,   // 每次改动约一半档位的数量
+    CHURN_FULL       // 每次整盘换价（所有档位删除再新增）
+};
+
+const char* modeName(ChurnMode mode) {
+    switch (mode) {
+    case CHURN_SYNTHETIC:
+        return "synthetic";
+    case CHURN_TOP:
+        return "top-of-book";
+    case CHURN_PARTIAL:
+        return "partial";
+    default:
+        return "full-book";
+    }
+}
+
+// 生成 count 条按模式变化的订单薄
+std::vector<orderbook_t> makeBooks(ChurnMode mode, size_t count) {
+    std::vector<orderbook_t> books(count);
+    if (mode == CHURN_SYNTHETIC) {
+        // 合成增量经订单薄管理器合并，档位时间戳只在该档变化时更新，与实盘写入历史的订单薄一致
+        SyntheticFeedGenerator generator;
+        generator.addSymbol(SYMBOL_BTC_USDT);
+        OrderbookManager manager;
+        OrderbookValidatorConfig validator_config;
+        validator_config.max_age_ms = 0;
+        manager.setValidatorConfig(validator_config);
+        orderbook_t initial;
+        generator.fillOrderbook(SYMBOL_BTC_USDT, initial);
+        manager.updateOrderbook(initial);
+        uint64_t time_ns = generator.now();
+        for (size_t n = 0; n < count; ++n) {
+            time_ns += 1000000;
+            manager.applyDepthDiff(generator.step(SYMBOL_BTC_USDT, time_ns));
+            books[n] = manager.getOrderbook(SYMBOL_BTC_USDT);
+            books[n].timestamp = 1000 + n;
+        }
+        return books;
+    }
+    std::mt19937_64 rng(7);
+    std::uniform_real_distribution<double> quantity(0.1, 10.0);
+    orderbook_t book;
+    memset(&book, 0, sizeof(book));
+    book.bid_count = ORDERBOOK_MAX_LEVELS;
+    book.ask_count = ORDERBOOK_MAX_LEVELS;
+    double mid = 50000.0;
+    for (size_t n = 0; n < count; ++n) {
+        if (n == 0 || mode == CHURN_FULL) {
+            // 整盘换价：新价格与上一份完全不重叠
+            mid += n == 0 ? 0.0 : 100.0;
+            for (uint32_t i = 0; i < ORDERBOOK_MAX_LEVELS; ++i) {
+                book.bids[i].price = mid - 0.5 - i;
+                book.bids[i].quantity = quantity(rng);
+                book.asks[i].price = mid + 0.5 + i;
+                book.asks[i].quantity = quantity(rng);
+            }
+        } else {
+            uint32_t changed = mode == CHURN_TOP ? 2 : ORDERBOOK_MAX_LEVELS / 2;
+            for (uint32_t i = 0; i < changed; ++i) {
+                uint32_t level = mode == CHURN_TOP ? 0 : static_cast<uint32_t>(rng() % ORDERBOOK_MAX_LEVELS);
+                if (i % 2 == 0) {
+                    book.bids[level].quantity = quantity(rng);
+                } else {
+                    book.asks[level].quantity = quantity(rng);
+                }
+            }
+        }
+        book.timestamp = 1000 + n;
+        book.last_update_id = n + 1;
+        books[n] = book;
+    }
+    return books;
+}
+
+bool sameBook(const orderbook_t& a, const orderbook_t& b) {
+    if (a.bid_count != b.bid_count || a.ask_count != b.ask_count ||
+        a.timestamp != b.timestamp || a.last_update_id != b.last_update_id) {
+        return false;
+    }
+    for (uint32_t i = 0; i < a.bid_count; ++i) {
+        if (a.bids[i].price != b.bids[i].price || a.bids[i].quantity != b.bids[i].quantity) {
+            return false;
+        }
+    }
+    for (uint32_t i = 0; i < a.ask_count; ++i) {
+        if (a.asks[i].price != b.asks[i].price || a.asks[i].quantity != b.asks[i].quantity) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// 返回失败数：重建不一致的记录，以及预算内的模式未保留最近 capacity 条
+size_t runMode(ChurnMode mode, size_t capacity) {
+    // 多写一倍，环已经绕过一圈
+    std::vector<orderbook_t> books = makeBooks(mode, capacity * 2);
+    OrderbookHistory history(capacity);
+
+    uint64_t start = nowNs();
+    for (size_t n = 0; n < books.size(); ++n) {
+        history.record(books[n]);
+    }
+    double record_ns = static_cast<double>(nowNs() - start) / books.size();
+
+    size_t retained = history.size();
+    size_t failed = 0;
+    orderbook_t rebuilt;
+    start = nowNs();
+    for (size_t n = books.size() - retained; n < books.size(); ++n) {
+        if (!history.getAt(books[n].timestamp, rebuilt) || !sameBook(rebuilt, books[n])) {
+            ++failed;
+        }
+    }
+    double query_ns = retained > 0 ? static_cast<double>(nowNs() - start) / retained : 0.0;
+
+    // 遍历与 getAt 结果一致
+    size_t visited = 0;
+    size_t index = books.size() - retained;
+    history.forEachInRange(0, UINT64_MAX, [&](const orderbook_t& orderbook) {
+        if (index >= books.size() || !sameBook(orderbook, books[index])) {
+            ++failed;
+        }
+        ++index;
+        ++visited;
+        return true;
+    });
+    if (visited != retained) {
+        ++failed;
+    }
+
+    bool within_budget = mode == CHURN_SYNTHETIC || mode == CHURN_TOP;
+    if (within_budget && retained < capacity) {
+        ++failed;
+    }
+    printf("%-12s records=%zu retained=%zu bytes/record=%6.1f avg_delta=%4.1f record=%7.1f ns "
+           "getAt=%8.1f ns%s\n",
+           modeName(mode), books.size(), retained,
+           static_cast<double>(history.memoryBytes()) / capacity, history.averageDeltaLevels(),
+           record_ns, query_ns, failed == 0 ? "" : "  MISMATCH");
+    return failed;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    size_t capacity = argc > 1 ? static_cast<size_t>(atol(argv[1])) : 10000;
+    if (capacity == 0) {
+        capacity = 1;
+    }
+    spdlog::set_level(spdlog::level::warn);
+
+    printf("plain orderbook_t ring: %zu bytes/record\n", sizeof(orderbook_t));
+    size_t failed = 0;
+    failed += runMode(CHURN_SYNTHETIC, capacity);
+    failed += runMode(CHURN_TOP, capacity);
+    failed += runMode(CHURN_PARTIAL, capacity);
+    failed += runMode(CHURN_FULL, capacity);
+    return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,120 @@
+// 订单薄读写吞吐基准
+// 一个写线程持续更新所有交易对的订单薄，N个读线程轮询各类查询接口，
+// 分别统计读、写吞吐。用法: orderbook_read_bench [每轮秒数]
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+#include <spdlog/spdlog.h>
+
+#include "orderbook_manager.h"
+
+using namespace crypto_quant;
+
+namespace {
+
+const int kSymbols = 3;
+// 跨轮次递增的写入时间戳
+uint64_t g_next_timestamp = 0;
+
+orderbook_t makeOrderbook(symbol_t symbol, uint64_t seq) {
+    orderbook_t orderbook;
+    memset(&orderbook, 0, sizeof(orderbook));
+    orderbook.symbol = symbol;
+    orderbook.timestamp = seq;
+    orderbook.bid_count = 20;
+    orderbook.ask_count = 20;
+    double mid = 50000.0 + static_cast<double>(seq % 100);
+    for (int i = 0; i < 20; ++i) {
+        orderbook.bids[i].price = mid - 0.5 - i;
+        orderbook.bids[i].quantity = 1.0 + i;
+        orderbook.asks[i].price = mid + 0.5 + i;
+        orderbook.asks[i].quantity = 1.0 + i;
+    }
+    return orderbook;
+}
+
+void runRound(OrderbookManager& manager, int reader_count, double seconds) {
+    std::atomic<bool> running(true);
+    std::atomic<uint64_t> writes(0);
+    std::vector<uint64_t> reads(reader_count, 0);
+
+    // 预先生成订单薄，避免把构造开销计入写吞吐
+    std::vector<orderbook_t> books;
+    for (uint64_t i = 0; i < 256; ++i) {
+        books.push_back(makeOrderbook(static_cast<symbol_t>(i % kSymbols), i));
+    }
+
+    std::thread writer([&]() {
+        uint64_t count = 0;
+        while (running.load(std::memory_order_relaxed)) {
+            // 循环复用订单薄时保持时间戳递增，避免被判为时间戳回退
+            orderbook_t& orderbook = books[count & 255];
+            orderbook.timestamp = ++g_next_timestamp;
+            manager.updateOrderbook(orderbook);
+            ++count;
+        }
+        writes.store(count);
+    });
+
+    std::vector<std::thread> readers;
+    for (int r = 0; r < reader_count; ++r) {
+        readers.push_back(std::thread([&, r]() {
+            uint64_t count = 0;
+            double sink = 0.0;
+            while (running.load(std::memory_order_relaxed)) {
+                symbol_t symbol = static_cast<symbol_t>(count % kSymbols);
+                sink += manager.getBestBid(symbol);
+                sink += manager.getBestAsk(symbol);
+                sink += manager.getMidPrice(symbol);
+                sink += manager.getSpread(symbol);
+                sink += manager.getBidDepth(symbol, 5);
+                count += 5;
+            }
+            reads[r] = count;
+            if (sink == 42.0) {
+                printf(" ");
+            }
+        }));
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(static_cast<int>(seconds * 1000)));
+    running.store(false);
+    writer.join();
+    uint64_t total_reads = 0;
+    for (int r = 0; r < reader_count; ++r) {
+        readers[r].join();
+        total_reads += reads[r];
+    }
+
+    printf("%8d %16.0f %16.0f %18.0f\n", reader_count,
+           writes.load() / seconds, total_reads / seconds,
+           total_reads / seconds / reader_count);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    double seconds = argc > 1 ? atof(argv[1]) : 1.0;
+    if (seconds <= 0) {
+        seconds = 1.0;
+    }
+    spdlog::set_level(spdlog::level::warn);
+
+    OrderbookManager manager;
+    manager.initialize();
+    // 写线程用序号作时间戳，关闭过期检查
+    OrderbookValidatorConfig validator_config;
+    validator_config.max_age_ms = 0;
+    manager.setValidatorConfig(validator_config);
+
+    printf("%8s %16s %16s %18s\n", "readers", "writes/s", "reads/s", "reads/s/thread");
+    const int reader_counts[] = {1, 4, 16};
+    for (int readers : reader_counts) {
+        runRound(manager, readers, seconds);
+    }
+    return 0;
+}
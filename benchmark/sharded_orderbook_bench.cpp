@@ -0,0 +1,183 @@
+// 分片订单薄管理器写吞吐基准
+// 注册1000个交易对，预先生成每个交易对连续的增量深度事件，
+// 分别用单个 OrderbookManager（调用线程直接写入）和不同分片数的 ShardedOrderbookManager 回放，
+// 统计处理完全部事件的吞吐。每个交易对只由一个生产者线程回放，保证同一交易对的事件有序。
+// 用法: sharded_orderbook_bench [每个交易对的事件数]
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+#include <spdlog/spdlog.h>
+
+#include "orderbook_manager.h"
+#include "sharded_orderbook_manager.h"
+#include "symbol_registry.h"
+
+using namespace crypto_quant;
+
+namespace {
+
+const size_t kSymbolCount = 1000;
+const uint32_t kLevelsPerSide = 4;
+
+// 单个事件及其档位（档位放在事件自身，回放时不分配）
+struct ReplayEvent {
+    depth_diff_t diff;
+    price_level_t bids[kLevelsPerSide];
+    price_level_t asks[kLevelsPerSide];
+};
+
+// 合成数据的时间戳不是本地时钟，关闭过期检查
+OrderbookValidatorConfig syntheticValidatorConfig() {
+    OrderbookValidatorConfig config;
+    config.max_age_ms = 0;
+    return config;
+}
+
+orderbook_t makeSnapshot(symbol_t symbol) {
+    orderbook_t orderbook;
+    memset(&orderbook, 0, sizeof(orderbook));
+    orderbook.symbol = symbol;
+    orderbook.bid_count = 20;
+    orderbook.ask_count = 20;
+    orderbook.last_update_id = 1;
+    double mid = 100.0 + static_cast<double>(symbol);
+    for (int i = 0; i < 20; ++i) {
+        orderbook.bids[i].price = mid - 0.01 * (i + 1);
+        orderbook.bids[i].quantity = 1.0 + i;
+        orderbook.asks[i].price = mid + 0.01 * (i + 1);
+        orderbook.asks[i].quantity = 1.0 + i;
+    }
+    return orderbook;
+}
+
+// 事件按轮次交错排列：第 r 轮依次包含每个交易对的第 r 个事件
+std::vector<ReplayEvent> makeEvents(const std::vector<symbol_t>& symbols, size_t per_symbol) {
+    std::vector<ReplayEvent> events(symbols.size() * per_symbol);
+    uint32_t seed = 12345;
+    for (size_t r = 0; r < per_symbol; ++r) {
+        for (size_t s = 0; s < symbols.size(); ++s) {
+            ReplayEvent& event = events[r * symbols.size() + s];
+            memset(&event, 0, sizeof(event));
+            double mid = 100.0 + static_cast<double>(symbols[s]);
+            for (uint32_t i = 0; i < kLevelsPerSide; ++i) {
+                seed = seed * 1103515245u + 12345u;
+                uint32_t offset = (seed >> 16) % 20;
+                event.bids[i].price = mid - 0.01 * (offset + 1);
+                event.bids[i].quantity = (seed % 7 == 0) ? 0.0 : 1.0 + (seed >> 8) % 10;
+                event.asks[i].price = mid + 0.01 * (offset + 1);
+                event.asks[i].quantity = (seed % 5 == 0) ? 0.0 : 1.0 + (seed >> 4) % 10;
+            }
+            event.diff.symbol = symbols[s];
+            event.diff.first_update_id = 2 + r;
+            event.diff.final_update_id = 2 + r;
+            event.diff.event_time = r;
+            event.diff.bid_count = kLevelsPerSide;
+            event.diff.ask_count = kLevelsPerSide;
+        }
+    }
+    return events;
+}
+
+inline void replay(IOrderbookManager& manager, ReplayEvent& event) {
+    event.diff.bids = event.bids;
+    event.diff.asks = event.asks;
+    manager.applyDepthDiff(event.diff);
+}
+
+double runDirect(std::vector<ReplayEvent>& events, const std::vector<symbol_t>& symbols) {
+    OrderbookManager manager;
+    manager.setValidatorConfig(syntheticValidatorConfig());
+    for (size_t s = 0; s < symbols.size(); ++s) {
+        manager.updateOrderbook(makeSnapshot(symbols[s]));
+    }
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < events.size(); ++i) {
+        replay(manager, events[i]);
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return events.size() / seconds;
+}
+
+double runSharded(std::vector<ReplayEvent>& events, const std::vector<symbol_t>& symbols,
+                  size_t shard_count, size_t producer_count) {
+    ShardedOrderbookConfig config;
+    config.shard_count = shard_count;
+    config.idle_sleep_us = 0;
+    ShardedOrderbookManager manager(config);
+    manager.setValidatorConfig(syntheticValidatorConfig());
+    for (size_t s = 0; s < symbols.size(); ++s) {
+        manager.updateOrderbook(makeSnapshot(symbols[s]));
+    }
+    manager.flush();
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> producers;
+    for (size_t p = 0; p < producer_count; ++p) {
+        producers.push_back(std::thread([&, p]() {
+            // 生产者 p 负责 symbol 下标 % producer_count == p 的交易对
+            for (size_t i = p; i < events.size(); i += producer_count) {
+                replay(manager, events[i]);
+            }
+        }));
+    }
+    for (size_t p = 0; p < producers.size(); ++p) {
+        producers[p].join();
+    }
+    manager.flush();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    uint64_t applied = 0;
+    uint64_t queue_full = 0;
+    for (size_t i = 0; i < manager.shardCount(); ++i) {
+        ShardStats stats = manager.getShardStats(i);
+        applied += stats.diffs_applied;
+        queue_full += stats.queue_full;
+    }
+    if (applied != events.size()) {
+        printf("  warning: applied %llu of %zu events\n",
+               static_cast<unsigned long long>(applied), events.size());
+    }
+    printf("  queue full waits: %llu\n", static_cast<unsigned long long>(queue_full));
+    return events.size() / seconds;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    size_t per_symbol = argc > 1 ? static_cast<size_t>(atoi(argv[1])) : 200;
+    spdlog::set_level(spdlog::level::warn);
+
+    std::vector<symbol_t> symbols;
+    for (size_t i = 0; i < kSymbolCount; ++i) {
+        char name[32];
+        snprintf(name, sizeof(name), "BENCH%04zuUSDT", i);
+        symbol_t symbol = SymbolRegistry::instance().registerSymbol(name);
+        if (symbol == SYMBOL_INVALID) {
+            printf("failed to register %s\n", name);
+            return 1;
+        }
+        symbols.push_back(symbol);
+    }
+    // 交错排列下，事件下标 % 交易对数 即交易对下标；生产者数需整除交易对数才能保证同一交易对只有一个生产者
+    std::vector<ReplayEvent> events = makeEvents(symbols, per_symbol);
+    unsigned int cores = std::thread::hardware_concurrency();
+    printf("symbols=%zu events=%zu cores=%u\n", symbols.size(), events.size(), cores);
+
+    printf("direct OrderbookManager: %.2f M updates/s\n", runDirect(events, symbols) / 1e6);
+    const size_t shard_counts[] = {1, 2, 4, 8};
+    for (size_t i = 0; i < sizeof(shard_counts) / sizeof(shard_counts[0]); ++i) {
+        size_t shards = shard_counts[i];
+        if (shards > 1 && shards > cores) {
+            break;
+        }
+        size_t producers = shards;
+        printf("sharded shards=%zu producers=%zu:\n", shards, producers);
+        double rate = runSharded(events, symbols, shards, producers);
+        printf("  %.2f M updates/s\n", rate / 1e6);
+    }
+    return 0;
+}
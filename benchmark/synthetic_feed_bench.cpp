@@ -0,0 +1,167 @@
+// 合成行情基准
+// 1. 生成器本身：不同交易对数量下每秒能生成的增量深度事件数；
+// 2. 合成行情源尽快生成并交给订单薄管理器应用增量（解析之后的整条处理路径），最后核对订单薄与生成器一致；
+// 3. 按墙钟节奏以给定事件速率推送，测实际达到的速率。
+// 用法: synthetic_feed_bench [事件数] [实时速率（次/秒）]
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+#include <spdlog/spdlog.h>
+
+#include "orderbook_manager.h"
+#include "symbol_registry.h"
+#include "synthetic_feed_generator.h"
+#include "synthetic_market_data_fetcher.h"
+
+using namespace crypto_quant;
+
+namespace {
+
+inline uint64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+std::vector<symbol_t> makeSymbols(size_t count) {
+    std::vector<symbol_t> symbols;
+    for (size_t i = 0; i < count; ++i) {
+        char name[24];
+        snprintf(name, sizeof(name), "SYNTH%zuUSDT", i);
+        symbols.push_back(SymbolRegistry::instance().registerSymbol(name));
+    }
+    return symbols;
+}
+
+void benchGenerator(size_t symbol_count, size_t events) {
+    SyntheticFeedGenerator generator;
+    std::vector<symbol_t> symbols = makeSymbols(symbol_count);
+    for (size_t i = 0; i < symbols.size(); ++i) {
+        generator.addSymbol(symbols[i]);
+    }
+    uint64_t levels = 0;
+    uint64_t begin = nowNs();
+    for (size_t i = 0; i < events; ++i) {
+        const depth_diff_t* diff = generator.next();
+        levels += diff->bid_count + diff->ask_count;
+    }
+    uint64_t elapsed = nowNs() - begin;
+    printf("generator %-5zu symbols %10.1f ns/event %12.0f events/s %6.2f levels/event\n", symbol_count,
+           static_cast<double>(elapsed) / events, events / (elapsed / 1e9), static_cast<double>(levels) / events);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    size_t events = argc > 1 ? static_cast<size_t>(atol(argv[1])) : 2000000;
+    double realtime_rate = argc > 2 ? atof(argv[2]) : 200000.0;
+    if (events == 0) {
+        events = 1;
+    }
+    spdlog::set_level(spdlog::level::err);
+
+    benchGenerator(1, events);
+    benchGenerator(100, events);
+    benchGenerator(1000, events);
+
+    // 尽快生成，订单薄管理器直接应用增量
+    const size_t kPipelineSymbols = 100;
+    std::vector<symbol_t> symbols = makeSymbols(kPipelineSymbols);
+    {
+        OrderbookManager manager;
+        manager.initialize();
+        OrderbookValidatorConfig validator_config;
+        validator_config.max_age_ms = 0;
+        manager.setValidatorConfig(validator_config);
+
+        SyntheticMarketDataConfig config;
+        config.realtime = false;
+        SyntheticMarketDataFetcher fetcher(config);
+        manager.setSnapshotProvider([&fetcher](symbol_t symbol, DepthSnapshot& snapshot) {
+            return fetcher.fetchDepthSnapshot(symbol, 1000, snapshot);
+        });
+        std::atomic<uint64_t> applied(0);
+        std::atomic<uint64_t> rejected(0);
+        std::atomic<uint64_t> buffered(0);
+        std::atomic<bool> done(false);
+        const uint64_t target = events;
+        fetcher.setDepthDiffCallback([&](const depth_diff_t& diff) {
+            DepthDiffResult result = manager.applyDepthDiff(diff);
+            if (result == DepthDiffResult::APPLIED || result == DepthDiffResult::RESYNCED) {
+                if (applied.fetch_add(1, std::memory_order_relaxed) + 1 >= target) {
+                    done.store(true);
+                }
+            } else if (result == DepthDiffResult::BUFFERED) {
+                // 首次同步期间缓存，快照装入后重放
+                buffered.fetch_add(1, std::memory_order_relaxed);
+            } else {
+                rejected.fetch_add(1, std::memory_order_relaxed);
+            }
+        });
+        fetcher.initialize();
+        uint64_t begin = nowNs();
+        fetcher.start(symbols[0]);
+        for (size_t i = 1; i < symbols.size(); ++i) {
+            fetcher.subscribe(symbols[i], 0);
+        }
+        while (!done.load()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        uint64_t elapsed = nowNs() - begin;
+        uint64_t measured = applied.load();
+        fetcher.stop();
+
+        // 停止后生成的事件都已交给管理器，比较管理器的订单薄与生成器的当前订单薄
+        size_t checked = 0;
+        size_t mismatched = 0;
+        for (size_t i = 0; i < symbols.size(); ++i) {
+            orderbook_t expected = fetcher.getOrderbook(symbols[i]);
+            orderbook_t actual = manager.getOrderbook(symbols[i]);
+            ++checked;
+            if (actual.last_update_id != expected.last_update_id) {
+                ++mismatched;
+                continue;
+            }
+            for (uint32_t level = 0; level < expected.bid_count; ++level) {
+                if (actual.bids[level].price != expected.bids[level].price ||
+                    actual.bids[level].quantity != expected.bids[level].quantity ||
+                    actual.asks[level].price != expected.asks[level].price ||
+                    actual.asks[level].quantity != expected.asks[level].quantity) {
+                    ++mismatched;
+                    break;
+                }
+            }
+        }
+        printf("pipeline  %-5zu symbols %10.1f ns/event %12.0f events/s  buffered=%llu rejected=%llu "
+               "books checked=%zu mismatched=%zu\n",
+               kPipelineSymbols, static_cast<double>(elapsed) / measured, measured / (elapsed / 1e9),
+               static_cast<unsigned long long>(buffered.load()), static_cast<unsigned long long>(rejected.load()),
+               checked, mismatched);
+    }
+
+    // 按墙钟节奏推送
+    {
+        SyntheticMarketDataConfig config;
+        config.realtime = true;
+        config.feed.event_rate = realtime_rate;
+        SyntheticMarketDataFetcher fetcher(config);
+        std::atomic<uint64_t> received(0);
+        fetcher.setDepthDiffCallback([&received](const depth_diff_t&) {
+            received.fetch_add(1, std::memory_order_relaxed);
+        });
+        fetcher.initialize();
+        fetcher.start(symbols[0]);
+        for (size_t i = 1; i < symbols.size(); ++i) {
+            fetcher.subscribe(symbols[i], 0);
+        }
+        const uint64_t duration_ms = 2000;
+        std::this_thread::sleep_for(std::chrono::milliseconds(duration_ms));
+        fetcher.stop();
+        printf("realtime  target %10.0f events/s achieved %12.0f events/s\n", realtime_rate,
+               received.load() / (duration_ms / 1000.0));
+    }
+    return 0;
+}
@@ -0,0 +1,401 @@
+// WebSocket 客户端回环测试与吞吐基准
+// 在本机起一个按脚本收发帧的 ws:// 服务端，驱动 WebSocketConnection 走完：
+// 1. 地址回退：服务端只监听 localhost 解析结果中的最后一个地址，排在前面的地址须连接失败后换下一个
+// 2. HTTP 升级握手（校验请求头，返回正确的 Sec-WebSocket-Accept）
+// 3. 客户端发出的帧带掩码，服务端解掩码后内容一致
+// 4. 分片消息重组（分片之间夹一个 ping），ping 的 pong 回复带原负载
+// 5. 16 位和 64 位长度的负载
+// 6. 服务端连续推送小消息的接收吞吐
+// 7. 服务端 close(1000) 后客户端回送 close 并断开
+// 任一检查失败时返回1
+// 用法: websocket_loopback_bench [吞吐阶段消息数]
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <openssl/evp.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <spdlog/spdlog.h>
+
+#include "websocket_connection.h"
+
+using namespace crypto_quant;
+
+namespace {
+
+const int kTimeoutMs = 5000;
+
+inline uint64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+int g_failures = 0;
+
+void check(bool ok, const char* name) {
+    printf("  %-44s %s\n", name, ok ? "ok" : "FAILED");
+    if (!ok) {
+        ++g_failures;
+    }
+}
+
+std::string acceptKey(const std::string& key) {
+    std::string input = key + "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+    unsigned char digest[EVP_MAX_MD_SIZE];
+    unsigned int digest_size = 0;
+    EVP_Digest(input.data(), input.size(), digest, &digest_size, EVP_sha1(), nullptr);
+    unsigned char out[64];
+    int length = EVP_EncodeBlock(out, digest, static_cast<int>(digest_size));
+    return std::string(reinterpret_cast<char*>(out), length > 0 ? length : 0);
+}
+
+bool writeAll(int fd, const std::string& data) {
+    size_t offset = 0;
+    while (offset < data.size()) {
+        ssize_t n = ::send(fd, data.data() + offset, data.size() - offset, MSG_NOSIGNAL);
+        if (n <= 0) {
+            return false;
+        }
+        offset += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+bool readExact(int fd, char* out, size_t size) {
+    size_t offset = 0;
+    while (offset < size) {
+        ssize_t n = ::recv(fd, out + offset, size - offset, 0);
+        if (n <= 0) {
+            return false;
+        }
+        offset += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+// 服务端帧（不带掩码）
+std::string makeFrame(int opcode, bool fin, const std::string& payload) {
+    std::string frame;
+    frame.push_back(static_cast<char>((fin ? 0x80 : 0x00) | opcode));
+    if (payload.size() < 126) {
+        frame.push_back(static_cast<char>(payload.size()));
+    } else if (payload.size() <= 0xFFFF) {
+        frame.push_back(static_cast<char>(126));
+        frame.push_back(static_cast<char>(payload.size() >> 8));
+        frame.push_back(static_cast<char>(payload.size() & 0xFF));
+    } else {
+        frame.push_back(static_cast<char>(127));
+        for (int shift = 56; shift >= 0; shift -= 8) {
+            frame.push_back(static_cast<char>((static_cast<uint64_t>(payload.size()) >> shift) & 0xFF));
+        }
+    }
+    frame += payload;
+    return frame;
+}
+
+struct ClientFrame {
+    int opcode;
+    bool fin;
+    bool masked;
+    std::string payload;
+};
+
+// 读一个客户端帧并解掩码
+bool readFrame(int fd, ClientFrame& frame) {
+    unsigned char header[2];
+    if (!readExact(fd, reinterpret_cast<char*>(header), 2)) {
+        return false;
+    }
+    frame.fin = (header[0] & 0x80) != 0;
+    frame.opcode = header[0] & 0x0F;
+    frame.masked = (header[1] & 0x80) != 0;
+    uint64_t length = header[1] & 0x7F;
+    if (length >= 126) {
+        unsigned char extended[8];
+        size_t bytes = length == 126 ? 2 : 8;
+        if (!readExact(fd, reinterpret_cast<char*>(extended), bytes)) {
+            return false;
+        }
+        length = 0;
+        for (size_t i = 0; i < bytes; ++i) {
+            length = (length << 8) | extended[i];
+        }
+    }
+    unsigned char mask[4] = {0, 0, 0, 0};
+    if (frame.masked && !readExact(fd, reinterpret_cast<char*>(mask), 4)) {
+        return false;
+    }
+    frame.payload.resize(length);
+    if (length > 0 && !readExact(fd, &frame.payload[0], length)) {
+        return false;
+    }
+    for (size_t i = 0; i < length; ++i) {
+        frame.payload[i] = static_cast<char>(frame.payload[i] ^ mask[i & 3]);
+    }
+    return true;
+}
+
+std::string headerValue(const std::string& request, const std::string& name) {
+    std::string lower(request);
+    std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+    std::string key = "\r\n" + name + ":";
+    size_t pos = lower.find(key);
+    if (pos == std::string::npos) {
+        return std::string();
+    }
+    size_t begin = request.find_first_not_of(' ', pos + key.size());
+    size_t end = request.find("\r\n", begin);
+    return request.substr(begin, end - begin);
+}
+
+// 客户端收到的消息
+struct Inbox {
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::vector<std::string> messages;
+    std::vector<bool> binary;
+    int state_changes;
+    bool open;
+    // 吞吐阶段只计数
+    std::atomic<bool> bulk;
+    std::atomic<uint64_t> bulk_count;
+    uint64_t bulk_first_ns;
+    uint64_t bulk_last_ns;
+
+    Inbox() : state_changes(0), open(false), bulk(false), bulk_count(0), bulk_first_ns(0), bulk_last_ns(0) {}
+
+    template <typename Predicate>
+    bool waitFor(Predicate predicate) {
+        std::unique_lock<std::mutex> lock(mutex);
+        return cv.wait_for(lock, std::chrono::milliseconds(kTimeoutMs), predicate);
+    }
+};
+
+// 服务端脚本的结果
+struct ServerResult {
+    std::atomic<bool> accepted;
+    bool handshake_ok;
+    bool client_text_masked;
+    std::string client_text;
+    bool pong_ok;
+    bool close_echo_ok;
+
+    ServerResult() : accepted(false), handshake_ok(false), client_text_masked(false),
+                     pong_ok(false), close_echo_ok(false) {}
+};
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    size_t bulk_messages = argc > 1 ? static_cast<size_t>(atol(argv[1])) : 200000;
+    if (bulk_messages == 0) {
+        bulk_messages = 1;
+    }
+    spdlog::set_level(spdlog::level::warn);
+
+    // 服务端只监听 localhost 的最后一个解析地址
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    struct addrinfo* resolved = nullptr;
+    if (getaddrinfo("localhost", "0", &hints, &resolved) != 0 || !resolved) {
+        printf("cannot resolve localhost\n");
+        return 1;
+    }
+    size_t address_count = 0;
+    struct addrinfo* last = resolved;
+    for (struct addrinfo* ai = resolved; ai; ai = ai->ai_next) {
+        ++address_count;
+        last = ai;
+    }
+    int listen_fd = socket(last->ai_family, SOCK_STREAM, 0);
+    int one = 1;
+    setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    if (listen_fd < 0 || bind(listen_fd, last->ai_addr, last->ai_addrlen) != 0 || listen(listen_fd, 4) != 0) {
+        printf("cannot listen on localhost: %s\n", strerror(errno));
+        freeaddrinfo(resolved);
+        return 1;
+    }
+    struct sockaddr_storage bound;
+    socklen_t bound_length = sizeof(bound);
+    getsockname(listen_fd, reinterpret_cast<struct sockaddr*>(&bound), &bound_length);
+    unsigned port = ntohs(bound.ss_family == AF_INET6
+                              ? reinterpret_cast<struct sockaddr_in6*>(&bound)->sin6_port
+                              : reinterpret_cast<struct sockaddr_in*>(&bound)->sin_port);
+    const int listen_family = last->ai_family;
+    freeaddrinfo(resolved);
+
+    const std::string large_binary(70000, '\x5A');
+    const std::string medium_text(300, 'm');
+    const std::string bulk_payload = "{\"e\":\"depthUpdate\",\"s\":\"BTCUSDT\",\"u\":123456789}";
+
+    ServerResult server_result;
+    std::thread server([&]() {
+        int fd = accept(listen_fd, nullptr, nullptr);
+        close(listen_fd);
+        if (fd < 0) {
+            return;
+        }
+        server_result.accepted.store(true);
+        struct timeval timeout;
+        timeout.tv_sec = kTimeoutMs / 1000;
+        timeout.tv_usec = 0;
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+        // 握手
+        std::string request;
+        char c;
+        while (request.size() < 16384 && request.find("\r\n\r\n") == std::string::npos && readExact(fd, &c, 1)) {
+            request.push_back(c);
+        }
+        std::string key = headerValue(request, "sec-websocket-key");
+        std::string upgrade = headerValue(request, "upgrade");
+        std::transform(upgrade.begin(), upgrade.end(), upgrade.begin(), ::tolower);
+        server_result.handshake_ok = request.compare(0, 4, "GET ") == 0 && upgrade == "websocket" &&
+                                     headerValue(request, "sec-websocket-version") == "13" && !key.empty();
+        writeAll(fd, "HTTP/1.1 101 Switching Protocols\r\n"
+                     "Upgrade: websocket\r\n"
+                     "Connection: Upgrade\r\n"
+                     "Sec-WebSocket-Accept: " + acceptKey(key) + "\r\n\r\n");
+
+        // 单帧文本，客户端收到后回发一条（掩码）
+        writeAll(fd, makeFrame(0x1, true, "hello"));
+        ClientFrame frame;
+        if (readFrame(fd, frame) && frame.opcode == 0x1) {
+            server_result.client_text_masked = frame.masked;
+            server_result.client_text = frame.payload;
+        }
+
+        // 分片中夹 ping，随后是 16 位和 64 位长度的负载，一次写出
+        std::string batch = makeFrame(0x1, false, "frag-") + makeFrame(0x9, true, "p1") +
+                            makeFrame(0x0, false, "men") + makeFrame(0x0, true, "ted") +
+                            makeFrame(0x1, true, medium_text) + makeFrame(0x2, true, large_binary);
+        writeAll(fd, batch);
+        server_result.pong_ok = readFrame(fd, frame) && frame.opcode == 0xA && frame.masked &&
+                                frame.payload == "p1";
+
+        // 等客户端切到吞吐阶段后连续推送
+        if (readFrame(fd, frame) && frame.payload == "bulk") {
+            std::string chunk;
+            for (size_t i = 0; i < bulk_messages; ++i) {
+                chunk += makeFrame(0x1, true, bulk_payload);
+                if (chunk.size() >= 64 * 1024) {
+                    writeAll(fd, chunk);
+                    chunk.clear();
+                }
+            }
+            writeAll(fd, chunk);
+        }
+
+        // 关闭：close(1000) 后期望客户端回送带相同状态码的 close
+        if (readFrame(fd, frame) && frame.payload == "close") {
+            writeAll(fd, makeFrame(0x8, true, std::string("\x03\xE8" "bye", 5)));
+            server_result.close_echo_ok = readFrame(fd, frame) && frame.opcode == 0x8 && frame.masked &&
+                                          frame.payload.size() == 2 &&
+                                          static_cast<unsigned char>(frame.payload[0]) == 0x03 &&
+                                          static_cast<unsigned char>(frame.payload[1]) == 0xE8;
+        }
+        close(fd);
+    });
+
+    Inbox inbox;
+    WebSocketConfig config;
+    config.connect_timeout_ms = kTimeoutMs;
+    // 测试期间不重连回来
+    config.reconnect_initial_ms = 60000;
+    char url[64];
+    snprintf(url, sizeof(url), "ws://localhost:%u/ws", port);
+    std::shared_ptr<WebSocketConnection> connection = std::make_shared<WebSocketConnection>(url, config);
+    connection->setMessageHandler([&inbox](const char* data, size_t size, bool binary) {
+        if (inbox.bulk.load(std::memory_order_relaxed)) {
+            uint64_t now = nowNs();
+            uint64_t count = inbox.bulk_count.load(std::memory_order_relaxed);
+            if (count == 0) {
+                inbox.bulk_first_ns = now;
+            }
+            inbox.bulk_last_ns = now;
+            inbox.bulk_count.store(count + 1, std::memory_order_release);
+            return;
+        }
+        std::lock_guard<std::mutex> lock(inbox.mutex);
+        inbox.messages.push_back(std::string(data, size));
+        inbox.binary.push_back(binary);
+        inbox.cv.notify_all();
+    });
+    connection->setStateHandler([&inbox](bool open) {
+        std::lock_guard<std::mutex> lock(inbox.mutex);
+        ++inbox.state_changes;
+        inbox.open = open;
+        inbox.cv.notify_all();
+    });
+
+    WebSocketEventLoop loop;
+    loop.start();
+    loop.add(connection);
+
+    printf("server on %s port %u, localhost resolves to %zu address(es)\n",
+           listen_family == AF_INET6 ? "IPv6" : "IPv4", port, address_count);
+    bool opened = inbox.waitFor([&inbox]() { return inbox.open; });
+    check(opened && server_result.accepted.load(), address_count > 1 ? "connect (fallback to last address)"
+                                                                      : "connect (single address)");
+    check(server_result.handshake_ok, "upgrade request headers");
+
+    bool hello = inbox.waitFor([&inbox]() { return inbox.messages.size() >= 1; });
+    check(hello && inbox.messages[0] == "hello", "unfragmented text frame");
+    connection->send("client-text");
+
+    bool batch = inbox.waitFor([&inbox]() { return inbox.messages.size() >= 4; });
+    check(batch && inbox.messages[1] == "frag-mented" && !inbox.binary[1], "fragmented message with ping inside");
+    check(batch && inbox.messages[2] == medium_text, "16-bit payload length");
+    check(batch && inbox.messages[3] == large_binary && inbox.binary[3], "64-bit payload length (binary)");
+    check(server_result.client_text_masked && server_result.client_text == "client-text",
+          "client frame masked and unmasks correctly");
+    check(server_result.pong_ok, "pong echoes ping payload");
+    WebSocketConnectionStats stats = connection->getStats();
+    check(stats.pings_received == 1, "ping counted");
+
+    // 吞吐：从第一条到最后一条的接收间隔
+    inbox.bulk.store(true);
+    connection->send("bulk");
+    uint64_t wait_start = nowNs();
+    while (inbox.bulk_count.load(std::memory_order_acquire) < bulk_messages &&
+           nowNs() - wait_start < 30ULL * 1000000000ULL) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    uint64_t received = inbox.bulk_count.load(std::memory_order_acquire);
+    check(received == bulk_messages, "all bulk messages received");
+    double seconds = (inbox.bulk_last_ns - inbox.bulk_first_ns) / 1e9;
+    if (received > 1 && seconds > 0) {
+        printf("  bulk: %llu messages of %zu bytes, %.0f msg/s, %.1f MB/s\n",
+               static_cast<unsigned long long>(received), bulk_payload.size(), received / seconds,
+               received * (bulk_payload.size() + 2) / seconds / 1e6);
+    }
+    inbox.bulk.store(false);
+
+    connection->send("close");
+    bool closed = inbox.waitFor([&inbox]() { return inbox.state_changes >= 2 && !inbox.open; });
+    server.join();
+    check(closed, "state handler reports close");
+    check(server_result.close_echo_ok, "close frame echoed with status 1000");
+    stats = connection->getStats();
+    check(stats.connects == 1 && stats.disconnects == 1 && stats.protocol_errors == 0,
+          "connection stats (1 connect, 1 disconnect, 0 errors)");
+
+    loop.remove(connection);
+    loop.stop();
+    printf("%s\n", g_failures == 0 ? "all checks passed" : "FAILED");
+    return g_failures == 0 ? 0 : 1;
+}
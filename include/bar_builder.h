@@ -0,0 +1,73 @@
+#ifndef BAR_BUILDER_H
+#define BAR_BUILDER_H
+
+#include <stdint.h>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+#include "crypto_quant.h"
+
+namespace crypto_quant {
+
+// K 线规格：threshold 对时间 K 线为区间长度（毫秒），对成交量 / 成交笔数 / 成交额 K 线为收盘阈值
+struct BarSpec {
+    BarType type;
+    double threshold;
+
+    BarSpec() : type(BarType::TIME), threshold(60000.0) {}
+    BarSpec(BarType bar_type, double bar_threshold) : type(bar_type), threshold(bar_threshold) {}
+};
+
+// 由逐笔成交在本地聚合 K 线，一路成交流同时生成任意多种规格，不需要按周期单独订阅 kline 流。
+// 每笔成交对每个规格 O(1) 增量更新 OHLCV 和 VWAP，不保存逐笔历史。
+// 时间 K 线按成交时间对齐到区间整数倍，没有成交的区间不生成；成交迟到（所在区间已收盘）时计入下一根。
+// 阈值 K 线整笔计入当前 K 线，累计量达到阈值即收盘，不拆分成交。
+class BarBuilder {
+public:
+    BarBuilder();
+
+    // 增加一种规格，返回规格编号（即 bar_t::spec），阈值无效时返回 -1；须在接入成交流之前调用
+    int addSpec(const BarSpec& spec);
+    size_t specCount() const;
+    // 收盘回调在持锁时调用（调用 onTrade / flush 的线程上），回调中不能再调用本对象
+    void setBarCallback(std::function<void(const bar_t&)> callback);
+
+    void onTrade(const trade_t& trade);
+    // 收盘区间已结束的时间 K 线（now_ms 为成交时间口径的当前时间），没有新成交时由调用方定时调用
+    void flush(uint64_t now_ms);
+    // 交易对在某规格下尚未收盘的 K 线，没有时返回 false
+    bool getCurrentBar(symbol_t symbol, uint32_t spec, bar_t& bar) const;
+    // 丢弃交易对所有未收盘的 K 线（重连后成交流不连续时）
+    void reset(symbol_t symbol);
+    // 已收盘的 K 线总数
+    uint64_t barCount() const;
+
+private:
+    struct OpenBar {
+        // trade_count 为0表示没有未收盘的 K 线
+        bar_t bar;
+        // 时间 K 线：已收盘区间的结束时间，之前的成交计入下一根
+        uint64_t closed_until;
+    };
+
+    struct SpecState {
+        BarSpec spec;
+        // 时间 K 线的区间长度（毫秒）
+        uint64_t interval_ms;
+        // 按 symbol_t 索引，按需扩展
+        std::vector<OpenBar> bars;
+    };
+
+    void addTrade(uint32_t index, SpecState& state, const trade_t& trade);
+    void closeBar(OpenBar& open);
+
+    mutable std::mutex mutex_;
+    std::vector<SpecState> specs_;
+    std::function<void(const bar_t&)> callback_;
+    uint64_t bar_count_;
+};
+
+} // namespace crypto_quant
+
+#endif // BAR_BUILDER_H
@@ -0,0 +1,103 @@
+#ifndef BINANCE_MESSAGE_PARSER_H
+#define BINANCE_MESSAGE_PARSER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+#include "crypto_quant.h"
+
+namespace crypto_quant {
+
+enum class BinanceMessageType {
+    INVALID = 0,   // 不是合法的 JSON 对象，或字段格式错误
+    UNKNOWN,       // 合法但不是支持的事件
+    DEPTH,         // 部分深度快照（<symbol>@depth<N>）
+    DEPTH_UPDATE,  // 增量深度（depthUpdate）
+    TRADE,
+    AGG_TRADE,
+    RESULT,        // 订阅/退订请求的应答 {"result":...,"id":N}
+    ERROR          // 请求错误应答 {"error":{...},"id":N}
+};
+
+// 币安行情消息专用解析器
+// 单遍扫描原始 JSON，只识别 depth / depthUpdate / trade / aggTrade 及请求应答需要的字段，
+// 其余字段整体跳过，不构建 DOM。价格、数量字符串直接转 double，直接写入
+// orderbook_t / depth_diff_t / trade_t。增量深度的档位缓冲按容量复用，稳态下不分配内存。
+// 同时支持原始流和组合流（{"stream":...,"data":{...}}）。
+// 解析结果引用解析器内部缓冲和输入数据，在下一次 parse() 前有效；单线程使用。
+class BinanceMessageParser {
+public:
+    // reserve_levels：增量深度每侧预留的档位数
+    explicit BinanceMessageParser(size_t reserve_levels = 1000);
+
+    // 原始流的部分深度消息中不带交易对，使用该默认值（通常由 URL 中的流名决定）
+    void setDefaultSymbol(symbol_t symbol) { default_symbol_ = symbol; }
+
+    BinanceMessageType parse(const char* data, size_t size);
+
+    // DEPTH：最多20档，timestamp 为本地接收时间（毫秒）
+    const orderbook_t& orderbook() const { return orderbook_; }
+    // DEPTH_UPDATE：档位指向解析器内部缓冲
+    const depth_diff_t& depthDiff() const { return diff_; }
+    // TRADE / AGG_TRADE
+    const trade_t& trade() const { return trade_; }
+    // RESULT / ERROR 对应的请求ID
+    uint64_t requestId() const { return request_id_; }
+    // 组合流的流名，指向输入数据；原始流为空
+    const char* stream() const { return stream_; }
+    size_t streamLength() const { return stream_length_; }
+    // 最近一次 INVALID 的原因（静态字符串）
+    const char* error() const { return error_; }
+
+private:
+    // 单次解析收集的字段
+    struct Fields {
+        const char* event;
+        size_t event_length;
+        const char* symbol;
+        size_t symbol_length;
+        uint64_t event_time;
+        uint64_t first_update_id;
+        uint64_t final_update_id;
+        uint64_t last_update_id;
+        uint64_t trade_id;
+        uint64_t agg_trade_id;
+        uint64_t first_trade_id;
+        uint64_t last_trade_id;
+        uint64_t trade_time;
+        double price;
+        double quantity;
+        bool buyer_maker;
+        bool has_last_update_id;
+        bool has_bids;
+        bool has_asks;
+        bool has_result;
+        bool has_error;
+        bool has_id;
+    };
+
+    struct Cursor;
+
+    bool parseObject(Cursor& cursor, int depth);
+    bool parseField(Cursor& cursor, const char* key, size_t key_length, int depth);
+    bool parseLevels(Cursor& cursor, std::vector<price_level_t>& levels);
+    symbol_t resolveSymbol() const;
+    BinanceMessageType finish();
+
+    Fields fields_;
+    std::vector<price_level_t> bids_;
+    std::vector<price_level_t> asks_;
+    orderbook_t orderbook_;
+    depth_diff_t diff_;
+    trade_t trade_;
+    uint64_t request_id_;
+    const char* stream_;
+    size_t stream_length_;
+    symbol_t default_symbol_;
+    const char* error_;
+};
+
+} // namespace crypto_quant
+
+#endif // BINANCE_MESSAGE_PARSER_H
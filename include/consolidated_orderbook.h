@@ -0,0 +1,128 @@
+#ifndef CONSOLIDATED_ORDERBOOK_H
+#define CONSOLIDATED_ORDERBOOK_H
+
+#include <stdint.h>
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "crypto_quant.h"
+#include "orderbook_notifier.h"
+#include "utils/seqlock.h"
+#include "utils/chunked_array.h"
+
+namespace crypto_quant {
+
+// 合并订单薄的档位：同一价格上各场所的挂单合并，保留按场所的明细
+typedef struct {
+    double price;
+    // 各场所合计
+    double quantity;
+    // 在该价格有挂单的场所位图（第 venue 位）
+    uint32_t venue_mask;
+    uint32_t venue_count;
+    // 按场所的挂单量，未挂单的场所为0
+    double venue_quantity[VENUE_MAX];
+} consolidated_level_t;
+
+// 合并盘口摘要（无锁读取）
+typedef struct {
+    symbol_t symbol;
+    // 当前有报价的场所位图
+    uint32_t venue_mask;
+    double bid_price;
+    double bid_quantity;
+    // 给出最优买价的场所位图
+    uint32_t bid_venue_mask;
+    uint32_t ask_venue_mask;
+    double ask_price;
+    double ask_quantity;
+    // 跨场所交叉（某场所买一 >= 另一场所卖一）时为1
+    uint32_t crossed;
+    uint32_t reserved;
+    // 各场所订单薄的最新时间戳
+    uint64_t timestamp;
+    // 每次合并变化加1
+    uint64_t sequence;
+} consolidated_top_t;
+
+// 多场所合并订单薄
+// 每个场所按交易对提交自己的 orderbook_t（通常来自该场所的 IOrderbookManager），
+// 合并视图按价格聚合各场所的挂单并标注来源场所。
+// 更新是增量的：新旧两份场所订单薄做一次有序归并，只有数量变化的价格才触碰合并档位，
+// 其他场所的档位不重新合并。合并视图允许交叉（跨场所套利机会），不做完整性隔离。
+// 写入按交易对加锁，可在多个场所的回调线程上调用；盘口摘要由顺序锁发布，无锁读取。
+class ConsolidatedOrderbook {
+public:
+    ConsolidatedOrderbook();
+
+    // 用场所的最新订单薄替换该场所在合并视图中的贡献
+    // 场所ID越界、交易对未注册或档位无序时返回false
+    bool update(venue_t venue, const orderbook_t& orderbook);
+    // 移除场所在该交易对上的全部挂单（断线、被隔离时）
+    bool removeVenue(venue_t venue, symbol_t symbol);
+    void clear();
+
+    // 合并后的前20档（timestamp 为各场所最新值，last_update_id 为合并序号）
+    orderbook_t getOrderbook(symbol_t symbol) const;
+    // 按由优到劣顺序导出最多 max_levels 档，返回实际档数
+    size_t getLevels(symbol_t symbol, bool bid, consolidated_level_t* out, size_t max_levels) const;
+    size_t getLevelCount(symbol_t symbol, bool bid) const;
+    consolidated_top_t getTop(symbol_t symbol) const;
+    // 场所最近提交的订单薄，未提交过时返回false
+    bool getVenueOrderbook(venue_t venue, symbol_t symbol, orderbook_t& orderbook) const;
+
+    // 合并视图的变更订阅（与 IOrderbookManager 的订阅语义相同）
+    std::shared_ptr<IOrderbookSubscription> subscribeConflated(symbol_t symbol);
+    uint64_t subscribeEveryUpdate(symbol_t symbol, OrderbookUpdateCallback callback);
+    void unsubscribe(uint64_t subscription_id);
+    uint64_t droppedUpdates(uint64_t subscription_id) const;
+
+    // 累计被触碰的合并档位数（衡量增量更新的工作量）
+    uint64_t levelChangeCount() const { return level_changes_.load(std::memory_order_relaxed); }
+
+    static const char* venueName(venue_t venue);
+
+private:
+    struct SymbolBook {
+        mutable std::mutex mutex;
+        // 各场所最近提交的订单薄
+        orderbook_t venue_books[VENUE_MAX];
+        uint32_t venue_mask;
+        // 买盘价格递减、卖盘价格递增
+        std::vector<consolidated_level_t> bids;
+        std::vector<consolidated_level_t> asks;
+        uint64_t sequence;
+        Seqlock<consolidated_top_t> top;
+
+        SymbolBook() : venue_mask(0), sequence(0) {
+            memset(static_cast<void*>(venue_books), 0, sizeof(venue_books));
+        }
+    };
+
+    SymbolBook* findBook(symbol_t symbol) const;
+    SymbolBook* findOrCreateBook(symbol_t symbol);
+    // 把场所一侧的挂单从 old_levels 换成 new_levels（两者均由优到劣排序），返回触碰的档位数
+    static size_t replaceVenueSide(std::vector<consolidated_level_t>& levels, bool bid, venue_t venue,
+                                   const price_level_t* old_levels, size_t old_count,
+                                   const price_level_t* new_levels, size_t new_count);
+    static void setVenueQuantity(std::vector<consolidated_level_t>& levels, bool bid, venue_t venue,
+                                 double price, double quantity);
+    // 在持有订单薄锁时发布盘口摘要
+    static void publishTop(symbol_t symbol, SymbolBook& book);
+    // 在持有订单薄锁时导出前20档
+    static void toOrderbook(symbol_t symbol, const SymbolBook& book, orderbook_t& orderbook);
+
+    mutable ChunkedArray<SymbolBook, 1> books_;
+    OrderbookNotifier notifier_;
+    std::atomic<uint64_t> level_changes_;
+
+    ConsolidatedOrderbook(const ConsolidatedOrderbook&) = delete;
+    ConsolidatedOrderbook& operator=(const ConsolidatedOrderbook&) = delete;
+};
+
+} // namespace crypto_quant
+
+#endif // CONSOLIDATED_ORDERBOOK_H
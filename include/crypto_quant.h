@@ -87,13 +87,24 @@ namespace crypto_quant
         PARTIAL
     };
 
-    // 交易对类型（提前定义，供其他结构体使用）
-    typedef enum
-    {
-        SYMBOL_BTC_USDT = 0,
-        SYMBOL_ETH_USDT,
-        SYMBOL_BTC_ETH
-    } symbol_t;
+    // 交易对ID（提前定义，供其他结构体使用）
+    // 由 SymbolRegistry 在运行时分配的稠密整数，可直接作为数组下标
+    typedef uint32_t symbol_t;
+
+    // 预注册的交易对
+    static const symbol_t SYMBOL_BTC_USDT = 0;
+    static const symbol_t SYMBOL_ETH_USDT = 1;
+    static const symbol_t SYMBOL_BTC_ETH = 2;
+    // 非法/未注册的交易对
+    static const symbol_t SYMBOL_INVALID = 0xFFFFFFFFu;
+
+    // 交易场所ID（合并订单薄等多场所组件使用）
+    typedef uint32_t venue_t;
+    static const venue_t VENUE_BINANCE = 0;
+    // 本地模拟的第二场所（测试用）
+    static const venue_t VENUE_SIMULATED = 1;
+    // 支持的场所数上限（场所ID需小于该值）
+    static const venue_t VENUE_MAX = 8;
 
     // 交易信号结构
     struct TradingSignal
@@ -124,6 +135,8 @@ namespace crypto_quant
         int short_period;
         int long_period;
         double momentum_threshold;
+        // 动量信号的订单流确认：多档不平衡反向超过该值时抑制信号
+        double imbalance_threshold;
         int rsi_period;
         double rsi_oversold;
         double rsi_overbought;
@@ -136,7 +149,8 @@ namespace crypto_quant
                            risk_per_trade(0.02), max_position_size(1000.0),
                            lookback_period(20), z_score_threshold(2.0),
                            mean_period(20), short_period(12), long_period(26),
-                           momentum_threshold(0.01), rsi_period(14),
+                           momentum_threshold(0.01), imbalance_threshold(0.3),
+                           rsi_period(14),
                            rsi_oversold(30.0), rsi_overbought(70.0),
                            bb_period(20), bb_std_dev(2.0),
                            grid_spacing(0.001), grid_levels(10) {}
@@ -175,6 +189,15 @@ namespace crypto_quant
         MARKET_DATA_TRADE,
         MARKET_DATA_KLINE
     } market_data_type_t;
+
+    // 行情流（按位组合，用于订阅）
+    typedef enum
+    {
+        MARKET_STREAM_DEPTH = 1,      // 20档部分深度快照 <symbol>@depth20@100ms
+        MARKET_STREAM_DEPTH_DIFF = 2, // 增量深度 <symbol>@depth@100ms
+        MARKET_STREAM_TRADE = 4,      // 逐笔成交 <symbol>@trade
+        MARKET_STREAM_AGG_TRADE = 8   // 归集成交 <symbol>@aggTrade
+    } market_stream_t;
     
     // 订单类型
     typedef enum
@@ -251,8 +274,7 @@ namespace crypto_quant
 #pragma pack(push, 1)
     typedef struct
     {
-        uint8_t symbol;             // 1 byte
-        uint8_t reserved[3];        // 3 bytes padding for alignment
+        uint32_t symbol;            // 4 bytes
         uint32_t bid_count;         // 4 bytes
         uint32_t ask_count;         // 4 bytes
         uint64_t timestamp;         // 8 bytes
@@ -263,8 +285,7 @@ namespace crypto_quant
 #else
     typedef struct __attribute__((packed))
     {
-        uint8_t symbol;             // 1 byte
-        uint8_t reserved[3];        // 3 bytes padding for alignment
+        uint32_t symbol;            // 4 bytes
         uint32_t bid_count;         // 4 bytes
         uint32_t ask_count;         // 4 bytes
         uint64_t timestamp;         // 8 bytes
@@ -273,26 +294,257 @@ namespace crypto_quant
     } orderbook_net_t;
 #endif
 
+// 逐笔成交（网络传输/落盘用，1字节对齐，无填充）
+#ifdef _MSC_VER
+#pragma pack(push, 1)
+    typedef struct
+    {
+        uint32_t symbol;            // 4 bytes
+        uint32_t flags;             // 4 bytes，bit0 归集成交，bit1 买方是挂单方
+        uint64_t trade_id;          // 8 bytes
+        uint64_t first_trade_id;    // 8 bytes
+        uint64_t last_trade_id;     // 8 bytes
+        uint64_t trade_time;        // 8 bytes
+        uint64_t event_time;        // 8 bytes
+        double price;               // 8 bytes
+        double quantity;            // 8 bytes
+    } trade_net_t;
+#pragma pack(pop)
+#else
+    typedef struct __attribute__((packed))
+    {
+        uint32_t symbol;            // 4 bytes
+        uint32_t flags;             // 4 bytes，bit0 归集成交，bit1 买方是挂单方
+        uint64_t trade_id;          // 8 bytes
+        uint64_t first_trade_id;    // 8 bytes
+        uint64_t last_trade_id;     // 8 bytes
+        uint64_t trade_time;        // 8 bytes
+        uint64_t event_time;        // 8 bytes
+        double price;               // 8 bytes
+        double quantity;            // 8 bytes
+    } trade_net_t;
+#endif
+
+    // 订单薄每侧的档位容量
+    static const uint32_t ORDERBOOK_MAX_LEVELS = 20;
+
     // 订单薄结构
     typedef struct
     {
         symbol_t symbol;
-        price_level_t bids[20]; // 买盘
-        price_level_t asks[20]; // 卖盘
+        price_level_t bids[ORDERBOOK_MAX_LEVELS]; // 买盘
+        price_level_t asks[ORDERBOOK_MAX_LEVELS]; // 卖盘
         // 实际有效的买盘档位数量
         uint32_t bid_count;
         // 实际有效的卖盘档位数量
         uint32_t ask_count;
         // 整个订单簿的最新更新时间戳
         uint64_t timestamp;
+        // 交易所订单簿更新ID（币安 lastUpdateId / u），0表示未知
+        uint64_t last_update_id;
     } orderbook_t;
 
+    // 盘口摘要（批量查询用），同一交易对的各字段来自同一份一致的订单簿快照
+    typedef struct
+    {
+        symbol_t symbol;
+        // 买卖盘均有报价且未被隔离时为1。为0时 mid_price / spread 为0，
+        // 买卖价和数量仍按存在的一侧填写（单边盘口、隔离中的订单薄），没有报价的一侧为0
+        uint32_t valid;
+        double bid_price;
+        double bid_quantity;
+        double ask_price;
+        double ask_quantity;
+        double mid_price;
+        double spread;
+        uint64_t timestamp;
+        uint64_t last_update_id;
+    } top_of_book_t;
+
+    // 价差状态（相对价差的长期均值）
+    typedef enum
+    {
+        SPREAD_REGIME_UNKNOWN = 0,
+        SPREAD_REGIME_TIGHT,  // 一个tick或明显低于均值
+        SPREAD_REGIME_NORMAL,
+        SPREAD_REGIME_WIDE    // 明显高于均值（流动性撤出）
+    } spread_regime_t;
+
+    // 微观结构特征（每个交易对一份，按缓存行对齐，策略可直接按字段读取）
+    // 流量类特征按时间指数衰减，半衰期由特征引擎配置
+    typedef struct alignas(64)
+    {
+        symbol_t symbol;
+        // 买卖盘均有报价时为1
+        uint32_t valid;
+        // spread_regime_t
+        uint32_t spread_regime;
+        uint32_t reserved;
+        uint64_t timestamp;
+        uint64_t update_count;
+        double mid_price;
+        // 按最优档数量加权的中间价：(买价*卖量 + 卖价*买量) / (买量 + 卖量)
+        double microprice;
+        double spread;
+        double spread_bps;
+        // 价差的长期指数均值
+        double spread_ewma;
+        // 最优档数量不平衡 (买量-卖量)/(买量+卖量)，范围[-1, 1]
+        double imbalance_l1;
+        // 前N档按档位衰减加权的数量不平衡
+        double imbalance_multi;
+        // 本次更新的最优档订单流不平衡（Cont-Kukanov-Stoikov OFI），正值为买压
+        double ofi;
+        // OFI 的时间衰减累计
+        double ofi_flow;
+        // 最优档队列被消耗的速率（数量/秒，时间衰减估计）
+        double bid_depletion_rate;
+        double ask_depletion_rate;
+    } microstructure_features_t;
+
+    // 增量深度事件（币安 depthUpdate）
+    // 档位数组由解析方持有并复用，数量为0的档位表示删除该价格
+    typedef struct
+    {
+        symbol_t symbol;
+        // 本事件第一个更新ID（U）
+        uint64_t first_update_id;
+        // 本事件最后一个更新ID（u）
+        uint64_t final_update_id;
+        // 交易所事件时间（E，毫秒）
+        uint64_t event_time;
+        const price_level_t *bids;
+        uint32_t bid_count;
+        const price_level_t *asks;
+        uint32_t ask_count;
+    } depth_diff_t;
+
+    // 逐笔成交（币安 trade / aggTrade）
+    typedef struct
+    {
+        symbol_t symbol;
+        // 非0表示归集成交（aggTrade），trade_id 为归集ID
+        uint32_t aggregated;
+        // trade: t；aggTrade: a
+        uint64_t trade_id;
+        // 归集成交覆盖的首末成交ID（trade 时均等于 trade_id）
+        uint64_t first_trade_id;
+        uint64_t last_trade_id;
+        // 成交时间（T，毫秒）
+        uint64_t trade_time;
+        // 交易所事件时间（E，毫秒）
+        uint64_t event_time;
+        double price;
+        double quantity;
+        // 非0表示买方是挂单方，即主动卖出成交
+        uint32_t is_buyer_maker;
+        uint32_t reserved;
+    } trade_t;
+
+    // K 线类型：按时间区间，或按累计成交量 / 成交笔数 / 成交额达到阈值收盘
+    enum class BarType
+    {
+        TIME = 0,
+        VOLUME,
+        TICK,
+        DOLLAR
+    };
+
+    // 由逐笔成交在本地聚合的 K 线
+    typedef struct
+    {
+        symbol_t symbol;
+        // 生成该 K 线的规格编号（BarBuilder::addSpec 的返回值）
+        uint32_t spec;
+        BarType type;
+        uint32_t trade_count;
+        // 时间 K 线为区间起止（毫秒，止为区间末毫秒）；其余为首末成交时间
+        uint64_t open_time;
+        uint64_t close_time;
+        double open;
+        double high;
+        double low;
+        double close;
+        // 成交量（基础币）、成交额（计价币）和主动买入成交量
+        double volume;
+        double quote_volume;
+        double buy_volume;
+        // 成交量加权平均价 = quote_volume / volume
+        double vwap;
+    } bar_t;
+
+    // 增量深度应用结果
+    enum class DepthDiffResult
+    {
+        APPLIED = 0,  // 已应用
+        STALE,        // 事件早于当前订单簿，已丢弃
+        RESYNCED,     // 已应用，且是快照重新同步后应用的第一个事件
+        OUT_OF_SYNC,  // 检测到缺口且重新同步失败，事件被丢弃
+        BUFFERED,     // 重新同步进行中，事件已缓存，快照到达后按序应用
+        QUEUED        // 已交给异步写线程，尚未应用（实际结果见管理器自身的统计）
+    };
+
+    // 订单簿完整性问题
+    enum class OrderbookIntegrityIssue
+    {
+        NONE = 0,
+        CROSSED,          // 买一价 >= 卖一价
+        NON_MONOTONIC,    // 档位价格未严格有序，或价格/数量非正
+        STALE_TIMESTAMP,  // 时间戳回退，或落后本地时钟过多
+        SEQUENCE_GAP      // 更新ID出现缺口或回退
+    };
+
+    // 订单簿完整性统计（管理器启动以来的累计值）
+    typedef struct
+    {
+        uint64_t checked;
+        uint64_t crossed;
+        uint64_t non_monotonic;
+        uint64_t stale_timestamp;
+        uint64_t sequence_gap;
+        // 进入隔离的次数
+        uint64_t quarantined;
+        uint64_t resync_requested;
+        uint64_t resync_failed;
+        // 解除隔离的次数
+        uint64_t recovered;
+    } orderbook_integrity_stats_t;
+
+    // REST 深度快照（用于增量流的初始同步和缺口恢复）
+    struct DepthSnapshot
+    {
+        symbol_t symbol;
+        uint64_t last_update_id;
+        std::vector<price_level_t> bids; // 价格从高到低
+        std::vector<price_level_t> asks; // 价格从低到高
+        // 请求的每侧档位上限：某一侧档位数达到上限时更深的档位被截断，0表示未知（按截断处理）
+        uint32_t limit;
+
+        DepthSnapshot() : symbol(SYMBOL_BTC_USDT), last_update_id(0), limit(0) {}
+    };
+
+    // 深度快照获取函数：成功时填充快照并返回true
+    typedef std::function<bool(symbol_t, DepthSnapshot &)> DepthSnapshotProvider;
+
     // 抽象策略基类
     class IStrategy
     {
     public:
         virtual ~IStrategy() = default;
         virtual SignalType processMarketData(const orderbook_t &orderbook) = 0;
+        // 带微观结构特征的行情入口（策略引擎调用），默认忽略特征
+        virtual SignalType processFeatures(const orderbook_t &orderbook,
+                                           const microstructure_features_t &features)
+        {
+            (void)features;
+            return processMarketData(orderbook);
+        }
+        // 收盘的 K 线（BarBuilder 由逐笔成交聚合），默认忽略
+        virtual SignalType processBar(const bar_t &bar)
+        {
+            (void)bar;
+            return SignalType::NONE;
+        }
         virtual bool initialize() = 0;
         virtual void cleanup() = 0;
         virtual StrategyStatus getStatus() const = 0;
@@ -314,6 +566,7 @@ namespace crypto_quant
         virtual void pause() = 0;
         virtual StrategyStatus getStatus() const = 0;
         virtual void processMarketData(const orderbook_t &orderbook) = 0;
+        virtual void processBar(const bar_t &bar) = 0;
     };
 
     // 订单执行器接口
@@ -328,7 +581,10 @@ namespace crypto_quant
         virtual bool connect() = 0;
         virtual void disconnect() = 0;
         virtual ExecutionStatus getStatus() const = 0;
+        // price<=0 为市价单；注册了定点规格的交易对按 tick / lot 取整，正价格取整后不足一个 tick 时拒绝
         virtual ExecutionResult submitOrder(symbol_t symbol, int side, double price, double quantity) = 0;
+        // 定点限价单：价格以 tick、数量以 lot 为单位（需先注册交易对的定点规格），price_ticks<=0 或 quantity_lots<=0 被拒绝
+        virtual ExecutionResult submitOrderFixed(symbol_t symbol, int side, int64_t price_ticks, int64_t quantity_lots) = 0;
         virtual bool cancelOrder(uint64_t order_id) = 0;
         virtual double getBalance(symbol_t symbol) = 0;
         virtual double getPosition(symbol_t symbol) = 0;
@@ -336,6 +592,24 @@ namespace crypto_quant
         virtual std::vector<uint64_t> getOrderHistory(int max_count = 100) = 0;
     };
 
+    // 逐笔订单薄更新回调（在通知器的投递线程上按发布顺序调用，慢回调会使投递队列溢出而丢更新）
+    typedef std::function<void(const orderbook_t &)> OrderbookUpdateCallback;
+
+    // 合并订阅：只通知哪些交易对有变化，消费者再读取最新订单薄。
+    // 消费者处理不过来时多次变化合并为一次，不会积压。
+    class IOrderbookSubscription
+    {
+    public:
+        virtual ~IOrderbookSubscription() = default;
+        virtual uint64_t id() const = 0;
+        // 取出自上次调用以来有变化的交易对（每个最多出现一次），返回数量，不阻塞
+        virtual size_t poll(symbol_t *symbols, size_t max_count) = 0;
+        // 同 poll，没有变化时最多阻塞 timeout_ms 毫秒
+        virtual size_t wait(symbol_t *symbols, size_t max_count, int timeout_ms) = 0;
+        // 唤醒阻塞中的 wait（退订时自动调用）
+        virtual void close() = 0;
+    };
+
     // 订单薄管理器接口
     class IOrderbookManager
     {
@@ -351,11 +625,50 @@ namespace crypto_quant
         virtual double getSpread(symbol_t symbol) const = 0;
         virtual double getBidDepth(symbol_t symbol, int levels = 5) const = 0;
         virtual double getAskDepth(symbol_t symbol, int levels = 5) const = 0;
+        // 中间价 bps 基点范围内的累计数量
+        virtual double getDepthWithinBps(symbol_t symbol, double bps, bool bid) const = 0;
+        // 前 levels 档的成交量加权平均价
+        virtual double getVwap(symbol_t symbol, int levels, bool bid) const = 0;
+        // 市价吃掉 quantity 所需的成交金额（buy 为true时吃卖盘），流动性不足时只计算可成交部分
+        virtual double getCostToFill(symbol_t symbol, double quantity, bool buy,
+                                     double *filled_quantity = nullptr) const = 0;
         virtual uint64_t getTimestamp(symbol_t symbol) const = 0;
+        // 有买卖盘、价格为正且未被隔离
         virtual bool isValid(symbol_t symbol) const = 0;
+        // 批量查询盘口：每个交易对只读一次快照，结果依次写入 out[0..count)，
+        // 未知或尚无数据的交易对对应的条目清零（symbol 除外）。返回 valid 为1的条目数
+        virtual size_t getTopOfBook(const symbol_t *symbols, size_t count, top_of_book_t *out) const = 0;
+
+        // 增量深度：按更新ID把差分事件应用到常驻订单簿，检测到缺口时通过快照重新同步
+        virtual DepthDiffResult applyDepthDiff(const depth_diff_t &diff) = 0;
+        virtual void setSnapshotProvider(DepthSnapshotProvider provider) = 0;
+
+        // 完整性校验（始终开启）：交叉盘口、档位乱序、时间戳过期、更新ID缺口。
+        // 校验失败的交易对被隔离，并通过快照提供者重新同步，重新同步成功或收到合法的完整快照后解除
+        virtual bool isQuarantined(symbol_t symbol) const = 0;
+        virtual orderbook_integrity_stats_t getIntegrityStats() const = 0;
+
+        // 变更订阅，symbol 为 SYMBOL_INVALID 时订阅全部交易对
+        // 合并订阅适合仪表盘、风控等慢消费者；逐笔订阅经投递队列在投递线程上回调，适合策略等快消费者
+        virtual std::shared_ptr<IOrderbookSubscription> subscribeConflated(symbol_t symbol) = 0;
+        virtual uint64_t subscribeEveryUpdate(symbol_t symbol, OrderbookUpdateCallback callback) = 0;
+        // 返回时该订阅正在执行的回调已结束，之后不再回调（在回调内退订时只保证不再有新的回调）
+        virtual void unsubscribe(uint64_t subscription_id) = 0;
+        // 逐笔订阅各有独立的有界投递队列，回调慢于更新速度时只丢弃该订阅的更新；返回其丢弃数
+        virtual uint64_t droppedUpdates(uint64_t subscription_id) const = 0;
+
+        // 订单薄历史（回测、事后分析用），默认关闭；capacity 为保留的更新条数，0表示关闭
+        virtual bool setHistoryCapacity(symbol_t symbol, size_t capacity) = 0;
+        // 时间戳不晚于 timestamp 的最后一个订单薄，历史中没有时返回false
+        virtual bool getOrderbookAt(symbol_t symbol, uint64_t timestamp, orderbook_t &orderbook) const = 0;
+        // 按时间顺序遍历 [from, to] 内的历史订单薄，fn 返回false时停止，返回回调次数
+        virtual size_t forEachOrderbookInRange(symbol_t symbol, uint64_t from, uint64_t to,
+                                               const std::function<bool(const orderbook_t &)> &fn) const = 0;
     };
 
     // 市场数据提供者接口
+    class MarketDataRecorder;
+
     class IMarketDataFetcher
     {
     public:
@@ -366,6 +679,18 @@ namespace crypto_quant
         virtual void setApiKey(const std::string &api_key, const std::string &api_secret) = 0;
         virtual void setDataSources(bool use_binance, bool use_coingecko) = 0;
         virtual void setOrderbookCallback(std::function<void(const orderbook_t &)> callback) = 0;
+        // 设置后订阅增量深度流（@depth@100ms）代替部分深度快照流
+        virtual void setDepthDiffCallback(std::function<void(const depth_diff_t &)> callback) = 0;
+        // 逐笔/归集成交（订阅 MARKET_STREAM_TRADE / MARKET_STREAM_AGG_TRADE 的交易对）
+        virtual void setTradeCallback(std::function<void(const trade_t &)> callback) = 0;
+        // 通过 REST 获取深度快照
+        virtual bool fetchDepthSnapshot(symbol_t symbol, int limit, DepthSnapshot &snapshot) = 0;
+        // 运行中增减订阅（start 之后调用）；streams 为 market_stream_t 按位组合，
+        // 0 表示按已设置的回调选择（设置了增量回调时订阅增量深度，否则订阅部分深度快照；设置了成交回调时加上归集成交）
+        virtual int subscribe(symbol_t symbol, uint32_t streams) = 0;
+        virtual int unsubscribe(symbol_t symbol) = 0;
+        // 录制收到的行情（须在 start 之前设置，空指针表示不录制）
+        virtual void setRecorder(std::shared_ptr<MarketDataRecorder> recorder) = 0;
 
         virtual orderbook_t getOrderbook(symbol_t symbol) const = 0;
     };
@@ -377,6 +702,9 @@ namespace crypto_quant
         static std::shared_ptr<IStrategyEngine> createStrategyEngine();
         static std::shared_ptr<IOrderExecutor> createOrderExecutor();
         static std::shared_ptr<IOrderbookManager> createOrderbookManager();
+        static std::shared_ptr<IOrderbookManager> createFullDepthOrderbookManager();
+        // 按CPU核分片的订单薄管理器（写入异步，交易对多时使用）
+        static std::shared_ptr<IOrderbookManager> createShardedOrderbookManager();
         static std::shared_ptr<IMarketDataFetcher> createMarketDataFetcher();
 
         // 创建具体策略
@@ -0,0 +1,57 @@
+#ifndef DEPTH_KERNELS_H
+#define DEPTH_KERNELS_H
+
+#include <stdint.h>
+
+#include "crypto_quant.h"
+
+namespace crypto_quant {
+
+// 结构数组（SoA）布局的订单薄
+// 价格与数量分别连续存放并按32字节对齐，便于 SSE/AVX2 一次处理2/4档。
+// 档位数与 orderbook_t 相同，未使用的档位保持为0；核函数按块读取，不足一块的尾部逐档处理。
+struct alignas(32) orderbook_soa_t {
+    double bid_prices[ORDERBOOK_MAX_LEVELS];
+    double bid_quantities[ORDERBOOK_MAX_LEVELS];
+    double ask_prices[ORDERBOOK_MAX_LEVELS];
+    double ask_quantities[ORDERBOOK_MAX_LEVELS];
+    uint32_t bid_count;
+    uint32_t ask_count;
+};
+
+// 由 orderbook_t（AoS）转换为 SoA 布局
+void orderbookToSoa(const orderbook_t& orderbook, orderbook_soa_t& soa);
+
+// 深度核函数表（按CPU能力在运行时选择实现）
+// 所有核函数要求 prices / quantities 按价格由优到劣排列。
+struct DepthKernels {
+    // 指令集名称："avx2" / "sse2" / "scalar"
+    const char* isa;
+
+    // 前 n 档的累计数量
+    double (*cumulativeQuantity)(const double* quantities, uint32_t n);
+
+    // 价格不劣于 limit_price 的档位累计数量（买盘 price >= limit，卖盘 price <= limit）
+    double (*quantityWithinPrice)(const double* prices, const double* quantities, uint32_t n,
+                                  double limit_price, bool bid);
+
+    // 前 n 档的成交量加权平均价，无数量时返回0
+    double (*vwap)(const double* prices, const double* quantities, uint32_t n);
+
+    // 吃掉 target_quantity 需要的总成交金额；流动性不足时只计算可成交部分，
+    // 实际可成交数量写入 filled_quantity
+    double (*costToFill)(const double* prices, const double* quantities, uint32_t n,
+                         double target_quantity, double* filled_quantity);
+};
+
+// 当前CPU上可用的最优实现（首次调用时检测）
+const DepthKernels& depthKernels();
+
+// 指定实现，供基准和对比使用（不支持的指令集返回标量实现）
+const DepthKernels& scalarDepthKernels();
+const DepthKernels& sse2DepthKernels();
+const DepthKernels& avx2DepthKernels();
+
+} // namespace crypto_quant
+
+#endif // DEPTH_KERNELS_H
@@ -0,0 +1,122 @@
+#ifndef FEED_LATENCY_MONITOR_H
+#define FEED_LATENCY_MONITOR_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include <memory>
+
+#include "crypto_quant.h"
+
+namespace crypto_quant {
+
+// 延迟分位数摘要（纳秒）；分位数为所在桶的中点，相对误差不超过 1/64
+struct LatencySummary {
+    uint64_t count;
+    uint64_t min;
+    uint64_t max;
+    double mean;
+    uint64_t p50;
+    uint64_t p90;
+    uint64_t p99;
+    uint64_t p999;
+};
+
+// HDR 式对数线性直方图：每个2的幂区间分成32个等宽桶，64纳秒以下逐纳秒计数，
+// 上限约 2^41 纳秒（约36分钟），更大的值计入最后一个桶（max 仍精确）。
+// 记录只做几次 relaxed 原子操作，不加锁、不分配，任意线程可并发记录和读取。
+class LatencyHistogram {
+public:
+    static const uint32_t kLinearBuckets = 64;
+    static const uint32_t kSubBuckets = 32;
+    static const uint32_t kMaxExponent = 40;
+    static const uint32_t kBucketCount = kLinearBuckets + (kMaxExponent - 5) * kSubBuckets;
+
+    LatencyHistogram();
+
+    void record(uint64_t value_ns);
+    // 读取期间仍有记录时各字段可能相差几个样本
+    LatencySummary summary() const;
+    void reset();
+
+    static uint32_t bucketIndex(uint64_t value);
+    // 桶覆盖的最小值和宽度
+    static uint64_t bucketLow(uint32_t index);
+    static uint64_t bucketWidth(uint32_t index);
+
+private:
+    std::atomic<uint64_t> counts_[kBucketCount];
+    std::atomic<uint64_t> total_;
+    std::atomic<uint64_t> sum_;
+    std::atomic<uint64_t> min_;
+    std::atomic<uint64_t> max_;
+
+    LatencyHistogram(const LatencyHistogram&) = delete;
+    LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+};
+
+// 行情链路上的测量区段
+enum class LatencyStage {
+    EXCHANGE_TO_RECEIVE = 0,  // 交易所事件时间 E 到读出套接字（跨机器时钟，含时钟偏差，E 只有毫秒精度）
+    RECEIVE_TO_PARSE,         // 读出套接字到消息解析完成（含同一批读取中排在前面的消息）
+    PARSE_TO_CALLBACK,        // 解析完成（入队分发器）到处理线程调用策略回调（含分发队列等待）
+    STAGE_COUNT
+};
+
+// 消息所属的流，与 market_stream_t 的位一一对应
+enum class LatencyStream {
+    DEPTH = 0,
+    DEPTH_DIFF,
+    TRADE,
+    AGG_TRADE,
+    STREAM_COUNT
+};
+
+// 按（交易对，流，区段）统计的行情延迟
+// 每个交易对的每种流在第一次记录时分配一组直方图，之后记录路径无锁、不分配。
+// 时间戳均为系统时钟纳秒（Unix 纪元），与交易所事件时间可比较；为0的时间戳表示未知，该区段不记录。
+class FeedLatencyMonitor {
+public:
+    FeedLatencyMonitor();
+    ~FeedLatencyMonitor();
+
+    // 网络线程：一条被接受的消息的交易所事件时间（毫秒）、读出时间和解析完成时间
+    void recordFeed(symbol_t symbol, LatencyStream stream, uint64_t event_time_ms,
+                    uint64_t receive_ns, uint64_t parsed_ns);
+    // 处理线程：解析完成到调用回调
+    void recordCallback(symbol_t symbol, LatencyStream stream, uint64_t parsed_ns, uint64_t callback_ns);
+
+    // 没有样本时返回 false
+    bool getSummary(symbol_t symbol, LatencyStream stream, LatencyStage stage, LatencySummary& summary) const;
+    // 交易所事件时间晚于本地读出时间（本地时钟落后）而未计入直方图的消息数
+    uint64_t clockSkewCount() const { return clock_skew_.load(std::memory_order_relaxed); }
+    // 所有有样本的（交易对，流，区段）写入日志
+    void dump() const;
+    void reset();
+
+    static uint64_t nowNs();
+    static LatencyStream streamOf(const trade_t& trade) {
+        return trade.aggregated ? LatencyStream::AGG_TRADE : LatencyStream::TRADE;
+    }
+    static const char* streamName(LatencyStream stream);
+    static const char* stageName(LatencyStage stage);
+
+private:
+    struct StreamLatency {
+        LatencyHistogram stages[static_cast<size_t>(LatencyStage::STAGE_COUNT)];
+    };
+
+    StreamLatency* find(symbol_t symbol, LatencyStream stream) const;
+    StreamLatency* acquire(symbol_t symbol, LatencyStream stream);
+
+    // 按 symbol * STREAM_COUNT + stream 索引，首次记录时以 CAS 安装
+    std::unique_ptr<std::atomic<StreamLatency*>[]> streams_;
+    std::atomic<uint64_t> clock_skew_;
+
+    FeedLatencyMonitor(const FeedLatencyMonitor&) = delete;
+    FeedLatencyMonitor& operator=(const FeedLatencyMonitor&) = delete;
+};
+
+} // namespace crypto_quant
+
+#endif // FEED_LATENCY_MONITOR_H
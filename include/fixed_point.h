@@ -0,0 +1,79 @@
+#ifndef FIXED_POINT_H
+#define FIXED_POINT_H
+
+#include <stdint.h>
+#include <cstddef>
+#include <string>
+
+#include "crypto_quant.h"
+#include "utils/seqlock.h"
+#include "utils/chunked_array.h"
+
+namespace crypto_quant {
+
+// 交易对的定点数规格
+// 价格以 tick 为单位、数量以 lot 为单位保存为 int64：
+//   price    = price_ticks    * tick_units / 10^price_decimals
+//   quantity = quantity_lots  * lot_units  / 10^quantity_decimals
+// 例如 BTCUSDT 的 tick_size "0.01" 对应 price_decimals=2, tick_units=1。
+struct InstrumentSpec {
+    int price_decimals;
+    int64_t tick_units;
+    int quantity_decimals;
+    int64_t lot_units;
+
+    InstrumentSpec() : price_decimals(0), tick_units(0), quantity_decimals(0), lot_units(0) {}
+
+    bool valid() const { return tick_units > 0 && lot_units > 0; }
+    double tickSize() const;
+    double lotSize() const;
+};
+
+// 10的整数次幂（0~18），超出范围返回0
+int64_t pow10Int(int exponent);
+
+// 把十进制字符串精确解析为放大 10^decimals 倍的整数，多余的小数位四舍五入。
+// 不分配内存，输入无需以'\0'结尾。
+bool parseDecimalFixed(const char* begin, const char* end, int decimals, int64_t& out);
+
+// 快速十进制字符串转 double：有效数字不超过15位时用一次精确除法（结果正确舍入），
+// 否则回退到 strtod。不分配内存。
+bool parseDecimalDouble(const char* begin, const char* end, double& out);
+
+// 把放大 10^decimals 倍的整数格式化为十进制字符串，返回写入长度（不含'\0'）。
+// buf 至少需要32字节。
+size_t formatDecimalFixed(int64_t value, int decimals, char* buf);
+
+// 由 tick_size / lot_size 的十进制字符串构造规格（如 "0.01", "0.00001"）
+bool makeInstrumentSpec(const std::string& tick_size, const std::string& lot_size, InstrumentSpec& spec);
+
+// 交易对定点数规格注册表（可选，未注册的交易对继续使用 double 路径）
+// 规格一般在启动时设置；读取通过顺序锁无锁完成。
+class FixedPointRegistry {
+public:
+    static FixedPointRegistry& instance();
+
+    void setSpec(symbol_t symbol, const InstrumentSpec& spec);
+    bool getSpec(symbol_t symbol, InstrumentSpec& spec) const;
+
+    // double 与定点数互转（按 tick / lot 就近取整），未注册时返回false
+    bool priceToTicks(symbol_t symbol, double price, int64_t& ticks) const;
+    bool quantityToLots(symbol_t symbol, double quantity, int64_t& lots) const;
+    bool ticksToPrice(symbol_t symbol, int64_t ticks, double& price) const;
+    bool lotsToQuantity(symbol_t symbol, int64_t lots, double& quantity) const;
+
+private:
+    FixedPointRegistry();
+
+    struct SpecEntry {
+        bool present;
+        InstrumentSpec spec;
+    };
+
+    // 按交易对ID索引，设置规格时按块分配
+    ChunkedArray<Seqlock<SpecEntry> > specs_;
+};
+
+} // namespace crypto_quant
+
+#endif // FIXED_POINT_H
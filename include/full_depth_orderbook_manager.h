@@ -0,0 +1,187 @@
+#ifndef FULL_DEPTH_ORDERBOOK_MANAGER_H
+#define FULL_DEPTH_ORDERBOOK_MANAGER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "crypto_quant.h"
+#include "orderbook_notifier.h"
+#include "orderbook_history.h"
+#include "orderbook_validator.h"
+#include "price_ladder.h"
+#include "utils/seqlock.h"
+#include "utils/chunked_array.h"
+
+namespace crypto_quant {
+
+// 全深度订单薄管理器
+// 每个交易对的买卖盘各用一个按tick索引的 PriceLadder 保存完整深度（可达数千档），
+// 20档的 orderbook_t 只在 getOrderbook 时按需生成。
+// 最优价等高频查询走顺序锁保护的盘口摘要，无锁读取；深度类查询在订单薄互斥锁下遍历阶梯。
+// 阶梯的 tick 取自定点规格注册表（config.json 的 market_data.instruments，或 FixedPointRegistry::setSpec），
+// 也可用 setTickSize 指定；tick 未知的交易对拒绝写入，不按猜测的 tick 建阶梯。
+// 出现缺口或完整性问题时快照由后台线程获取，期间到达的增量缓存起来，快照到达后按序重放
+// （装入快照后的变更通知在后台线程上发出）。
+class FullDepthOrderbookManager : public IOrderbookManager {
+public:
+    // 重新同步期间最多缓存的增量数，超出后清空缓存，快照重放时按缺口再次同步
+    static const size_t kMaxBufferedDiffs = 4096;
+
+    FullDepthOrderbookManager();
+    ~FullDepthOrderbookManager();
+
+    bool initialize() override;
+    void cleanup() override;
+    void updateOrderbook(const orderbook_t& orderbook) override;
+    orderbook_t getOrderbook(symbol_t symbol) const override;
+    double getBestBid(symbol_t symbol) const override;
+    double getBestAsk(symbol_t symbol) const override;
+    double getMidPrice(symbol_t symbol) const override;
+    double getSpread(symbol_t symbol) const override;
+    double getBidDepth(symbol_t symbol, int levels = 5) const override;
+    double getAskDepth(symbol_t symbol, int levels = 5) const override;
+    double getDepthWithinBps(symbol_t symbol, double bps, bool bid) const override;
+    double getVwap(symbol_t symbol, int levels, bool bid) const override;
+    double getCostToFill(symbol_t symbol, double quantity, bool buy,
+                         double* filled_quantity = nullptr) const override;
+    uint64_t getTimestamp(symbol_t symbol) const override;
+    bool isValid(symbol_t symbol) const override;
+    size_t getTopOfBook(const symbol_t* symbols, size_t count, top_of_book_t* out) const override;
+    DepthDiffResult applyDepthDiff(const depth_diff_t& diff) override;
+    void setSnapshotProvider(DepthSnapshotProvider provider) override;
+    std::shared_ptr<IOrderbookSubscription> subscribeConflated(symbol_t symbol) override;
+    uint64_t subscribeEveryUpdate(symbol_t symbol, OrderbookUpdateCallback callback) override;
+    void unsubscribe(uint64_t subscription_id) override;
+    uint64_t droppedUpdates(uint64_t subscription_id) const override;
+    bool isQuarantined(symbol_t symbol) const override;
+    orderbook_integrity_stats_t getIntegrityStats() const override;
+    void setValidatorConfig(const OrderbookValidatorConfig& config) { validator_.setConfig(config); }
+    bool setHistoryCapacity(symbol_t symbol, size_t capacity) override;
+    bool getOrderbookAt(symbol_t symbol, uint64_t timestamp, orderbook_t& orderbook) const override;
+    size_t forEachOrderbookInRange(symbol_t symbol, uint64_t from, uint64_t to,
+                                   const std::function<bool(const orderbook_t&)>& fn) const override;
+
+    // 设置交易对的最小价格变动单位（覆盖定点规格），会清空该交易对的订单薄
+    void setTickSize(symbol_t symbol, double tick_size);
+    // 某一侧的档位总数
+    size_t getLevelCount(symbol_t symbol, bool bid) const;
+    // 按由优到劣顺序导出最多 max_levels 档，返回实际档数
+    size_t getLevels(symbol_t symbol, bool bid, price_level_t* out, size_t max_levels) const;
+
+private:
+    // 盘口摘要（顺序锁发布，供无锁读取）
+    struct BookTop {
+        double bid_price;
+        double bid_quantity;
+        double ask_price;
+        double ask_quantity;
+        uint64_t timestamp;
+        uint64_t last_update_id;
+    };
+
+    struct BufferedDiff {
+        depth_diff_t diff;
+        std::vector<price_level_t> bids;
+        std::vector<price_level_t> asks;
+    };
+
+    struct FullDepthBook {
+        mutable std::mutex mutex;
+        PriceLadder bids;
+        PriceLadder asks;
+        // 0 表示尚不知道 tick
+        double tick_size;
+        // tick 未知时只报一次错
+        bool tick_missing_logged;
+        uint64_t last_update_id;
+        uint64_t timestamp;
+        // 已请求重新同步、快照尚未装入
+        bool syncing;
+        // 快照装入后尚未有增量应用，下一个应用的增量返回 RESYNCED
+        bool resynced;
+        std::vector<BufferedDiff> buffered;
+        // 上次请求快照的时间（毫秒），用于限制 REST 请求频率
+        std::atomic<uint64_t> last_resync_ms;
+        Seqlock<BookTop> top;
+        // 历史环（记录20档订单薄），未开启时为nullptr；对象创建后不释放
+        std::atomic<OrderbookHistory*> history;
+        std::unique_ptr<OrderbookHistory> history_storage;
+        // 完整性校验失败后隔离，重新同步成功或收到合法完整快照后解除
+        std::atomic<bool> quarantined;
+
+        FullDepthBook()
+            : bids(true), asks(false), tick_size(0.0), tick_missing_logged(false),
+              last_update_id(0), timestamp(0), syncing(false), resynced(false),
+              last_resync_ms(0), history(nullptr),
+              quarantined(false) {}
+    };
+
+    // 最小重新同步间隔（毫秒）
+    static const uint64_t kMinResyncIntervalMs = 1000;
+
+    // 订单薄自带同步（互斥锁/顺序锁），const 查询也需要加锁。
+    // 每个订单薄的阶梯窗口较大，按交易对逐个分配（块大小为1）
+    mutable ChunkedArray<FullDepthBook, 1> books_;
+    std::mutex provider_mutex_;
+    DepthSnapshotProvider snapshot_provider_;
+    // 变更订阅
+    OrderbookNotifier notifier_;
+    // 串行化历史容量设置
+    std::mutex history_mutex_;
+    // 完整性校验（阶梯保证档位有序，只检查盘口和时间戳/更新ID）
+    OrderbookValidator validator_;
+
+    // 后台重新同步线程：按请求顺序获取快照，首次请求时启动
+    std::mutex resync_mutex_;
+    std::condition_variable resync_cv_;
+    std::deque<symbol_t> resync_queue_;
+    std::thread resync_thread_;
+    bool resync_running_;
+
+    // 查找已分配的订单薄，未写入过的交易对返回nullptr
+    FullDepthBook* findBook(symbol_t symbol) const;
+    // 写入用：未注册的交易对返回nullptr，已注册但尚未分配时分配
+    FullDepthBook* findOrCreateBook(symbol_t symbol);
+    // 在持有订单薄锁时确定 tick（尚未设置时查定点规格注册表），tick 未知返回false
+    static bool resolveTickSize(symbol_t symbol, FullDepthBook& book);
+    // 在持有订单薄锁时重新发布盘口摘要
+    static void publishTop(FullDepthBook& book);
+    // 在持有订单薄锁时把一组档位写入阶梯
+    static void applyLevels(FullDepthBook& book, PriceLadder& ladder,
+                            const price_level_t* levels, size_t count);
+    static double sumDepth(const PriceLadder& ladder, int levels);
+    // 在持有订单薄锁时导出档位
+    static size_t getLevelsLocked(const FullDepthBook& book, const PriceLadder& ladder,
+                                  price_level_t* out, size_t max_levels);
+    // 通过快照提供者重建阶梯并重放缓存的增量（后台线程调用）
+    void resync(symbol_t symbol, FullDepthBook& book);
+    // 在持有订单薄锁时调用：标记同步中并交给后台线程，已在同步中时不重复请求
+    void requestResync(symbol_t symbol, FullDepthBook& book);
+    void enqueueResync(symbol_t symbol);
+    void runResync();
+    void stopResync();
+    // 以下在持有订单薄锁时调用
+    static void bufferDiff(FullDepthBook& book, const depth_diff_t& diff);
+    static void mergeDiff(FullDepthBook& book, const depth_diff_t& diff);
+    // 按序重放缓存的增量，遇到缺口时保留剩余部分并返回false
+    static bool replayBuffered(FullDepthBook& book);
+    // 在持有订单薄锁时校验刚发布的盘口
+    OrderbookIntegrityIssue checkTop(const FullDepthBook& book, uint64_t previous_timestamp,
+                                     uint64_t previous_update_id, uint64_t now);
+    bool hasSnapshotProvider();
+    // 在持有订单薄锁时调用：根据校验结果隔离/解除隔离；隔离中的交易对请求重新同步
+    void handleIntegrity(symbol_t symbol, FullDepthBook& book, OrderbookIntegrityIssue issue,
+                         bool full_snapshot);
+    void quarantine(symbol_t symbol, FullDepthBook& book, OrderbookIntegrityIssue issue);
+    void recover(symbol_t symbol, FullDepthBook& book);
+    // 发布后记录历史并通知订阅者，调用时不能持有订单薄锁
+    void notifyChanged(symbol_t symbol);
+};
+
+} // namespace crypto_quant
+
+#endif // FULL_DEPTH_ORDERBOOK_MANAGER_H
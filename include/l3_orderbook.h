@@ -0,0 +1,148 @@
+#ifndef L3_ORDERBOOK_H
+#define L3_ORDERBOOK_H
+
+#include <stdint.h>
+#include <cstddef>
+
+#include "crypto_quant.h"
+#include "price_ladder.h"
+#include "utils/index_pool.h"
+#include "utils/u64_hash_map.h"
+
+namespace crypto_quant {
+
+// 逐笔委托事件类型
+typedef enum {
+    L3_EVENT_ADD = 0,   // 新增委托
+    L3_EVENT_MODIFY,    // 修改价格/数量
+    L3_EVENT_CANCEL,    // 撤单
+    L3_EVENT_EXECUTE,   // 成交（quantity 为本次成交量）
+    L3_EVENT_CLEAR      // 清空整个订单薄（重连、快照前）
+} l3_event_type_t;
+
+// 逐笔委托事件（L3）
+typedef struct {
+    symbol_t symbol;
+    // l3_event_type_t
+    uint32_t type;
+    uint64_t order_id;
+    // order_side_t，仅 ADD 需要
+    uint32_t side;
+    double price;
+    double quantity;
+    uint64_t timestamp;
+} l3_event_t;
+
+// 单个交易对的逐笔委托订单薄（L3）
+// 委托节点来自对象池，每个价格档位是一条按到达顺序排列的侵入式双向链表，
+// 订单ID通过开放寻址哈希表定位节点，新增/修改/撤单/成交都是O(1)。
+// 各档位的合计数量同步写入买卖两个 PriceLadder，聚合的20档 orderbook_t 由阶梯导出。
+// 非线程安全：只能在单个写线程上使用。
+class L3Orderbook {
+public:
+    // tick_size 不为正时订单薄没有 tick，设置之前所有带价格的事件都被拒绝
+    explicit L3Orderbook(symbol_t symbol = SYMBOL_INVALID, double tick_size = 0.0);
+
+    symbol_t symbol() const { return symbol_; }
+    double tickSize() const { return tick_size_; }
+    bool hasTickSize() const { return tick_size_ > 0.0; }
+    // 修改 tick 会清空订单薄
+    void setTickSize(double tick_size);
+
+    // 订单ID重复或参数非法时返回false
+    bool add(uint64_t order_id, order_side_t side, double price, double quantity, uint64_t timestamp);
+    // 价格不变且数量减少时保留排队位置，否则移到新价格档位的队尾
+    bool modify(uint64_t order_id, double price, double quantity, uint64_t timestamp);
+    bool cancel(uint64_t order_id);
+    // 成交 quantity，剩余为0时移除委托
+    bool execute(uint64_t order_id, double quantity, uint64_t timestamp);
+    bool apply(const l3_event_t& event);
+    void clear();
+
+    size_t orderCount() const { return orders_.size(); }
+    size_t levelCount(order_side_t side) const;
+    double bestPrice(order_side_t side) const;
+    // 某价格档位的委托数和合计数量
+    size_t ordersAtPrice(order_side_t side, double price, double* total_quantity = nullptr) const;
+    // 委托前方排队的数量（同价格档位中更早到达的委托数量之和），委托不存在时返回-1
+    double queueAhead(uint64_t order_id) const;
+    bool getOrder(uint64_t order_id, order_side_t& side, double& price, double& quantity) const;
+    // 按到达顺序遍历某价格档位的委托，fn(uint64_t order_id, double quantity, uint64_t timestamp) 返回false时停止
+    template <typename Fn>
+    void forEachOrderAtPrice(order_side_t side, double price, Fn fn) const;
+
+    // 导出聚合后的前20档（时间戳取档位最近一次变化的时间）
+    void toOrderbook(orderbook_t& orderbook) const;
+    uint64_t lastTimestamp() const { return last_timestamp_; }
+
+private:
+    static const uint32_t kNull = IndexPool<int>::kNull;
+
+    struct OrderNode {
+        uint64_t order_id;
+        double quantity;
+        uint64_t timestamp;
+        uint32_t level;
+        uint32_t prev;
+        uint32_t next;
+    };
+
+    struct Level {
+        int64_t tick;
+        double quantity;
+        uint64_t timestamp;
+        uint32_t head;
+        uint32_t tail;
+        uint32_t order_count;
+        uint32_t side;
+    };
+
+    static uint64_t levelKey(uint32_t side, int64_t tick) {
+        return (static_cast<uint64_t>(tick) << 1) | side;
+    }
+    bool toTick(double price, int64_t& tick) const;
+    PriceLadder& ladder(uint32_t side) { return side == ORDER_SIDE_BUY ? bids_ : asks_; }
+    const PriceLadder& ladder(uint32_t side) const { return side == ORDER_SIDE_BUY ? bids_ : asks_; }
+    const Level* findLevel(uint32_t side, int64_t tick) const;
+
+    // 把节点挂到档位队尾（档位不存在时创建）
+    void link(uint32_t node_index, uint32_t side, int64_t tick, uint64_t timestamp);
+    // 从档位摘下节点（档位空时删除），不释放节点
+    void unlink(uint32_t node_index, uint64_t timestamp);
+    // 同步档位合计数量到阶梯
+    void publishLevel(Level& level);
+
+    symbol_t symbol_;
+    double tick_size_;
+    IndexPool<OrderNode> nodes_;
+    IndexPool<Level> levels_;
+    // 订单ID -> 节点下标
+    U64HashMap<uint32_t> orders_;
+    // (tick, 方向) -> 档位下标
+    U64HashMap<uint32_t> level_index_;
+    PriceLadder bids_;
+    PriceLadder asks_;
+    uint64_t last_timestamp_;
+};
+
+template <typename Fn>
+void L3Orderbook::forEachOrderAtPrice(order_side_t side, double price, Fn fn) const {
+    int64_t tick;
+    if (!toTick(price, tick)) {
+        return;
+    }
+    const Level* level = findLevel(side, tick);
+    if (!level) {
+        return;
+    }
+    for (uint32_t index = level->head; index != kNull; index = nodes_[index].next) {
+        const OrderNode& node = nodes_[index];
+        if (!fn(node.order_id, node.quantity, node.timestamp)) {
+            return;
+        }
+    }
+}
+
+} // namespace crypto_quant
+
+#endif // L3_ORDERBOOK_H
@@ -0,0 +1,75 @@
+#ifndef L3_ORDERBOOK_MANAGER_H
+#define L3_ORDERBOOK_MANAGER_H
+
+#include <stdint.h>
+#include <memory>
+#include <vector>
+
+#include "crypto_quant.h"
+#include "l3_orderbook.h"
+
+namespace crypto_quant {
+
+// 逐笔委托订单薄管理器
+// 与 OrderbookManager 并列使用：逐笔事件在这里维护 L3 订单薄，
+// 聚合出的20档 orderbook_t 通过 updateOrderbook 发布到目标 IOrderbookManager，
+// 现有的策略、订阅者照常从目标管理器读取。
+// 单写线程使用；L3 明细查询（getBook）也只能在写线程上进行。
+class L3OrderbookManager {
+public:
+    explicit L3OrderbookManager(std::shared_ptr<IOrderbookManager> target = nullptr);
+
+    // 聚合订单薄的发布目标，为空时只维护 L3 订单薄
+    void setTarget(std::shared_ptr<IOrderbookManager> target) { target_ = target; }
+    // 设置交易对的最小价格变动单位，会清空该交易对的订单薄。
+    // 未设置时取定点规格；两者都没有时拒绝该交易对的事件并记录错误，不猜测 tick
+    bool setTickSize(symbol_t symbol, double tick_size);
+
+    // 应用单个事件并立即发布聚合订单薄
+    bool apply(const l3_event_t& event);
+    // 批量应用事件，每个有变化的交易对只在最后发布一次；返回成功应用的事件数
+    size_t applyBatch(const l3_event_t* events, size_t count);
+    // 发布交易对当前的聚合订单薄
+    bool publish(symbol_t symbol);
+
+    // 交易对的 L3 订单薄，尚未收到事件时返回nullptr
+    L3Orderbook* getBook(symbol_t symbol);
+    const L3Orderbook* getBook(symbol_t symbol) const;
+    orderbook_t getOrderbook(symbol_t symbol) const;
+
+    uint64_t appliedCount() const { return applied_; }
+    // 订单ID重复、未知订单等被拒绝的事件数
+    uint64_t rejectedCount() const { return rejected_; }
+
+private:
+    struct BookEntry {
+        L3Orderbook book;
+        // 发布到聚合订单薄的 last_update_id（按交易对递增的事件序号）
+        uint64_t sequence;
+        bool dirty;
+        // 缺少 tick 的错误只记录一次
+        bool tick_missing_logged;
+
+        BookEntry(symbol_t symbol, double tick_size)
+            : book(symbol, tick_size), sequence(0), dirty(false), tick_missing_logged(false) {}
+    };
+
+    BookEntry* findOrCreate(symbol_t symbol);
+    // 订单薄还没有 tick 时从定点规格补上，仍没有则返回false
+    bool resolveTickSize(BookEntry& entry);
+    bool applyEvent(const l3_event_t& event, BookEntry*& entry);
+    void publishEntry(BookEntry& entry);
+
+    std::shared_ptr<IOrderbookManager> target_;
+    std::vector<std::unique_ptr<BookEntry> > books_;
+    std::vector<symbol_t> touched_;
+    uint64_t applied_;
+    uint64_t rejected_;
+
+    L3OrderbookManager(const L3OrderbookManager&) = delete;
+    L3OrderbookManager& operator=(const L3OrderbookManager&) = delete;
+};
+
+} // namespace crypto_quant
+
+#endif // L3_ORDERBOOK_MANAGER_H
@@ -0,0 +1,153 @@
+#ifndef MARKET_DATA_DISPATCHER_H
+#define MARKET_DATA_DISPATCHER_H
+
+#include <stdint.h>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "crypto_quant.h"
+#include "feed_latency_monitor.h"
+#include "utils/spsc_ring.h"
+
+namespace crypto_quant {
+
+// 处理线程等待新事件的方式
+enum class DispatchWaitMode {
+    BUSY_POLL,  // 一直自旋轮询，延迟最低，独占一个CPU核
+    BLOCKING    // 短暂自旋后在条件变量上等待，由生产者唤醒
+};
+
+// 队列满时生产者（网络线程）的处理方式
+enum class DispatchOverflowPolicy {
+    DROP_NEWEST,  // 丢弃新事件并计数；丢弃的增量深度会被订单薄的更新ID检查发现并重新同步
+    BLOCK         // 自旋等待处理线程腾出位置（背压传到网络线程，不丢数据）
+};
+
+// 行情分发配置
+struct MarketDataDispatcherConfig {
+    // 队列长度（向上取整为2的幂）
+    size_t capacity;
+    DispatchWaitMode wait_mode;
+    DispatchOverflowPolicy overflow_policy;
+    // 阻塞模式下进入等待前的自旋次数
+    uint32_t spin_iterations;
+
+    MarketDataDispatcherConfig()
+        : capacity(4096), wait_mode(DispatchWaitMode::BLOCKING),
+          overflow_policy(DispatchOverflowPolicy::DROP_NEWEST), spin_iterations(256) {}
+};
+
+// 分发统计（计数器单调递增，任意线程可读）
+struct MarketDataDispatcherStats {
+    uint64_t published;
+    uint64_t processed;
+    // 队列满被丢弃的事件（DROP_NEWEST）
+    uint64_t dropped;
+    // 生产者遇到队列满的次数，以及 BLOCK 策略下累计等待的时间（纳秒）
+    uint64_t backpressure;
+    uint64_t backpressure_wait_ns;
+    // 队列最高水位
+    uint64_t max_depth;
+    // 档位超出内联容量、需要在生产者线程上分配内存的差分
+    uint64_t overflow_allocations;
+    // 阻塞模式下处理线程被唤醒的次数
+    uint64_t wakeups;
+};
+
+// 行情分发器：网络线程与行情处理线程之间的单生产者单消费者队列
+// 网络线程的回调只把订单薄/增量深度/成交拷进环形队列就返回，不会被慢的下游拖住读套接字；
+// 专用处理线程按到达顺序取出事件调用处理函数。
+// publish 必须始终在同一个线程上调用（如 WebSocket 事件循环线程）；处理函数在处理线程上调用。
+// 停止时处理线程先处理完队列中已有的事件再退出。
+class MarketDataDispatcher {
+public:
+    explicit MarketDataDispatcher(const MarketDataDispatcherConfig& config = MarketDataDispatcherConfig());
+    ~MarketDataDispatcher();
+
+    // 处理函数须在 start 之前设置
+    void setOrderbookHandler(std::function<void(const orderbook_t&)> handler);
+    void setDepthDiffHandler(std::function<void(const depth_diff_t&)> handler);
+    void setTradeHandler(std::function<void(const trade_t&)> handler);
+    // 统计入队到调用处理函数的延迟（须在 start 之前设置）；publish 在解析回调中调用时即解析完成到策略回调
+    void setLatencyMonitor(std::shared_ptr<FeedLatencyMonitor> monitor);
+
+    bool start();
+    void stop();
+    bool isRunning() const { return running_.load(std::memory_order_acquire); }
+
+    // 生产者线程调用；事件被丢弃或分发器未运行时返回 false
+    bool publish(const orderbook_t& orderbook);
+    bool publish(const depth_diff_t& diff);
+    bool publish(const trade_t& trade);
+
+    MarketDataDispatcherStats getStats() const;
+    // 当前积压的事件数（近似）
+    size_t backlog() const { return ring_.sizeApprox(); }
+
+private:
+    // 差分内联保存的档位数（两侧合计），更多的档位放到堆上（由处理线程释放）
+    static const size_t kInlineLevels = 64;
+
+    enum EventType {
+        EVENT_ORDERBOOK = 0,
+        EVENT_DEPTH_DIFF = 1,
+        EVENT_TRADE = 2
+    };
+
+    // 队列元素：完整订单薄、自带档位的差分或成交
+    struct Event {
+        uint32_t type;
+        // 入队时间（系统时钟纳秒），未统计延迟时为0
+        uint64_t publish_ns;
+        // 差分头部，bids/asks 指针在处理线程上按 levels/overflow 重新设置
+        depth_diff_t diff;
+        price_level_t* overflow;
+        union {
+            orderbook_t orderbook;
+            price_level_t levels[kInlineLevels];
+            trade_t trade;
+        };
+    };
+
+    template <typename Fill>
+    bool push(Fill fill);
+    void run();
+    void process(Event& event);
+    void recordLatency(const Event& event);
+
+    MarketDataDispatcherConfig config_;
+    std::function<void(const orderbook_t&)> orderbook_handler_;
+    std::function<void(const depth_diff_t&)> diff_handler_;
+    std::function<void(const trade_t&)> trade_handler_;
+    std::shared_ptr<FeedLatencyMonitor> latency_;
+    SpscRing<Event> ring_;
+    std::atomic<bool> running_;
+    std::thread thread_;
+
+    // 阻塞模式：处理线程等待前置位 waiting_，生产者入队后看到置位才加锁唤醒
+    std::mutex wait_mutex_;
+    std::condition_variable wait_cv_;
+    std::atomic<bool> waiting_;
+
+    // 生产者线程写
+    std::atomic<uint64_t> published_;
+    std::atomic<uint64_t> dropped_;
+    std::atomic<uint64_t> backpressure_;
+    std::atomic<uint64_t> backpressure_wait_ns_;
+    std::atomic<uint64_t> max_depth_;
+    std::atomic<uint64_t> overflow_allocations_;
+    // 处理线程写
+    std::atomic<uint64_t> processed_;
+    std::atomic<uint64_t> wakeups_;
+
+    MarketDataDispatcher(const MarketDataDispatcher&) = delete;
+    MarketDataDispatcher& operator=(const MarketDataDispatcher&) = delete;
+};
+
+} // namespace crypto_quant
+
+#endif // MARKET_DATA_DISPATCHER_H
@@ -3,52 +3,242 @@
 
 #include <string>
 #include <atomic>
+#include <condition_variable>
 #include <mutex>
 #include <thread>
 #include <functional>
 #include <memory>
+#include <vector>
 
 #include "crypto_quant.h"
 #include "websocket_client.h"
+#include "market_data_recorder.h"
+#include "feed_latency_monitor.h"
+#include "synthetic_feed_generator.h"
 
 namespace crypto_quant {
 
+// 组合流订阅配置
+struct MarketDataFetcherConfig {
+    // 组合流端点，连接后通过 SUBSCRIBE / UNSUBSCRIBE 请求增减流
+    std::string stream_url;
+    // 最多同时保持的连接数；交易对少于该值时每个交易对先各占一个连接
+    uint32_t max_connections;
+    // 每个连接最多的流数量（币安上限1024）
+    uint32_t max_streams_per_connection;
+    // 每个连接两次订阅请求的最小间隔（毫秒），币安每连接每秒最多接收5条控制消息
+    uint32_t request_interval_ms;
+    // 按消息速率重新均衡的检查周期（毫秒），每次最多迁移一个交易对
+    uint32_t rebalance_interval_ms;
+    // 最忙与最闲连接的速率差超过最忙连接速率的该比例时才迁移
+    double rebalance_threshold;
+    // 每个连接的并行线路数：各线路订阅完全相同的流，按更新ID仲裁，先到的采用、后到的重复丢弃
+    // （1 表示不做冗余；上限4）
+    uint32_t redundancy;
+
+    MarketDataFetcherConfig()
+        : stream_url("wss://stream.binance.com:9443/stream"), max_connections(4),
+          max_streams_per_connection(1024), request_interval_ms(250),
+          rebalance_interval_ms(10000), rebalance_threshold(0.25), redundancy(1) {}
+};
+
+// 单个组合流连接的状态
+struct StreamConnectionStats {
+    bool connected;
+    uint32_t symbols;
+    uint32_t streams;
+    // 最近一个均衡周期内的消息速率（条/秒）
+    double message_rate;
+    uint64_t reconnects;
+    // 已连接的冗余线路数
+    uint32_t lines_connected;
+};
+
+// 冗余线路的仲裁统计（同一线路序号在所有连接上的合计，计数器单调递增）
+// 只统计带更新ID的消息；部分深度快照是采样推送，不计漏收
+struct FeedLineStats {
+    uint32_t line;
+    // 归属连接在该线路上收到的消息
+    uint64_t messages;
+    // 先于其他线路送达而被采用的，以及其他线路已送达而被丢弃的
+    uint64_t wins;
+    uint64_t duplicates;
+    // 该线路上更新ID不连续的次数（本线路漏收，其他线路可能补上）
+    uint64_t gaps;
+    double win_rate;
+};
+
 // 统一的市场数据获取器实现类
+// 所有交易对共用一个 WebSocket 事件循环线程和少量组合流连接：每个交易对的流归属一个连接，
+// 订阅变化批量合并成 SUBSCRIBE / UNSUBSCRIBE 请求，按间隔限速发出；连接重连后自动重新订阅。
+// 维护线程定期统计各交易对的消息速率，把交易对从最忙的连接迁移到最闲的连接。
+// 迁移时先在新连接订阅，新连接收到该交易对的第一条消息后切换归属，再从旧连接退订，期间旧连接的重复消息被丢弃
+// （切换那一刻新旧连接可能各送达同一更新，增量深度按更新ID去重，由订单薄管理器忽略）。
+// redundancy 大于1时每个连接由多条并行线路组成，同一消息先到的线路胜出，下游只看到一份；
+// 仲裁状态只在事件循环线程上访问，不加锁。
+// 线程数（事件循环 + 维护线程）和连接数不随交易对数量增长。
 class MarketDataFetcher : public IMarketDataFetcher {
 private:
+    // 单个交易对的订阅状态（受 subscription_mutex_ 保护）
+    struct Subscription {
+        // 已订阅的流（market_stream_t 组合），0 表示未订阅
+        uint32_t streams;
+        // 归属连接，迁移中时为迁出的连接
+        int connection;
+        // 迁移目标连接，-1 表示不在迁移中
+        int moving_to;
+        uint64_t move_started_ms;
+        uint64_t last_message_count;
+        // 消息速率（条/秒，指数平滑）
+        double message_rate;
+    };
+
+    // 连接的一条线路：独立的 WebSocket 连接，各自限速发送订阅请求、断线重连
+    struct StreamLine {
+        std::unique_ptr<WebSocketClient> client;
+        bool open;
+        uint64_t last_request_ms;
+        // 尚未发出的订阅变更（流名）
+        std::vector<std::string> pending_subscribe;
+        std::vector<std::string> pending_unsubscribe;
+    };
+
+    // 单个组合流连接（受 subscription_mutex_ 保护），所有线路订阅同一组流
+    struct StreamConnection {
+        std::vector<StreamLine> lines;
+        uint32_t streams;
+
+        bool isOpen() const {
+            for (size_t i = 0; i < lines.size(); ++i) {
+                if (lines[i].open) {
+                    return true;
+                }
+            }
+            return false;
+        }
+    };
+
+    // 仲裁按流分别记录更新ID
+    enum ArbitratedStream {
+        ARBITRATED_DEPTH = 0,
+        ARBITRATED_DEPTH_DIFF,
+        ARBITRATED_TRADE,
+        ARBITRATED_AGG_TRADE,
+        ARBITRATED_STREAM_COUNT
+    };
+
+    struct LineCounters {
+        std::atomic<uint64_t> messages;
+        std::atomic<uint64_t> wins;
+        std::atomic<uint64_t> duplicates;
+        std::atomic<uint64_t> gaps;
+    };
+
+    MarketDataFetcherConfig config_;
     std::function<void(const orderbook_t&)> orderbook_callback;
+    std::function<void(const depth_diff_t&)> depth_diff_callback;
+    std::function<void(const trade_t&)> trade_callback;
+    // 行情录制：仲裁胜出的消息录制原始负载和解析结果，冗余线路的重复消息不录制
+    std::shared_ptr<MarketDataRecorder> recorder_;
+    // 行情延迟统计：归属连接接受的消息记录交易所到读出、读出到解析两段
+    std::shared_ptr<FeedLatencyMonitor> latency_;
     std::atomic<bool> is_running;
     std::string api_key;
     std::string api_secret;
     std::atomic<bool> use_binance;
     std::atomic<bool> use_coingecko;
     mutable std::mutex mutex;
+    // 没有可用连接时的备用合成行情（受 mutex 保护）
+    mutable SyntheticFeedGenerator fallback_feed_;
+    // 维护线程：发送订阅请求、均衡负载，没有已打开的连接时推送模拟数据
     std::thread data_thread;
-    symbol_t current_symbol;
-    
-    // WebSocket 客户端
-    std::unique_ptr<WebSocketClient> websocket_client_;
+    std::condition_variable data_cv;
+
+    // 所有连接共用的事件循环
+    std::shared_ptr<WebSocketEventLoop> event_loop_;
+    mutable std::mutex subscription_mutex_;
+    std::vector<std::unique_ptr<StreamConnection>> connections_;
+    std::vector<Subscription> subscriptions_;
+    // 已订阅的交易对列表
+    std::vector<symbol_t> subscribed_;
+    std::atomic<uint64_t> next_request_id_;
+    uint64_t last_rebalance_ms_;
+
+    // 以下按 symbol_t 索引，事件循环线程无锁访问
+    // 消息路由：低16位为归属连接+1，高16位为迁移目标连接+1，0 表示未订阅
+    std::unique_ptr<std::atomic<uint32_t>[]> routes_;
+    // 已接受的消息数（用于计算速率）
+    std::unique_ptr<std::atomic<uint64_t>[]> message_counts_;
+    // 冗余线路仲裁（事件循环线程访问），按 symbol * ARBITRATED_STREAM_COUNT + 流 索引：
+    // 已采用的最大更新ID，以及每条线路收到的最大更新ID（线路 * kMaxSymbols * ARBITRATED_STREAM_COUNT 偏移）
+    std::unique_ptr<uint64_t[]> accepted_ids_;
+    std::unique_ptr<uint64_t[]> line_ids_;
+    std::unique_ptr<LineCounters[]> line_counters_;
+    // 所有线路都漏收的次数（采用的消息之间更新ID不连续）
+    std::atomic<uint64_t> arbitrated_gaps_;
 
 public:
-    MarketDataFetcher();
+    explicit MarketDataFetcher(const MarketDataFetcherConfig& config = MarketDataFetcherConfig());
     ~MarketDataFetcher();
     bool initialize() override;
+    // 启动事件循环和维护线程并订阅 symbol；已在运行时等同于 subscribe(symbol, 0)
     int start(symbol_t symbol) override;
     void stop() override;
     void setApiKey(const std::string& api_key, const std::string& api_secret) override;
     void setDataSources(bool use_binance, bool use_coingecko) override;
+    // 回调都在事件循环线程上调用（没有打开的线路时的模拟数据也投递到该线程），
+    // 可直接接单生产者的 MarketDataDispatcher::publish；未启用事件循环时在维护线程上调用
     void setOrderbookCallback(std::function<void(const orderbook_t&)> callback) override;
+    void setDepthDiffCallback(std::function<void(const depth_diff_t&)> callback) override;
+    void setTradeCallback(std::function<void(const trade_t&)> callback) override;
+    bool fetchDepthSnapshot(symbol_t symbol, int limit, DepthSnapshot& snapshot) override;
     orderbook_t getOrderbook(symbol_t symbol) const override;
+    int subscribe(symbol_t symbol, uint32_t streams) override;
+    int unsubscribe(symbol_t symbol) override;
+    void setRecorder(std::shared_ptr<MarketDataRecorder> recorder) override;
+    // 行情延迟统计（须在 start 之前设置，空指针表示不统计）
+    void setLatencyMonitor(std::shared_ptr<FeedLatencyMonitor> monitor);
+
+    std::vector<StreamConnectionStats> getConnectionStats() const;
+    // 各冗余线路的胜出率和漏收次数，以及仲裁后仍不连续的次数
+    std::vector<FeedLineStats> getLineStats() const;
+    uint64_t getArbitratedGaps() const;
 
 private:
-    // 生成模拟订单薄数据（备用方案）
+    // 把备用合成行情推进到当前时间并返回订单薄（备用方案，持有 mutex 时调用）
     orderbook_t generateOrderbook(symbol_t symbol) const;
-    
-    // 初始化 WebSocket 客户端
-    bool initializeWebSocketClient(symbol_t symbol);
-    
+
+    // 维护线程主循环
+    void run();
+
+    // 新建一个组合流连接并加入事件循环，返回连接下标，失败返回-1
+    int openConnection();
+    // 为新交易对选择连接：连接数未达上限时新建，否则选消息速率最低且流数量未满的连接
+    int chooseConnection(uint32_t stream_count);
+    void onConnectionState(size_t index, size_t line, bool open);
+    // 事件循环线程上判断消息是否来自交易对的归属连接，迁移目标连接的第一条消息会切换归属；
+    // 再按更新ID [first_id, last_id] 在冗余线路间仲裁，其他线路已送达的丢弃（ID 为0时不仲裁）
+    bool acceptMessage(symbol_t symbol, size_t index, size_t line, ArbitratedStream stream,
+                       uint64_t first_id, uint64_t last_id);
+    bool arbitrate(symbol_t symbol, size_t line, ArbitratedStream stream, uint64_t first_id, uint64_t last_id);
+
+    // 以下在持有 subscription_mutex_ 时调用
+    void addStreams(size_t index, symbol_t symbol, uint32_t streams);
+    void removeStreams(size_t index, symbol_t symbol, uint32_t streams);
+    // 每条线路发出一条积压的订阅请求（受请求间隔限制）
+    void flushRequests(size_t index, uint64_t now_ms);
+    void updateRates(uint64_t now_ms);
+    void finishMoves(uint64_t now_ms);
+    void rebalance(uint64_t now_ms);
+
+    static void appendStreamNames(symbol_t symbol, uint32_t streams, std::vector<std::string>& names);
+    uint32_t defaultStreams() const;
+
     // 将 symbol_t 转换为币安交易对字符串
     static std::string symbolToBinanceSymbol(symbol_t symbol);
+
+    // Libcurl 写入回调
+    static size_t writeCallback(void* contents, size_t size, size_t nmemb, void* userp);
 };
 
 } // namespace crypto_quant
@@ -0,0 +1,302 @@
+#ifndef MARKET_DATA_RECORDER_H
+#define MARKET_DATA_RECORDER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "crypto_quant.h"
+
+namespace crypto_quant {
+
+// 录制文件格式（所有整数和浮点数均为网络字节序，文件可在不同字节序的机器间交换）
+// 每个段文件 = 段头（固定部分 + 稀疏时间索引，共 header_size 字节）+ 连续的记录。
+// 每条记录 = 记录头 + 负载，长度按8字节对齐。data_end 之后的内容无效。
+// 交易对ID只在单个段内有效：段内第一次出现某个交易对前先写一条 SYMBOL 记录（ID -> 名称），
+// 读取时按名称映射到当前进程的注册表。
+#pragma pack(push, 1)
+typedef struct
+{
+    char magic[8];              // "CQMDREC"
+    uint32_t version;
+    uint32_t header_size;       // 第一条记录的偏移
+    uint64_t sequence;          // 段序号（同一次录制内递增）
+    uint64_t capacity;          // 写入时的文件大小
+    uint64_t data_end;          // 已提交记录的结束偏移
+    uint64_t record_count;
+    uint64_t first_timestamp;   // 纳秒（本地接收时间，Unix 纪元）
+    uint64_t last_timestamp;
+    uint32_t index_interval;    // 每隔多少条记录写一个索引项
+    uint32_t index_count;
+    uint32_t index_capacity;
+    uint32_t symbol_count;
+    uint64_t last_symbol;       // 最后一条 SYMBOL 记录的偏移，0 表示没有
+} recording_segment_header_net_t;
+
+// 稀疏索引项：记录的时间戳和偏移
+typedef struct
+{
+    uint64_t timestamp;
+    uint64_t offset;
+} recording_index_entry_net_t;
+
+typedef struct
+{
+    uint32_t length;            // 记录长度（含记录头，不含填充），下一条记录从8字节对齐处开始
+    uint16_t type;              // RecordType
+    uint16_t reserved;
+    uint64_t timestamp;         // 纳秒（本地接收时间，Unix 纪元）
+} recording_record_header_net_t;
+
+// SYMBOL 记录负载，后跟 name_length 字节的名称
+// SYMBOL 记录串成链表（段头 last_symbol 指向最后一条），读取方定位到段中间时不必扫描前面的记录
+typedef struct
+{
+    uint32_t symbol;
+    uint32_t name_length;
+    uint64_t previous;          // 上一条 SYMBOL 记录的偏移，0 表示没有
+} recording_symbol_net_t;
+
+// ORDERBOOK 记录负载
+typedef struct
+{
+    orderbook_net_t orderbook;
+    uint64_t last_update_id;
+} recording_orderbook_net_t;
+
+// DEPTH_DIFF 记录负载，后跟 bid_count + ask_count 个 price_level_net_t
+typedef struct
+{
+    uint32_t symbol;
+    uint32_t bid_count;
+    uint32_t ask_count;
+    uint32_t reserved;
+    uint64_t event_time;
+    uint64_t first_update_id;
+    uint64_t final_update_id;
+} recording_depth_diff_net_t;
+
+// SNAPSHOT 记录负载（REST 深度快照），后跟 bid_count + ask_count 个 price_level_net_t
+typedef struct
+{
+    uint32_t symbol;
+    uint32_t bid_count;
+    uint32_t ask_count;
+    uint32_t reserved;
+    uint64_t last_update_id;
+} recording_snapshot_net_t;
+#pragma pack(pop)
+
+enum class RecordType : uint16_t {
+    SYMBOL = 1,
+    RAW = 2,         // 原始 WebSocket 消息
+    ORDERBOOK = 3,
+    DEPTH_DIFF = 4,
+    TRADE = 5,
+    SNAPSHOT = 6     // 增量流同步用的 REST 深度快照
+};
+
+// 录制配置
+struct MarketDataRecorderConfig {
+    // 段文件目录（不存在时创建）和文件名前缀
+    std::string directory;
+    std::string prefix;
+    // 单个段文件的大小（字节），写满后切换到下一个段
+    size_t segment_size;
+    // 段头中每隔多少条记录写一个索引项
+    uint32_t index_interval;
+    // 段头预留的索引项数量（默认段头正好64KB），用完后不再写索引（读取时从最后一个索引项顺序查找）
+    uint32_t index_capacity;
+    bool record_raw;
+    bool record_normalized;
+
+    MarketDataRecorderConfig()
+        : directory("recordings"), prefix("md"), segment_size(256 * 1024 * 1024),
+          index_interval(1024), index_capacity(4090), record_raw(true), record_normalized(true) {}
+};
+
+struct MarketDataRecorderStats {
+    uint64_t records;
+    uint64_t bytes;
+    uint64_t segments;
+    // 段写满时备用段还没准备好，在写入线程上同步创建的次数
+    uint64_t rotation_stalls;
+    // 无法写入的记录（超过段容量或创建段失败）
+    uint64_t dropped;
+};
+
+// 行情录制器
+// 段文件预先分配磁盘空间并整体映射到内存，写一条记录就是一次内存拷贝，然后更新段头，
+// 不需要每条消息一次系统调用。后台线程提前创建下一个段并逐页预写（写入线程不缺页），
+// 收尾写满的段（截断到实际长度），切换段时写入线程只交换指针；备用段没准备好时才等待。
+// 进程崩溃时已写入映射的数据仍由内核写回文件；读取方以段头 data_end 为准。
+// 写入接口线程安全（内部互斥锁，通常只有事件循环线程写入，不会竞争）。
+class MarketDataRecorder {
+public:
+    explicit MarketDataRecorder(const MarketDataRecorderConfig& config = MarketDataRecorderConfig());
+    ~MarketDataRecorder();
+
+    bool open();
+    void close();
+    bool isOpen() const { return open_.load(std::memory_order_acquire); }
+
+    // timestamp_ns：本地接收时间（纳秒，Unix 纪元）
+    bool recordRaw(const char* data, size_t size, uint64_t timestamp_ns);
+    bool recordOrderbook(const orderbook_t& orderbook, uint64_t timestamp_ns);
+    bool recordDepthDiff(const depth_diff_t& diff, uint64_t timestamp_ns);
+    bool recordTrade(const trade_t& trade, uint64_t timestamp_ns);
+    bool recordSnapshot(const DepthSnapshot& snapshot, uint64_t timestamp_ns);
+
+    MarketDataRecorderStats getStats() const;
+    const MarketDataRecorderConfig& config() const { return config_; }
+
+    // 当前时间（纳秒，Unix 纪元），录制时间戳的默认来源
+    static uint64_t nowNs();
+
+private:
+    struct Segment {
+        int fd;
+        char* base;
+        size_t capacity;
+        size_t write_offset;
+        uint64_t sequence;
+        uint64_t record_count;
+        uint32_t index_count;
+        uint32_t symbol_count;
+        uint64_t last_symbol;
+        std::string path;
+        // 本段已写过 SYMBOL 记录的交易对
+        std::vector<uint8_t> symbols_written;
+    };
+
+    // 以下在持有 write_mutex_ 时调用
+    // 开始写一条记录：必要时切换段并补写 SYMBOL 记录，返回负载的写入位置，失败返回 nullptr；
+    // 调用方填好负载后调用 commitRecord
+    char* beginRecord(RecordType type, symbol_t symbol, size_t payload_size, uint64_t timestamp_ns);
+    void commitRecord(uint64_t timestamp_ns);
+    // 更新段头（记录数、索引、data_end），commitRecord 另外累计消息数
+    void publishRecord(uint64_t timestamp_ns);
+    // 在当前段写记录头，返回负载位置（调用方已确认空间足够）
+    char* writeRecordHeader(RecordType type, size_t payload_size, uint64_t timestamp_ns);
+    void writeSymbolRecord(symbol_t symbol, uint64_t timestamp_ns);
+    // 换上备用段，没有可用的备用段时返回 false
+    bool rotate();
+
+    Segment* createSegment(uint64_t sequence);
+    void finalizeSegment(Segment* segment);
+    void discardSegment(Segment* segment);
+    void prepareLoop();
+
+    MarketDataRecorderConfig config_;
+    size_t header_size_;
+    uint64_t session_ms_;
+    std::atomic<bool> open_;
+
+    // 写入状态（受 write_mutex_ 保护）
+    std::mutex write_mutex_;
+    std::unique_ptr<Segment> current_;
+    size_t pending_offset_;
+    size_t pending_length_;
+
+    // 后台线程：准备备用段、收尾写满的段（以下受 prepare_mutex_ 保护）
+    std::thread prepare_thread_;
+    std::mutex prepare_mutex_;
+    std::condition_variable prepare_cv_;
+    std::unique_ptr<Segment> spare_;
+    // 需要一个备用段 / 上次创建失败
+    bool spare_requested_;
+    bool spare_failed_;
+    uint64_t next_sequence_;
+    std::vector<std::unique_ptr<Segment> > retired_;
+    bool stopping_;
+
+    std::atomic<uint64_t> records_;
+    std::atomic<uint64_t> bytes_;
+    std::atomic<uint64_t> segments_;
+    std::atomic<uint64_t> rotation_stalls_;
+    std::atomic<uint64_t> dropped_;
+
+    MarketDataRecorder(const MarketDataRecorder&) = delete;
+    MarketDataRecorder& operator=(const MarketDataRecorder&) = delete;
+};
+
+// 读出的一条记录；字段按 type 有效，指针指向读取器内部缓冲或映射，在下一次 next() 前有效
+struct MarketDataRecord {
+    RecordType type;
+    uint64_t timestamp;
+    // RAW
+    const char* raw;
+    size_t raw_size;
+    // ORDERBOOK
+    orderbook_t orderbook;
+    // DEPTH_DIFF（档位指向读取器内部缓冲）
+    depth_diff_t diff;
+    // TRADE
+    trade_t trade;
+    // SNAPSHOT
+    DepthSnapshot snapshot;
+};
+
+// 单个段文件的读取器（只读映射）
+// 交易对按 SYMBOL 记录中的名称注册到当前进程的注册表；SYMBOL 记录本身不返回给调用方。
+// 可读取正在写入的段（读到当前的 data_end 为止）。
+class MarketDataRecordReader {
+public:
+    MarketDataRecordReader();
+    ~MarketDataRecordReader();
+
+    bool open(const std::string& path);
+    void close();
+
+    // 读取下一条记录；段结束或数据损坏时返回 false
+    bool next(MarketDataRecord& record);
+    // 借助段头索引定位到第一条时间戳 >= timestamp_ns 的记录，之后 next() 从该记录开始
+    bool seek(uint64_t timestamp_ns);
+    void rewind();
+    // 当前读取位置（下一条记录的偏移），只能用 position() 的返回值调用 setPosition()
+    uint64_t position() const { return offset_; }
+    bool setPosition(uint64_t position);
+
+    uint64_t recordCount() const;
+    uint64_t firstTimestamp() const;
+    uint64_t lastTimestamp() const;
+    // 数据损坏（记录长度非法）时为 true
+    bool corrupted() const { return corrupted_; }
+
+    // 目录中指定前缀的段文件，按录制顺序排列
+    static std::vector<std::string> listSegments(const std::string& directory, const std::string& prefix);
+
+private:
+    uint64_t dataEnd() const;
+    // 解析 offset 处的记录头，非法时返回 false
+    bool recordAt(size_t offset, size_t end, RecordType& type, uint64_t& timestamp, size_t& length) const;
+    // 登记 SYMBOL 记录，返回上一条 SYMBOL 记录的偏移
+    uint64_t readSymbol(const char* payload, size_t payload_size);
+    // 沿 SYMBOL 链登记段内全部交易对
+    void loadSymbols();
+    symbol_t mapSymbol(uint32_t file_symbol) const;
+
+    int fd_;
+    const char* base_;
+    size_t size_;
+    size_t header_size_;
+    size_t offset_;
+    bool corrupted_;
+    // 段内交易对ID -> 本进程交易对ID
+    std::vector<symbol_t> symbol_map_;
+    std::vector<price_level_t> levels_;
+    std::string path_;
+
+    MarketDataRecordReader(const MarketDataRecordReader&) = delete;
+    MarketDataRecordReader& operator=(const MarketDataRecordReader&) = delete;
+};
+
+} // namespace crypto_quant
+
+#endif // MARKET_DATA_RECORDER_H
@@ -0,0 +1,93 @@
+#ifndef MICROSTRUCTURE_FEATURES_H
+#define MICROSTRUCTURE_FEATURES_H
+
+#include <stdint.h>
+#include <memory>
+#include <mutex>
+
+#include "crypto_quant.h"
+#include "utils/seqlock.h"
+#include "utils/chunked_array.h"
+
+namespace crypto_quant {
+
+// 微观结构特征配置
+struct MicrostructureConfig {
+    // 多档不平衡使用的档位数
+    int imbalance_levels;
+    // 多档不平衡中每深一档的权重衰减
+    double level_decay;
+    // OFI 累计和队列消耗速率的半衰期（毫秒）
+    double flow_half_life_ms;
+    // 价差长期均值的半衰期（毫秒）
+    double spread_half_life_ms;
+    // 价差/均值 低于该值为 TIGHT，高于 wide_ratio 为 WIDE
+    double tight_ratio;
+    double wide_ratio;
+
+    MicrostructureConfig()
+        : imbalance_levels(5), level_decay(0.5), flow_half_life_ms(1000.0),
+          spread_half_life_ms(60000.0), tight_ratio(0.75), wide_ratio(2.0) {}
+};
+
+// 微观结构特征引擎
+// 每次订单薄更新只与上一次的最优档和几个衰减累计量比较，O(档位数)，不回看历史。
+// 同一交易对的更新须来自单个线程（订单薄通知器的投递线程或策略引擎），
+// 特征通过顺序锁发布，任意线程可无锁读取。
+class MicrostructureFeatureEngine {
+public:
+    explicit MicrostructureFeatureEngine(const MicrostructureConfig& config = MicrostructureConfig());
+    ~MicrostructureFeatureEngine();
+
+    // 用一次订单薄更新刷新特征；features 非空时同时返回最新特征
+    bool update(const orderbook_t& orderbook, microstructure_features_t* features = nullptr);
+    // 最新特征，交易对尚无数据时返回false
+    bool getFeatures(symbol_t symbol, microstructure_features_t& features) const;
+    // 清除交易对的累计状态（重连、重新同步后），须在调用 update 的线程上调用
+    void reset(symbol_t symbol);
+
+    // 通过逐笔订阅接入订单薄管理器（在通知器的投递线程上计算），symbol 为 SYMBOL_INVALID 时接入全部交易对
+    bool attach(std::shared_ptr<IOrderbookManager> manager, symbol_t symbol = SYMBOL_INVALID);
+    // 返回后不再有进行中的回调，之后即可析构引擎
+    void detach();
+
+private:
+    // 写线程私有的增量状态
+    struct FlowState {
+        bool has_previous;
+        double bid_price;
+        double bid_quantity;
+        double ask_price;
+        double ask_quantity;
+        uint64_t timestamp;
+        double ofi_flow;
+        double bid_depleted;
+        double ask_depleted;
+        double spread_ewma;
+        // 交易对的 tick（未注册定点规格时为0）
+        double tick_size;
+    };
+
+    struct SymbolFeatures {
+        Seqlock<microstructure_features_t> published;
+        FlowState state;
+        uint64_t update_count;
+    };
+
+    MicrostructureConfig config_;
+    // 半衰期换算的时间常数（毫秒）
+    double flow_tau_ms_;
+    double spread_tau_ms_;
+    ChunkedArray<SymbolFeatures> symbols_;
+
+    std::mutex attach_mutex_;
+    std::shared_ptr<IOrderbookManager> manager_;
+    uint64_t subscription_id_;
+
+    MicrostructureFeatureEngine(const MicrostructureFeatureEngine&) = delete;
+    MicrostructureFeatureEngine& operator=(const MicrostructureFeatureEngine&) = delete;
+};
+
+} // namespace crypto_quant
+
+#endif // MICROSTRUCTURE_FEATURES_H
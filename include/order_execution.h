@@ -34,6 +34,7 @@ public:
     void disconnect() override;
     ExecutionStatus getStatus() const override;
     ExecutionResult submitOrder(symbol_t symbol, int side, double price, double quantity) override;
+    ExecutionResult submitOrderFixed(symbol_t symbol, int side, int64_t price_ticks, int64_t quantity_lots) override;
     bool cancelOrder(uint64_t order_id) override;
     double getBalance(symbol_t symbol) override;
     double getPosition(symbol_t symbol) override;
@@ -41,6 +42,12 @@ public:
     std::vector<uint64_t> getOrderHistory(int max_count = 100) override;
 
 private:
+    // 定点下单，price_ticks 为0表示市价单
+    ExecutionResult placeOrderFixed(symbol_t symbol, int side, int64_t price_ticks, int64_t quantity_lots);
+    // 使用已格式化的价格/数量字符串下单，price_str 为空表示市价单
+    ExecutionResult placeOrder(symbol_t symbol, int side, const char* price_str,
+                               const char* quantity_str, double price, double quantity);
+
     // HMAC SHA256 签名生成
     std::string hmac_sha256(const std::string& key, const std::string& data);
     
@@ -0,0 +1,177 @@
+#ifndef ORDERBOOK_HISTORY_H
+#define ORDERBOOK_HISTORY_H
+
+#include <stdint.h>
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+#include "crypto_quant.h"
+
+namespace crypto_quant {
+
+// 单个交易对的订单薄历史环
+// 每次更新记录一条：与上一条相比只保存按价格计算的档位差分（新增/修改/删除），
+// 每隔 keyframe_interval 条或差分过大时保存一份完整订单薄（全量帧）。
+// 三个环形缓冲区（记录、差分档位池、全量帧）在 reset 时一次性分配，记录与查询都不分配内存。
+// 差分档位池按每条平均 delta_levels 档分配，全量帧环按两倍的定期全量帧数分配：
+// 默认参数下每条记录约 240 字节，而直接保存 orderbook_t 每条约 1 KB。
+// 写入差分会覆盖最近 capacity 条仍在使用的差分时改存全量帧；变化超出预算时（整盘频繁变化）
+// 全量帧环先绕回，可查询的记录少于 capacity，size() 返回实际可重建的条数。
+// 时间戳取 orderbook_t::timestamp，要求基本单调，倒退的时间戳按上一条记录处理。
+class OrderbookHistory {
+public:
+    // 差分档位数超过该值时改存全量帧
+    static const size_t kMaxDeltaLevels = 16;
+    static const size_t kDefaultKeyframeInterval = 32;
+    // 差分档位池按每条记录的平均差分档位数分配。合成行情（每个事件约2次盘口变化加价格移动）
+    // 经订单薄管理器合并后实测平均约 2 档，按两倍余量预留 4 档
+    static const size_t kDefaultDeltaLevels = 4;
+
+    explicit OrderbookHistory(size_t capacity = 0,
+                              size_t keyframe_interval = kDefaultKeyframeInterval,
+                              size_t delta_levels = kDefaultDeltaLevels);
+
+    // 重新分配并清空历史，capacity 为0时关闭
+    void reset(size_t capacity, size_t keyframe_interval = kDefaultKeyframeInterval,
+               size_t delta_levels = kDefaultDeltaLevels);
+    void clear();
+    size_t capacity() const;
+    // 当前可重建的记录数（变化在预算内时写满后不少于 capacity）
+    size_t size() const;
+    // 三个环形缓冲区占用的字节数
+    size_t memoryBytes() const;
+    // 已记录的差分记录平均差分档位数（调整 delta_levels 用），没有差分记录时为0
+    double averageDeltaLevels() const;
+
+    // 追加一条记录（写线程调用）
+    void record(const orderbook_t& orderbook);
+
+    // 时间戳不晚于 timestamp 的最后一个订单薄，没有时返回false
+    bool getAt(uint64_t timestamp, orderbook_t& out) const;
+
+    // 按时间顺序遍历 [from, to] 内的订单薄，fn(const orderbook_t&) 返回false时停止。
+    // 订单薄在栈上逐条重建，不分配内存；每条只在重建时短暂持有历史锁，fn 在锁外调用，
+    // 慢回调不会阻塞写线程。遍历期间被写线程覆盖的记录跳过。返回回调次数。
+    template <typename Fn>
+    size_t forEachInRange(uint64_t from, uint64_t to, Fn fn) const;
+
+private:
+    struct LevelChange {
+        // 0=买盘，1=卖盘
+        uint32_t side;
+        // 数量为0表示删除该价格
+        price_level_t level;
+    };
+
+    struct Record {
+        uint64_t timestamp;
+        uint64_t last_update_id;
+        // 重建起点的全量帧（绝对序号）及其记录序号
+        uint64_t keyframe_seq;
+        uint64_t keyframe_record;
+        // 差分档位在池中的起始位置（绝对序号）
+        uint64_t change_begin;
+        uint32_t change_count;
+        uint32_t is_keyframe;
+    };
+
+    struct Keyframe {
+        uint64_t record_seq;
+        orderbook_t orderbook;
+    };
+
+    const Record& recordAt(uint64_t seq) const { return records_[seq % records_.size()]; }
+    const Keyframe& keyframeAt(uint64_t seq) const { return keyframes_[seq % keyframes_.size()]; }
+
+    // 记录 seq 能否重建（在持有锁时调用）
+    bool reconstructible(uint64_t seq) const;
+    // 最早可重建的记录序号
+    uint64_t firstValid() const;
+    // 第一个时间戳大于 timestamp 的记录序号，范围 [first, record_count_]
+    uint64_t upperBound(uint64_t first, uint64_t timestamp) const;
+    // 重建记录 seq 的订单薄
+    void reconstruct(uint64_t seq, orderbook_t& out) const;
+    // 在 out（上一条记录）的基础上应用记录 seq
+    void applyRecord(uint64_t seq, orderbook_t& out) const;
+
+    // 计算 prev -> next 的一侧差分，写入 changes，超出 max_changes 时返回false
+    static bool diffSide(const price_level_t* prev, uint32_t prev_count,
+                         const price_level_t* next, uint32_t next_count,
+                         bool descending, uint32_t side,
+                         LevelChange* changes, size_t& change_count, size_t max_changes);
+
+    std::vector<Record> records_;
+    std::vector<LevelChange> changes_;
+    std::vector<Keyframe> keyframes_;
+    uint64_t record_count_;
+    uint64_t change_count_;
+    uint64_t keyframe_count_;
+    size_t keyframe_interval_;
+    size_t capacity_;
+    // reset / clear 时递增，遍历据此发现历史已被清空
+    uint64_t generation_;
+    // 差分记录数及其差分档位总数
+    uint64_t delta_records_;
+    uint64_t delta_levels_total_;
+    uint64_t last_keyframe_record_;
+    // 写入差分时仍需保护的最早记录（最近 capacity 条中最早可重建的一条）
+    uint64_t oldest_protected_;
+    uint64_t last_timestamp_;
+    // 上一条记录的完整订单薄（计算差分用）
+    orderbook_t last_;
+    mutable std::mutex mutex_;
+};
+
+template <typename Fn>
+size_t OrderbookHistory::forEachInRange(uint64_t from, uint64_t to, Fn fn) const {
+    if (from > to) {
+        return 0;
+    }
+    size_t calls = 0;
+    orderbook_t orderbook;
+    bool built = false;
+    uint64_t seq = 0;
+    uint64_t generation = 0;
+    for (;;) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!built) {
+                if (records_.empty() || record_count_ == 0) {
+                    return calls;
+                }
+                uint64_t first = firstValid();
+                // 第一个时间戳 >= from 的记录
+                seq = from == 0 ? first : upperBound(first, from - 1);
+                generation = generation_;
+            } else if (generation != generation_) {
+                return calls;
+            }
+            if (seq >= record_count_ || recordAt(seq).timestamp > to) {
+                return calls;
+            }
+            if (!built || !reconstructible(seq)) {
+                // 首条，或上一次回调期间 seq 已被覆盖：从最早可重建的记录重新开始
+                if (built) {
+                    seq = firstValid();
+                    if (seq >= record_count_ || recordAt(seq).timestamp > to) {
+                        return calls;
+                    }
+                }
+                reconstruct(seq, orderbook);
+                built = true;
+            } else {
+                applyRecord(seq, orderbook);
+            }
+        }
+        ++seq;
+        ++calls;
+        if (!fn(static_cast<const orderbook_t&>(orderbook))) {
+            return calls;
+        }
+    }
+}
+
+} // namespace crypto_quant
+
+#endif // ORDERBOOK_HISTORY_H
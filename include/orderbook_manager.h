@@ -2,21 +2,146 @@
 #define ORDERBOOK_MANAGER_H
 
 #include <vector>
+#include <deque>
 #include <mutex>
+#include <thread>
+#include <condition_variable>
 #include <cstring>
 
 #include "crypto_quant.h"
+#include "orderbook_notifier.h"
+#include "orderbook_history.h"
+#include "orderbook_validator.h"
+#include "depth_kernels.h"
+#include "utils/seqlock.h"
+#include "utils/chunked_array.h"
 
 namespace crypto_quant {
 
 // 订单薄管理器实现类
+// 每个交易对一个顺序锁槽位：写线程原地发布新订单薄，
+// 读线程（策略）无锁读取，读写互不阻塞。
+// 槽位内同时保存 SoA 视图，深度类查询走 SIMD 核函数。
+// 增量流合并进槽位背后的深订单薄（最多 kMaxDepthLevels 档），槽位只发布其前20档；
+// 出现缺口时快照由后台线程获取，期间到达的增量缓存起来，快照到达后按序重放
+// （装入快照后的变更通知在后台线程上发出）。
 class OrderbookManager : public IOrderbookManager {
+public:
+    // 深订单薄每侧保留的最多档位数（REST 快照的最大档位数）
+    static const size_t kMaxDepthLevels = 5000;
+    // 重新同步期间最多缓存的增量数，超出后清空缓存，快照重放时按缺口再次同步
+    static const size_t kMaxBufferedDiffs = 4096;
+
 private:
-    std::vector<orderbook_t> orderbooks_;
-    mutable std::mutex mutex_;
+    // 订单薄及其 SoA 视图，写入时同步更新
+    struct BookState {
+        orderbook_t book;
+        orderbook_soa_t soa;
+    };
+    typedef Seqlock<BookState> BookSlot;
+
+    // 深订单薄的一侧：从最差价到最优价存放，最优价在末尾，
+    // 靠近盘口的插入和删除只移动少量档位
+    struct DepthSide {
+        std::vector<price_level_t> levels;
+        // 本地覆盖范围的边界价格：快照截断或超出档位上限丢弃过档位后，
+        // 比边界更差的价格状态未知，新增档位丢弃而不插到已丢弃档位之前；0表示完整
+        double boundary;
+
+        DepthSide() : boundary(0.0) {}
+    };
+
+    // 重新同步期间缓存的增量（档位从调用方拷贝）
+    struct BufferedDiff {
+        depth_diff_t diff;
+        std::vector<price_level_t> bids;
+        std::vector<price_level_t> asks;
+    };
+
+    struct SymbolBook {
+        BookSlot slot;
+        // 写入区：序号检查、深订单薄合并和槽位发布都在锁内，
+        // 写线程与后台重新同步线程通过它串行化
+        std::mutex write_mutex;
+        DepthSide bids;
+        DepthSide asks;
+        // 深订单薄对应的最后更新ID（0表示尚未同步）
+        uint64_t last_update_id;
+        // 已请求重新同步、快照尚未装入
+        bool syncing;
+        // 快照装入后尚未有增量应用，下一个应用的增量返回 RESYNCED
+        bool resynced;
+        std::vector<BufferedDiff> buffered;
+        // 上次请求快照的时间（毫秒），用于限制 REST 请求频率
+        std::atomic<uint64_t> last_resync_ms;
+        // 历史环，未开启时为nullptr；对象创建后不释放，关闭时只置空指针
+        std::atomic<OrderbookHistory*> history;
+        std::unique_ptr<OrderbookHistory> history_storage;
+        // 完整性校验失败后隔离，重新同步成功或收到合法完整快照后解除
+        std::atomic<bool> quarantined;
+
+        SymbolBook()
+            : last_update_id(0), syncing(false), resynced(false), last_resync_ms(0),
+              history(nullptr), quarantined(false) {}
+    };
+
+    // 按交易对ID索引，首次写入时按块分配
+    ChunkedArray<SymbolBook> books_;
+
+    // 快照提供者（增量流缺口恢复用）
+    std::mutex provider_mutex_;
+    DepthSnapshotProvider snapshot_provider_;
+    // 运行时选择的深度核函数
+    const DepthKernels* kernels_;
+    // 变更订阅：默认使用自带的通知器，分片管理器中各分片共用外部通知器
+    OrderbookNotifier own_notifier_;
+    OrderbookNotifier* notifier_;
+    // 串行化历史容量设置
+    std::mutex history_mutex_;
+    // 完整性校验
+    OrderbookValidator validator_;
+
+    // 后台重新同步线程：按请求顺序获取快照，首次请求时启动
+    std::mutex resync_mutex_;
+    std::condition_variable resync_cv_;
+    std::deque<symbol_t> resync_queue_;
+    std::thread resync_thread_;
+    bool resync_running_;
+
+    // 最小重新同步间隔（毫秒）
+    static const uint64_t kMinResyncIntervalMs = 1000;
+
+    // 根据交易对查找槽位，未写入过的交易对返回nullptr
+    const BookSlot* findSlot(symbol_t symbol) const;
+    // 写入用：未注册的交易对返回nullptr，已注册但尚未分配时分配
+    SymbolBook* findOrCreateBook(symbol_t symbol);
+
+    // 通过快照提供者重建订单薄并重放缓存的增量（后台线程调用）
+    void resync(symbol_t symbol, SymbolBook& book);
+    // 在写入区内调用：标记同步中并交给后台线程，已在同步中时不重复请求
+    void requestResync(symbol_t symbol, SymbolBook& book);
+    void enqueueResync(symbol_t symbol);
+    void runResync();
+    void stopResync();
+    bool hasSnapshotProvider();
+    // 以下在写入区内调用
+    void bufferDiff(SymbolBook& book, const depth_diff_t& diff);
+    void mergeDiff(SymbolBook& book, const depth_diff_t& diff);
+    // 按序重放缓存的增量，遇到缺口时保留剩余部分并返回false
+    bool replayBuffered(SymbolBook& book);
+    // 深订单薄前 ORDERBOOK_MAX_LEVELS 档写入槽位并校验，返回校验结果
+    OrderbookIntegrityIssue publishDepth(symbol_t symbol, SymbolBook& book, bool full_snapshot, uint64_t now);
+    // 在写入区内调用：根据校验结果隔离/解除隔离；隔离中的交易对请求重新同步
+    void handleIntegrity(symbol_t symbol, SymbolBook& book, OrderbookIntegrityIssue issue,
+                         bool full_snapshot);
+    void quarantine(symbol_t symbol, SymbolBook& book, OrderbookIntegrityIssue issue);
+    // 发布后记录历史并通知订阅者
+    void notifyChanged(symbol_t symbol, SymbolBook& book);
+    const OrderbookHistory* findHistory(symbol_t symbol) const;
 
 public:
-    OrderbookManager();
+    explicit OrderbookManager(OrderbookNotifier* notifier = nullptr);
+    ~OrderbookManager();
 
     bool initialize() override;
     void cleanup() override;
@@ -28,11 +153,28 @@ public:
     double getSpread(symbol_t symbol) const override;
     double getBidDepth(symbol_t symbol, int levels = 5) const override;
     double getAskDepth(symbol_t symbol, int levels = 5) const override;
+    double getDepthWithinBps(symbol_t symbol, double bps, bool bid) const override;
+    double getVwap(symbol_t symbol, int levels, bool bid) const override;
+    double getCostToFill(symbol_t symbol, double quantity, bool buy,
+                         double* filled_quantity = nullptr) const override;
     uint64_t getTimestamp(symbol_t symbol) const override;
     bool isValid(symbol_t symbol) const override;
+    size_t getTopOfBook(const symbol_t* symbols, size_t count, top_of_book_t* out) const override;
+    DepthDiffResult applyDepthDiff(const depth_diff_t& diff) override;
+    void setSnapshotProvider(DepthSnapshotProvider provider) override;
+    std::shared_ptr<IOrderbookSubscription> subscribeConflated(symbol_t symbol) override;
+    uint64_t subscribeEveryUpdate(symbol_t symbol, OrderbookUpdateCallback callback) override;
+    void unsubscribe(uint64_t subscription_id) override;
+    uint64_t droppedUpdates(uint64_t subscription_id) const override;
+    bool isQuarantined(symbol_t symbol) const override;
+    orderbook_integrity_stats_t getIntegrityStats() const override;
+    void setValidatorConfig(const OrderbookValidatorConfig& config) { validator_.setConfig(config); }
+    bool setHistoryCapacity(symbol_t symbol, size_t capacity) override;
+    bool getOrderbookAt(symbol_t symbol, uint64_t timestamp, orderbook_t& orderbook) const override;
+    size_t forEachOrderbookInRange(symbol_t symbol, uint64_t from, uint64_t to,
+                                   const std::function<bool(const orderbook_t&)>& fn) const override;
 };
 
 } // namespace crypto_quant
 
 #endif // ORDERBOOK_MANAGER_H
-
@@ -0,0 +1,214 @@
+#ifndef ORDERBOOK_NOTIFIER_H
+#define ORDERBOOK_NOTIFIER_H
+
+#include <stdint.h>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "crypto_quant.h"
+#include "symbol_registry.h"
+#include "utils/mpmc_queue.h"
+#include "utils/seqlock.h"
+
+namespace crypto_quant {
+
+// 合并（conflated）订阅
+// 每个交易对在位图中占一位，写线程只做一次原子或操作；
+// 消费者取出有变化的交易对后自行读取最新订单薄，慢消费者不会积压历史更新。
+// 只有消费者在 wait 中阻塞时写线程才会触碰互斥锁和条件变量。
+class ConflatedSubscription : public IOrderbookSubscription {
+public:
+    ConflatedSubscription(uint64_t id, symbol_t symbol);
+
+    uint64_t id() const override { return id_; }
+    size_t poll(symbol_t* symbols, size_t max_count) override;
+    size_t wait(symbol_t* symbols, size_t max_count, int timeout_ms) override;
+    void close() override;
+
+    // 订阅的交易对，SYMBOL_INVALID 表示全部
+    symbol_t symbol() const { return symbol_; }
+    // 写线程调用：标记交易对有变化
+    void markDirty(symbol_t symbol);
+
+private:
+    static const size_t kWordCount = (SymbolRegistry::kMaxSymbols + 63) / 64;
+
+    bool hasPending() const;
+
+    uint64_t id_;
+    symbol_t symbol_;
+    std::atomic<uint64_t> dirty_[kWordCount];
+    std::atomic<bool> waiting_;
+    std::atomic<bool> closed_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+};
+
+// 逐笔订阅的投递通道
+// 每个逐笔订阅者独占一个有界队列、一个投递线程和一个丢弃计数：
+// 慢回调只会让自己的队列溢出，不影响同一通知器上的其他订阅者。
+class EveryUpdateChannel {
+public:
+    EveryUpdateChannel(uint64_t id, OrderbookUpdateCallback callback, size_t capacity);
+
+    uint64_t id() const { return id_; }
+    // 投递队列满而丢弃的更新数
+    uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+    // 写线程调用：复制订单薄进队列，队列满时丢弃并计数，返回false
+    bool push(const orderbook_t& orderbook) {
+        if (!queue_.tryPush([&orderbook](orderbook_t& slot) {
+                memcpy(&slot, &orderbook, sizeof(slot));
+            })) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        // 与投递线程先置 waiting_ 再检查队列配对，避免丢失唤醒
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (waiting_.load(std::memory_order_relaxed)) {
+            std::lock_guard<std::mutex> lock(wait_mutex_);
+            cv_.notify_one();
+        }
+        return true;
+    }
+
+    // 启动投递线程；线程持有 self，在回调内退订时通道活到线程退出
+    static void start(const std::shared_ptr<EveryUpdateChannel>& self);
+    // 停止投递，丢弃队列中未投递的更新；不在本通道的投递线程上调用时等待正在执行的回调结束
+    void stop();
+
+private:
+    static void run(std::shared_ptr<EveryUpdateChannel> self);
+
+    uint64_t id_;
+    OrderbookUpdateCallback callback_;
+    MpmcQueue<orderbook_t> queue_;
+    std::thread thread_;
+    std::atomic<bool> running_;
+    std::atomic<bool> waiting_;
+    std::mutex wait_mutex_;
+    std::condition_variable cv_;
+    std::atomic<uint64_t> dropped_;
+
+    EveryUpdateChannel(const EveryUpdateChannel&) = delete;
+    EveryUpdateChannel& operator=(const EveryUpdateChannel&) = delete;
+};
+
+// 订单薄变更通知器（供订单薄管理器内部使用）
+// 订阅者列表写时复制：订阅/退订在互斥锁下生成新列表并原子替换，
+// 写线程发布时只在自己的读者计数条带上加减一次，不触碰互斥锁。
+// 被替换的旧列表在每个条带都观察到归零（宽限期）后释放。
+// 逐笔订阅的回调不在写线程上执行：写线程读取一次订单薄，复制进每个匹配订阅者自己的投递通道，
+// 由该通道的线程回调；通道队列满时只丢弃该订阅者的更新并计数，慢订阅者既不反压写线程也不拖累其他订阅者。
+class OrderbookNotifier {
+public:
+    // 每个逐笔订阅者的投递队列长度
+    static const size_t kDeliveryQueueCapacity = 1024;
+
+    OrderbookNotifier();
+    ~OrderbookNotifier();
+
+    std::shared_ptr<IOrderbookSubscription> subscribeConflated(symbol_t symbol);
+    uint64_t subscribeEveryUpdate(symbol_t symbol, OrderbookUpdateCallback callback);
+    // 返回后该订阅的回调不再执行，也没有正在执行的（在回调内退订时只保证不再有新的回调）
+    void unsubscribe(uint64_t subscription_id);
+    // 所有逐笔订阅者因投递队列满而丢弃的更新数之和（含已退订的）
+    uint64_t droppedUpdates() const { return dropped_.load(std::memory_order_relaxed); }
+    // 某个逐笔订阅者丢弃的更新数；订阅不存在或不是逐笔订阅时返回0
+    uint64_t droppedUpdates(uint64_t subscription_id) const;
+
+    // 写线程在发布新订单薄后调用；只有存在匹配的逐笔订阅者时才通过 load(orderbook_t&) 读取一次订单薄
+    template <typename Load>
+    void publish(symbol_t symbol, Load load) {
+        ReaderGuard guard(*this);
+        const SubscriberList* list = list_.load(std::memory_order_seq_cst);
+        if (!list) {
+            return;
+        }
+        orderbook_t orderbook;
+        bool loaded = false;
+        for (size_t i = 0; i < list->size(); ++i) {
+            const Subscriber& subscriber = (*list)[i];
+            if (subscriber.symbol != SYMBOL_INVALID && subscriber.symbol != symbol) {
+                continue;
+            }
+            if (subscriber.conflated) {
+                subscriber.conflated->markDirty(symbol);
+                continue;
+            }
+            if (!loaded) {
+                load(orderbook);
+                loaded = true;
+            }
+            if (!subscriber.channel->push(orderbook)) {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+    }
+
+private:
+    struct Subscriber {
+        uint64_t id;
+        symbol_t symbol;
+        std::shared_ptr<ConflatedSubscription> conflated;
+        std::shared_ptr<EveryUpdateChannel> channel;
+    };
+    typedef std::vector<Subscriber> SubscriberList;
+
+    // 读者计数条带：线程按首次使用的顺序分到各条带，避免所有写线程争用一个计数
+    // （用填充隔开而不用 alignas：通知器可能随管理器在堆上分配）
+    static const size_t kReaderStripes = 16;
+    struct ReaderStripe {
+        std::atomic<uint32_t> active;
+        char padding[CRYPTO_QUANT_CACHELINE_SIZE - sizeof(std::atomic<uint32_t>)];
+    };
+
+    // 在持有期间读取 list_ 得到的列表不会被释放
+    class ReaderGuard {
+    public:
+        explicit ReaderGuard(OrderbookNotifier& notifier)
+            : stripe_(notifier.readers_[stripeIndex()]) {
+            stripe_.active.fetch_add(1, std::memory_order_seq_cst);
+        }
+        ~ReaderGuard() {
+            stripe_.active.fetch_sub(1, std::memory_order_release);
+        }
+
+    private:
+        ReaderStripe& stripe_;
+    };
+
+    // 等待宽限期的旧列表；pending 为尚未观察到归零的条带位图
+    struct RetiredList {
+        const SubscriberList* list;
+        uint32_t pending;
+    };
+
+    static size_t stripeIndex();
+
+    // 在持有 mutex_ 时发布新列表（空列表发布为nullptr）
+    void replaceList(SubscriberList* list);
+    // 在持有 mutex_ 时从列表中去掉订阅，不存在时返回false；被去掉的逐笔订阅通道由 channel 带出
+    bool removeSubscriber(uint64_t subscription_id, std::shared_ptr<EveryUpdateChannel>& channel);
+    // 在持有 mutex_ 时释放已过宽限期的旧列表
+    void reclaimRetired();
+
+    std::atomic<const SubscriberList*> list_;
+    ReaderStripe readers_[kReaderStripes];
+    std::vector<RetiredList> retired_;
+    mutable std::mutex mutex_;
+    uint64_t next_id_;
+    std::atomic<uint64_t> dropped_;
+
+    OrderbookNotifier(const OrderbookNotifier&) = delete;
+    OrderbookNotifier& operator=(const OrderbookNotifier&) = delete;
+};
+
+} // namespace crypto_quant
+
+#endif // ORDERBOOK_NOTIFIER_H
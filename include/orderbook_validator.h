@@ -0,0 +1,73 @@
+#ifndef ORDERBOOK_VALIDATOR_H
+#define ORDERBOOK_VALIDATOR_H
+
+#include <stdint.h>
+#include <atomic>
+
+#include "crypto_quant.h"
+
+namespace crypto_quant {
+
+// 订单薄校验配置
+struct OrderbookValidatorConfig {
+    // 时间戳落后本地时钟超过该值（毫秒）视为过期，0表示不检查（回放数据等）
+    uint64_t max_age_ms;
+
+    OrderbookValidatorConfig() : max_age_ms(10000) {}
+};
+
+// 订单薄完整性校验器（供订单薄管理器内部使用）
+// 在写线程上对刚发布的订单薄做O(档位数)的检查，正常情况下只有比较和一次计数；
+// 各类问题和隔离/重新同步事件计入原子计数器，可随时无锁读取。
+class OrderbookValidator {
+public:
+    explicit OrderbookValidator(const OrderbookValidatorConfig& config = OrderbookValidatorConfig());
+
+    void setConfig(const OrderbookValidatorConfig& config) { max_age_ms_.store(config.max_age_ms); }
+
+    // 检查完整订单薄；previous_* 为上一次发布的时间戳和更新ID（0表示未知）
+    OrderbookIntegrityIssue check(const orderbook_t& orderbook,
+                                  uint64_t previous_timestamp, uint64_t previous_update_id,
+                                  uint64_t now_ms);
+    // 只检查盘口（档位有序由数据结构保证时使用），价格为0表示该侧为空
+    OrderbookIntegrityIssue checkTop(double best_bid, double best_ask,
+                                     uint64_t timestamp, uint64_t update_id,
+                                     uint64_t previous_timestamp, uint64_t previous_update_id,
+                                     uint64_t now_ms);
+
+    // 检查增量事件的交易所时间是否落后本地时钟过多
+    OrderbookIntegrityIssue checkEventAge(uint64_t event_time, uint64_t now_ms);
+    // 增量流检测到的缺口（由管理器的更新ID检查发现）
+    void recordSequenceGap() { sequence_gap_.fetch_add(1, std::memory_order_relaxed); }
+    void recordQuarantined() { quarantined_.fetch_add(1, std::memory_order_relaxed); }
+    void recordResync(bool success);
+    void recordRecovered() { recovered_.fetch_add(1, std::memory_order_relaxed); }
+
+    orderbook_integrity_stats_t stats() const;
+
+    static const char* issueName(OrderbookIntegrityIssue issue);
+
+private:
+    OrderbookIntegrityIssue checkSequence(uint64_t timestamp, uint64_t update_id,
+                                          uint64_t previous_timestamp, uint64_t previous_update_id,
+                                          uint64_t now_ms);
+    OrderbookIntegrityIssue record(OrderbookIntegrityIssue issue);
+
+    std::atomic<uint64_t> max_age_ms_;
+    std::atomic<uint64_t> checked_;
+    std::atomic<uint64_t> crossed_;
+    std::atomic<uint64_t> non_monotonic_;
+    std::atomic<uint64_t> stale_timestamp_;
+    std::atomic<uint64_t> sequence_gap_;
+    std::atomic<uint64_t> quarantined_;
+    std::atomic<uint64_t> resync_requested_;
+    std::atomic<uint64_t> resync_failed_;
+    std::atomic<uint64_t> recovered_;
+
+    OrderbookValidator(const OrderbookValidator&) = delete;
+    OrderbookValidator& operator=(const OrderbookValidator&) = delete;
+};
+
+} // namespace crypto_quant
+
+#endif // ORDERBOOK_VALIDATOR_H
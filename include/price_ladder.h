@@ -0,0 +1,104 @@
+#ifndef PRICE_LADDER_H
+#define PRICE_LADDER_H
+
+#include <stdint.h>
+#include <cstddef>
+#include <map>
+#include <vector>
+
+namespace crypto_quant {
+
+// 单边价格档位阶梯（按整数tick索引）
+// 最优价附近的档位存放在定长稠密数组（窗口）中，配合占用位图快速定位下一档；
+// 窗口之外（一定劣于窗口内所有价格）的深档位存放在稀疏的有序溢出表中。
+// 窗口内的插入、修改、删除以及最优价移动均为O(1)，
+// 只有最优价越出窗口时才重新定位窗口（摊还代价）。
+class PriceLadder {
+public:
+    // 默认窗口大小（tick数，必须是64的倍数）
+    static const size_t kDefaultWindowTicks = 4096;
+
+    explicit PriceLadder(bool is_bid, size_t window_ticks = kDefaultWindowTicks);
+
+    // 设置档位数量，quantity<=0 表示删除该档位
+    void set(int64_t tick, double quantity);
+    // 查询档位数量，不存在返回0
+    double get(int64_t tick) const;
+    // 清空所有档位（只遍历已占用的位，不整体清零窗口）
+    void clear();
+
+    bool empty() const { return count_ == 0; }
+    size_t size() const { return count_; }
+    bool isBid() const { return is_bid_; }
+
+    // 最优价tick，仅在非空时有效
+    int64_t bestTick() const { return best_; }
+    double bestQuantity() const;
+
+    // 从最优价开始按价格由优到劣遍历，fn(int64_t tick, double quantity) 返回false时停止
+    template <typename Fn>
+    void forEachLevel(Fn fn) const;
+
+private:
+    bool inWindow(int64_t tick) const {
+        return tick >= base_ && tick < base_ + static_cast<int64_t>(window_);
+    }
+    bool better(int64_t a, int64_t b) const {
+        return is_bid_ ? a > b : a < b;
+    }
+    void remove(int64_t tick);
+    // 以新的最优价重新定位窗口
+    void recenter(int64_t best_tick);
+    // 在窗口内从 from_tick（不含）向劣价方向查找下一个非空档位
+    bool scanWorse(int64_t from_tick, int64_t& found) const;
+
+    bool is_bid_;
+    size_t window_;
+    int64_t base_;
+    std::vector<double> quantities_;
+    std::vector<uint64_t> occupied_;
+    std::map<int64_t, double> overflow_;
+    size_t count_;
+    int64_t best_;
+};
+
+template <typename Fn>
+void PriceLadder::forEachLevel(Fn fn) const {
+    if (count_ == 0) {
+        return;
+    }
+
+    // 先遍历窗口内的档位
+    int64_t tick = best_;
+    if (inWindow(tick)) {
+        for (;;) {
+            if (!fn(tick, quantities_[static_cast<size_t>(tick - base_)])) {
+                return;
+            }
+            if (!scanWorse(tick, tick)) {
+                break;
+            }
+        }
+    }
+
+    // 再按由优到劣的顺序遍历溢出表
+    if (is_bid_) {
+        for (std::map<int64_t, double>::const_reverse_iterator it = overflow_.rbegin();
+             it != overflow_.rend(); ++it) {
+            if (!fn(it->first, it->second)) {
+                return;
+            }
+        }
+    } else {
+        for (std::map<int64_t, double>::const_iterator it = overflow_.begin();
+             it != overflow_.end(); ++it) {
+            if (!fn(it->first, it->second)) {
+                return;
+            }
+        }
+    }
+}
+
+} // namespace crypto_quant
+
+#endif // PRICE_LADDER_H
@@ -0,0 +1,177 @@
+#ifndef REPLAY_MARKET_DATA_FETCHER_H
+#define REPLAY_MARKET_DATA_FETCHER_H
+
+#include <stdint.h>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "crypto_quant.h"
+#include "binance_message_parser.h"
+#include "market_data_recorder.h"
+
+namespace crypto_quant {
+
+// 回放速度
+enum class ReplaySpeedMode {
+    REALTIME,            // 按录制时的时间间隔
+    SCALED,              // 时间间隔除以 speed（speed=10 即10倍速）
+    AS_FAST_AS_POSSIBLE  // 不等待，读到即推送
+};
+
+// 回放配置
+struct ReplayConfig {
+    // 录制目录和文件名前缀（files 为空时按前缀列出段文件）
+    std::string directory;
+    std::string prefix;
+    // 指定要回放的段文件（按给定顺序）
+    std::vector<std::string> files;
+    ReplaySpeedMode mode;
+    double speed;
+    // 回放的录制时间范围（纳秒，Unix 纪元），0 表示不限
+    uint64_t start_time_ns;
+    uint64_t end_time_ns;
+    // 从原始消息重新解析（与实盘走同一个解析器），否则使用录制的解析结果
+    bool parse_raw;
+
+    ReplayConfig()
+        : directory("recordings"), prefix("md"), mode(ReplaySpeedMode::REALTIME), speed(1.0),
+          start_time_ns(0), end_time_ns(0), parse_raw(false) {}
+};
+
+struct ReplayStats {
+    // 读出的记录和推送给回调的订单薄/增量深度/成交
+    uint64_t records;
+    uint64_t orderbooks;
+    uint64_t depth_diffs;
+    uint64_t trades;
+    // 未订阅的交易对、不在时间范围内或当前模式不使用的记录
+    uint64_t skipped;
+    // 交还给订单薄管理器的录制快照
+    uint64_t snapshots;
+    // 落后计划时间的最大值（纳秒），回调太慢时变大
+    uint64_t max_lag_ns;
+    // 已回放的录制时间跨度和实际耗时（纳秒），两者之比为实际倍速
+    uint64_t replay_time_ns;
+    uint64_t wall_time_ns;
+    bool finished;
+};
+
+// 行情回放：把录制的段文件按录制顺序推送给订单薄/增量深度/成交回调，与实盘走同一回调路径
+// 回放线程按模拟时钟推进：每条记录的录制时间戳即模拟时间，按速度模式换算出应推送的墙钟时刻。
+// 回调在回放线程上按录制顺序同步调用，同一份录制、同样的订阅每次推送的序列完全相同；
+// 下游若经过 MarketDataDispatcher，应使用 BLOCK 溢出策略，否则高倍速下可能丢事件。
+// 订单薄时间戳是录制时的本地时间，订单薄管理器的过期检查应关闭（max_age_ms = 0）。
+// 增量流的快照请求按交易对依次交还录制时取得的快照（录制时 fetchDepthSnapshot 的结果）。
+class ReplayMarketDataFetcher : public IMarketDataFetcher {
+public:
+    explicit ReplayMarketDataFetcher(const ReplayConfig& config = ReplayConfig());
+    ~ReplayMarketDataFetcher();
+
+    // 列出段文件；没有可回放的文件时返回 false
+    bool initialize() override;
+    // 订阅 symbol 并开始回放；已在回放时等同于 subscribe(symbol, 0)
+    int start(symbol_t symbol) override;
+    void stop() override;
+    void setApiKey(const std::string& api_key, const std::string& api_secret) override;
+    void setDataSources(bool use_binance, bool use_coingecko) override;
+    // 回调须在 start 之前设置
+    void setOrderbookCallback(std::function<void(const orderbook_t&)> callback) override;
+    void setDepthDiffCallback(std::function<void(const depth_diff_t&)> callback) override;
+    void setTradeCallback(std::function<void(const trade_t&)> callback) override;
+    bool fetchDepthSnapshot(symbol_t symbol, int limit, DepthSnapshot& snapshot) override;
+    orderbook_t getOrderbook(symbol_t symbol) const override;
+    // streams 为 market_stream_t 组合，0 表示推送录制中该交易对的所有深度和成交数据
+    int subscribe(symbol_t symbol, uint32_t streams) override;
+    int unsubscribe(symbol_t symbol) override;
+    // 把推送的记录按原时间戳重新录制（截取时间段或交易对）
+    void setRecorder(std::shared_ptr<MarketDataRecorder> recorder) override;
+
+    // 运行中调整速度，从当前模拟时间开始按新速度计时
+    void setSpeed(ReplaySpeedMode mode, double speed);
+    // 模拟时钟：最近推送的记录的录制时间（纳秒），尚未开始时为0
+    uint64_t now() const { return clock_ns_.load(std::memory_order_acquire); }
+    bool isFinished() const { return finished_.load(std::memory_order_acquire); }
+    // 等待回放结束，超时返回 false
+    bool waitUntilFinished(uint64_t timeout_ms);
+    ReplayStats getStats() const;
+
+private:
+    // 快照查找位置：段文件下标和其中的偏移
+    struct SnapshotCursor {
+        size_t file;
+        uint64_t position;
+    };
+
+    void run();
+    // 按速度模式等到记录的推送时刻，停止时返回 false
+    bool pace(uint64_t timestamp_ns);
+    void deliver(const MarketDataRecord& record);
+    void deliverOrderbook(const orderbook_t& orderbook, uint64_t timestamp_ns);
+    void deliverDepthDiff(const depth_diff_t& diff, uint64_t timestamp_ns);
+    void deliverTrade(const trade_t& trade, uint64_t timestamp_ns);
+    bool wants(symbol_t symbol, uint32_t stream) const;
+    // 打开段文件并定位到回放起点
+    bool openFile(MarketDataRecordReader& reader, size_t index) const;
+
+    ReplayConfig config_;
+    std::vector<std::string> files_;
+    std::function<void(const orderbook_t&)> orderbook_callback_;
+    std::function<void(const depth_diff_t&)> diff_callback_;
+    std::function<void(const trade_t&)> trade_callback_;
+    std::shared_ptr<MarketDataRecorder> recorder_;
+    // 保护回调、订单薄和速度设置
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::thread thread_;
+    std::atomic<bool> running_;
+    std::atomic<bool> finished_;
+
+    // 按 symbol_t 索引的订阅流（0 表示未订阅），回放线程无锁读取
+    std::unique_ptr<std::atomic<uint32_t>[]> subscriptions_;
+    std::vector<orderbook_t> orderbooks_;
+    // 各交易对下一次查找录制快照的起点（受 snapshot_mutex_ 保护，查找时不阻塞回放线程）
+    std::mutex snapshot_mutex_;
+    std::vector<SnapshotCursor> snapshot_cursors_;
+
+    // 模拟时钟与计时基准：模拟时间 sim_base_ns_ 对应墙钟 wall_base_ns_（steady_clock）
+    std::atomic<uint64_t> clock_ns_;
+    // mode_ / speed_ 受 mutex_ 保护，setSpeed 后回放线程重新取基准并拷贝到 active_*
+    ReplaySpeedMode mode_;
+    double speed_;
+    std::atomic<bool> rebase_;
+
+    // 以下只由回放线程使用
+    ReplaySpeedMode active_mode_;
+    double active_speed_;
+    uint64_t sim_base_ns_;
+    uint64_t wall_base_ns_;
+    std::function<void(const orderbook_t&)> active_orderbook_callback_;
+    std::function<void(const depth_diff_t&)> active_diff_callback_;
+    std::function<void(const trade_t&)> active_trade_callback_;
+    // 原始消息模式的解析器
+    BinanceMessageParser parser_;
+
+    std::atomic<uint64_t> records_;
+    std::atomic<uint64_t> orderbooks_delivered_;
+    std::atomic<uint64_t> diffs_delivered_;
+    std::atomic<uint64_t> trades_delivered_;
+    std::atomic<uint64_t> skipped_;
+    std::atomic<uint64_t> snapshots_;
+    std::atomic<uint64_t> max_lag_ns_;
+    std::atomic<uint64_t> first_timestamp_ns_;
+    std::atomic<uint64_t> wall_start_ns_;
+    std::atomic<uint64_t> wall_end_ns_;
+
+    ReplayMarketDataFetcher(const ReplayMarketDataFetcher&) = delete;
+    ReplayMarketDataFetcher& operator=(const ReplayMarketDataFetcher&) = delete;
+};
+
+} // namespace crypto_quant
+
+#endif // REPLAY_MARKET_DATA_FETCHER_H
@@ -0,0 +1,167 @@
+#ifndef SHARDED_ORDERBOOK_MANAGER_H
+#define SHARDED_ORDERBOOK_MANAGER_H
+
+#include <stdint.h>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "crypto_quant.h"
+#include "orderbook_manager.h"
+#include "orderbook_notifier.h"
+#include "utils/mpmc_queue.h"
+
+namespace crypto_quant {
+
+// 分片订单薄管理器配置
+struct ShardedOrderbookConfig {
+    // 分片数，0表示按CPU核数
+    size_t shard_count;
+    // 每个分片的更新队列长度（向上取整为2的幂）
+    size_t queue_capacity;
+    // 是否把分片线程绑定到CPU核
+    bool pin_threads;
+    // 分片 i 绑定到 cpus[i % cpus.size()]；为空时从进程可用的核中依次选取，
+    // 可用核多于一个时跳过0号核（通常承担中断和系统任务）
+    std::vector<int> cpus;
+    // 队列为空时的休眠时间（微秒），0表示忙等（只让出CPU）
+    int idle_sleep_us;
+
+    ShardedOrderbookConfig()
+        : shard_count(0), queue_capacity(4096), pin_threads(true), idle_sleep_us(50) {}
+};
+
+// 单个分片的统计
+struct ShardStats {
+    uint64_t enqueued;
+    uint64_t processed;
+    // 差分应用结果
+    uint64_t diffs_applied;
+    uint64_t diffs_stale;
+    uint64_t diffs_resynced;
+    uint64_t diffs_out_of_sync;
+    // 重新同步期间缓存、快照到达后才应用的差分
+    uint64_t diffs_buffered;
+    // 队列满导致生产者等待的次数
+    uint64_t queue_full;
+};
+
+// 分片订单薄管理器
+// 交易对按 symbol % N 划分到 N 个分片，每个分片由一个（可绑核的）线程独占写入，
+// 写入接口只把更新放进分片的有界 MPMC 队列，不同分片的更新并行处理。
+// 每个分片内部是一个 OrderbookManager，读接口直接读分片的顺序锁快照，跨分片读取无锁。
+// 写入是异步的：applyDepthDiff 入队即返回 QUEUED，实际结果计入分片统计；
+// 需要读到刚写入的数据时先调用 flush，或订阅变更通知。
+// 缺口重新同步由各分片管理器的后台线程完成，不占用（已绑核的）分片线程。
+// 所有分片共用一个通知器，逐笔订阅回调在通知器的投递线程上执行。
+class ShardedOrderbookManager : public IOrderbookManager {
+public:
+    explicit ShardedOrderbookManager(const ShardedOrderbookConfig& config = ShardedOrderbookConfig());
+    ~ShardedOrderbookManager();
+
+    bool initialize() override;
+    void cleanup() override;
+    void updateOrderbook(const orderbook_t& orderbook) override;
+    orderbook_t getOrderbook(symbol_t symbol) const override;
+    double getBestBid(symbol_t symbol) const override;
+    double getBestAsk(symbol_t symbol) const override;
+    double getMidPrice(symbol_t symbol) const override;
+    double getSpread(symbol_t symbol) const override;
+    double getBidDepth(symbol_t symbol, int levels = 5) const override;
+    double getAskDepth(symbol_t symbol, int levels = 5) const override;
+    double getDepthWithinBps(symbol_t symbol, double bps, bool bid) const override;
+    double getVwap(symbol_t symbol, int levels, bool bid) const override;
+    double getCostToFill(symbol_t symbol, double quantity, bool buy,
+                         double* filled_quantity = nullptr) const override;
+    uint64_t getTimestamp(symbol_t symbol) const override;
+    bool isValid(symbol_t symbol) const override;
+    size_t getTopOfBook(const symbol_t* symbols, size_t count, top_of_book_t* out) const override;
+    DepthDiffResult applyDepthDiff(const depth_diff_t& diff) override;
+    void setSnapshotProvider(DepthSnapshotProvider provider) override;
+    std::shared_ptr<IOrderbookSubscription> subscribeConflated(symbol_t symbol) override;
+    uint64_t subscribeEveryUpdate(symbol_t symbol, OrderbookUpdateCallback callback) override;
+    void unsubscribe(uint64_t subscription_id) override;
+    uint64_t droppedUpdates(uint64_t subscription_id) const override;
+    bool isQuarantined(symbol_t symbol) const override;
+    // 所有分片的校验计数之和
+    orderbook_integrity_stats_t getIntegrityStats() const override;
+    bool setHistoryCapacity(symbol_t symbol, size_t capacity) override;
+    bool getOrderbookAt(symbol_t symbol, uint64_t timestamp, orderbook_t& orderbook) const override;
+    size_t forEachOrderbookInRange(symbol_t symbol, uint64_t from, uint64_t to,
+                                   const std::function<bool(const orderbook_t&)>& fn) const override;
+
+    size_t shardCount() const { return shards_.size(); }
+    size_t shardOf(symbol_t symbol) const { return symbol % shards_.size(); }
+    // 等待调用前已入队的更新全部处理完
+    void flush();
+    ShardStats getShardStats(size_t shard) const;
+    // 应用到所有分片的完整性校验配置
+    void setValidatorConfig(const OrderbookValidatorConfig& config);
+
+private:
+    // 差分内联保存的档位数，更多的档位放到堆上（由分片线程释放）
+    static const size_t kInlineLevels = 40;
+
+    enum MessageType {
+        MESSAGE_ORDERBOOK = 0,
+        MESSAGE_DEPTH_DIFF = 1
+    };
+
+    // 队列元素：完整订单薄或自带档位的差分
+    struct ShardMessage {
+        uint32_t type;
+        // 差分头部，bids/asks 指针在分片线程上按 levels/overflow 重新设置
+        depth_diff_t diff;
+        price_level_t* overflow;
+        union {
+            orderbook_t orderbook;
+            price_level_t levels[kInlineLevels];
+        };
+    };
+
+    struct Shard {
+        size_t index;
+        std::unique_ptr<OrderbookManager> manager;
+        std::unique_ptr<MpmcQueue<ShardMessage> > queue;
+        std::thread thread;
+        std::atomic<uint64_t> enqueued;
+        std::atomic<uint64_t> processed;
+        std::atomic<uint64_t> diffs_applied;
+        std::atomic<uint64_t> diffs_stale;
+        std::atomic<uint64_t> diffs_resynced;
+        std::atomic<uint64_t> diffs_out_of_sync;
+        std::atomic<uint64_t> diffs_buffered;
+        std::atomic<uint64_t> queue_full;
+
+        Shard();
+    };
+
+    Shard& shardFor(symbol_t symbol) { return *shards_[shardOf(symbol)]; }
+    const Shard& shardFor(symbol_t symbol) const { return *shards_[shardOf(symbol)]; }
+
+    // 放入分片队列，队列满时自旋等待（背压）
+    template <typename Fill>
+    void enqueue(Shard& shard, Fill fill);
+    void runShard(Shard& shard);
+    void processMessage(Shard& shard, ShardMessage& message);
+    void startThreads();
+    void stopThreads();
+
+    ShardedOrderbookConfig config_;
+    // 分片线程依次绑定的核，未开启绑核时为空
+    std::vector<int> cpus_;
+    // 所有分片共用，必须先于分片构造、后于分片析构
+    OrderbookNotifier notifier_;
+    std::vector<std::unique_ptr<Shard> > shards_;
+    std::atomic<bool> running_;
+    std::mutex lifecycle_mutex_;
+
+    ShardedOrderbookManager(const ShardedOrderbookManager&) = delete;
+    ShardedOrderbookManager& operator=(const ShardedOrderbookManager&) = delete;
+};
+
+} // namespace crypto_quant
+
+#endif // SHARDED_ORDERBOOK_MANAGER_H
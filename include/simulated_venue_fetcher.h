@@ -0,0 +1,103 @@
+#ifndef SIMULATED_VENUE_FETCHER_H
+#define SIMULATED_VENUE_FETCHER_H
+
+#include <stdint.h>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "crypto_quant.h"
+#include "market_data_recorder.h"
+
+namespace crypto_quant {
+
+// 模拟场所配置
+struct SimulatedVenueConfig {
+    // 推送间隔（毫秒）
+    uint32_t interval_ms;
+    // 买一卖一价差（基点）
+    double spread_bps;
+    // 相邻档位间隔（基点）
+    double level_step_bps;
+    // 相对参考价的最大偏离（基点），偏离按均值回复随机游走变化，偶尔与主场所交叉
+    double max_offset_bps;
+    double tick_size;
+    uint64_t seed;
+
+    SimulatedVenueConfig()
+        : interval_ms(100), spread_bps(2.0), level_step_bps(1.0), max_offset_bps(1.5),
+          tick_size(0.01), seed(0x9E3779B97F4A7C15ULL) {}
+};
+
+// 本地模拟的第二交易场所（测试合并订单薄、跨场所逻辑用）
+// 围绕参考价（通常是主场所的中间价）生成20档订单薄，报价相对参考价随机偏离；
+// 没有参考价时用内部随机游走。实现 IMarketDataFetcher，可替换真实场所的数据源。
+class SimulatedVenueFetcher : public IMarketDataFetcher {
+public:
+    explicit SimulatedVenueFetcher(const SimulatedVenueConfig& config = SimulatedVenueConfig());
+    ~SimulatedVenueFetcher();
+
+    bool initialize() override;
+    int start(symbol_t symbol) override;
+    void stop() override;
+    // 模拟场所不需要凭据和数据源选择
+    void setApiKey(const std::string& api_key, const std::string& api_secret) override;
+    void setDataSources(bool use_binance, bool use_coingecko) override;
+    void setOrderbookCallback(std::function<void(const orderbook_t&)> callback) override;
+    // 不支持增量深度流，只推送完整订单薄
+    void setDepthDiffCallback(std::function<void(const depth_diff_t&)> callback) override;
+    // 不生成成交
+    void setTradeCallback(std::function<void(const trade_t&)> callback) override;
+    // 返回当前模拟订单薄作为快照
+    bool fetchDepthSnapshot(symbol_t symbol, int limit, DepthSnapshot& snapshot) override;
+    orderbook_t getOrderbook(symbol_t symbol) const override;
+    // 增减模拟的交易对（只推送完整订单薄，忽略 streams）
+    int subscribe(symbol_t symbol, uint32_t streams) override;
+    int unsubscribe(symbol_t symbol) override;
+    // 录制推送的订单薄（没有原始消息）
+    void setRecorder(std::shared_ptr<MarketDataRecorder> recorder) override;
+
+    // 参考价来源，返回值<=0时使用内部随机游走
+    void setReferencePrice(std::function<double(symbol_t)> reference);
+    // 生成并保存下一份订单薄（不回调），测试中可直接驱动
+    orderbook_t step(symbol_t symbol);
+
+private:
+    struct SymbolState {
+        // 内部随机游走的中间价，0表示尚未初始化
+        double mid;
+        // 当前相对参考价的偏离（基点）
+        double offset_bps;
+        uint64_t update_id;
+        orderbook_t book;
+    };
+
+    SymbolState& stateFor(symbol_t symbol);
+    // [0, 1) 均匀分布
+    double uniform();
+    void run();
+
+    SimulatedVenueConfig config_;
+    std::function<void(const orderbook_t&)> orderbook_callback_;
+    std::function<double(symbol_t)> reference_;
+    std::shared_ptr<MarketDataRecorder> recorder_;
+    // 保护回调、参考价、随机数状态、交易对列表和各交易对状态
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::vector<SymbolState> states_;
+    uint64_t random_state_;
+    std::atomic<bool> running_;
+    std::vector<symbol_t> symbols_;
+    std::thread thread_;
+
+    SimulatedVenueFetcher(const SimulatedVenueFetcher&) = delete;
+    SimulatedVenueFetcher& operator=(const SimulatedVenueFetcher&) = delete;
+};
+
+} // namespace crypto_quant
+
+#endif // SIMULATED_VENUE_FETCHER_H
@@ -2,6 +2,7 @@
 #define STRATEGY_ENGINE_H
 
 #include "crypto_quant.h"
+#include "microstructure_features.h"
 #include <memory>
 #include <atomic>
 #include <mutex>
@@ -15,6 +16,8 @@ private:
     std::atomic<bool> initialized_;
     std::atomic<StrategyStatus> status_;
     mutable std::mutex mutex_;
+    // 策略收到的每次行情都先增量更新微观结构特征
+    MicrostructureFeatureEngine features_;
 
 public:
     StrategyEngine();
@@ -27,6 +30,10 @@ public:
     void pause() override;
     StrategyStatus getStatus() const override;
     void processMarketData(const orderbook_t& orderbook) override;
+    // 本地聚合收盘的 K 线（BarBuilder 回调）
+    void processBar(const bar_t& bar) override;
+    // 交易对的最新微观结构特征（无锁读取）
+    bool getFeatures(symbol_t symbol, microstructure_features_t& features) const;
 };
 
 } // namespace crypto_quant
@@ -0,0 +1,86 @@
+#ifndef SYMBOL_REGISTRY_H
+#define SYMBOL_REGISTRY_H
+
+#include <stdint.h>
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <string>
+
+#include "crypto_quant.h"
+
+namespace crypto_quant {
+
+// 交易对注册表
+// 运行时为交易对分配从0开始的稠密ID，订单薄、策略、执行器都以ID为下标直接索引。
+// 名称统一规范化为大写字母数字（"btc_usdt"、"BTC/USDT" 都视为 "BTCUSDT"），
+// 同时保存小写形式供拼接币安流名。
+// 注册在互斥锁下进行，条目发布后不再移动或修改；查询完全无锁，不分配内存。
+class SymbolRegistry {
+public:
+    // 最多可注册的交易对数量
+    static const size_t kMaxSymbols = 4096;
+    // 规范化后名称的最大长度
+    static const size_t kMaxNameLength = 23;
+
+    static SymbolRegistry& instance();
+
+    // 注册交易对，已存在时返回原ID；名称非法或注册表已满时返回 SYMBOL_INVALID
+    symbol_t registerSymbol(const char* name, size_t length);
+    symbol_t registerSymbol(const std::string& name) {
+        return registerSymbol(name.data(), name.size());
+    }
+
+    // 按名称查找（大小写、分隔符不敏感），不存在返回 SYMBOL_INVALID
+    symbol_t find(const char* name, size_t length) const;
+    symbol_t find(const std::string& name) const {
+        return find(name.data(), name.size());
+    }
+
+    // 按币安流名查找，如 "btcusdt@depth20@100ms"，只取 '@' 之前的部分
+    symbol_t findByStreamName(const char* stream, size_t length) const;
+    symbol_t findByStreamName(const std::string& stream) const {
+        return findByStreamName(stream.data(), stream.size());
+    }
+
+    // 规范名称（"BTCUSDT"），未注册返回空串
+    const char* name(symbol_t symbol) const;
+    // 小写流名前缀（"btcusdt"），未注册返回空串
+    const char* streamName(symbol_t symbol) const;
+
+    bool contains(symbol_t symbol) const {
+        return symbol < size();
+    }
+    // 已注册的交易对数量（ID 范围为 [0, size)）
+    size_t size() const {
+        return count_.load(std::memory_order_acquire);
+    }
+
+private:
+    SymbolRegistry();
+
+    struct Entry {
+        char name[kMaxNameLength + 1];
+        char stream[kMaxNameLength + 1];
+    };
+
+    // 开放寻址哈希表，容量为交易对上限的2倍；槽位保存 ID+1，0 表示空
+    static const size_t kTableSize = kMaxSymbols * 2;
+
+    // 把名称规范化为大写字母数字，返回长度；非法时返回0
+    static size_t normalize(const char* name, size_t length, char* out);
+    static uint32_t hash(const char* name, size_t length);
+    symbol_t lookup(const char* normalized, size_t length) const;
+
+    Entry entries_[kMaxSymbols];
+    std::atomic<uint32_t> table_[kTableSize];
+    std::atomic<size_t> count_;
+    std::mutex mutex_;
+
+    SymbolRegistry(const SymbolRegistry&) = delete;
+    SymbolRegistry& operator=(const SymbolRegistry&) = delete;
+};
+
+} // namespace crypto_quant
+
+#endif // SYMBOL_REGISTRY_H
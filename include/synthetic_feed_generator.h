@@ -0,0 +1,143 @@
+#ifndef SYNTHETIC_FEED_GENERATOR_H
+#define SYNTHETIC_FEED_GENERATOR_H
+
+#include <stdint.h>
+#include <vector>
+
+#include "crypto_quant.h"
+
+namespace crypto_quant {
+
+// 合成行情模型参数（与 strategies/stochastic_process 中的 Python 模型对应）
+struct SyntheticFeedConfig {
+    // 所有交易对合计的事件速率（次/秒），事件按泊松过程到达，随机落在各交易对上
+    double event_rate;
+    // 中间价：Merton 跳跃扩散（年化参数，一年按365天），jump_intensity 为0时即几何布朗运动
+    // initial_price <= 0 时按交易对生成不同的起始价
+    double initial_price;
+    double drift;
+    double volatility;
+    // 每年跳跃次数，跳跃幅度为对数正态 N(jump_mean, jump_volatility^2)
+    double jump_intensity;
+    double jump_mean;
+    double jump_volatility;
+    // 买一卖一价差（基点）：OU 均值回复过程，回复速度和波动按秒计
+    double spread_mean_bps;
+    double spread_reversion;
+    double spread_volatility_bps;
+    // 每侧档位数和档位间隔（基点），价格落在 tick 的整数倍上
+    uint32_t levels;
+    double level_step_bps;
+    double tick_size;
+    // 每个事件中盘口数量变化的平均次数（泊松），以及档位数量的均值
+    double level_updates_per_event;
+    double mean_quantity;
+    // 每个事件伴随一笔成交的概率（按买一/卖一价成交，不改变订单薄）
+    double trade_probability;
+    uint64_t seed;
+
+    SyntheticFeedConfig()
+        : event_rate(1000.0), initial_price(0.0), drift(0.0), volatility(0.6),
+          jump_intensity(365.0), jump_mean(0.0), jump_volatility(0.005),
+          spread_mean_bps(2.0), spread_reversion(5.0), spread_volatility_bps(2.0),
+          levels(20), level_step_bps(1.0), tick_size(0.01),
+          level_updates_per_event(2.0), mean_quantity(1.0), trade_probability(0.2),
+          seed(0x9E3779B97F4A7C15ULL) {}
+};
+
+// 合成行情生成器：按随机过程演化各交易对的订单薄并输出增量深度
+// 中间价走 Merton 跳跃扩散，价差走 OU 过程，事件到达和每个事件的盘口数量变化为泊松过程；
+// 每侧档位是以档位间隔为步长的连续价格阶梯，价格移动时移出的档位以数量0删除、移入的档位带新数量，
+// 因此增量序列与 fillSnapshot 的快照一致，可直接交给订单薄管理器按更新ID应用。
+// 同一配置和种子生成的序列完全相同。不加锁，调用方负责串行化；生成过程不分配内存。
+class SyntheticFeedGenerator {
+public:
+    explicit SyntheticFeedGenerator(const SyntheticFeedConfig& config = SyntheticFeedConfig());
+
+    // 增减参与 next() 的交易对（加入时以当前模拟时间初始化订单薄，移除后状态保留）
+    void addSymbol(symbol_t symbol);
+    void removeSymbol(symbol_t symbol);
+    const std::vector<symbol_t>& symbols() const { return symbols_; }
+
+    // 模拟时钟（纳秒，Unix 纪元），next() 按泊松到达间隔推进
+    void setTime(uint64_t time_ns) { clock_ns_ = time_ns; }
+    uint64_t now() const { return clock_ns_; }
+
+    // 生成下一个事件：推进模拟时钟并随机选择一个交易对更新，没有交易对时返回 nullptr
+    // 返回的增量（及其档位数组）在下一次生成前有效
+    const depth_diff_t* next();
+    // 把交易对演化到 time_ns 并生成一次更新（不推进模拟时钟）
+    const depth_diff_t& step(symbol_t symbol, uint64_t time_ns);
+    // 最近一次生成的事件伴随的成交，没有时返回 nullptr
+    const trade_t* trade() const { return has_trade_ ? &trade_ : nullptr; }
+
+    // 当前订单薄（前20档）和快照（前 limit 档），尚未生成过的交易对先初始化
+    void fillOrderbook(symbol_t symbol, orderbook_t& orderbook);
+    void fillSnapshot(symbol_t symbol, size_t limit, DepthSnapshot& snapshot);
+
+private:
+    // xorshift 随机数流：[0, 1) 均匀分布、标准正态分布、泊松分布
+    struct RandomStream {
+        uint64_t state;
+        bool has_spare_normal;
+        double spare_normal;
+
+        void seed(uint64_t value);
+        double uniform();
+        double normal();
+        uint32_t poisson(double mean);
+    };
+
+    struct SymbolState {
+        bool initialized;
+        // 每个交易对独立的随机数流，演化结果不受其他交易对和快照请求时机的影响
+        RandomStream random;
+        double mid;
+        double spread_bps;
+        uint64_t time_ns;
+        uint64_t update_id;
+        uint64_t trade_id;
+        // 档位间隔（tick 数），初始化时按起始价确定
+        int64_t step_ticks;
+        // 买一、卖一在档位阶梯上的下标（价格 = 下标 * step_ticks * tick）
+        int64_t bid_index;
+        int64_t ask_index;
+        // 各档数量，按阶梯下标对档位数取模存放（窗口连续，移动时只覆盖移入的档位）
+        std::vector<double> bid_quantities;
+        std::vector<double> ask_quantities;
+    };
+
+    SymbolState& stateFor(symbol_t symbol);
+    // 中间价和价差演化 dt 秒后重新计算买一卖一下标
+    void evolve(SymbolState& state, double dt);
+    // 一侧的档位窗口从 [old_low, old_low + levels) 移到 [new_low, new_low + levels)：输出删除和新增的档位
+    void shiftSide(SymbolState& state, bool bid, int64_t old_low, int64_t new_low, uint64_t timestamp_ms);
+    // 在增量里设置某价格的数量，已存在则覆盖
+    void setLevel(bool bid, double price, double quantity, uint64_t timestamp_ms);
+    double levelPrice(const SymbolState& state, int64_t index) const;
+    double& quantityAt(SymbolState& state, bool bid, int64_t index);
+    double drawQuantity(RandomStream& random);
+
+    SyntheticFeedConfig config_;
+    std::vector<SymbolState> states_;
+    std::vector<symbol_t> symbols_;
+    uint64_t clock_ns_;
+    // 到达间隔和交易对选择
+    RandomStream arrivals_;
+    // tick 换算：tick 的倒数为整数时用除法，使价格与交易所文本解析出的 double 一致
+    double ticks_per_unit_;
+    bool exact_division_;
+    // Merton 漂移补偿项 lambda * (E[e^J] - 1)
+    double jump_compensator_;
+
+    // 本次事件的增量，档位数组复用
+    depth_diff_t diff_;
+    std::vector<price_level_t> bid_levels_;
+    std::vector<price_level_t> ask_levels_;
+    trade_t trade_;
+    bool has_trade_;
+};
+
+} // namespace crypto_quant
+
+#endif // SYNTHETIC_FEED_GENERATOR_H
@@ -0,0 +1,87 @@
+#ifndef SYNTHETIC_MARKET_DATA_FETCHER_H
+#define SYNTHETIC_MARKET_DATA_FETCHER_H
+
+#include <stdint.h>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "crypto_quant.h"
+#include "market_data_recorder.h"
+#include "synthetic_feed_generator.h"
+
+namespace crypto_quant {
+
+struct SyntheticMarketDataConfig {
+    SyntheticFeedConfig feed;
+    // true 时按墙钟节奏推送（模拟时间与墙钟同步）；false 时尽快生成，模拟时间快于墙钟
+    bool realtime;
+
+    SyntheticMarketDataConfig() : realtime(true) {}
+};
+
+// 合成行情源：用 SyntheticFeedGenerator 按配置的事件速率生成多个交易对的增量深度/订单薄，
+// 与实盘走同一回调路径，离线压测整个行情处理链路（解析之后的部分）。
+// 快照请求返回生成器的当前订单薄，增量缺口时订单薄管理器可正常重新同步。
+class SyntheticMarketDataFetcher : public IMarketDataFetcher {
+public:
+    explicit SyntheticMarketDataFetcher(const SyntheticMarketDataConfig& config = SyntheticMarketDataConfig());
+    ~SyntheticMarketDataFetcher();
+
+    bool initialize() override;
+    // 订阅 symbol 并开始生成；已在运行时等同于 subscribe(symbol, 0)
+    int start(symbol_t symbol) override;
+    void stop() override;
+    // 合成行情不需要凭据和数据源选择
+    void setApiKey(const std::string& api_key, const std::string& api_secret) override;
+    void setDataSources(bool use_binance, bool use_coingecko) override;
+    // 回调在生成线程上调用，不持有内部锁（回调中可以请求快照）；回调和录制器须在 start 之前设置
+    void setOrderbookCallback(std::function<void(const orderbook_t&)> callback) override;
+    void setDepthDiffCallback(std::function<void(const depth_diff_t&)> callback) override;
+    // 生成器按 trade_probability 伴随事件产生的成交（订阅 MARKET_STREAM_TRADE / MARKET_STREAM_AGG_TRADE）
+    void setTradeCallback(std::function<void(const trade_t&)> callback) override;
+    bool fetchDepthSnapshot(symbol_t symbol, int limit, DepthSnapshot& snapshot) override;
+    orderbook_t getOrderbook(symbol_t symbol) const override;
+    // streams 为0时：设置了增量深度回调则推送增量，否则推送完整订单薄；设置了成交回调时加上归集成交
+    int subscribe(symbol_t symbol, uint32_t streams) override;
+    int unsubscribe(symbol_t symbol) override;
+    // 按模拟时间录制推送的增量/订单薄/成交
+    void setRecorder(std::shared_ptr<MarketDataRecorder> recorder) override;
+
+    // 已生成的事件数和模拟时钟（纳秒）
+    uint64_t eventCount() const { return events_.load(std::memory_order_relaxed); }
+    uint64_t now() const { return clock_ns_.load(std::memory_order_relaxed); }
+
+private:
+    void run();
+    // 按墙钟等到模拟时间 time_ns，停止时返回 false
+    bool pace(uint64_t time_ns, uint64_t sim_base_ns, uint64_t wall_base_ns);
+
+    SyntheticMarketDataConfig config_;
+    // 保护生成器、订阅、回调和录制器；生成线程每个事件加锁一次，回调在锁外调用
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    mutable SyntheticFeedGenerator generator_;
+    // 按 symbol_t 索引的订阅流（market_stream_t 组合）
+    std::vector<uint32_t> streams_;
+    std::function<void(const orderbook_t&)> orderbook_callback_;
+    std::function<void(const depth_diff_t&)> diff_callback_;
+    std::function<void(const trade_t&)> trade_callback_;
+    std::shared_ptr<MarketDataRecorder> recorder_;
+    std::atomic<bool> running_;
+    std::thread thread_;
+
+    std::atomic<uint64_t> events_;
+    std::atomic<uint64_t> clock_ns_;
+
+    SyntheticMarketDataFetcher(const SyntheticMarketDataFetcher&) = delete;
+    SyntheticMarketDataFetcher& operator=(const SyntheticMarketDataFetcher&) = delete;
+};
+
+} // namespace crypto_quant
+
+#endif // SYNTHETIC_MARKET_DATA_FETCHER_H
@@ -7,43 +7,86 @@
 #include <thread>
 #include <functional>
 #include <memory>
+#include <vector>
 
 #include "crypto_quant.h"
+#include "websocket_connection.h"
+#include "binance_message_parser.h"
+#include "market_data_recorder.h"
 
 namespace crypto_quant {
 
-// WebSocket 客户端类
+// 币安行情 WebSocket 客户端：在 WebSocketConnection 之上解析深度、成交消息和请求应答
+// 可与其他客户端共享一个事件循环线程；不传事件循环时自带一个
 class WebSocketClient {
 private:
     std::string url_;
-    void* curl_;  // CURL* 类型，使用 void* 避免在头文件中暴露 curl 头文件
-    std::thread worker_thread_;
+    std::shared_ptr<WebSocketEventLoop> loop_;
+    bool owns_loop_;
+    std::shared_ptr<WebSocketConnection> connection_;
     std::atomic<bool> is_running_;
     std::function<void(const orderbook_t*)> callback_;
+    std::function<void(const depth_diff_t*)> diff_callback_;
+    std::function<void(const trade_t*)> trade_callback_;
+    std::function<void(bool)> state_callback_;
+    std::function<void(uint64_t, bool)> response_callback_;
+    // 原始消息录制（start 之前设置，事件循环线程读取）
+    std::shared_ptr<MarketDataRecorder> recorder_;
     mutable std::mutex mutex_;
     std::atomic<bool> initialized_;
+    // 无法解析的消息数
+    std::atomic<uint64_t> parse_errors_;
+    // 解析完成后打时间戳（start 之前设置），以及当前消息的解析完成时间（仅事件循环线程使用）
+    bool timestamps_;
+    uint64_t parsed_ns_;
+    // 当前消息的原始负载（仅事件循环线程使用，只在消息回调期间有效）
+    const char* message_data_;
+    size_t message_size_;
+
+    // 消息解析器（仅事件循环线程使用，内部缓冲复用，稳态下不分配内存）
+    BinanceMessageParser parser_;
 
     // 禁止拷贝和赋值
     WebSocketClient(const WebSocketClient&) = delete;
     WebSocketClient& operator=(const WebSocketClient&) = delete;
 
     // 内部方法
-    size_t onDataReceived(char* data, size_t size);
-    orderbook_t parseOrderbook(const void* json_obj, const std::string& stream_name) const;  // json_obj 是 json* 类型
-    void workerThread();
-
-    // CURL 回调函数
-    static size_t writeCallback(char* ptr, size_t size, size_t nmemb, void* userdata);
+    void onDataReceived(const char* data, size_t size);
+    void recordParseError(const char* what);
 
 public:
-    explicit WebSocketClient(const std::string& url);
+    explicit WebSocketClient(const std::string& url,
+                             std::shared_ptr<WebSocketEventLoop> loop = std::shared_ptr<WebSocketEventLoop>(),
+                             const WebSocketConfig& config = WebSocketConfig());
     ~WebSocketClient();
 
     void setCallback(std::function<void(const orderbook_t*)> callback);
+    void setDiffCallback(std::function<void(const depth_diff_t*)> callback);
+    void setTradeCallback(std::function<void(const trade_t*)> callback);
+    // 连接建立（true）或断开（false），每次重连成功都会调用，可在此重新订阅
+    void setStateCallback(std::function<void(bool open)> callback);
+    // 订阅/退订请求的应答：请求ID，成功为 true
+    void setResponseCallback(std::function<void(uint64_t id, bool ok)> callback);
+    // 录制收到的原始消息（须在 start 之前设置）
+    void setRecorder(std::shared_ptr<MarketDataRecorder> recorder);
+    // 为延迟统计在解析完成时打时间戳（须在 start 之前设置）
+    void setTimestamping(bool enabled);
+    // 当前消息的读出时间和解析完成时间（系统时钟纳秒），只能在消息回调中读取；未打时间戳时为0
+    uint64_t receiveNs() const { return timestamps_ ? connection_->lastReadNs() : 0; }
+    uint64_t parsedNs() const { return parsed_ns_; }
+    // 当前消息的原始负载，只能在消息回调中读取（冗余线路仲裁后录制胜出的原始消息）
+    const char* messageData() const { return message_data_; }
+    size_t messageSize() const { return message_size_; }
+    // 发送文本消息（如 SUBSCRIBE 请求），未连接时排队到连接建立后发出
+    bool send(const std::string& text);
     bool start();
     bool stop();
     bool isRunning() const;
     bool isInitialized() const;
+    // 握手完成、正在收数据
+    bool isConnected() const;
+    WebSocketConnectionStats getStats() const;
+    uint64_t getParseErrors() const;
 };
 
 } // namespace crypto_quant
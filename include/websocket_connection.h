@@ -0,0 +1,273 @@
+#ifndef WEBSOCKET_CONNECTION_H
+#define WEBSOCKET_CONNECTION_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "utils/receive_buffer.h"
+
+// OpenSSL 类型前置声明，避免在头文件中暴露 OpenSSL 头文件
+typedef struct ssl_st SSL;
+typedef struct ssl_ctx_st SSL_CTX;
+
+namespace crypto_quant {
+
+// WebSocket 连接配置
+struct WebSocketConfig {
+    // TCP 连接 + TLS 握手 + HTTP 升级的总超时（毫秒）
+    uint32_t connect_timeout_ms;
+    // 超过该时间没有收到任何数据时主动发 ping（毫秒，0 关闭）
+    uint32_t ping_interval_ms;
+    // 超过该时间没有收到任何数据时认为连接已死并重连（毫秒，0 关闭）
+    uint32_t idle_timeout_ms;
+    // 重连退避的初始值和上限（毫秒），每次失败翻倍并加随机抖动
+    uint32_t reconnect_initial_ms;
+    uint32_t reconnect_max_ms;
+    // 单条消息（含分片重组后）的最大字节数，超过视为协议错误
+    size_t max_message_size;
+    // 校验服务端证书和主机名
+    bool verify_peer;
+
+    WebSocketConfig()
+        : connect_timeout_ms(10000), ping_interval_ms(15000), idle_timeout_ms(60000),
+          reconnect_initial_ms(100), reconnect_max_ms(30000),
+          max_message_size(16 * 1024 * 1024), verify_peer(true) {}
+};
+
+enum class WebSocketState {
+    DISCONNECTED,
+    CONNECTING,      // TCP 非阻塞连接中
+    TLS_HANDSHAKE,
+    UPGRADING,       // 已发送 HTTP Upgrade，等待 101 响应
+    OPEN,
+    RECONNECT_WAIT   // 出错后等待退避时间
+};
+
+// 连接统计（计数器单调递增，任意线程可读）
+struct WebSocketConnectionStats {
+    uint64_t messages_received;
+    uint64_t bytes_received;
+    uint64_t messages_sent;
+    uint64_t pings_received;
+    uint64_t pongs_received;
+    uint64_t connects;
+    uint64_t disconnects;
+    uint64_t protocol_errors;
+};
+
+class WebSocketEventLoop;
+
+// 单个 RFC 6455 客户端连接（ws:// 或 wss://）
+// 所有套接字和 TLS 操作都在所属事件循环线程上执行；send() 可在任意线程调用，
+// 消息进入发送队列后由循环线程掩码、分帧并写出。
+// 消息和状态回调在循环线程上调用，不能阻塞，否则会拖慢同一线程上的所有连接。
+class WebSocketConnection : public std::enable_shared_from_this<WebSocketConnection> {
+public:
+    // 完整消息（分片已重组），data 直接指向接收缓冲，只在回调期间有效
+    typedef std::function<void(const char* data, size_t size, bool binary)> MessageHandler;
+    // 连接建立（true）或断开（false）
+    typedef std::function<void(bool open)> StateHandler;
+
+    explicit WebSocketConnection(const std::string& url, const WebSocketConfig& config = WebSocketConfig());
+    ~WebSocketConnection();
+
+    // 回调须在加入事件循环前设置
+    void setMessageHandler(MessageHandler handler);
+    void setStateHandler(StateHandler handler);
+
+    // 发送文本消息；连接未建立时排队，在连接建立后按顺序发出
+    bool send(const std::string& text);
+
+    bool isValid() const { return valid_; }
+    const std::string& url() const { return url_; }
+    WebSocketState state() const { return state_.load(std::memory_order_acquire); }
+    WebSocketConnectionStats getStats() const;
+    // 最近一次从套接字读到数据的系统时钟时间（纳秒），只在循环线程上（如消息回调中）读取
+    uint64_t lastReadNs() const { return last_read_ns_; }
+
+private:
+    friend class WebSocketEventLoop;
+
+    enum Opcode {
+        OPCODE_CONTINUATION = 0x0,
+        OPCODE_TEXT = 0x1,
+        OPCODE_BINARY = 0x2,
+        OPCODE_CLOSE = 0x8,
+        OPCODE_PING = 0x9,
+        OPCODE_PONG = 0xA
+    };
+
+    bool parseUrl(const std::string& url);
+
+    // 以下方法只在循环线程上调用
+    void beginConnect(uint64_t now_ms);
+    // 依次尝试尚未尝试的解析地址，全部失败时按 last_error 报错并等待重连
+    void connectNext(int last_error);
+    void onEvent(uint32_t events, uint64_t now_ms);
+    void onTimer(uint64_t now_ms);
+    uint64_t nextDeadline() const;
+    void onConnected();
+    void continueTlsHandshake();
+    void sendUpgradeRequest();
+    bool processUpgradeResponse();
+    void onOpen();
+    bool readAvailable();
+    bool processFrames();
+    bool handleFrame(int opcode, bool fin, char* payload, size_t length, size_t frame_size);
+    // 跳过已处理的帧：分片重组期间只前移解析位置，否则直接释放
+    void advance(size_t frame_size);
+    void queueFrame(int opcode, const char* payload, size_t length);
+    bool flushOutput();
+    void flushPendingSends();
+    void updateInterest();
+    void deliver(const char* data, size_t size, bool binary);
+    void fail(const std::string& reason);
+    void scheduleReconnect();
+    void teardown(bool graceful);
+    void closeSocket();
+
+    std::string url_;
+    bool valid_;
+    bool tls_;
+    std::string host_;
+    std::string port_;
+    std::string path_;
+    WebSocketConfig config_;
+
+    // 域名解析结果（sockaddr 按字节保存），每次建立连接时重新解析
+    struct ResolvedAddress {
+        int family;
+        int socktype;
+        int protocol;
+        std::string address;
+    };
+    std::vector<ResolvedAddress> addresses_;
+    size_t address_index_;
+    MessageHandler message_handler_;
+    StateHandler state_handler_;
+
+    std::atomic<WebSocketEventLoop*> loop_;
+    int fd_;
+    SSL* ssl_;
+    std::atomic<WebSocketState> state_;
+    // 最近一次 TLS 操作返回 SSL_ERROR_WANT_WRITE，需要等待可写
+    bool ssl_wants_write_;
+    uint32_t interest_;
+    std::string handshake_key_;
+
+    // 接收缓冲，帧头和负载都在其中原地解析
+    ReceiveBuffer rx_buffer_;
+    // 分片重组期间已解析但尚未释放的字节数；已收到的分片负载依次搬到缓冲开头
+    // [0, fragment_size_)，中间的帧头被覆盖，重组不需要额外的缓冲
+    size_t rx_parsed_;
+    size_t fragment_size_;
+    int fragment_opcode_;
+    bool in_fragment_;
+    // 发送缓冲：[tx_offset_, tx_buffer_.size()) 尚未写出
+    std::string tx_buffer_;
+    size_t tx_offset_;
+
+    // 跨线程发送队列
+    std::mutex send_mutex_;
+    std::vector<std::string> pending_sends_;
+
+    // 循环线程当前处理事件的时间（单调时钟毫秒）
+    uint64_t now_ms_;
+    uint64_t connect_started_ms_;
+    uint64_t last_receive_ms_;
+    uint64_t last_read_ns_;
+    uint64_t reconnect_at_ms_;
+    uint32_t reconnect_attempts_;
+    bool ping_outstanding_;
+    // 重连抖动用的随机数状态
+    uint64_t random_state_;
+
+    std::atomic<uint64_t> messages_received_;
+    std::atomic<uint64_t> bytes_received_;
+    std::atomic<uint64_t> messages_sent_;
+    std::atomic<uint64_t> pings_received_;
+    std::atomic<uint64_t> pongs_received_;
+    std::atomic<uint64_t> connects_;
+    std::atomic<uint64_t> disconnects_;
+    std::atomic<uint64_t> protocol_errors_;
+
+    WebSocketConnection(const WebSocketConnection&) = delete;
+    WebSocketConnection& operator=(const WebSocketConnection&) = delete;
+};
+
+// 基于 epoll 的非阻塞事件循环，一个线程驱动任意多个连接
+// 断线后按指数退避在循环内重连，不阻塞其他连接
+class WebSocketEventLoop {
+public:
+    WebSocketEventLoop();
+    ~WebSocketEventLoop();
+
+    bool start();
+    // 向所有打开的连接发送 close 帧后关闭套接字并结束线程
+    void stop();
+    bool isRunning() const { return running_.load(); }
+
+    // 加入连接，任意线程可调用，连接在循环线程上发起
+    bool add(std::shared_ptr<WebSocketConnection> connection);
+    // 移除并关闭连接；在其他线程调用时等待循环线程处理完毕，返回后不再有该连接的回调
+    void remove(std::shared_ptr<WebSocketConnection> connection);
+    size_t connectionCount() const;
+    // 把任务投递到循环线程上执行，使其与连接回调处于同一线程；循环停止时未执行的任务被丢弃
+    bool runInLoop(std::function<void()> task);
+
+private:
+    friend class WebSocketConnection;
+
+    enum CommandType {
+        COMMAND_ADD,
+        COMMAND_REMOVE,
+        COMMAND_SEND,
+        COMMAND_TASK
+    };
+
+    struct Command {
+        CommandType type;
+        std::shared_ptr<WebSocketConnection> connection;
+        // COMMAND_TASK 时执行的任务（connection 为空）
+        std::function<void()> task;
+    };
+
+    void run();
+    void post(CommandType type, std::shared_ptr<WebSocketConnection> connection);
+    void wake();
+    void processCommands(uint64_t now_ms);
+    void runTimers(uint64_t now_ms);
+    // 连接的截止时间提前时通知循环重新计算 epoll 超时
+    void scheduleTimer(uint64_t deadline_ms);
+
+    int epoll_fd_;
+    int wake_fd_;
+    SSL_CTX* ssl_ctx_;
+    SSL_CTX* ssl_ctx_no_verify_;
+    std::atomic<bool> running_;
+    std::thread thread_;
+
+    std::mutex command_mutex_;
+    std::condition_variable command_cv_;
+    std::vector<Command> commands_;
+    std::thread::id loop_thread_id_;
+    std::vector<std::shared_ptr<WebSocketConnection> > connections_;
+    std::atomic<size_t> connection_count_;
+    // 下一次需要扫描连接定时器的时间
+    uint64_t next_timer_ms_;
+
+    WebSocketEventLoop(const WebSocketEventLoop&) = delete;
+    WebSocketEventLoop& operator=(const WebSocketEventLoop&) = delete;
+};
+
+} // namespace crypto_quant
+
+#endif // WEBSOCKET_CONNECTION_H
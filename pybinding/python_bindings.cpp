@@ -4,6 +4,11 @@
 #include <pybind11/numpy.h>
 #include <pybind11/chrono.h>
 #include "crypto_quant.h"
+#include "symbol_registry.h"
+#include "fixed_point.h"
+#include "consolidated_orderbook.h"
+#include "simulated_venue_fetcher.h"
+#include "microstructure_features.h"
 
 namespace py = pybind11;
 using namespace crypto_quant;
@@ -48,13 +53,30 @@ void bind_market_data(py::module& m) {
         })
         .def_readwrite("bid_count", &orderbook_t::bid_count)
         .def_readwrite("ask_count", &orderbook_t::ask_count)
-        .def_readwrite("timestamp", &orderbook_t::timestamp);
+        .def_readwrite("timestamp", &orderbook_t::timestamp)
+        .def_readwrite("last_update_id", &orderbook_t::last_update_id);
     
-    // 绑定 symbol_t 枚举
-    py::enum_<symbol_t>(m, "Symbol")
-        .value("BTC_USDT", SYMBOL_BTC_USDT)
-        .value("ETH_USDT", SYMBOL_ETH_USDT)
-        .value("BTC_ETH", SYMBOL_BTC_ETH);
+    // symbol_t 是注册表分配的整数ID，预注册的交易对以常量形式提供
+    m.attr("SYMBOL_BTC_USDT") = SYMBOL_BTC_USDT;
+    m.attr("SYMBOL_ETH_USDT") = SYMBOL_ETH_USDT;
+    m.attr("SYMBOL_BTC_ETH") = SYMBOL_BTC_ETH;
+    m.attr("SYMBOL_INVALID") = SYMBOL_INVALID;
+
+    // 绑定交易对注册表（单例）
+    py::class_<SymbolRegistry, std::unique_ptr<SymbolRegistry, py::nodelete>>(m, "SymbolRegistry")
+        .def_static("instance", &SymbolRegistry::instance, py::return_value_policy::reference)
+        .def("register_symbol", [](SymbolRegistry& self, const std::string& name) {
+            return self.registerSymbol(name);
+        })
+        .def("find", [](const SymbolRegistry& self, const std::string& name) {
+            return self.find(name);
+        })
+        .def("find_by_stream_name", [](const SymbolRegistry& self, const std::string& stream) {
+            return self.findByStreamName(stream);
+        })
+        .def("name", &SymbolRegistry::name)
+        .def("stream_name", &SymbolRegistry::streamName)
+        .def("size", &SymbolRegistry::size);
     
     // 绑定 IMarketDataFetcher 接口
     py::class_<IMarketDataFetcher, std::shared_ptr<IMarketDataFetcher>>(m, "MarketDataFetcher")
@@ -64,11 +86,59 @@ void bind_market_data(py::module& m) {
         .def("set_orderbook_callback", &IMarketDataFetcher::setOrderbookCallback)
         .def("get_orderbook", &IMarketDataFetcher::getOrderbook)
         .def("set_api_key", &IMarketDataFetcher::setApiKey)
-        .def("set_data_sources", &IMarketDataFetcher::setDataSources);
+        .def("set_data_sources", &IMarketDataFetcher::setDataSources)
+        .def("subscribe", &IMarketDataFetcher::subscribe, py::arg("symbol"), py::arg("streams") = 0)
+        .def("unsubscribe", &IMarketDataFetcher::unsubscribe);
+
+    m.attr("MARKET_STREAM_DEPTH") = static_cast<uint32_t>(MARKET_STREAM_DEPTH);
+    m.attr("MARKET_STREAM_DEPTH_DIFF") = static_cast<uint32_t>(MARKET_STREAM_DEPTH_DIFF);
+
+    // 本地模拟场所
+    py::class_<SimulatedVenueFetcher, IMarketDataFetcher, std::shared_ptr<SimulatedVenueFetcher>>(m, "SimulatedVenueFetcher")
+        .def(py::init<>())
+        .def("set_reference_price", &SimulatedVenueFetcher::setReferencePrice)
+        .def("step", &SimulatedVenueFetcher::step);
+
+    m.attr("VENUE_BINANCE") = VENUE_BINANCE;
+    m.attr("VENUE_SIMULATED") = VENUE_SIMULATED;
 }
 
 // 订单薄模块绑定
 void bind_orderbook(py::module& m) {
+    // 盘口摘要以 NumPy 结构化数组返回
+    PYBIND11_NUMPY_DTYPE(top_of_book_t, symbol, valid, bid_price, bid_quantity, ask_price,
+                         ask_quantity, mid_price, spread, timestamp, last_update_id);
+
+    // 绑定合并订阅（wait 期间释放 GIL）
+    py::class_<IOrderbookSubscription, std::shared_ptr<IOrderbookSubscription>>(m, "OrderbookSubscription")
+        .def("id", &IOrderbookSubscription::id)
+        .def("poll", [](IOrderbookSubscription& self, size_t max_count) {
+                std::vector<symbol_t> symbols(max_count);
+                symbols.resize(self.poll(symbols.data(), max_count));
+                return symbols;
+             }, py::arg("max_count") = 64)
+        .def("wait", [](IOrderbookSubscription& self, int timeout_ms, size_t max_count) {
+                std::vector<symbol_t> symbols(max_count);
+                {
+                    py::gil_scoped_release release;
+                    symbols.resize(self.wait(symbols.data(), max_count, timeout_ms));
+                }
+                return symbols;
+             }, py::arg("timeout_ms"), py::arg("max_count") = 64)
+        .def("close", &IOrderbookSubscription::close);
+
+    // 绑定订单薄完整性统计
+    py::class_<orderbook_integrity_stats_t>(m, "OrderbookIntegrityStats")
+        .def_readonly("checked", &orderbook_integrity_stats_t::checked)
+        .def_readonly("crossed", &orderbook_integrity_stats_t::crossed)
+        .def_readonly("non_monotonic", &orderbook_integrity_stats_t::non_monotonic)
+        .def_readonly("stale_timestamp", &orderbook_integrity_stats_t::stale_timestamp)
+        .def_readonly("sequence_gap", &orderbook_integrity_stats_t::sequence_gap)
+        .def_readonly("quarantined", &orderbook_integrity_stats_t::quarantined)
+        .def_readonly("resync_requested", &orderbook_integrity_stats_t::resync_requested)
+        .def_readonly("resync_failed", &orderbook_integrity_stats_t::resync_failed)
+        .def_readonly("recovered", &orderbook_integrity_stats_t::recovered);
+
     // 绑定 IOrderbookManager 接口
     py::class_<IOrderbookManager, std::shared_ptr<IOrderbookManager>>(m, "OrderbookManager")
         .def("initialize", &IOrderbookManager::initialize)
@@ -83,8 +153,77 @@ void bind_orderbook(py::module& m) {
              py::arg("symbol"), py::arg("levels") = 5)
         .def("get_ask_depth", &IOrderbookManager::getAskDepth,
              py::arg("symbol"), py::arg("levels") = 5)
+        .def("get_depth_within_bps", &IOrderbookManager::getDepthWithinBps,
+             py::arg("symbol"), py::arg("bps"), py::arg("bid"))
+        .def("get_vwap", &IOrderbookManager::getVwap,
+             py::arg("symbol"), py::arg("levels"), py::arg("bid"))
+        // 返回 (成交金额, 可成交数量)
+        .def("get_cost_to_fill", [](const IOrderbookManager& manager, symbol_t symbol,
+                                    double quantity, bool buy) {
+                double filled = 0.0;
+                double cost = manager.getCostToFill(symbol, quantity, buy, &filled);
+                return py::make_tuple(cost, filled);
+             }, py::arg("symbol"), py::arg("quantity"), py::arg("buy"))
         .def("get_timestamp", &IOrderbookManager::getTimestamp)
-        .def("is_valid", &IOrderbookManager::isValid);
+        .def("is_valid", &IOrderbookManager::isValid)
+        .def("get_top_of_book", [](const IOrderbookManager& manager, const std::vector<symbol_t>& symbols) {
+                py::array_t<top_of_book_t> result(static_cast<py::ssize_t>(symbols.size()));
+                manager.getTopOfBook(symbols.data(), symbols.size(), result.mutable_data());
+                return result;
+             }, py::arg("symbols"))
+        .def("subscribe_conflated", &IOrderbookManager::subscribeConflated,
+             py::arg("symbol") = SYMBOL_INVALID)
+        .def("subscribe_every_update", &IOrderbookManager::subscribeEveryUpdate,
+             py::arg("symbol"), py::arg("callback"))
+        .def("unsubscribe", &IOrderbookManager::unsubscribe)
+        .def("dropped_updates", &IOrderbookManager::droppedUpdates)
+        .def("is_quarantined", &IOrderbookManager::isQuarantined)
+        .def("get_integrity_stats", &IOrderbookManager::getIntegrityStats)
+        .def("set_history_capacity", &IOrderbookManager::setHistoryCapacity,
+             py::arg("symbol"), py::arg("capacity"))
+        .def("get_orderbook_at", [](const IOrderbookManager& manager, symbol_t symbol, uint64_t timestamp) {
+                orderbook_t orderbook;
+                if (!manager.getOrderbookAt(symbol, timestamp, orderbook)) {
+                    return py::object(py::none());
+                }
+                return py::object(py::cast(orderbook));
+             }, py::arg("symbol"), py::arg("timestamp"))
+        .def("get_orderbooks_in_range", [](const IOrderbookManager& manager, symbol_t symbol,
+                                           uint64_t from, uint64_t to) {
+                std::vector<orderbook_t> orderbooks;
+                manager.forEachOrderbookInRange(symbol, from, to, [&orderbooks](const orderbook_t& orderbook) {
+                    orderbooks.push_back(orderbook);
+                    return true;
+                });
+                return orderbooks;
+             }, py::arg("symbol"), py::arg("from_timestamp"), py::arg("to_timestamp"));
+
+    // 多场所合并订单薄；档位以 (价格, 合计数量, {场所: 数量}) 列表返回
+    py::class_<ConsolidatedOrderbook, std::shared_ptr<ConsolidatedOrderbook>>(m, "ConsolidatedOrderbook")
+        .def(py::init<>())
+        .def("update", &ConsolidatedOrderbook::update, py::arg("venue"), py::arg("orderbook"))
+        .def("remove_venue", &ConsolidatedOrderbook::removeVenue, py::arg("venue"), py::arg("symbol"))
+        .def("clear", &ConsolidatedOrderbook::clear)
+        .def("get_orderbook", &ConsolidatedOrderbook::getOrderbook)
+        .def("get_levels", [](const ConsolidatedOrderbook& book, symbol_t symbol, bool bid, size_t max_levels) {
+                std::vector<consolidated_level_t> levels(max_levels);
+                levels.resize(book.getLevels(symbol, bid, levels.data(), max_levels));
+                py::list result;
+                for (size_t i = 0; i < levels.size(); ++i) {
+                    py::dict venues;
+                    for (venue_t venue = 0; venue < VENUE_MAX; ++venue) {
+                        if (levels[i].venue_mask & (1u << venue)) {
+                            venues[py::cast(ConsolidatedOrderbook::venueName(venue))] = levels[i].venue_quantity[venue];
+                        }
+                    }
+                    result.append(py::make_tuple(levels[i].price, levels[i].quantity, venues));
+                }
+                return result;
+             }, py::arg("symbol"), py::arg("bid"), py::arg("max_levels") = 20)
+        .def("is_crossed", [](const ConsolidatedOrderbook& book, symbol_t symbol) {
+                return book.getTop(symbol).crossed != 0;
+             })
+        .def("level_change_count", &ConsolidatedOrderbook::levelChangeCount);
 }
 
 // 策略模块绑定
@@ -136,6 +275,7 @@ void bind_strategy(py::module& m) {
         .def_readwrite("short_period", &StrategyParams::short_period)
         .def_readwrite("long_period", &StrategyParams::long_period)
         .def_readwrite("momentum_threshold", &StrategyParams::momentum_threshold)
+        .def_readwrite("imbalance_threshold", &StrategyParams::imbalance_threshold)
         .def_readwrite("rsi_period", &StrategyParams::rsi_period)
         .def_readwrite("rsi_oversold", &StrategyParams::rsi_oversold)
         .def_readwrite("rsi_overbought", &StrategyParams::rsi_overbought)
@@ -144,6 +284,61 @@ void bind_strategy(py::module& m) {
         .def_readwrite("grid_spacing", &StrategyParams::grid_spacing)
         .def_readwrite("grid_levels", &StrategyParams::grid_levels);
     
+    // 绑定微观结构特征
+    py::enum_<spread_regime_t>(m, "SpreadRegime")
+        .value("UNKNOWN", SPREAD_REGIME_UNKNOWN)
+        .value("TIGHT", SPREAD_REGIME_TIGHT)
+        .value("NORMAL", SPREAD_REGIME_NORMAL)
+        .value("WIDE", SPREAD_REGIME_WIDE);
+
+    py::class_<microstructure_features_t>(m, "MicrostructureFeatures")
+        .def_readonly("symbol", &microstructure_features_t::symbol)
+        .def_readonly("valid", &microstructure_features_t::valid)
+        .def_readonly("spread_regime", &microstructure_features_t::spread_regime)
+        .def_readonly("timestamp", &microstructure_features_t::timestamp)
+        .def_readonly("update_count", &microstructure_features_t::update_count)
+        .def_readonly("mid_price", &microstructure_features_t::mid_price)
+        .def_readonly("microprice", &microstructure_features_t::microprice)
+        .def_readonly("spread", &microstructure_features_t::spread)
+        .def_readonly("spread_bps", &microstructure_features_t::spread_bps)
+        .def_readonly("spread_ewma", &microstructure_features_t::spread_ewma)
+        .def_readonly("imbalance_l1", &microstructure_features_t::imbalance_l1)
+        .def_readonly("imbalance_multi", &microstructure_features_t::imbalance_multi)
+        .def_readonly("ofi", &microstructure_features_t::ofi)
+        .def_readonly("ofi_flow", &microstructure_features_t::ofi_flow)
+        .def_readonly("bid_depletion_rate", &microstructure_features_t::bid_depletion_rate)
+        .def_readonly("ask_depletion_rate", &microstructure_features_t::ask_depletion_rate);
+
+    py::class_<MicrostructureConfig>(m, "MicrostructureConfig")
+        .def(py::init<>())
+        .def_readwrite("imbalance_levels", &MicrostructureConfig::imbalance_levels)
+        .def_readwrite("level_decay", &MicrostructureConfig::level_decay)
+        .def_readwrite("flow_half_life_ms", &MicrostructureConfig::flow_half_life_ms)
+        .def_readwrite("spread_half_life_ms", &MicrostructureConfig::spread_half_life_ms)
+        .def_readwrite("tight_ratio", &MicrostructureConfig::tight_ratio)
+        .def_readwrite("wide_ratio", &MicrostructureConfig::wide_ratio);
+
+    py::class_<MicrostructureFeatureEngine, std::shared_ptr<MicrostructureFeatureEngine>>(m, "MicrostructureFeatureEngine")
+        .def(py::init<const MicrostructureConfig&>(), py::arg("config") = MicrostructureConfig())
+        .def("update", [](MicrostructureFeatureEngine& engine, const orderbook_t& orderbook) {
+                microstructure_features_t features;
+                if (!engine.update(orderbook, &features)) {
+                    return py::object(py::none());
+                }
+                return py::object(py::cast(features));
+            })
+        .def("get_features", [](const MicrostructureFeatureEngine& engine, symbol_t symbol) {
+                microstructure_features_t features;
+                if (!engine.getFeatures(symbol, features)) {
+                    return py::object(py::none());
+                }
+                return py::object(py::cast(features));
+            })
+        .def("reset", &MicrostructureFeatureEngine::reset)
+        .def("attach", &MicrostructureFeatureEngine::attach,
+             py::arg("manager"), py::arg("symbol") = SYMBOL_INVALID)
+        .def("detach", &MicrostructureFeatureEngine::detach);
+    
     // 绑定 IStrategy 接口
     py::class_<IStrategy, std::shared_ptr<IStrategy>>(m, "Strategy")
         .def("process_market_data", &IStrategy::processMarketData)
@@ -210,6 +405,8 @@ void bind_execution(py::module& m) {
         .def("get_status", &IOrderExecutor::getStatus)
         .def("submit_order", &IOrderExecutor::submitOrder,
              py::arg("symbol"), py::arg("side"), py::arg("price"), py::arg("quantity"))
+        .def("submit_order_fixed", &IOrderExecutor::submitOrderFixed,
+             py::arg("symbol"), py::arg("side"), py::arg("price_ticks"), py::arg("quantity_lots"))
         .def("cancel_order", &IOrderExecutor::cancelOrder)
         .def("get_balance", &IOrderExecutor::getBalance)
         .def("get_position", &IOrderExecutor::getPosition)
@@ -226,6 +423,8 @@ void bind_factory(py::module& m) {
         .def_static("create_strategy_engine", &CryptoQuantFactory::createStrategyEngine)
         .def_static("create_order_executor", &CryptoQuantFactory::createOrderExecutor)
         .def_static("create_orderbook_manager", &CryptoQuantFactory::createOrderbookManager)
+        .def_static("create_full_depth_orderbook_manager", &CryptoQuantFactory::createFullDepthOrderbookManager)
+        .def_static("create_sharded_orderbook_manager", &CryptoQuantFactory::createShardedOrderbookManager)
         .def_static("create_market_data_fetcher", &CryptoQuantFactory::createMarketDataFetcher)
         .def_static("create_mean_reversion_strategy", &CryptoQuantFactory::createMeanReversionStrategy)
         .def_static("create_momentum_strategy", &CryptoQuantFactory::createMomentumStrategy)
@@ -235,7 +434,18 @@ void bind_factory(py::module& m) {
     m.def("create_strategy_engine", &CryptoQuantFactory::createStrategyEngine);
     m.def("create_order_executor", &CryptoQuantFactory::createOrderExecutor);
     m.def("create_orderbook_manager", &CryptoQuantFactory::createOrderbookManager);
+    m.def("create_full_depth_orderbook_manager", &CryptoQuantFactory::createFullDepthOrderbookManager);
+    m.def("create_sharded_orderbook_manager", &CryptoQuantFactory::createShardedOrderbookManager);
     m.def("create_market_data_fetcher", &CryptoQuantFactory::createMarketDataFetcher);
+    // 交易对的定点规格（tick_size / lot_size 十进制字符串），全深度订单薄按其 tick 建阶梯
+    m.def("set_instrument_spec", [](symbol_t symbol, const std::string& tick_size, const std::string& lot_size) {
+        InstrumentSpec spec;
+        if (!makeInstrumentSpec(tick_size, lot_size, spec)) {
+            return false;
+        }
+        FixedPointRegistry::instance().setSpec(symbol, spec);
+        return true;
+    }, py::arg("symbol"), py::arg("tick_size"), py::arg("lot_size"));
 }
 
 PYBIND11_MODULE(crypto_quant_python, m) {
@@ -1,4 +1,6 @@
 #include "order_execution.h"
+#include "fixed_point.h"
+#include "symbol_registry.h"
 #include <curl/curl.h>
 #include <openssl/hmac.h>
 #include <openssl/sha.h>
@@ -9,6 +11,8 @@
 #include <sstream>
 #include <chrono>
 #include <algorithm>
+#include <cstdio>
+#include <cstring>
 
 using json = nlohmann::json;
 
@@ -19,20 +23,29 @@ namespace crypto_quant
     static const std::string BINANCE_BASE_URL = "https://api.binance.com";
     static const std::string BINANCE_TESTNET_URL = "https://testnet.binance.vision/api";
 
-    // 将symbol_t转换为币安交易对符号
-    static std::string symbol_to_binance(symbol_t symbol)
+    // 常见计价资产（用于从交易对名称中拆出基础资产）
+    static const char *const QUOTE_ASSETS[] = {"FDUSD", "USDT", "USDC", "BUSD", "BTC", "ETH", "BNB"};
+
+    // 将symbol_t转换为币安交易对符号（注册表中的规范名称，无需构造字符串）
+    static const char *symbol_to_binance(symbol_t symbol)
     {
-        switch (symbol)
+        return SymbolRegistry::instance().name(symbol);
+    }
+
+    // 交易对的基础资产，如 BTCUSDT -> BTC；无法识别时返回空串
+    static std::string base_asset(symbol_t symbol)
+    {
+        std::string name = symbol_to_binance(symbol);
+        for (const char *quote : QUOTE_ASSETS)
         {
-        case SYMBOL_BTC_USDT:
-            return "BTCUSDT";
-        case SYMBOL_ETH_USDT:
-            return "ETHUSDT";
-        case SYMBOL_BTC_ETH:
-            return "BTCETH";
-        default:
-            return "BTCUSDT";
+            size_t quote_len = strlen(quote);
+            if (name.size() > quote_len &&
+                name.compare(name.size() - quote_len, quote_len, quote) == 0)
+            {
+                return name.substr(0, name.size() - quote_len);
+            }
         }
+        return std::string();
     }
 
     OrderExecutor::OrderExecutor() : status_(ExecutionStatus::IDLE), next_order_id_(1)
@@ -130,6 +143,77 @@ namespace crypto_quant
     }
 
     ExecutionResult OrderExecutor::submitOrder(symbol_t symbol, int side, double price, double quantity)
+    {
+        // 注册了定点规格的交易对：按 tick / lot 取整后走定点路径，保证下单字符串精确
+        const FixedPointRegistry &registry = FixedPointRegistry::instance();
+        int64_t price_ticks = 0;
+        int64_t quantity_lots = 0;
+        if (registry.quantityToLots(symbol, quantity, quantity_lots) &&
+            (price <= 0 || registry.priceToTicks(symbol, price, price_ticks)))
+        {
+            // 限价取整为0个 tick 时不能退化成市价单
+            if (price > 0 && price_ticks <= 0)
+            {
+                ExecutionResult result;
+                result.error_message = "Limit price rounds to zero ticks";
+                spdlog::error("Order submission failed: {}, price={}", result.error_message, price);
+                return result;
+            }
+            return placeOrderFixed(symbol, side, price > 0 ? price_ticks : 0, quantity_lots);
+        }
+
+        char price_str[32];
+        char quantity_str[32];
+        snprintf(price_str, sizeof(price_str), "%.8f", price);
+        snprintf(quantity_str, sizeof(quantity_str), "%.8f", quantity);
+        return placeOrder(symbol, side, price > 0 ? price_str : nullptr, quantity_str, price, quantity);
+    }
+
+    ExecutionResult OrderExecutor::submitOrderFixed(symbol_t symbol, int side, int64_t price_ticks, int64_t quantity_lots)
+    {
+        // 定点接口只下限价单，市价单通过 submitOrder(price<=0)
+        if (price_ticks <= 0)
+        {
+            ExecutionResult result;
+            result.error_message = "Limit price must be at least one tick";
+            spdlog::error("Order submission failed: {}, price_ticks={}", result.error_message, price_ticks);
+            return result;
+        }
+        return placeOrderFixed(symbol, side, price_ticks, quantity_lots);
+    }
+
+    ExecutionResult OrderExecutor::placeOrderFixed(symbol_t symbol, int side, int64_t price_ticks, int64_t quantity_lots)
+    {
+        InstrumentSpec spec;
+        if (!FixedPointRegistry::instance().getSpec(symbol, spec))
+        {
+            ExecutionResult result;
+            result.error_message = "No fixed-point spec for symbol";
+            spdlog::error("Order submission failed: {}", result.error_message);
+            return result;
+        }
+        // 数量须至少一个 lot（submitOrder 把不足半个 lot 的数量取整为0）
+        if (quantity_lots <= 0)
+        {
+            ExecutionResult result;
+            result.error_message = "Quantity must be at least one lot";
+            spdlog::error("Order submission failed: {}", result.error_message);
+            return result;
+        }
+
+        // 整数直接格式化，无需浮点到字符串的转换
+        char price_str[32];
+        char quantity_str[32];
+        formatDecimalFixed(price_ticks * spec.tick_units, spec.price_decimals, price_str);
+        formatDecimalFixed(quantity_lots * spec.lot_units, spec.quantity_decimals, quantity_str);
+
+        double price = static_cast<double>(price_ticks) * spec.tickSize();
+        double quantity = static_cast<double>(quantity_lots) * spec.lotSize();
+        return placeOrder(symbol, side, price_ticks > 0 ? price_str : nullptr, quantity_str, price, quantity);
+    }
+
+    ExecutionResult OrderExecutor::placeOrder(symbol_t symbol, int side, const char *price_str,
+                                              const char *quantity_str, double price, double quantity)
     {
         ExecutionResult result;
         result.status = ExecutionResultStatus::FAILED;
@@ -152,24 +236,29 @@ namespace crypto_quant
         }
 
         // 构建订单参数
-        std::string binance_symbol = symbol_to_binance(symbol);
+        const char *binance_symbol = symbol_to_binance(symbol);
+        if (binance_symbol[0] == '\0')
+        {
+            result.error_message = "Unknown symbol";
+            spdlog::error("Order submission failed: {}, symbol={}", result.error_message, symbol);
+            return result;
+        }
         std::string side_str = (side == 0) ? "BUY" : "SELL"; // 0=BUY, 1=SELL
-        std::string type_str = (price > 0) ? "LIMIT" : "MARKET";
+        std::string type_str = price_str ? "LIMIT" : "MARKET";
 
-        std::stringstream query;
-        query << "symbol=" << binance_symbol
-              << "&side=" << side_str
-              << "&type=" << type_str
-              << "&quantity=" << std::fixed << std::setprecision(8) << quantity;
+        std::string query = std::string("symbol=") + binance_symbol +
+                            "&side=" + side_str +
+                            "&type=" + type_str +
+                            "&quantity=" + quantity_str;
 
-        if (type_str == "LIMIT")
+        if (price_str)
         {
-            query << "&timeInForce=GTC"
-                  << "&price=" << std::fixed << std::setprecision(8) << price;
+            query += "&timeInForce=GTC&price=";
+            query += price_str;
         }
 
         // 发送下单请求
-        std::string response = send_signed_request("POST", "/api/v3/order", query.str());
+        std::string response = send_signed_request("POST", "/api/v3/order", query);
 
         try
         {
@@ -314,17 +403,9 @@ namespace crypto_quant
 
             if (j.contains("balances") && j["balances"].is_array())
             {
-                std::string asset;
-                switch (symbol)
+                std::string asset = base_asset(symbol);
+                if (asset.empty())
                 {
-                case SYMBOL_BTC_USDT:
-                case SYMBOL_BTC_ETH:
-                    asset = "BTC";
-                    break;
-                case SYMBOL_ETH_USDT:
-                    asset = "ETH";
-                    break;
-                default:
                     asset = "USDT";
                 }
 
@@ -4,6 +4,8 @@
 #include "order_execution.h"
 #include "market_data_fetcher.h"
 #include "orderbook_manager.h"
+#include "full_depth_orderbook_manager.h"
+#include "sharded_orderbook_manager.h"
 
 namespace crypto_quant
 {
@@ -13,6 +15,8 @@ namespace crypto_quant
     static std::shared_ptr<IStrategyEngine> g_strategy_engine_instance = nullptr;
     static std::shared_ptr<IOrderExecutor> g_order_executor_instance = nullptr;
     static std::shared_ptr<IOrderbookManager> g_orderbook_manager_instance = nullptr;
+    static std::shared_ptr<IOrderbookManager> g_full_depth_orderbook_manager_instance = nullptr;
+    static std::shared_ptr<IOrderbookManager> g_sharded_orderbook_manager_instance = nullptr;
     static std::shared_ptr<IMarketDataFetcher> g_market_data_fetcher_instance = nullptr;
 
     // 互斥锁保护单例创建（双重检查锁定模式）
@@ -20,6 +24,8 @@ namespace crypto_quant
     static std::mutex g_strategy_engine_mutex;
     static std::mutex g_order_executor_mutex;
     static std::mutex g_orderbook_manager_mutex;
+    static std::mutex g_full_depth_orderbook_manager_mutex;
+    static std::mutex g_sharded_orderbook_manager_mutex;
     static std::mutex g_market_data_provider_mutex;
 
     // 工厂类实现 - 单例模式
@@ -66,35 +72,47 @@ namespace crypto_quant
         return g_orderbook_manager_instance;
     }
 
-    std::shared_ptr<IMarketDataFetcher> CryptoQuantFactory::createMarketDataFetcher()
+    std::shared_ptr<IOrderbookManager> CryptoQuantFactory::createFullDepthOrderbookManager()
     {
-        if (g_market_data_fetcher_instance == nullptr)
+        if (g_full_depth_orderbook_manager_instance == nullptr)
         {
-            std::lock_guard<std::mutex> lock(g_market_data_provider_mutex);
-            if (g_market_data_fetcher_instance == nullptr)
+            std::lock_guard<std::mutex> lock(g_full_depth_orderbook_manager_mutex);
+            if (g_full_depth_orderbook_manager_instance == nullptr)
             {
-                g_market_data_fetcher_instance = std::shared_ptr<IMarketDataFetcher>(new MarketDataFetcher());
+                g_full_depth_orderbook_manager_instance =
+                    std::shared_ptr<IOrderbookManager>(new FullDepthOrderbookManager());
             }
         }
-        return g_market_data_fetcher_instance;
+        return g_full_depth_orderbook_manager_instance;
     }
 
-    std::shared_ptr<IStrategy> CryptoQuantFactory::createMeanReversionStrategy()
+    std::shared_ptr<IOrderbookManager> CryptoQuantFactory::createShardedOrderbookManager()
     {
-        // 暂时返回nullptr，需要实现具体策略
-        return nullptr;
+        if (g_sharded_orderbook_manager_instance == nullptr)
+        {
+            std::lock_guard<std::mutex> lock(g_sharded_orderbook_manager_mutex);
+            if (g_sharded_orderbook_manager_instance == nullptr)
+            {
+                g_sharded_orderbook_manager_instance =
+                    std::shared_ptr<IOrderbookManager>(new ShardedOrderbookManager());
+            }
+        }
+        return g_sharded_orderbook_manager_instance;
     }
 
-    std::shared_ptr<IStrategy> CryptoQuantFactory::createMomentumStrategy()
+    std::shared_ptr<IMarketDataFetcher> CryptoQuantFactory::createMarketDataFetcher()
     {
-        // 暂时返回nullptr，需要实现具体策略
-        return nullptr;
+        if (g_market_data_fetcher_instance == nullptr)
+        {
+            std::lock_guard<std::mutex> lock(g_market_data_provider_mutex);
+            if (g_market_data_fetcher_instance == nullptr)
+            {
+                g_market_data_fetcher_instance = std::shared_ptr<IMarketDataFetcher>(new MarketDataFetcher());
+            }
+        }
+        return g_market_data_fetcher_instance;
     }
 
-    std::shared_ptr<IStrategy> CryptoQuantFactory::createRSIStrategy()
-    {
-        // 暂时返回nullptr，需要实现具体策略
-        return nullptr;
-    }
+    // 策略工厂方法定义在各策略的实现文件中（策略类不对外暴露）
 
 } // namespace crypto_quant
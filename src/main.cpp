@@ -10,6 +10,18 @@
 #include <fstream>
 #include <nlohmann/json.hpp>
 #include "crypto_quant.h"
+#include "fixed_point.h"
+#include "symbol_registry.h"
+#include "consolidated_orderbook.h"
+#include "simulated_venue_fetcher.h"
+#include "market_data_dispatcher.h"
+#include "market_data_fetcher.h"
+#include "feed_latency_monitor.h"
+#include "bar_builder.h"
+#include "market_data_recorder.h"
+#include "replay_market_data_fetcher.h"
+#include "synthetic_market_data_fetcher.h"
+#include "orderbook_manager.h"
 
 using json = nlohmann::json;
 
@@ -26,13 +38,23 @@ void signal_handler(int sig) {
 }
 
 // 将symbol_t转换为字符串
-std::string symbol_to_string(symbol_t symbol) {
-    switch (symbol) {
-        case SYMBOL_BTC_USDT: return "BTC/USDT";
-        case SYMBOL_ETH_USDT: return "ETH/USDT";
-        case SYMBOL_BTC_ETH: return "BTC/ETH";
-        default: return "UNKNOWN";
+const char* symbol_to_string(symbol_t symbol) {
+    const char* name = SymbolRegistry::instance().name(symbol);
+    return name[0] != '\0' ? name : "UNKNOWN";
+}
+
+// 场所位图转为名称列表，如 "binance+simulated"
+std::string venue_mask_to_string(uint32_t mask) {
+    std::string names;
+    for (venue_t venue = 0; venue < VENUE_MAX; ++venue) {
+        if (mask & (1u << venue)) {
+            if (!names.empty()) {
+                names += "+";
+            }
+            names += ConsolidatedOrderbook::venueName(venue);
+        }
     }
+    return names;
 }
 
 // 市场数据回调函数
@@ -68,11 +90,46 @@ void on_market_data(const orderbook_t& orderbook) {
               << std::flush;
 }
 
+// 本地聚合的 K 线收盘回调
+void on_bar(const bar_t& bar) {
+    static const char* kBarTypeNames[] = {"时间", "成交量", "笔数", "成交额"};
+    auto time_point = std::chrono::system_clock::time_point(
+        std::chrono::milliseconds(bar.open_time)
+    );
+    auto time_t = std::chrono::system_clock::to_time_t(time_point);
+    std::tm* tm = std::localtime(&time_t);
+    
+    std::cout << "\n[K线 " << bar.spec << " " << kBarTypeNames[static_cast<int>(bar.type)] << "] "
+              << std::put_time(tm, "%H:%M:%S") << " "
+              << symbol_to_string(bar.symbol) << " | "
+              << std::fixed << std::setprecision(2)
+              << "开: " << bar.open << " 高: " << bar.high << " 低: " << bar.low << " 收: " << bar.close
+              << " | VWAP: " << bar.vwap
+              << std::setprecision(4) << " | 量: " << bar.volume << " (主买 " << bar.buy_volume << ")"
+              << " | 笔数: " << bar.trade_count
+              << std::flush;
+}
+
+// 按配置名创建策略，未知名称返回空
+std::shared_ptr<IStrategy> create_strategy(const std::string& name, StrategyParams& params) {
+    if (name == "mean_reversion_strategy") {
+        params.strategy_type = StrategyType::MEAN_REVERSION;
+        return CryptoQuantFactory::createMeanReversionStrategy();
+    } else if (name == "momentum_strategy") {
+        params.strategy_type = StrategyType::MOMENTUM;
+        return CryptoQuantFactory::createMomentumStrategy();
+    } else if (name == "rsi_strategy") {
+        params.strategy_type = StrategyType::RSI_STRATEGY;
+        return CryptoQuantFactory::createRSIStrategy();
+    }
+    return std::shared_ptr<IStrategy>();
+}
+
 // 打印使用说明
 void print_usage(const char* program_name) {
     std::cout << "用法: " << program_name << " [选项]\n";
     std::cout << "\n选项:\n";
-    std::cout << "  --symbol SYMBOL      交易对 (BTC_USDT, ETH_USDT, BTC_ETH) [默认: 从config.json读取]\n";
+    std::cout << "  --symbol SYMBOL      币安交易对，如 BTCUSDT、ETH_USDT [默认: 从config.json读取]\n";
     std::cout << "  --api-key KEY       币安API密钥 [默认: 从config.json读取]\n";
     std::cout << "  --api-secret SECRET 币安API密钥 [默认: 从config.json读取]\n";
     std::cout << "  --config FILE        配置文件路径 [默认: config.json]\n";
@@ -90,6 +147,8 @@ void print_usage(const char* program_name) {
 // 配置结构
 struct Config {
     symbol_t symbol = SYMBOL_BTC_USDT;
+    // 配置文件中的其余交易对，与主交易对共用组合流连接
+    std::vector<symbol_t> extra_symbols;
     std::string api_key;
     std::string api_secret;
     bool test_order = false;
@@ -98,19 +157,41 @@ struct Config {
     double max_daily_loss = 100.0;
     int max_orders_per_minute = 10;
     bool enable_risk_control = true;
+    // 启用本地模拟的第二场所，并与币安合并成多场所订单薄
+    bool simulated_venue = false;
+    // 网络线程与行情处理线程之间的队列
+    MarketDataDispatcherConfig dispatcher;
+    // 实时行情的组合流连接（redundancy 大于1时每个连接开多条并行线路并仲裁）
+    MarketDataFetcherConfig fetcher;
+    // 行情延迟直方图（交易所事件时间到读出、读出到解析、解析到策略回调），退出时写入日志
+    bool latency_stats = true;
+    // 录制币安行情到内存映射的段文件
+    bool recording = false;
+    MarketDataRecorderConfig recorder;
+    // 用录制的行情代替实时行情
+    bool replay = false;
+    ReplayConfig replay_config;
+    // 用合成行情代替实时行情（离线压测）
+    bool synthetic = false;
+    SyntheticMarketDataConfig synthetic_config;
+    // 由成交流本地聚合的 K 线规格，非空时才订阅成交流
+    std::vector<BarSpec> bar_specs;
+    // 成交流：aggTrade（默认，归集成交）或 trade（逐笔）
+    std::string trade_stream = "aggTrade";
+    // 行情处理线程上运行的策略：mean_reversion_strategy、momentum_strategy 或 rsi_strategy，空为不运行
+    std::string strategy_name = "mean_reversion_strategy";
+    StrategyParams strategy_params;
     std::string config_file = "config.json";
 };
 
-// 从字符串转换为symbol_t
+// 从字符串转换为symbol_t（未注册的交易对自动注册）
 symbol_t string_to_symbol(const std::string& symbol_str) {
-    if (symbol_str == "BTCUSDT" || symbol_str == "BTC_USDT") {
+    symbol_t symbol = SymbolRegistry::instance().registerSymbol(symbol_str);
+    if (symbol == SYMBOL_INVALID) {
+        std::cerr << "警告: 无效的交易对 " << symbol_str << "，使用 BTCUSDT\n";
         return SYMBOL_BTC_USDT;
-    } else if (symbol_str == "ETHUSDT" || symbol_str == "ETH_USDT") {
-        return SYMBOL_ETH_USDT;
-    } else if (symbol_str == "BTCETH" || symbol_str == "BTC_ETH") {
-        return SYMBOL_BTC_ETH;
     }
-    return SYMBOL_BTC_USDT;
+    return symbol;
 }
 
 // 从配置文件加载配置
@@ -155,14 +236,147 @@ bool load_config_from_file(Config& config, const std::string& config_file) {
             }
         }
         
+        // 读取strategy配置
+        if (j.contains("strategy") && j["strategy"].is_object()) {
+            const auto& strategy = j["strategy"];
+            StrategyParams& params = config.strategy_params;
+            config.strategy_name = strategy.value("name", config.strategy_name);
+            params.risk_per_trade = strategy.value("risk_per_trade", params.risk_per_trade);
+            params.max_position_size = strategy.value("max_position_size", params.max_position_size);
+            params.lookback_period = strategy.value("lookback_period", params.lookback_period);
+            params.z_score_threshold = strategy.value("z_score_threshold", params.z_score_threshold);
+            params.short_period = strategy.value("short_period", params.short_period);
+            params.long_period = strategy.value("long_period", params.long_period);
+            params.momentum_threshold = strategy.value("momentum_threshold", params.momentum_threshold);
+            params.imbalance_threshold = strategy.value("imbalance_threshold", params.imbalance_threshold);
+            params.rsi_period = strategy.value("rsi_period", params.rsi_period);
+            params.rsi_oversold = strategy.value("rsi_oversold", params.rsi_oversold);
+            params.rsi_overbought = strategy.value("rsi_overbought", params.rsi_overbought);
+        }
+        
         // 读取market_data配置中的symbols
         if (j.contains("market_data")) {
             const auto& market_data = j["market_data"];
             if (market_data.contains("symbols") && market_data["symbols"].is_array()) {
                 const auto& symbols = market_data["symbols"];
-                if (!symbols.empty()) {
-                    std::string first_symbol = symbols[0].get<std::string>();
-                    config.symbol = string_to_symbol(first_symbol);
+                // 全部注册并订阅，第一个为主交易对
+                for (size_t i = 0; i < symbols.size(); ++i) {
+                    symbol_t symbol = string_to_symbol(symbols[i].get<std::string>());
+                    if (i == 0) {
+                        config.symbol = symbol;
+                    } else {
+                        config.extra_symbols.push_back(symbol);
+                    }
+                }
+            }
+            
+            if (market_data.contains("simulated_venue")) {
+                config.simulated_venue = market_data["simulated_venue"].get<bool>();
+            }
+            
+            // 可选的分发队列配置：{"capacity": 4096, "wait_mode": "blocking"|"busy_poll", "overflow": "drop"|"block"}
+            if (market_data.contains("dispatcher") && market_data["dispatcher"].is_object()) {
+                const auto& dispatcher = market_data["dispatcher"];
+                config.dispatcher.capacity = dispatcher.value("capacity", config.dispatcher.capacity);
+                if (dispatcher.value("wait_mode", "blocking") == "busy_poll") {
+                    config.dispatcher.wait_mode = DispatchWaitMode::BUSY_POLL;
+                }
+                if (dispatcher.value("overflow", "drop") == "block") {
+                    config.dispatcher.overflow_policy = DispatchOverflowPolicy::BLOCK;
+                }
+            }
+            
+            // 可选的组合流连接配置：{"max_connections": 4, "redundancy": 2}
+            if (market_data.contains("connections") && market_data["connections"].is_object()) {
+                const auto& connections = market_data["connections"];
+                config.fetcher.max_connections = connections.value("max_connections", config.fetcher.max_connections);
+                config.fetcher.redundancy = connections.value("redundancy", config.fetcher.redundancy);
+            }
+            
+            config.latency_stats = market_data.value("latency_stats", config.latency_stats);
+            
+            // 可选的行情录制：{"enabled": true, "directory": "recordings", "segment_size_mb": 256, "raw": true, "normalized": true}
+            if (market_data.contains("recording") && market_data["recording"].is_object()) {
+                const auto& recording = market_data["recording"];
+                config.recording = recording.value("enabled", false);
+                config.recorder.directory = recording.value("directory", config.recorder.directory);
+                config.recorder.segment_size = static_cast<size_t>(
+                    recording.value("segment_size_mb", static_cast<int>(config.recorder.segment_size >> 20))) << 20;
+                config.recorder.record_raw = recording.value("raw", config.recorder.record_raw);
+                config.recorder.record_normalized = recording.value("normalized", config.recorder.record_normalized);
+            }
+            
+            // 可选的行情回放：{"enabled": true, "directory": "recordings", "mode": "realtime"|"scaled"|"fast",
+            //                  "speed": 10, "parse_raw": false, "start_ms": 0, "end_ms": 0}
+            if (market_data.contains("replay") && market_data["replay"].is_object()) {
+                const auto& replay = market_data["replay"];
+                config.replay = replay.value("enabled", false);
+                config.replay_config.directory = replay.value("directory", config.replay_config.directory);
+                config.replay_config.prefix = replay.value("prefix", config.replay_config.prefix);
+                std::string mode = replay.value("mode", "realtime");
+                if (mode == "scaled") {
+                    config.replay_config.mode = ReplaySpeedMode::SCALED;
+                } else if (mode == "fast") {
+                    config.replay_config.mode = ReplaySpeedMode::AS_FAST_AS_POSSIBLE;
+                }
+                config.replay_config.speed = replay.value("speed", config.replay_config.speed);
+                config.replay_config.parse_raw = replay.value("parse_raw", config.replay_config.parse_raw);
+                config.replay_config.start_time_ns = replay.value("start_ms", static_cast<uint64_t>(0)) * 1000000ULL;
+                config.replay_config.end_time_ns = replay.value("end_ms", static_cast<uint64_t>(0)) * 1000000ULL;
+            }
+            
+            // 可选的合成行情：{"enabled": true, "event_rate": 100000, "realtime": true, "volatility": 0.6,
+            //                  "jump_intensity": 365, "spread_bps": 2, "levels": 20, "seed": 1}
+            if (market_data.contains("synthetic") && market_data["synthetic"].is_object()) {
+                const auto& synthetic = market_data["synthetic"];
+                SyntheticFeedConfig& feed = config.synthetic_config.feed;
+                config.synthetic = synthetic.value("enabled", false);
+                config.synthetic_config.realtime = synthetic.value("realtime", config.synthetic_config.realtime);
+                feed.event_rate = synthetic.value("event_rate", feed.event_rate);
+                feed.initial_price = synthetic.value("initial_price", feed.initial_price);
+                feed.drift = synthetic.value("drift", feed.drift);
+                feed.volatility = synthetic.value("volatility", feed.volatility);
+                feed.jump_intensity = synthetic.value("jump_intensity", feed.jump_intensity);
+                feed.jump_mean = synthetic.value("jump_mean", feed.jump_mean);
+                feed.jump_volatility = synthetic.value("jump_volatility", feed.jump_volatility);
+                feed.spread_mean_bps = synthetic.value("spread_bps", feed.spread_mean_bps);
+                feed.spread_reversion = synthetic.value("spread_reversion", feed.spread_reversion);
+                feed.spread_volatility_bps = synthetic.value("spread_volatility_bps", feed.spread_volatility_bps);
+                feed.levels = synthetic.value("levels", feed.levels);
+                feed.level_step_bps = synthetic.value("level_step_bps", feed.level_step_bps);
+                feed.level_updates_per_event = synthetic.value("level_updates_per_event", feed.level_updates_per_event);
+                feed.seed = synthetic.value("seed", feed.seed);
+            }
+            
+            // 由成交流聚合的 K 线（不订阅交易所的 kline 流）
+            if (market_data.contains("bars") && market_data["bars"].is_array()) {
+                for (const auto& bar : market_data["bars"]) {
+                    std::string type = bar.value("type", "time");
+                    if (type == "time") {
+                        config.bar_specs.push_back(BarSpec(BarType::TIME, bar.value("interval_ms", 60000.0)));
+                    } else if (type == "volume") {
+                        config.bar_specs.push_back(BarSpec(BarType::VOLUME, bar.value("threshold", 0.0)));
+                    } else if (type == "tick") {
+                        config.bar_specs.push_back(BarSpec(BarType::TICK, bar.value("threshold", 0.0)));
+                    } else if (type == "dollar") {
+                        config.bar_specs.push_back(BarSpec(BarType::DOLLAR, bar.value("threshold", 0.0)));
+                    } else {
+                        std::cerr << "警告: 未知的K线类型: " << type << "\n";
+                    }
+                }
+            }
+            config.trade_stream = market_data.value("trade_stream", config.trade_stream);
+            
+            // 可选的定点数规格（tick_size / lot_size）
+            if (market_data.contains("instruments") && market_data["instruments"].is_object()) {
+                for (auto it = market_data["instruments"].begin(); it != market_data["instruments"].end(); ++it) {
+                    InstrumentSpec spec;
+                    if (makeInstrumentSpec(it.value().value("tick_size", ""),
+                                           it.value().value("lot_size", ""), spec)) {
+                        FixedPointRegistry::instance().setSpec(string_to_symbol(it.key()), spec);
+                    } else {
+                        std::cerr << "警告: 无效的定点数规格: " << it.key() << "\n";
+                    }
                 }
             }
         }
@@ -206,7 +420,21 @@ int main(int argc, char* argv[]) {
     
     try {
         // 创建组件
-        auto market_data_fetcher = CryptoQuantFactory::createMarketDataFetcher();
+        std::shared_ptr<ReplayMarketDataFetcher> replay;
+        std::shared_ptr<SyntheticMarketDataFetcher> synthetic;
+        std::shared_ptr<IMarketDataFetcher> market_data_fetcher;
+        if (config.replay) {
+            replay = std::make_shared<ReplayMarketDataFetcher>(config.replay_config);
+            market_data_fetcher = replay;
+        } else if (config.synthetic) {
+            synthetic = std::make_shared<SyntheticMarketDataFetcher>(config.synthetic_config);
+            market_data_fetcher = synthetic;
+        } else if (config.fetcher.redundancy > 1 ||
+                   config.fetcher.max_connections != MarketDataFetcherConfig().max_connections) {
+            market_data_fetcher = std::make_shared<MarketDataFetcher>(config.fetcher);
+        } else {
+            market_data_fetcher = CryptoQuantFactory::createMarketDataFetcher();
+        }
         auto order_executor = CryptoQuantFactory::createOrderExecutor();
         auto orderbook_manager = CryptoQuantFactory::createOrderbookManager();
         
@@ -231,15 +459,157 @@ int main(int argc, char* argv[]) {
             return 1;
         }
         
+        // 策略引擎：在行情处理线程上逐笔更新微观结构特征并运行策略
+        auto strategy_engine = CryptoQuantFactory::createStrategyEngine();
+        std::shared_ptr<IStrategy> strategy;
+        if (!config.strategy_name.empty()) {
+            strategy = create_strategy(config.strategy_name, config.strategy_params);
+            if (!strategy) {
+                std::cerr << "警告: 未知的策略 " << config.strategy_name << "，不运行策略\n";
+            }
+        }
+        if (strategy) {
+            strategy->initialize();
+            strategy->setParams(config.strategy_params);
+            strategy->setStatus(StrategyStatus::RUNNING);
+            strategy_engine->initialize();
+            strategy_engine->setStrategy(strategy);
+            strategy_engine->start();
+        }
+        
         crypto_quant_log_info("所有组件初始化成功");
         
-        // 设置市场数据回调
-        market_data_fetcher->setOrderbookCallback([&orderbook_manager](const orderbook_t& orderbook) {
+        // 回放时订单薄时间戳是录制时的时间，关闭过期检查；分发队列满时阻塞而不是丢弃，保证回放可重复
+        // 非实时的合成行情模拟时间快于墙钟，同样关闭过期检查
+        if (replay || (config.synthetic && !config.synthetic_config.realtime)) {
+            std::shared_ptr<OrderbookManager> manager = std::dynamic_pointer_cast<OrderbookManager>(orderbook_manager);
+            if (manager) {
+                OrderbookValidatorConfig validator_config;
+                validator_config.max_age_ms = 0;
+                manager->setValidatorConfig(validator_config);
+            }
+        }
+        if (replay) {
+            config.dispatcher.overflow_policy = DispatchOverflowPolicy::BLOCK;
+        }
+        
+        // 行情录制（可选）
+        std::shared_ptr<MarketDataRecorder> recorder;
+        if (config.recording) {
+            recorder = std::make_shared<MarketDataRecorder>(config.recorder);
+            if (recorder->open()) {
+                market_data_fetcher->setRecorder(recorder);
+            } else {
+                crypto_quant_log_error("行情录制启动失败，继续运行但不录制");
+                recorder.reset();
+            }
+        }
+        
+        // 多场所合并订单薄（可选）：币安与本地模拟场所
+        std::unique_ptr<ConsolidatedOrderbook> consolidated;
+        std::shared_ptr<SimulatedVenueFetcher> simulated_venue;
+        if (config.simulated_venue) {
+            consolidated.reset(new ConsolidatedOrderbook());
+            simulated_venue = std::make_shared<SimulatedVenueFetcher>();
+            // 模拟场所围绕币安中间价报价
+            simulated_venue->setReferencePrice([&orderbook_manager](symbol_t symbol) {
+                return orderbook_manager->getMidPrice(symbol);
+            });
+            simulated_venue->setOrderbookCallback([&consolidated](const orderbook_t& orderbook) {
+                consolidated->update(VENUE_SIMULATED, orderbook);
+            });
+        }
+        // 币安订单薄进入合并视图，被隔离时撤出
+        auto update_consolidated = [&consolidated, &orderbook_manager](symbol_t symbol) {
+            if (!consolidated) {
+                return;
+            }
+            if (orderbook_manager->isQuarantined(symbol)) {
+                consolidated->removeVenue(VENUE_BINANCE, symbol);
+            } else {
+                consolidated->update(VENUE_BINANCE, orderbook_manager->getOrderbook(symbol));
+            }
+        };
+        
+        // 行情延迟统计：实时连接记录交易所到读出、读出到解析，分发器记录解析到回调
+        std::shared_ptr<FeedLatencyMonitor> latency_monitor;
+        if (config.latency_stats) {
+            latency_monitor = std::make_shared<FeedLatencyMonitor>();
+            std::shared_ptr<MarketDataFetcher> live = std::dynamic_pointer_cast<MarketDataFetcher>(market_data_fetcher);
+            if (live) {
+                live->setLatencyMonitor(latency_monitor);
+            }
+        }
+        
+        // 网络线程只把行情放进队列，订单薄更新和输出在处理线程上进行，慢的下游不会拖住读套接字
+        MarketDataDispatcher dispatcher(config.dispatcher);
+        dispatcher.setLatencyMonitor(latency_monitor);
+        
+        // 设置市场数据回调（备用模拟数据走完整快照）
+        // 未隔离的订单薄交给输出和策略引擎（引擎未启动时直接返回）
+        auto deliver_orderbook = [&strategy_engine](const orderbook_t& orderbook) {
+            on_market_data(orderbook);
+            strategy_engine->processMarketData(orderbook);
+        };
+        dispatcher.setOrderbookHandler([&orderbook_manager, &update_consolidated, &deliver_orderbook](const orderbook_t& orderbook) {
             // 更新订单薄管理器
             orderbook_manager->updateOrderbook(orderbook);
+            update_consolidated(orderbook.symbol);
             
-            // 显示市场数据
-            on_market_data(orderbook);
+            // 隔离中的订单薄不交给下游
+            if (!orderbook_manager->isQuarantined(orderbook.symbol)) {
+                deliver_orderbook(orderbook);
+            }
+        });
+        
+        // 增量深度流：缺口时通过 REST 快照重新同步
+        orderbook_manager->setSnapshotProvider([&market_data_fetcher](symbol_t symbol, DepthSnapshot& snapshot) {
+            return market_data_fetcher->fetchDepthSnapshot(symbol, 1000, snapshot);
+        });
+        dispatcher.setDepthDiffHandler([&orderbook_manager, &update_consolidated, &deliver_orderbook](const depth_diff_t& diff) {
+            DepthDiffResult result = orderbook_manager->applyDepthDiff(diff);
+            switch (result) {
+            case DepthDiffResult::APPLIED:
+            case DepthDiffResult::RESYNCED:
+                update_consolidated(diff.symbol);
+                if (!orderbook_manager->isQuarantined(diff.symbol)) {
+                    deliver_orderbook(orderbook_manager->getOrderbook(diff.symbol));
+                }
+                break;
+            case DepthDiffResult::QUEUED:
+                // 异步管理器尚未应用，此时读到的是旧订单薄，不交给下游
+                break;
+            default:
+                // 缓存、过期或失步：订单薄没有变化（隔离状态可能变化）
+                update_consolidated(diff.symbol);
+                break;
+            }
+        });
+        
+        // 成交在处理线程上聚合成 K 线
+        BarBuilder bar_builder;
+        for (size_t i = 0; i < config.bar_specs.size(); ++i) {
+            bar_builder.addSpec(config.bar_specs[i]);
+        }
+        // 收盘 K 线既输出也交给策略引擎
+        bar_builder.setBarCallback([&strategy_engine](const bar_t& bar) {
+            on_bar(bar);
+            strategy_engine->processBar(bar);
+        });
+        dispatcher.setTradeHandler([&bar_builder](const trade_t& trade) {
+            bar_builder.onTrade(trade);
+        });
+        dispatcher.start();
+        if (bar_builder.specCount() > 0) {
+            market_data_fetcher->setTradeCallback([&dispatcher](const trade_t& trade) {
+                dispatcher.publish(trade);
+            });
+        }
+        market_data_fetcher->setOrderbookCallback([&dispatcher](const orderbook_t& orderbook) {
+            dispatcher.publish(orderbook);
+        });
+        market_data_fetcher->setDepthDiffCallback([&dispatcher](const depth_diff_t& diff) {
+            dispatcher.publish(diff);
         });
         
         // 设置币安数据源
@@ -247,10 +617,26 @@ int main(int argc, char* argv[]) {
         
         // 启动市场数据收集
         std::cout << "\n启动市场数据收集 (" << symbol_to_string(config.symbol) << ")...\n";
-        if (!market_data_fetcher->start(config.symbol)) {
+        if (market_data_fetcher->start(config.symbol) != 0) {
             crypto_quant_log_error("启动市场数据收集失败");
             return 1;
         }
+        // 默认流在设置成交回调时已包含归集成交，选择逐笔成交时显式指定
+        uint32_t streams = 0;
+        if (bar_builder.specCount() > 0 && config.trade_stream == "trade") {
+            streams = MARKET_STREAM_DEPTH_DIFF | MARKET_STREAM_TRADE;
+            market_data_fetcher->subscribe(config.symbol, streams);
+        }
+        for (size_t i = 0; i < config.extra_symbols.size(); ++i) {
+            if (config.extra_symbols[i] != config.symbol) {
+                market_data_fetcher->subscribe(config.extra_symbols[i], streams);
+            }
+        }
+        if (simulated_venue) {
+            simulated_venue->initialize();
+            simulated_venue->start(config.symbol);
+            std::cout << "已启用模拟场所，合并订单薄包含 binance + simulated\n";
+        }
         
         // 如果提供了API密钥，连接订单执行器
         if (!config.api_key.empty() && !config.api_secret.empty()) {
@@ -362,12 +748,48 @@ int main(int argc, char* argv[]) {
         
         while (g_running.load()) {
             std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            if (replay && replay->isFinished()) {
+                ReplayStats replay_stats = replay->getStats();
+                std::cout << "\n回放结束: " << replay_stats.records << " 条记录, 耗时 "
+                          << replay_stats.wall_time_ns / 1000000 << " ms\n";
+                break;
+            }
+            
+            // 没有新成交时也按时收盘时间 K 线（回放和合成行情用其行情时钟）
+            if (bar_builder.specCount() > 0) {
+                uint64_t now_ms = 0;
+                if (replay) {
+                    now_ms = replay->now() / 1000000;
+                } else if (synthetic) {
+                    now_ms = synthetic->now() / 1000000;
+                } else {
+                    // 本地时钟减去1秒，留给网络延迟中仍在路上的成交
+                    now_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                        std::chrono::system_clock::now().time_since_epoch()).count() - 1000;
+                }
+                bar_builder.flush(now_ms);
+            }
             
             // 每秒更新一次统计信息
             auto now = std::chrono::steady_clock::now();
             if (std::chrono::duration_cast<std::chrono::seconds>(now - last_stats_time).count() >= 1) {
                 int count = g_market_data_count.load();
                 std::cout << "\n已接收数据: " << count << " 条" << std::flush;
+                LatencySummary latency;
+                if (latency_monitor &&
+                    latency_monitor->getSummary(config.symbol, LatencyStream::DEPTH_DIFF,
+                                                LatencyStage::EXCHANGE_TO_RECEIVE, latency)) {
+                    std::cout << " | 行情延迟 p50/p99: " << std::fixed << std::setprecision(1)
+                              << latency.p50 / 1e6 << "/" << latency.p99 / 1e6 << " ms" << std::flush;
+                }
+                if (consolidated) {
+                    consolidated_top_t top = consolidated->getTop(config.symbol);
+                    std::cout << " | 合并盘口: 买 " << top.bid_price
+                              << " (" << venue_mask_to_string(top.bid_venue_mask) << ")"
+                              << " 卖 " << top.ask_price
+                              << " (" << venue_mask_to_string(top.ask_venue_mask) << ")"
+                              << (top.crossed ? " [交叉]" : "") << std::flush;
+                }
                 last_stats_time = now;
             }
         }
@@ -375,12 +797,43 @@ int main(int argc, char* argv[]) {
         // 停止组件
         std::cout << "\n\n正在停止...\n";
         market_data_fetcher->stop();
+        dispatcher.stop();
+        std::shared_ptr<MarketDataFetcher> live = std::dynamic_pointer_cast<MarketDataFetcher>(market_data_fetcher);
+        if (live && config.fetcher.redundancy > 1) {
+            std::vector<FeedLineStats> lines = live->getLineStats();
+            for (size_t i = 0; i < lines.size(); ++i) {
+                std::cout << "冗余线路 " << lines[i].line << ": 消息 " << lines[i].messages << " 条, 胜出 "
+                          << lines[i].wins << " 条 (" << std::fixed << std::setprecision(1)
+                          << lines[i].win_rate * 100.0 << "%), 重复 " << lines[i].duplicates
+                          << " 条, 漏收 " << lines[i].gaps << " 次\n";
+            }
+            std::cout << "仲裁后仍不连续: " << live->getArbitratedGaps() << " 次\n";
+        }
+        MarketDataDispatcherStats dispatch_stats = dispatcher.getStats();
+        std::cout << "行情分发: 处理 " << dispatch_stats.processed << " 条, 丢弃 " << dispatch_stats.dropped
+                  << " 条, 队列满 " << dispatch_stats.backpressure << " 次, 最高积压 " << dispatch_stats.max_depth << "\n";
+        if (latency_monitor) {
+            latency_monitor->dump();
+        }
+        if (recorder) {
+            recorder->close();
+            MarketDataRecorderStats record_stats = recorder->getStats();
+            std::cout << "行情录制: " << record_stats.records << " 条, " << (record_stats.bytes >> 20)
+                      << " MB, " << record_stats.segments << " 个段文件, 丢弃 " << record_stats.dropped << " 条\n";
+        }
+        if (simulated_venue) {
+            simulated_venue->stop();
+        }
         if (order_executor->getStatus() == ExecutionStatus::CONNECTED) {
             order_executor->disconnect();
         }
         
         // 清理组件
         // market_data_fetcher->cleanup();
+        strategy_engine->cleanup();
+        if (strategy) {
+            strategy->cleanup();
+        }
         order_executor->cleanup();
         orderbook_manager->cleanup();
         
@@ -0,0 +1,439 @@
+#include "binance_message_parser.h"
+#include "fixed_point.h"
+#include "symbol_registry.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace crypto_quant {
+
+namespace {
+
+inline bool isSpace(char c) {
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+inline bool isDigit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+inline bool keyEquals(const char* key, size_t length, const char* literal, size_t literal_length) {
+    return length == literal_length && memcmp(key, literal, length) == 0;
+}
+
+} // namespace
+
+// 输入上的读取位置，所有方法在越界或格式错误时返回false
+struct BinanceMessageParser::Cursor {
+    const char* p;
+    const char* end;
+    const char* error;
+
+    bool fail(const char* reason) {
+        error = reason;
+        return false;
+    }
+
+    void skipSpace() {
+        while (p < end && isSpace(*p)) {
+            ++p;
+        }
+    }
+
+    // 跳过空白后读取期望的字符
+    bool consume(char expected) {
+        skipSpace();
+        if (p < end && *p == expected) {
+            ++p;
+            return true;
+        }
+        return false;
+    }
+
+    char peek() {
+        skipSpace();
+        return p < end ? *p : '\0';
+    }
+
+    // 字符串原文（不反转义），返回引号之间的范围
+    bool parseString(const char*& text, size_t& length) {
+        if (!consume('"')) {
+            return fail("expected string");
+        }
+        const char* begin = p;
+        while (true) {
+            const char* quote = static_cast<const char*>(memchr(p, '"', static_cast<size_t>(end - p)));
+            if (!quote) {
+                return fail("unterminated string");
+            }
+            // 前面有奇数个反斜杠时是转义的引号
+            size_t backslashes = 0;
+            while (quote - backslashes > begin && quote[-1 - static_cast<ptrdiff_t>(backslashes)] == '\\') {
+                ++backslashes;
+            }
+            p = quote + 1;
+            if ((backslashes & 1) == 0) {
+                text = begin;
+                length = static_cast<size_t>(quote - begin);
+                return true;
+            }
+        }
+    }
+
+    bool parseUint(uint64_t& value) {
+        skipSpace();
+        const char* begin = p;
+        uint64_t result = 0;
+        while (p < end && isDigit(*p)) {
+            if (p - begin >= 19) {
+                return fail("integer overflow");
+            }
+            result = result * 10 + static_cast<uint64_t>(*p - '0');
+            ++p;
+        }
+        if (p == begin) {
+            return fail("expected integer");
+        }
+        value = result;
+        return true;
+    }
+
+    // 币安的价格、数量是十进制字符串，也兼容裸数字
+    bool parseDecimal(double& value) {
+        skipSpace();
+        const char* begin;
+        size_t length;
+        if (p < end && *p == '"') {
+            if (!parseString(begin, length)) {
+                return false;
+            }
+        } else {
+            begin = p;
+            while (p < end && (isDigit(*p) || *p == '.' || *p == '-' || *p == '+' || *p == 'e' || *p == 'E')) {
+                ++p;
+            }
+            length = static_cast<size_t>(p - begin);
+        }
+        if (!parseDecimalDouble(begin, begin + length, value)) {
+            return fail("invalid decimal");
+        }
+        return true;
+    }
+
+    bool parseBool(bool& value) {
+        skipSpace();
+        if (end - p >= 4 && memcmp(p, "true", 4) == 0) {
+            p += 4;
+            value = true;
+            return true;
+        }
+        if (end - p >= 5 && memcmp(p, "false", 5) == 0) {
+            p += 5;
+            value = false;
+            return true;
+        }
+        return fail("expected boolean");
+    }
+
+    // 跳过任意 JSON 值
+    bool skipValue() {
+        skipSpace();
+        if (p >= end) {
+            return fail("unexpected end");
+        }
+        if (*p == '"') {
+            const char* text;
+            size_t length;
+            return parseString(text, length);
+        }
+        if (*p == '{' || *p == '[') {
+            int nesting = 0;
+            while (p < end) {
+                char c = *p;
+                if (c == '"') {
+                    const char* text;
+                    size_t length;
+                    if (!parseString(text, length)) {
+                        return false;
+                    }
+                    continue;
+                }
+                ++p;
+                if (c == '{' || c == '[') {
+                    ++nesting;
+                } else if (c == '}' || c == ']') {
+                    if (--nesting == 0) {
+                        return true;
+                    }
+                }
+            }
+            return fail("unterminated container");
+        }
+        // 数字、true/false/null
+        const char* begin = p;
+        while (p < end && *p != ',' && *p != '}' && *p != ']' && !isSpace(*p)) {
+            ++p;
+        }
+        return p > begin || fail("expected value");
+    }
+};
+
+BinanceMessageParser::BinanceMessageParser(size_t reserve_levels)
+    : request_id_(0), stream_(nullptr), stream_length_(0), default_symbol_(SYMBOL_INVALID), error_("") {
+    bids_.reserve(reserve_levels);
+    asks_.reserve(reserve_levels);
+    memset(&fields_, 0, sizeof(fields_));
+    memset(&orderbook_, 0, sizeof(orderbook_));
+    memset(&diff_, 0, sizeof(diff_));
+    memset(&trade_, 0, sizeof(trade_));
+}
+
+BinanceMessageType BinanceMessageParser::parse(const char* data, size_t size) {
+    memset(&fields_, 0, sizeof(fields_));
+    bids_.clear();
+    asks_.clear();
+    stream_ = nullptr;
+    stream_length_ = 0;
+    request_id_ = 0;
+
+    Cursor cursor;
+    cursor.p = data;
+    cursor.end = data + size;
+    cursor.error = "";
+    if (!cursor.consume('{')) {
+        error_ = "expected object";
+        return BinanceMessageType::INVALID;
+    }
+    if (!parseObject(cursor, 0)) {
+        error_ = cursor.error;
+        return BinanceMessageType::INVALID;
+    }
+    cursor.skipSpace();
+    if (cursor.p != cursor.end) {
+        error_ = "trailing data";
+        return BinanceMessageType::INVALID;
+    }
+    return finish();
+}
+
+// 左花括号已读取，解析到对应的右花括号
+bool BinanceMessageParser::parseObject(Cursor& cursor, int depth) {
+    if (cursor.consume('}')) {
+        return true;
+    }
+    while (true) {
+        const char* key;
+        size_t key_length;
+        if (!cursor.parseString(key, key_length)) {
+            return false;
+        }
+        if (!cursor.consume(':')) {
+            return cursor.fail("expected ':'");
+        }
+        if (!parseField(cursor, key, key_length, depth)) {
+            return false;
+        }
+        if (cursor.consume(',')) {
+            continue;
+        }
+        if (cursor.consume('}')) {
+            return true;
+        }
+        return cursor.fail("expected ',' or '}'");
+    }
+}
+
+bool BinanceMessageParser::parseField(Cursor& cursor, const char* key, size_t key_length, int depth) {
+    Fields& f = fields_;
+    if (key_length == 1) {
+        switch (key[0]) {
+        case 'e':
+            return cursor.parseString(f.event, f.event_length);
+        case 'E':
+            return cursor.parseUint(f.event_time);
+        case 's':
+            return cursor.parseString(f.symbol, f.symbol_length);
+        case 'U':
+            return cursor.parseUint(f.first_update_id);
+        case 'u':
+            return cursor.parseUint(f.final_update_id);
+        case 'b':
+            // depthUpdate 的买盘；旧版 trade 中是买方订单ID
+            if (cursor.peek() == '[') {
+                f.has_bids = true;
+                return parseLevels(cursor, bids_);
+            }
+            return cursor.skipValue();
+        case 'a':
+            // depthUpdate 的卖盘；aggTrade 中是归集成交ID
+            if (cursor.peek() == '[') {
+                f.has_asks = true;
+                return parseLevels(cursor, asks_);
+            }
+            return cursor.parseUint(f.agg_trade_id);
+        case 't':
+            return cursor.parseUint(f.trade_id);
+        case 'p':
+            return cursor.parseDecimal(f.price);
+        case 'q':
+            return cursor.parseDecimal(f.quantity);
+        case 'T':
+            return cursor.parseUint(f.trade_time);
+        case 'm':
+            return cursor.parseBool(f.buyer_maker);
+        case 'f':
+            return cursor.parseUint(f.first_trade_id);
+        case 'l':
+            return cursor.parseUint(f.last_trade_id);
+        default:
+            return cursor.skipValue();
+        }
+    }
+    if (keyEquals(key, key_length, "lastUpdateId", 12)) {
+        f.has_last_update_id = true;
+        return cursor.parseUint(f.last_update_id);
+    }
+    if (keyEquals(key, key_length, "bids", 4)) {
+        f.has_bids = true;
+        return parseLevels(cursor, bids_);
+    }
+    if (keyEquals(key, key_length, "asks", 4)) {
+        f.has_asks = true;
+        return parseLevels(cursor, asks_);
+    }
+    if (depth == 0) {
+        if (keyEquals(key, key_length, "stream", 6)) {
+            return cursor.parseString(stream_, stream_length_);
+        }
+        if (keyEquals(key, key_length, "data", 4)) {
+            if (!cursor.consume('{')) {
+                return cursor.fail("expected data object");
+            }
+            return parseObject(cursor, depth + 1);
+        }
+        if (keyEquals(key, key_length, "result", 6)) {
+            f.has_result = true;
+            return cursor.skipValue();
+        }
+        if (keyEquals(key, key_length, "error", 5)) {
+            f.has_error = true;
+            return cursor.skipValue();
+        }
+        if (keyEquals(key, key_length, "id", 2)) {
+            if (cursor.peek() == 'n') {
+                return cursor.skipValue();
+            }
+            f.has_id = true;
+            return cursor.parseUint(request_id_);
+        }
+    }
+    return cursor.skipValue();
+}
+
+// [["价格","数量"], ...]，每个档位多余的元素被忽略
+bool BinanceMessageParser::parseLevels(Cursor& cursor, std::vector<price_level_t>& levels) {
+    levels.clear();
+    if (!cursor.consume('[')) {
+        return cursor.fail("expected level array");
+    }
+    if (cursor.consume(']')) {
+        return true;
+    }
+    while (true) {
+        price_level_t level;
+        level.timestamp = 0;
+        if (!cursor.consume('[') || !cursor.parseDecimal(level.price) || !cursor.consume(',') ||
+            !cursor.parseDecimal(level.quantity)) {
+            return cursor.fail("invalid price level");
+        }
+        while (cursor.consume(',')) {
+            if (!cursor.skipValue()) {
+                return false;
+            }
+        }
+        if (!cursor.consume(']')) {
+            return cursor.fail("expected ']' after price level");
+        }
+        levels.push_back(level);
+        if (cursor.consume(',')) {
+            continue;
+        }
+        if (cursor.consume(']')) {
+            return true;
+        }
+        return cursor.fail("expected ',' or ']' in level array");
+    }
+}
+
+symbol_t BinanceMessageParser::resolveSymbol() const {
+    const SymbolRegistry& registry = SymbolRegistry::instance();
+    if (fields_.symbol_length > 0) {
+        return registry.find(fields_.symbol, fields_.symbol_length);
+    }
+    if (stream_length_ > 0) {
+        return registry.findByStreamName(stream_, stream_length_);
+    }
+    return default_symbol_;
+}
+
+BinanceMessageType BinanceMessageParser::finish() {
+    const Fields& f = fields_;
+    if (f.has_error) {
+        return BinanceMessageType::ERROR;
+    }
+    if (f.has_result && f.has_id) {
+        return BinanceMessageType::RESULT;
+    }
+
+    if (keyEquals(f.event, f.event_length, "depthUpdate", 11)) {
+        diff_.symbol = resolveSymbol();
+        diff_.first_update_id = f.first_update_id;
+        diff_.final_update_id = f.final_update_id;
+        diff_.event_time = f.event_time;
+        for (size_t i = 0; i < bids_.size(); ++i) {
+            bids_[i].timestamp = f.event_time;
+        }
+        for (size_t i = 0; i < asks_.size(); ++i) {
+            asks_[i].timestamp = f.event_time;
+        }
+        diff_.bids = bids_.data();
+        diff_.bid_count = static_cast<uint32_t>(bids_.size());
+        diff_.asks = asks_.data();
+        diff_.ask_count = static_cast<uint32_t>(asks_.size());
+        return BinanceMessageType::DEPTH_UPDATE;
+    }
+
+    const bool trade = keyEquals(f.event, f.event_length, "trade", 5);
+    const bool agg_trade = keyEquals(f.event, f.event_length, "aggTrade", 8);
+    if (trade || agg_trade) {
+        trade_.symbol = resolveSymbol();
+        trade_.aggregated = agg_trade ? 1 : 0;
+        trade_.trade_id = agg_trade ? f.agg_trade_id : f.trade_id;
+        trade_.first_trade_id = agg_trade ? f.first_trade_id : f.trade_id;
+        trade_.last_trade_id = agg_trade ? f.last_trade_id : f.trade_id;
+        trade_.trade_time = f.trade_time;
+        trade_.event_time = f.event_time;
+        trade_.price = f.price;
+        trade_.quantity = f.quantity;
+        trade_.is_buyer_maker = f.buyer_maker ? 1 : 0;
+        trade_.reserved = 0;
+        return agg_trade ? BinanceMessageType::AGG_TRADE : BinanceMessageType::TRADE;
+    }
+
+    if (f.event_length == 0 && f.has_last_update_id && (f.has_bids || f.has_asks)) {
+        memset(&orderbook_, 0, sizeof(orderbook_));
+        orderbook_.symbol = resolveSymbol();
+        orderbook_.timestamp = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()
+        ).count();
+        orderbook_.last_update_id = f.last_update_id;
+        orderbook_.bid_count = static_cast<uint32_t>(std::min<size_t>(bids_.size(), 20));
+        orderbook_.ask_count = static_cast<uint32_t>(std::min<size_t>(asks_.size(), 20));
+        std::copy(bids_.begin(), bids_.begin() + orderbook_.bid_count, orderbook_.bids);
+        std::copy(asks_.begin(), asks_.begin() + orderbook_.ask_count, orderbook_.asks);
+        return BinanceMessageType::DEPTH;
+    }
+    return BinanceMessageType::UNKNOWN;
+}
+
+} // namespace crypto_quant
@@ -0,0 +1,275 @@
+#include "feed_latency_monitor.h"
+#include "symbol_registry.h"
+#include <spdlog/spdlog.h>
+#include <chrono>
+#include <cmath>
+
+namespace crypto_quant {
+
+namespace {
+
+const size_t kStreamCount = static_cast<size_t>(LatencyStream::STREAM_COUNT);
+const size_t kStageCount = static_cast<size_t>(LatencyStage::STAGE_COUNT);
+
+inline uint32_t log2Floor(uint64_t value) {
+    return 63 - static_cast<uint32_t>(__builtin_clzll(value));
+}
+
+} // namespace
+
+const uint32_t LatencyHistogram::kLinearBuckets;
+const uint32_t LatencyHistogram::kSubBuckets;
+const uint32_t LatencyHistogram::kMaxExponent;
+const uint32_t LatencyHistogram::kBucketCount;
+
+LatencyHistogram::LatencyHistogram() {
+    reset();
+}
+
+uint32_t LatencyHistogram::bucketIndex(uint64_t value) {
+    if (value < kLinearBuckets) {
+        return static_cast<uint32_t>(value);
+    }
+    const uint32_t exponent = log2Floor(value);
+    if (exponent > kMaxExponent) {
+        return kBucketCount - 1;
+    }
+    // 最高位之后取5位作为桶内序号
+    const uint32_t sub = static_cast<uint32_t>(value >> (exponent - 5)) - kSubBuckets;
+    return kLinearBuckets + (exponent - 6) * kSubBuckets + sub;
+}
+
+uint64_t LatencyHistogram::bucketLow(uint32_t index) {
+    if (index < kLinearBuckets) {
+        return index;
+    }
+    const uint32_t offset = index - kLinearBuckets;
+    const uint32_t exponent = 6 + offset / kSubBuckets;
+    return static_cast<uint64_t>(kSubBuckets + offset % kSubBuckets) << (exponent - 5);
+}
+
+uint64_t LatencyHistogram::bucketWidth(uint32_t index) {
+    if (index < kLinearBuckets) {
+        return 1;
+    }
+    const uint32_t exponent = 6 + (index - kLinearBuckets) / kSubBuckets;
+    return static_cast<uint64_t>(1) << (exponent - 5);
+}
+
+void LatencyHistogram::record(uint64_t value_ns) {
+    counts_[bucketIndex(value_ns)].fetch_add(1, std::memory_order_relaxed);
+    sum_.fetch_add(value_ns, std::memory_order_relaxed);
+    uint64_t current = min_.load(std::memory_order_relaxed);
+    while (value_ns < current && !min_.compare_exchange_weak(current, value_ns, std::memory_order_relaxed)) {
+    }
+    current = max_.load(std::memory_order_relaxed);
+    while (value_ns > current && !max_.compare_exchange_weak(current, value_ns, std::memory_order_relaxed)) {
+    }
+    // 最后增加总数：读取方看到的总数不会多于已计入桶的样本
+    total_.fetch_add(1, std::memory_order_release);
+}
+
+LatencySummary LatencyHistogram::summary() const {
+    LatencySummary result;
+    result.count = total_.load(std::memory_order_acquire);
+    result.min = 0;
+    result.max = 0;
+    result.mean = 0.0;
+    result.p50 = result.p90 = result.p99 = result.p999 = 0;
+    if (result.count == 0) {
+        return result;
+    }
+    result.min = min_.load(std::memory_order_relaxed);
+    result.max = max_.load(std::memory_order_relaxed);
+    result.mean = static_cast<double>(sum_.load(std::memory_order_relaxed)) / result.count;
+
+    const double quantiles[4] = {0.5, 0.9, 0.99, 0.999};
+    uint64_t* outputs[4] = {&result.p50, &result.p90, &result.p99, &result.p999};
+    size_t next = 0;
+    uint64_t cumulative = 0;
+    for (uint32_t i = 0; i < kBucketCount && next < 4; ++i) {
+        cumulative += counts_[i].load(std::memory_order_relaxed);
+        while (next < 4 && cumulative >= static_cast<uint64_t>(std::ceil(quantiles[next] * result.count))) {
+            uint64_t value = bucketLow(i) + bucketWidth(i) / 2;
+            if (value > result.max) {
+                value = result.max;
+            }
+            if (value < result.min) {
+                value = result.min;
+            }
+            *outputs[next++] = value;
+        }
+    }
+    // 并发记录时桶计数可能还没追上总数
+    for (; next < 4; ++next) {
+        *outputs[next] = result.max;
+    }
+    return result;
+}
+
+void LatencyHistogram::reset() {
+    for (uint32_t i = 0; i < kBucketCount; ++i) {
+        counts_[i].store(0, std::memory_order_relaxed);
+    }
+    total_.store(0, std::memory_order_relaxed);
+    sum_.store(0, std::memory_order_relaxed);
+    min_.store(UINT64_MAX, std::memory_order_relaxed);
+    max_.store(0, std::memory_order_relaxed);
+}
+
+FeedLatencyMonitor::FeedLatencyMonitor()
+    : streams_(new std::atomic<StreamLatency*>[SymbolRegistry::kMaxSymbols * kStreamCount]),
+      clock_skew_(0) {
+    for (size_t i = 0; i < SymbolRegistry::kMaxSymbols * kStreamCount; ++i) {
+        streams_[i].store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+FeedLatencyMonitor::~FeedLatencyMonitor() {
+    for (size_t i = 0; i < SymbolRegistry::kMaxSymbols * kStreamCount; ++i) {
+        delete streams_[i].load(std::memory_order_relaxed);
+    }
+}
+
+uint64_t FeedLatencyMonitor::nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()
+    ).count();
+}
+
+FeedLatencyMonitor::StreamLatency* FeedLatencyMonitor::find(symbol_t symbol, LatencyStream stream) const {
+    if (symbol >= SymbolRegistry::kMaxSymbols || stream >= LatencyStream::STREAM_COUNT) {
+        return nullptr;
+    }
+    return streams_[symbol * kStreamCount + static_cast<size_t>(stream)].load(std::memory_order_acquire);
+}
+
+FeedLatencyMonitor::StreamLatency* FeedLatencyMonitor::acquire(symbol_t symbol, LatencyStream stream) {
+    if (symbol >= SymbolRegistry::kMaxSymbols || stream >= LatencyStream::STREAM_COUNT) {
+        return nullptr;
+    }
+    std::atomic<StreamLatency*>& slot = streams_[symbol * kStreamCount + static_cast<size_t>(stream)];
+    StreamLatency* latency = slot.load(std::memory_order_acquire);
+    if (latency) {
+        return latency;
+    }
+    // 网络线程与处理线程可能同时首次记录同一条流，CAS 失败的一方释放自己的
+    StreamLatency* created = new StreamLatency();
+    if (slot.compare_exchange_strong(latency, created, std::memory_order_acq_rel)) {
+        return created;
+    }
+    delete created;
+    return latency;
+}
+
+void FeedLatencyMonitor::recordFeed(symbol_t symbol, LatencyStream stream, uint64_t event_time_ms,
+                                    uint64_t receive_ns, uint64_t parsed_ns) {
+    StreamLatency* latency = acquire(symbol, stream);
+    if (!latency || receive_ns == 0) {
+        return;
+    }
+    if (event_time_ms != 0) {
+        const uint64_t event_ns = event_time_ms * 1000000;
+        if (receive_ns >= event_ns) {
+            latency->stages[static_cast<size_t>(LatencyStage::EXCHANGE_TO_RECEIVE)].record(receive_ns - event_ns);
+        } else {
+            clock_skew_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    if (parsed_ns >= receive_ns) {
+        latency->stages[static_cast<size_t>(LatencyStage::RECEIVE_TO_PARSE)].record(parsed_ns - receive_ns);
+    }
+}
+
+void FeedLatencyMonitor::recordCallback(symbol_t symbol, LatencyStream stream, uint64_t parsed_ns,
+                                        uint64_t callback_ns) {
+    if (parsed_ns == 0 || callback_ns < parsed_ns) {
+        return;
+    }
+    StreamLatency* latency = acquire(symbol, stream);
+    if (latency) {
+        latency->stages[static_cast<size_t>(LatencyStage::PARSE_TO_CALLBACK)].record(callback_ns - parsed_ns);
+    }
+}
+
+bool FeedLatencyMonitor::getSummary(symbol_t symbol, LatencyStream stream, LatencyStage stage,
+                                    LatencySummary& summary) const {
+    const StreamLatency* latency = find(symbol, stream);
+    if (!latency || stage >= LatencyStage::STAGE_COUNT) {
+        return false;
+    }
+    summary = latency->stages[static_cast<size_t>(stage)].summary();
+    return summary.count != 0;
+}
+
+void FeedLatencyMonitor::dump() const {
+    SymbolRegistry& registry = SymbolRegistry::instance();
+    for (size_t symbol = 0; symbol < registry.size(); ++symbol) {
+        for (size_t stream = 0; stream < kStreamCount; ++stream) {
+            const StreamLatency* latency = find(static_cast<symbol_t>(symbol), static_cast<LatencyStream>(stream));
+            if (!latency) {
+                continue;
+            }
+            for (size_t stage = 0; stage < kStageCount; ++stage) {
+                LatencySummary s = latency->stages[stage].summary();
+                if (s.count == 0) {
+                    continue;
+                }
+                spdlog::info("Latency {} {} {}: count={} min={:.1f}us p50={:.1f}us p90={:.1f}us "
+                             "p99={:.1f}us p99.9={:.1f}us max={:.1f}us mean={:.1f}us",
+                             registry.name(static_cast<symbol_t>(symbol)),
+                             streamName(static_cast<LatencyStream>(stream)),
+                             stageName(static_cast<LatencyStage>(stage)), s.count,
+                             s.min / 1e3, s.p50 / 1e3, s.p90 / 1e3, s.p99 / 1e3, s.p999 / 1e3,
+                             s.max / 1e3, s.mean / 1e3);
+            }
+        }
+    }
+    uint64_t skew = clockSkewCount();
+    if (skew != 0) {
+        spdlog::warn("Latency: {} messages had exchange event time ahead of local clock", skew);
+    }
+}
+
+void FeedLatencyMonitor::reset() {
+    for (size_t i = 0; i < SymbolRegistry::kMaxSymbols * kStreamCount; ++i) {
+        StreamLatency* latency = streams_[i].load(std::memory_order_acquire);
+        if (!latency) {
+            continue;
+        }
+        for (size_t stage = 0; stage < kStageCount; ++stage) {
+            latency->stages[stage].reset();
+        }
+    }
+    clock_skew_.store(0, std::memory_order_relaxed);
+}
+
+const char* FeedLatencyMonitor::streamName(LatencyStream stream) {
+    switch (stream) {
+    case LatencyStream::DEPTH:
+        return "depth";
+    case LatencyStream::DEPTH_DIFF:
+        return "depthDiff";
+    case LatencyStream::TRADE:
+        return "trade";
+    case LatencyStream::AGG_TRADE:
+        return "aggTrade";
+    default:
+        return "unknown";
+    }
+}
+
+const char* FeedLatencyMonitor::stageName(LatencyStage stage) {
+    switch (stage) {
+    case LatencyStage::EXCHANGE_TO_RECEIVE:
+        return "exchange->receive";
+    case LatencyStage::RECEIVE_TO_PARSE:
+        return "receive->parse";
+    case LatencyStage::PARSE_TO_CALLBACK:
+        return "parse->callback";
+    default:
+        return "unknown";
+    }
+}
+
+} // namespace crypto_quant
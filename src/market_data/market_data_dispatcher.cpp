@@ -0,0 +1,287 @@
+#include "market_data_dispatcher.h"
+#include <spdlog/spdlog.h>
+#include <pthread.h>
+#include <chrono>
+#include <cstring>
+#include <new>
+
+namespace crypto_quant {
+
+namespace {
+
+inline uint64_t steadyNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()
+    ).count();
+}
+
+} // namespace
+
+MarketDataDispatcher::MarketDataDispatcher(const MarketDataDispatcherConfig& config)
+    : config_(config), ring_(config.capacity), running_(false), waiting_(false),
+      published_(0), dropped_(0), backpressure_(0), backpressure_wait_ns_(0), max_depth_(0),
+      overflow_allocations_(0), processed_(0), wakeups_(0) {
+}
+
+MarketDataDispatcher::~MarketDataDispatcher() {
+    stop();
+}
+
+void MarketDataDispatcher::setOrderbookHandler(std::function<void(const orderbook_t&)> handler) {
+    if (running_.load()) {
+        spdlog::warn("Dispatcher handlers must be set before start");
+        return;
+    }
+    orderbook_handler_ = handler;
+}
+
+void MarketDataDispatcher::setDepthDiffHandler(std::function<void(const depth_diff_t&)> handler) {
+    if (running_.load()) {
+        spdlog::warn("Dispatcher handlers must be set before start");
+        return;
+    }
+    diff_handler_ = handler;
+}
+
+void MarketDataDispatcher::setTradeHandler(std::function<void(const trade_t&)> handler) {
+    if (running_.load()) {
+        spdlog::warn("Dispatcher handlers must be set before start");
+        return;
+    }
+    trade_handler_ = handler;
+}
+
+void MarketDataDispatcher::setLatencyMonitor(std::shared_ptr<FeedLatencyMonitor> monitor) {
+    if (running_.load()) {
+        spdlog::warn("Dispatcher latency monitor must be set before start");
+        return;
+    }
+    latency_ = monitor;
+}
+
+bool MarketDataDispatcher::start() {
+    if (running_.exchange(true)) {
+        spdlog::warn("Market data dispatcher already running");
+        return true;
+    }
+    thread_ = std::thread(&MarketDataDispatcher::run, this);
+    spdlog::info("Market data dispatcher started: capacity={}, wait_mode={}, overflow={}",
+                 ring_.capacity(), config_.wait_mode == DispatchWaitMode::BUSY_POLL ? "busy_poll" : "blocking",
+                 config_.overflow_policy == DispatchOverflowPolicy::BLOCK ? "block" : "drop_newest");
+    return true;
+}
+
+void MarketDataDispatcher::stop() {
+    if (!running_.exchange(false)) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(wait_mutex_);
+        wait_cv_.notify_one();
+    }
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    // 与停止并发的 publish 可能在处理线程退出后才入队，这里释放其档位
+    while (ring_.tryPop([](Event& event) { delete[] event.overflow; event.overflow = nullptr; })) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    MarketDataDispatcherStats stats = getStats();
+    spdlog::info("Market data dispatcher stopped: published={}, processed={}, dropped={}, backpressure={}, max_depth={}",
+                 stats.published, stats.processed, stats.dropped, stats.backpressure, stats.max_depth);
+}
+
+bool MarketDataDispatcher::publish(const orderbook_t& orderbook) {
+    if (!running_.load(std::memory_order_acquire)) {
+        return false;
+    }
+    const uint64_t publish_ns = latency_ ? FeedLatencyMonitor::nowNs() : 0;
+    return push([&orderbook, publish_ns](Event& event) {
+        event.type = EVENT_ORDERBOOK;
+        event.publish_ns = publish_ns;
+        event.overflow = nullptr;
+        event.orderbook = orderbook;
+    });
+}
+
+bool MarketDataDispatcher::publish(const depth_diff_t& diff) {
+    if (!running_.load(std::memory_order_acquire)) {
+        return false;
+    }
+
+    // 档位由调用方持有，入队前拷贝；超出内联容量时先在队列外分配
+    size_t level_count = static_cast<size_t>(diff.bid_count) + diff.ask_count;
+    price_level_t* overflow = nullptr;
+    if (level_count > kInlineLevels) {
+        overflow = new (std::nothrow) price_level_t[level_count];
+        if (!overflow) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        overflow_allocations_.fetch_add(1, std::memory_order_relaxed);
+        memcpy(overflow, diff.bids, diff.bid_count * sizeof(price_level_t));
+        memcpy(overflow + diff.bid_count, diff.asks, diff.ask_count * sizeof(price_level_t));
+    }
+    const uint64_t publish_ns = latency_ ? FeedLatencyMonitor::nowNs() : 0;
+    bool pushed = push([&diff, overflow, publish_ns](Event& event) {
+        event.type = EVENT_DEPTH_DIFF;
+        event.publish_ns = publish_ns;
+        event.diff = diff;
+        event.diff.bids = nullptr;
+        event.diff.asks = nullptr;
+        event.overflow = overflow;
+        if (!overflow) {
+            memcpy(event.levels, diff.bids, diff.bid_count * sizeof(price_level_t));
+            memcpy(event.levels + diff.bid_count, diff.asks, diff.ask_count * sizeof(price_level_t));
+        }
+    });
+    if (!pushed) {
+        delete[] overflow;
+    }
+    return pushed;
+}
+
+bool MarketDataDispatcher::publish(const trade_t& trade) {
+    if (!running_.load(std::memory_order_acquire)) {
+        return false;
+    }
+    const uint64_t publish_ns = latency_ ? FeedLatencyMonitor::nowNs() : 0;
+    return push([&trade, publish_ns](Event& event) {
+        event.type = EVENT_TRADE;
+        event.publish_ns = publish_ns;
+        event.overflow = nullptr;
+        event.trade = trade;
+    });
+}
+
+template <typename Fill>
+bool MarketDataDispatcher::push(Fill fill) {
+    if (!ring_.tryPush(fill)) {
+        backpressure_.fetch_add(1, std::memory_order_relaxed);
+        if (config_.overflow_policy == DispatchOverflowPolicy::DROP_NEWEST) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        // 背压：等待处理线程腾出位置
+        uint64_t wait_start = steadyNs();
+        SpinBackoff backoff;
+        while (!ring_.tryPush(fill)) {
+            if (!running_.load(std::memory_order_relaxed)) {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            backoff.pause();
+        }
+        backpressure_wait_ns_.fetch_add(steadyNs() - wait_start, std::memory_order_relaxed);
+    }
+    published_.fetch_add(1, std::memory_order_relaxed);
+
+    // 只有生产者写最高水位
+    uint64_t depth = ring_.sizeApprox();
+    if (depth > max_depth_.load(std::memory_order_relaxed)) {
+        max_depth_.store(depth, std::memory_order_relaxed);
+    }
+
+    // 入队与读取 waiting_ 之间的全屏障，与处理线程置位后检查队列的屏障配对，避免丢失唤醒
+    if (config_.wait_mode == DispatchWaitMode::BLOCKING) {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (waiting_.load(std::memory_order_relaxed)) {
+            std::lock_guard<std::mutex> lock(wait_mutex_);
+            wait_cv_.notify_one();
+        }
+    }
+    return true;
+}
+
+void MarketDataDispatcher::run() {
+#ifdef __linux__
+    pthread_setname_np(pthread_self(), "md-dispatch");
+#endif
+    uint32_t idle_rounds = 0;
+    for (;;) {
+        bool popped = ring_.tryPop([this](Event& event) {
+            process(event);
+        });
+        if (popped) {
+            processed_.fetch_add(1, std::memory_order_relaxed);
+            idle_rounds = 0;
+            continue;
+        }
+        // 停止时队列已处理完
+        if (!running_.load(std::memory_order_acquire)) {
+            break;
+        }
+        if (config_.wait_mode == DispatchWaitMode::BUSY_POLL || ++idle_rounds < config_.spin_iterations) {
+            cpu_relax();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(wait_mutex_);
+        waiting_.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (ring_.empty() && running_.load(std::memory_order_acquire)) {
+            // 超时只是兜底，正常由生产者唤醒
+            if (wait_cv_.wait_for(lock, std::chrono::milliseconds(100)) == std::cv_status::no_timeout) {
+                wakeups_.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+        waiting_.store(false, std::memory_order_relaxed);
+        idle_rounds = 0;
+    }
+}
+
+void MarketDataDispatcher::recordLatency(const Event& event) {
+    const uint64_t now = FeedLatencyMonitor::nowNs();
+    if (event.type == EVENT_ORDERBOOK) {
+        latency_->recordCallback(event.orderbook.symbol, LatencyStream::DEPTH, event.publish_ns, now);
+    } else if (event.type == EVENT_TRADE) {
+        latency_->recordCallback(event.trade.symbol, FeedLatencyMonitor::streamOf(event.trade), event.publish_ns, now);
+    } else {
+        latency_->recordCallback(event.diff.symbol, LatencyStream::DEPTH_DIFF, event.publish_ns, now);
+    }
+}
+
+void MarketDataDispatcher::process(Event& event) {
+    try {
+        if (event.publish_ns != 0) {
+            recordLatency(event);
+        }
+        if (event.type == EVENT_ORDERBOOK) {
+            if (orderbook_handler_) {
+                orderbook_handler_(event.orderbook);
+            }
+        } else if (event.type == EVENT_TRADE) {
+            if (trade_handler_) {
+                trade_handler_(event.trade);
+            }
+        } else {
+            depth_diff_t& diff = event.diff;
+            const price_level_t* levels = event.overflow ? event.overflow : event.levels;
+            diff.bids = levels;
+            diff.asks = levels + diff.bid_count;
+            if (diff_handler_) {
+                diff_handler_(diff);
+            }
+        }
+    } catch (const std::exception& e) {
+        spdlog::error("Error in market data handler: {}", e.what());
+    }
+    delete[] event.overflow;
+    event.overflow = nullptr;
+}
+
+MarketDataDispatcherStats MarketDataDispatcher::getStats() const {
+    MarketDataDispatcherStats stats;
+    stats.published = published_.load(std::memory_order_relaxed);
+    stats.processed = processed_.load(std::memory_order_relaxed);
+    stats.dropped = dropped_.load(std::memory_order_relaxed);
+    stats.backpressure = backpressure_.load(std::memory_order_relaxed);
+    stats.backpressure_wait_ns = backpressure_wait_ns_.load(std::memory_order_relaxed);
+    stats.max_depth = max_depth_.load(std::memory_order_relaxed);
+    stats.overflow_allocations = overflow_allocations_.load(std::memory_order_relaxed);
+    stats.wakeups = wakeups_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+} // namespace crypto_quant
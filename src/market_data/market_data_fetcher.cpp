@@ -1,19 +1,60 @@
 #include <chrono>
+#include <cmath>
 #include <thread>
 #include <algorithm>
 #include <memory>
+#include <curl/curl.h>
+#include <nlohmann/json.hpp>
 #include <spdlog/spdlog.h>
 
 #include "market_data_fetcher.h"
 #include "websocket_client.h"
+#include "fixed_point.h"
+#include "symbol_registry.h"
+
+using json = nlohmann::json;
 
 namespace crypto_quant
 {
 
-    MarketDataFetcher::MarketDataFetcher()
-        : is_running(false),
-          use_binance(true), use_coingecko(true)
+    // 币安 REST 深度快照端点
+    static const std::string BINANCE_DEPTH_URL = "https://api.binance.com/api/v3/depth";
+
+    MarketDataFetcher::MarketDataFetcher(const MarketDataFetcherConfig &config)
+        : config_(config), is_running(false),
+          use_binance(true), use_coingecko(true),
+          subscriptions_(SymbolRegistry::kMaxSymbols), next_request_id_(1), last_rebalance_ms_(0),
+          routes_(new std::atomic<uint32_t>[SymbolRegistry::kMaxSymbols]),
+          message_counts_(new std::atomic<uint64_t>[SymbolRegistry::kMaxSymbols]),
+          arbitrated_gaps_(0)
     {
+        // 路由中连接下标占16位
+        config_.max_connections = std::max<uint32_t>(1, std::min<uint32_t>(config_.max_connections, 0xFFFE));
+        config_.max_streams_per_connection = std::max<uint32_t>(1, config_.max_streams_per_connection);
+        config_.redundancy = std::max<uint32_t>(1, std::min<uint32_t>(config_.redundancy, 4));
+        const size_t id_slots = SymbolRegistry::kMaxSymbols * ARBITRATED_STREAM_COUNT;
+        accepted_ids_.reset(new uint64_t[id_slots]());
+        line_ids_.reset(new uint64_t[id_slots * config_.redundancy]());
+        line_counters_.reset(new LineCounters[config_.redundancy]);
+        for (uint32_t i = 0; i < config_.redundancy; ++i)
+        {
+            line_counters_[i].messages.store(0, std::memory_order_relaxed);
+            line_counters_[i].wins.store(0, std::memory_order_relaxed);
+            line_counters_[i].duplicates.store(0, std::memory_order_relaxed);
+            line_counters_[i].gaps.store(0, std::memory_order_relaxed);
+        }
+        for (size_t i = 0; i < SymbolRegistry::kMaxSymbols; ++i)
+        {
+            Subscription &subscription = subscriptions_[i];
+            subscription.streams = 0;
+            subscription.connection = -1;
+            subscription.moving_to = -1;
+            subscription.move_started_ms = 0;
+            subscription.last_message_count = 0;
+            subscription.message_rate = 0.0;
+            routes_[i].store(0, std::memory_order_relaxed);
+            message_counts_[i].store(0, std::memory_order_relaxed);
+        }
         spdlog::debug("MarketDataFetcher constructor called");
     }
 
@@ -35,67 +76,32 @@ namespace crypto_quant
 
     int MarketDataFetcher::start(symbol_t symbol)
     {
-        if (is_running.load())
+        bool expected = false;
+        if (!is_running.compare_exchange_strong(expected, true))
         {
-            spdlog::warn("Market data fetcher already running");
-            return 0;
+            // 已在运行：追加订阅
+            return subscribe(symbol, 0);
         }
 
-        std::lock_guard<std::mutex> lock(mutex);
-        is_running.store(true);
-        current_symbol = symbol;
-
-        // 如果使用 WebSocket，初始化 WebSocket 客户端
-        if (use_binance.load()) {
-            initializeWebSocketClient(symbol);
-        }
-        
-        // 启动数据收集线程（用于备用模式）
-        data_thread = std::thread([this]()
-                                  {
-            while (is_running.load()) {
-                try {
-                    // 获取当前交易对（线程安全）
-                    symbol_t current_sym;
-                    {
-                        std::lock_guard<std::mutex> lock(mutex);
-                        current_sym = current_symbol;
-                    }
-                    
-                    // 如果 WebSocket 未运行，使用模拟数据
-                    bool use_fallback = true;
-                    {
-                        std::lock_guard<std::mutex> lock(mutex);
-                        if (websocket_client_ && websocket_client_->isRunning()) {
-                            use_fallback = false;
-                        }
-                    }
-                    
-                    if (use_fallback) {
-                        orderbook_t orderbook = generateOrderbook(current_sym);
-                        
-                        // 调用回调函数（如果已设置）
-                        std::function<void(const orderbook_t&)> callback;
-                        {
-                            std::lock_guard<std::mutex> lock(mutex);
-                            callback = orderbook_callback;
-                        }
-                        
-                        if (callback) {
-                            callback(orderbook);
-                        }
-                    }
-                } catch (const std::exception& e) {
-                    spdlog::error("Error in market data thread: {}", e.what());
-                }
-                
-                // 如果使用 WebSocket，减少轮询频率
-                int sleep_ms = (websocket_client_ && websocket_client_->isRunning()) ? 5000 : 1000;
-                std::this_thread::sleep_for(std::chrono::milliseconds(sleep_ms));
-            } });
+        // 所有连接共用一个事件循环线程；不使用币安时只推送模拟数据
+        if (use_binance.load())
+        {
+            std::shared_ptr<WebSocketEventLoop> loop = std::make_shared<WebSocketEventLoop>();
+            if (loop->start())
+            {
+                std::lock_guard<std::mutex> lock(subscription_mutex_);
+                event_loop_ = loop;
+            }
+            else
+            {
+                spdlog::error("Failed to start WebSocket event loop, falling back to generated data");
+            }
+        }
+
+        data_thread = std::thread(&MarketDataFetcher::run, this);
 
         spdlog::info("Market data fetcher started for symbol: {}", static_cast<int>(symbol));
-        return 0;
+        return subscribe(symbol, 0);
     }
 
     void MarketDataFetcher::stop()
@@ -107,25 +113,213 @@ namespace crypto_quant
         }
 
         is_running.store(false);
-        
-        // 停止 WebSocket 客户端
         {
             std::lock_guard<std::mutex> lock(mutex);
-            if (websocket_client_) {
-                websocket_client_->stop();
-                websocket_client_.reset();
-            }
+            data_cv.notify_all();
         }
-        
+
         // 等待线程结束
         if (data_thread.joinable())
         {
             data_thread.join();
         }
-        
+
+        // 清空订阅并取出连接；停止连接时不能持有 subscription_mutex_，
+        // 事件循环线程的状态回调需要它
+        std::vector<std::unique_ptr<StreamConnection>> connections;
+        std::shared_ptr<WebSocketEventLoop> loop;
+        {
+            std::lock_guard<std::mutex> lock(subscription_mutex_);
+            connections.swap(connections_);
+            loop.swap(event_loop_);
+            for (size_t i = 0; i < subscribed_.size(); ++i)
+            {
+                symbol_t symbol = subscribed_[i];
+                subscriptions_[symbol].streams = 0;
+                subscriptions_[symbol].connection = -1;
+                subscriptions_[symbol].moving_to = -1;
+                routes_[symbol].store(0, std::memory_order_release);
+            }
+            subscribed_.clear();
+        }
+
+        // 停止 WebSocket 客户端
+        for (size_t i = 0; i < connections.size(); ++i)
+        {
+            for (size_t line = 0; line < connections[i]->lines.size(); ++line)
+            {
+                connections[i]->lines[line].client->stop();
+            }
+        }
+        connections.clear();
+        if (loop)
+        {
+            loop->stop();
+        }
+
         spdlog::info("Market data fetcher stopped");
     }
 
+    int MarketDataFetcher::subscribe(symbol_t symbol, uint32_t streams)
+    {
+        if (!SymbolRegistry::instance().contains(symbol))
+        {
+            spdlog::error("Cannot subscribe unknown symbol: {}", symbol);
+            return -1;
+        }
+        if (!is_running.load())
+        {
+            spdlog::error("Cannot subscribe {}: market data fetcher not running", symbolToBinanceSymbol(symbol));
+            return -1;
+        }
+        if (streams == 0)
+        {
+            streams = defaultStreams();
+        }
+
+        std::lock_guard<std::mutex> lock(subscription_mutex_);
+        Subscription &subscription = subscriptions_[symbol];
+        if (subscription.streams == streams)
+        {
+            return 0;
+        }
+
+        if (subscription.streams == 0)
+        {
+            int index = -1;
+            if (event_loop_)
+            {
+                uint32_t stream_count = 0;
+                for (uint32_t bits = streams; bits != 0; bits &= bits - 1)
+                {
+                    ++stream_count;
+                }
+                index = chooseConnection(stream_count);
+                if (index < 0)
+                {
+                    spdlog::error("No stream connection available for {}", symbolToBinanceSymbol(symbol));
+                    return -1;
+                }
+                addStreams(index, symbol, streams);
+            }
+            subscription.streams = streams;
+            subscription.connection = index;
+            subscription.moving_to = -1;
+            subscription.last_message_count = message_counts_[symbol].load(std::memory_order_relaxed);
+            subscription.message_rate = 0.0;
+            routes_[symbol].store(static_cast<uint32_t>(index + 1), std::memory_order_release);
+            subscribed_.push_back(symbol);
+            spdlog::info("Subscribed {} on connection {}", symbolToBinanceSymbol(symbol), index);
+        }
+        else
+        {
+            // 已订阅：在归属连接（及迁移目标）上补订新增的流、退订去掉的流
+            uint32_t added = streams & ~subscription.streams;
+            uint32_t removed = subscription.streams & ~streams;
+            int owners[2] = {subscription.connection, subscription.moving_to};
+            for (int i = 0; i < 2; ++i)
+            {
+                if (owners[i] >= 0)
+                {
+                    addStreams(owners[i], symbol, added);
+                    removeStreams(owners[i], symbol, removed);
+                }
+            }
+            subscription.streams = streams;
+        }
+
+        data_cv.notify_one();
+        return 0;
+    }
+
+    int MarketDataFetcher::unsubscribe(symbol_t symbol)
+    {
+        std::lock_guard<std::mutex> lock(subscription_mutex_);
+        if (!SymbolRegistry::instance().contains(symbol) || subscriptions_[symbol].streams == 0)
+        {
+            spdlog::warn("Symbol {} is not subscribed", symbol);
+            return -1;
+        }
+
+        Subscription &subscription = subscriptions_[symbol];
+        routes_[symbol].store(0, std::memory_order_release);
+        if (subscription.connection >= 0)
+        {
+            removeStreams(subscription.connection, symbol, subscription.streams);
+        }
+        if (subscription.moving_to >= 0)
+        {
+            removeStreams(subscription.moving_to, symbol, subscription.streams);
+        }
+        subscription.streams = 0;
+        subscription.connection = -1;
+        subscription.moving_to = -1;
+        subscribed_.erase(std::find(subscribed_.begin(), subscribed_.end(), symbol));
+
+        data_cv.notify_one();
+        spdlog::info("Unsubscribed {}", symbolToBinanceSymbol(symbol));
+        return 0;
+    }
+
+    std::vector<StreamConnectionStats> MarketDataFetcher::getConnectionStats() const
+    {
+        std::lock_guard<std::mutex> lock(subscription_mutex_);
+        std::vector<StreamConnectionStats> result(connections_.size());
+        for (size_t i = 0; i < connections_.size(); ++i)
+        {
+            const StreamConnection &connection = *connections_[i];
+            result[i].connected = false;
+            result[i].symbols = 0;
+            result[i].streams = connection.streams;
+            result[i].message_rate = 0.0;
+            result[i].reconnects = 0;
+            result[i].lines_connected = 0;
+            for (size_t line = 0; line < connection.lines.size(); ++line)
+            {
+                WebSocketConnectionStats stats = connection.lines[line].client->getStats();
+                if (connection.lines[line].client->isConnected())
+                {
+                    result[i].connected = true;
+                    result[i].lines_connected++;
+                }
+                result[i].reconnects += stats.connects > 0 ? stats.connects - 1 : 0;
+            }
+        }
+        for (size_t i = 0; i < subscribed_.size(); ++i)
+        {
+            const Subscription &subscription = subscriptions_[subscribed_[i]];
+            int index = subscription.moving_to >= 0 ? subscription.moving_to : subscription.connection;
+            if (index >= 0)
+            {
+                result[index].symbols++;
+                result[index].message_rate += subscription.message_rate;
+            }
+        }
+        return result;
+    }
+
+    std::vector<FeedLineStats> MarketDataFetcher::getLineStats() const
+    {
+        std::vector<FeedLineStats> result(config_.redundancy);
+        for (uint32_t i = 0; i < config_.redundancy; ++i)
+        {
+            const LineCounters &counters = line_counters_[i];
+            result[i].line = i;
+            result[i].messages = counters.messages.load(std::memory_order_relaxed);
+            result[i].wins = counters.wins.load(std::memory_order_relaxed);
+            result[i].duplicates = counters.duplicates.load(std::memory_order_relaxed);
+            result[i].gaps = counters.gaps.load(std::memory_order_relaxed);
+            const uint64_t decided = result[i].wins + result[i].duplicates;
+            result[i].win_rate = decided > 0 ? static_cast<double>(result[i].wins) / decided : 0.0;
+        }
+        return result;
+    }
+
+    uint64_t MarketDataFetcher::getArbitratedGaps() const
+    {
+        return arbitrated_gaps_.load(std::memory_order_relaxed);
+    }
+
     void MarketDataFetcher::setOrderbookCallback(std::function<void(const orderbook_t &)> callback)
     {
         std::lock_guard<std::mutex> lock(mutex);
@@ -133,6 +327,126 @@ namespace crypto_quant
         spdlog::debug("Orderbook callback set");
     }
 
+    void MarketDataFetcher::setDepthDiffCallback(std::function<void(const depth_diff_t &)> callback)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        depth_diff_callback = callback;
+        spdlog::debug("Depth diff callback set");
+    }
+
+    void MarketDataFetcher::setTradeCallback(std::function<void(const trade_t &)> callback)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        trade_callback = callback;
+        spdlog::debug("Trade callback set");
+    }
+
+    void MarketDataFetcher::setRecorder(std::shared_ptr<MarketDataRecorder> recorder)
+    {
+        if (is_running.load())
+        {
+            spdlog::warn("Market data recorder must be set before start");
+            return;
+        }
+        recorder_ = recorder;
+    }
+
+    void MarketDataFetcher::setLatencyMonitor(std::shared_ptr<FeedLatencyMonitor> monitor)
+    {
+        if (is_running.load())
+        {
+            spdlog::warn("Latency monitor must be set before start");
+            return;
+        }
+        latency_ = monitor;
+    }
+
+    size_t MarketDataFetcher::writeCallback(void *contents, size_t size, size_t nmemb, void *userp)
+    {
+        static_cast<std::string *>(userp)->append(static_cast<char *>(contents), size * nmemb);
+        return size * nmemb;
+    }
+
+    bool MarketDataFetcher::fetchDepthSnapshot(symbol_t symbol, int limit, DepthSnapshot &snapshot)
+    {
+        // 币安允许的档位数为 1~5000
+        limit = std::max(1, std::min(limit, 5000));
+        std::string url = BINANCE_DEPTH_URL + "?symbol=" + symbolToBinanceSymbol(symbol) +
+                          "&limit=" + std::to_string(limit);
+
+        CURL *curl = curl_easy_init();
+        if (!curl)
+        {
+            spdlog::error("Failed to initialize CURL for depth snapshot");
+            return false;
+        }
+
+        std::string response;
+        curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, writeCallback);
+        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
+        curl_easy_setopt(curl, CURLOPT_TIMEOUT, 5L);
+
+        CURLcode res = curl_easy_perform(curl);
+        long http_code = 0;
+        curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_code);
+        curl_easy_cleanup(curl);
+
+        if (res != CURLE_OK)
+        {
+            spdlog::error("Depth snapshot request failed: {}", curl_easy_strerror(res));
+            return false;
+        }
+        if (http_code != 200)
+        {
+            spdlog::error("Depth snapshot HTTP response code: {}", http_code);
+            return false;
+        }
+
+        try
+        {
+            json j = json::parse(response);
+            snapshot.symbol = symbol;
+            snapshot.last_update_id = j.at("lastUpdateId").get<uint64_t>();
+            snapshot.limit = static_cast<uint32_t>(limit);
+
+            const char *sides[2] = {"bids", "asks"};
+            std::vector<price_level_t> *levels[2] = {&snapshot.bids, &snapshot.asks};
+            for (int side = 0; side < 2; ++side)
+            {
+                levels[side]->clear();
+                for (const auto &entry : j.at(sides[side]))
+                {
+                    price_level_t level;
+                    const std::string &price = entry.at(0).get_ref<const std::string &>();
+                    const std::string &quantity = entry.at(1).get_ref<const std::string &>();
+                    if (!parseDecimalDouble(price.data(), price.data() + price.size(), level.price) ||
+                        !parseDecimalDouble(quantity.data(), quantity.data() + quantity.size(), level.quantity))
+                    {
+                        throw std::invalid_argument("Invalid decimal in depth snapshot");
+                    }
+                    level.timestamp = 0;
+                    levels[side]->push_back(level);
+                }
+            }
+        }
+        catch (const std::exception &e)
+        {
+            spdlog::error("Failed to parse depth snapshot: {}", e.what());
+            return false;
+        }
+
+        spdlog::info("Depth snapshot fetched: symbol={}, last_update_id={}, bids={}, asks={}",
+                     symbolToBinanceSymbol(symbol), snapshot.last_update_id,
+                     snapshot.bids.size(), snapshot.asks.size());
+        // 回放增量流时按顺序交还录制的快照
+        if (recorder_)
+        {
+            recorder_->recordSnapshot(snapshot, MarketDataRecorder::nowNs());
+        }
+        return true;
+    }
+
     orderbook_t MarketDataFetcher::getOrderbook(symbol_t symbol) const
     {
         std::lock_guard<std::mutex> lock(mutex);
@@ -157,93 +471,693 @@ namespace crypto_quant
 
     orderbook_t MarketDataFetcher::generateOrderbook(symbol_t symbol) const
     {
-        orderbook_t orderbook = {};
-        orderbook.symbol = symbol;
-        orderbook.timestamp = std::chrono::duration_cast<std::chrono::milliseconds>(
-                                  std::chrono::system_clock::now().time_since_epoch())
-                                  .count();
+        // 随机过程演化的合成订单薄，代替固定价格的模拟数据
+        uint64_t now_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                              std::chrono::system_clock::now().time_since_epoch())
+                              .count();
+        fallback_feed_.step(symbol, now_ns);
+        orderbook_t orderbook;
+        fallback_feed_.fillOrderbook(symbol, orderbook);
 
-        // 根据交易对生成不同的价格
-        double base_price = 50000.0 + (static_cast<int>(symbol) * 1000.0);
-        orderbook.bid_count = 1;
-        orderbook.ask_count = 1;
-        orderbook.bids[0].price = base_price - 5.0;
-        orderbook.bids[0].quantity = 1.0;
-        orderbook.asks[0].price = base_price + 5.0;
-        orderbook.asks[0].quantity = 1.0;
-
-        spdlog::debug("Orderbook data generated for symbol: {}, price: {:.2f}",
-                      static_cast<int>(symbol), base_price);
+        spdlog::debug("Orderbook data generated for symbol: {}, bid: {:.2f}, ask: {:.2f}",
+                      static_cast<int>(symbol), orderbook.bids[0].price, orderbook.asks[0].price);
         return orderbook;
     }
     
-    bool MarketDataFetcher::initializeWebSocketClient(symbol_t symbol)
-    {
-        if (websocket_client_) {
-            return true; // 已经初始化
-        }
-        
-        // 构建 WebSocket URL（币安深度流）
-        std::string binance_symbol = symbolToBinanceSymbol(symbol);
-        std::transform(binance_symbol.begin(), binance_symbol.end(), 
-                      binance_symbol.begin(), ::tolower);
-        std::string ws_url = "wss://stream.binance.com:9443/ws/" + binance_symbol + "@depth20@100ms";
-        
-        try {
-            websocket_client_ = std::unique_ptr<WebSocketClient>(new WebSocketClient(ws_url));
-            
-            if (!websocket_client_->isInitialized()) {
+    void MarketDataFetcher::run()
+    {
+        // 启动后先给连接一个推送间隔的时间完成握手，再判断是否需要模拟数据
+        uint64_t last_fallback_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                                        std::chrono::steady_clock::now().time_since_epoch())
+                                        .count();
+        bool in_fallback = false;
+        while (is_running.load())
+        {
+            uint64_t now_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                                  std::chrono::steady_clock::now().time_since_epoch())
+                                  .count();
+            std::vector<symbol_t> fallback_symbols;
+            std::shared_ptr<WebSocketEventLoop> loop;
+            {
+                std::lock_guard<std::mutex> lock(subscription_mutex_);
+                for (size_t i = 0; i < connections_.size(); ++i)
+                {
+                    flushRequests(i, now_ms);
+                }
+                finishMoves(now_ms);
+                if (now_ms - last_rebalance_ms_ >= config_.rebalance_interval_ms)
+                {
+                    updateRates(now_ms);
+                    rebalance(now_ms);
+                    last_rebalance_ms_ = now_ms;
+                }
+
+                // 没有任何已打开的线路时（未建立、全部断线或重连中）每秒推送一次模拟数据
+                bool any_open = false;
+                for (size_t i = 0; i < connections_.size() && !any_open; ++i)
+                {
+                    any_open = connections_[i]->isOpen();
+                }
+                if (any_open)
+                {
+                    if (in_fallback)
+                    {
+                        spdlog::info("Stream connection open, fallback data stopped");
+                        in_fallback = false;
+                    }
+                }
+                else if (now_ms - last_fallback_ms >= 1000)
+                {
+                    if (!in_fallback)
+                    {
+                        spdlog::warn("No open stream connection, pushing fallback data");
+                        in_fallback = true;
+                    }
+                    fallback_symbols = subscribed_;
+                    loop = event_loop_;
+                    last_fallback_ms = now_ms;
+                }
+            }
+
+            if (!fallback_symbols.empty())
+            {
+                std::function<void(const orderbook_t &)> callback;
+                std::vector<orderbook_t> fallback_books;
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    callback = orderbook_callback;
+                    for (size_t i = 0; callback && i < fallback_symbols.size(); ++i)
+                    {
+                        fallback_books.push_back(generateOrderbook(fallback_symbols[i]));
+                    }
+                }
+                // 回调（如分发器的单生产者 publish）与线路数据须在同一线程上：
+                // 有事件循环时把模拟数据投递到循环线程，否则本线程是唯一的生产者
+                std::function<void()> push = [callback, fallback_books]()
+                {
+                    for (size_t i = 0; i < fallback_books.size(); ++i)
+                    {
+                        try
+                        {
+                            callback(fallback_books[i]);
+                        }
+                        catch (const std::exception &e)
+                        {
+                            spdlog::error("Error in market data thread: {}", e.what());
+                        }
+                    }
+                };
+                if (loop)
+                {
+                    loop->runInLoop(push);
+                }
+                else
+                {
+                    push();
+                }
+            }
+
+            std::unique_lock<std::mutex> lock(mutex);
+            if (is_running.load())
+            {
+                data_cv.wait_for(lock, std::chrono::milliseconds(config_.request_interval_ms));
+            }
+        }
+    }
+
+    int MarketDataFetcher::openConnection()
+    {
+        if (!event_loop_)
+        {
+            return -1;
+        }
+
+        const size_t index = connections_.size();
+        std::unique_ptr<StreamConnection> connection(new StreamConnection());
+        connection->streams = 0;
+        connection->lines.resize(config_.redundancy);
+        for (size_t line = 0; line < connection->lines.size(); ++line)
+        {
+            StreamLine &stream_line = connection->lines[line];
+            stream_line.open = false;
+            stream_line.last_request_ms = 0;
+            stream_line.client.reset(new WebSocketClient(config_.stream_url, event_loop_));
+            WebSocketClient &client = *stream_line.client;
+            if (!client.isInitialized())
+            {
                 spdlog::error("Failed to initialize WebSocket client");
-                websocket_client_.reset();
-                return false;
+                return -1;
             }
-            
-            // 设置回调函数
-            websocket_client_->setCallback([this](const orderbook_t* orderbook) {
-                if (!orderbook) {
+            // 客户端对象不会移动，回调在事件循环线程上读取当前消息的时间戳
+            WebSocketClient *client_ptr = &client;
+            client.setTimestamping(latency_ != nullptr);
+
+            client.setCallback([this, index, line, client_ptr](const orderbook_t *orderbook)
+                               {
+                if (!orderbook || !acceptMessage(orderbook->symbol, index, line, ARBITRATED_DEPTH,
+                                                 orderbook->last_update_id, orderbook->last_update_id)) {
                     return;
                 }
-                
-                // 调用回调函数（如果已设置）
+                // 部分深度消息不带事件时间，只统计读出到解析
+                if (latency_) {
+                    latency_->recordFeed(orderbook->symbol, LatencyStream::DEPTH, 0,
+                                         client_ptr->receiveNs(), client_ptr->parsedNs());
+                }
+                if (recorder_) {
+                    // 仲裁胜出的消息才录制，原始负载与归一化记录一一对应
+                    uint64_t record_ns = MarketDataRecorder::nowNs();
+                    recorder_->recordRaw(client_ptr->messageData(), client_ptr->messageSize(), record_ns);
+                    recorder_->recordOrderbook(*orderbook, record_ns);
+                }
+
                 std::function<void(const orderbook_t&)> callback;
                 {
                     std::lock_guard<std::mutex> lock(mutex);
                     callback = orderbook_callback;
                 }
-                
+
                 if (callback) {
                     callback(*orderbook);
+                } });
+
+            client.setDiffCallback([this, index, line, client_ptr](const depth_diff_t *diff)
+                                   {
+                if (!diff || !acceptMessage(diff->symbol, index, line, ARBITRATED_DEPTH_DIFF,
+                                            diff->first_update_id, diff->final_update_id)) {
+                    return;
+                }
+                if (latency_) {
+                    latency_->recordFeed(diff->symbol, LatencyStream::DEPTH_DIFF, diff->event_time,
+                                         client_ptr->receiveNs(), client_ptr->parsedNs());
+                }
+                if (recorder_) {
+                    uint64_t record_ns = MarketDataRecorder::nowNs();
+                    recorder_->recordRaw(client_ptr->messageData(), client_ptr->messageSize(), record_ns);
+                    recorder_->recordDepthDiff(*diff, record_ns);
+                }
+
+                std::function<void(const depth_diff_t&)> callback;
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    callback = depth_diff_callback;
                 }
-            });
-            
-            // 启动 WebSocket 连接
-            if (!websocket_client_->start()) {
-                spdlog::error("Failed to start WebSocket client");
-                websocket_client_.reset();
+
+                if (callback) {
+                    callback(*diff);
+                } });
+
+            client.setTradeCallback([this, index, line, client_ptr](const trade_t *trade)
+                                    {
+                // 归集成交按归集ID，逐笔成交按成交ID仲裁，两者都逐条连续
+                if (!trade || !acceptMessage(trade->symbol, index, line,
+                                             trade->aggregated ? ARBITRATED_AGG_TRADE : ARBITRATED_TRADE,
+                                             trade->trade_id, trade->trade_id)) {
+                    return;
+                }
+                if (latency_) {
+                    latency_->recordFeed(trade->symbol, FeedLatencyMonitor::streamOf(*trade), trade->event_time,
+                                         client_ptr->receiveNs(), client_ptr->parsedNs());
+                }
+                if (recorder_) {
+                    uint64_t record_ns = MarketDataRecorder::nowNs();
+                    recorder_->recordRaw(client_ptr->messageData(), client_ptr->messageSize(), record_ns);
+                    recorder_->recordTrade(*trade, record_ns);
+                }
+
+                std::function<void(const trade_t&)> callback;
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    callback = trade_callback;
+                }
+
+                if (callback) {
+                    callback(*trade);
+                } });
+
+            client.setStateCallback([this, index, line](bool open)
+                                    { onConnectionState(index, line, open); });
+            client.setResponseCallback([index, line](uint64_t id, bool ok)
+                                       {
+                if (ok) {
+                    spdlog::debug("Stream request {} acknowledged on connection {} line {}", id, index, line);
+                } });
+        }
+
+        // 启动前加入列表，状态回调按下标查找连接
+        StreamConnection &added = *connection;
+        connections_.push_back(std::move(connection));
+        for (size_t line = 0; line < added.lines.size(); ++line)
+        {
+            if (added.lines[line].client->start())
+            {
+                continue;
+            }
+            spdlog::error("Failed to start WebSocket client (connection {} line {})", index, line);
+            if (line == 0)
+            {
+                connections_.pop_back();
+                return -1;
+            }
+            // 冗余线路启动失败时以已启动的线路继续运行（未启动的客户端不在事件循环中，可以直接释放）
+            added.lines.resize(line);
+            break;
+        }
+
+        spdlog::info("Stream connection {} opened with {} line(s): {}", index, added.lines.size(), config_.stream_url);
+        return static_cast<int>(index);
+    }
+
+    int MarketDataFetcher::chooseConnection(uint32_t stream_count)
+    {
+        if (connections_.size() < config_.max_connections)
+        {
+            int index = openConnection();
+            if (index >= 0)
+            {
+                return index;
+            }
+        }
+
+        // 还没有速率统计的交易对按已知交易对的平均速率估算
+        double known_rate = 0.0;
+        size_t known = 0;
+        for (size_t i = 0; i < subscribed_.size(); ++i)
+        {
+            if (subscriptions_[subscribed_[i]].message_rate > 0.0)
+            {
+                known_rate += subscriptions_[subscribed_[i]].message_rate;
+                ++known;
+            }
+        }
+        const double average_rate = known > 0 ? known_rate / known : 1.0;
+        std::vector<double> loads(connections_.size(), 0.0);
+        for (size_t i = 0; i < subscribed_.size(); ++i)
+        {
+            const Subscription &subscription = subscriptions_[subscribed_[i]];
+            int index = subscription.moving_to >= 0 ? subscription.moving_to : subscription.connection;
+            if (index >= 0)
+            {
+                loads[index] += subscription.message_rate > 0.0 ? subscription.message_rate : average_rate;
+            }
+        }
+
+        int best = -1;
+        for (size_t i = 0; i < connections_.size(); ++i)
+        {
+            if (connections_[i]->streams + stream_count > config_.max_streams_per_connection)
+            {
+                continue;
+            }
+            if (best < 0 || loads[i] < loads[best])
+            {
+                best = static_cast<int>(i);
+            }
+        }
+        return best;
+    }
+
+    void MarketDataFetcher::onConnectionState(size_t index, size_t line, bool open)
+    {
+        std::lock_guard<std::mutex> lock(subscription_mutex_);
+        if (index >= connections_.size() || line >= connections_[index]->lines.size())
+        {
+            return; // 正在停止
+        }
+
+        // 连接断开后服务端的订阅随之失效，积压的增量变更不再有意义；
+        // 重新建立后按当前归属整体重新订阅。冗余线路各自重连，其他线路继续送达
+        StreamLine &connection = connections_[index]->lines[line];
+        connection.open = open;
+        connection.pending_subscribe.clear();
+        connection.pending_unsubscribe.clear();
+        if (!open)
+        {
+            spdlog::warn("Stream connection {} line {} closed", index, line);
+            return;
+        }
+
+        for (size_t i = 0; i < subscribed_.size(); ++i)
+        {
+            const Subscription &subscription = subscriptions_[subscribed_[i]];
+            if (subscription.connection == static_cast<int>(index) ||
+                subscription.moving_to == static_cast<int>(index))
+            {
+                appendStreamNames(subscribed_[i], subscription.streams, connection.pending_subscribe);
+            }
+        }
+        spdlog::info("Stream connection {} line {} open, subscribing {} streams", index, line,
+                     connection.pending_subscribe.size());
+        flushRequests(index, std::chrono::duration_cast<std::chrono::milliseconds>(
+                                 std::chrono::steady_clock::now().time_since_epoch())
+                                 .count());
+        data_cv.notify_one();
+    }
+
+    bool MarketDataFetcher::acceptMessage(symbol_t symbol, size_t index, size_t line, ArbitratedStream stream,
+                                          uint64_t first_id, uint64_t last_id)
+    {
+        if (symbol >= SymbolRegistry::kMaxSymbols)
+        {
+            return false;
+        }
+        std::atomic<uint32_t> &route = routes_[symbol];
+        const uint32_t self = static_cast<uint32_t>(index + 1);
+        uint32_t current = route.load(std::memory_order_acquire);
+        while ((current & 0xFFFF) != self)
+        {
+            if ((current >> 16) != self)
+            {
                 return false;
             }
-            
-            spdlog::info("WebSocket client initialized for symbol: {}", binance_symbol);
+            // 迁移目标连接的第一条消息：切换归属，旧连接此后的消息被丢弃
+            if (route.compare_exchange_weak(current, self, std::memory_order_acq_rel, std::memory_order_acquire))
+            {
+                break;
+            }
+        }
+        if (config_.redundancy > 1 && !arbitrate(symbol, line, stream, first_id, last_id))
+        {
+            return false;
+        }
+        message_counts_[symbol].fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    bool MarketDataFetcher::arbitrate(symbol_t symbol, size_t line, ArbitratedStream stream,
+                                      uint64_t first_id, uint64_t last_id)
+    {
+        if (last_id == 0)
+        {
             return true;
-        } catch (const std::exception& e) {
-            spdlog::error("Exception creating WebSocket client: {}", e.what());
-            websocket_client_.reset();
+        }
+        LineCounters &counters = line_counters_[line];
+        counters.messages.fetch_add(1, std::memory_order_relaxed);
+
+        // 部分深度快照按间隔采样推送，更新ID本来就不连续，只按大小去重
+        const bool sequential = stream != ARBITRATED_DEPTH;
+        const size_t slot = static_cast<size_t>(symbol) * ARBITRATED_STREAM_COUNT + stream;
+        uint64_t &line_last = line_ids_[line * SymbolRegistry::kMaxSymbols * ARBITRATED_STREAM_COUNT + slot];
+        if (sequential && line_last != 0 && first_id > line_last + 1)
+        {
+            counters.gaps.fetch_add(1, std::memory_order_relaxed);
+        }
+        if (last_id > line_last)
+        {
+            line_last = last_id;
+        }
+
+        // 其他线路已送达（或更新的消息已采用）
+        uint64_t &accepted = accepted_ids_[slot];
+        if (last_id <= accepted)
+        {
+            counters.duplicates.fetch_add(1, std::memory_order_relaxed);
             return false;
         }
+        if (sequential && accepted != 0 && first_id > accepted + 1)
+        {
+            // 所有线路都漏收，由下游按更新ID检查发现并重新同步
+            arbitrated_gaps_.fetch_add(1, std::memory_order_relaxed);
+        }
+        accepted = last_id;
+        counters.wins.fetch_add(1, std::memory_order_relaxed);
+        return true;
     }
-    
-    std::string MarketDataFetcher::symbolToBinanceSymbol(symbol_t symbol)
+
+    void MarketDataFetcher::addStreams(size_t index, symbol_t symbol, uint32_t streams)
+    {
+        StreamConnection &connection = *connections_[index];
+        std::vector<std::string> names;
+        appendStreamNames(symbol, streams, names);
+        for (size_t line = 0; line < connection.lines.size(); ++line)
+        {
+            StreamLine &stream_line = connection.lines[line];
+            for (size_t i = 0; i < names.size(); ++i)
+            {
+                // 尚未发出的退订直接撤销；连接未建立时等建立后整体订阅
+                std::vector<std::string>::iterator it = std::find(stream_line.pending_unsubscribe.begin(),
+                                                                  stream_line.pending_unsubscribe.end(), names[i]);
+                if (it != stream_line.pending_unsubscribe.end())
+                {
+                    stream_line.pending_unsubscribe.erase(it);
+                }
+                else if (stream_line.open)
+                {
+                    stream_line.pending_subscribe.push_back(names[i]);
+                }
+            }
+        }
+        connection.streams += static_cast<uint32_t>(names.size());
+    }
+
+    void MarketDataFetcher::removeStreams(size_t index, symbol_t symbol, uint32_t streams)
+    {
+        StreamConnection &connection = *connections_[index];
+        std::vector<std::string> names;
+        appendStreamNames(symbol, streams, names);
+        for (size_t line = 0; line < connection.lines.size(); ++line)
+        {
+            StreamLine &stream_line = connection.lines[line];
+            for (size_t i = 0; i < names.size(); ++i)
+            {
+                std::vector<std::string>::iterator it = std::find(stream_line.pending_subscribe.begin(),
+                                                                  stream_line.pending_subscribe.end(), names[i]);
+                if (it != stream_line.pending_subscribe.end())
+                {
+                    stream_line.pending_subscribe.erase(it);
+                }
+                else if (stream_line.open)
+                {
+                    stream_line.pending_unsubscribe.push_back(names[i]);
+                }
+            }
+        }
+        connection.streams -= std::min(connection.streams, static_cast<uint32_t>(names.size()));
+    }
+
+    void MarketDataFetcher::flushRequests(size_t index, uint64_t now_ms)
+    {
+        // 单条请求最多携带的流数量
+        static const size_t kMaxStreamsPerRequest = 200;
+
+        StreamConnection &stream_connection = *connections_[index];
+        for (size_t line = 0; line < stream_connection.lines.size(); ++line)
+        {
+            StreamLine &connection = stream_connection.lines[line];
+            if (!connection.open || now_ms - connection.last_request_ms < config_.request_interval_ms)
+            {
+                continue;
+            }
+
+            // 先订阅后退订：迁移时新连接先收到数据
+            const char *method = "SUBSCRIBE";
+            std::vector<std::string> *pending = &connection.pending_subscribe;
+            if (pending->empty())
+            {
+                method = "UNSUBSCRIBE";
+                pending = &connection.pending_unsubscribe;
+            }
+            if (pending->empty())
+            {
+                continue;
+            }
+
+            const size_t count = std::min(pending->size(), kMaxStreamsPerRequest);
+            const uint64_t id = next_request_id_.fetch_add(1);
+            std::string request = std::string("{\"method\":\"") + method + "\",\"params\":[";
+            for (size_t i = 0; i < count; ++i)
+            {
+                if (i > 0)
+                {
+                    request += ",";
+                }
+                request += "\"" + (*pending)[i] + "\"";
+            }
+            request += "],\"id\":" + std::to_string(id) + "}";
+            pending->erase(pending->begin(), pending->begin() + count);
+
+            connection.last_request_ms = now_ms;
+            connection.client->send(request);
+            spdlog::debug("Stream connection {} line {} request {}: {} {} streams", index, line, id, method, count);
+        }
+    }
+
+    void MarketDataFetcher::updateRates(uint64_t now_ms)
+    {
+        if (last_rebalance_ms_ == 0 || now_ms <= last_rebalance_ms_)
+        {
+            for (size_t i = 0; i < subscribed_.size(); ++i)
+            {
+                subscriptions_[subscribed_[i]].last_message_count =
+                    message_counts_[subscribed_[i]].load(std::memory_order_relaxed);
+            }
+            return;
+        }
+
+        const double seconds = (now_ms - last_rebalance_ms_) / 1000.0;
+        for (size_t i = 0; i < subscribed_.size(); ++i)
+        {
+            Subscription &subscription = subscriptions_[subscribed_[i]];
+            uint64_t count = message_counts_[subscribed_[i]].load(std::memory_order_relaxed);
+            double rate = (count - subscription.last_message_count) / seconds;
+            subscription.last_message_count = count;
+            subscription.message_rate = subscription.message_rate > 0.0
+                                            ? 0.5 * subscription.message_rate + 0.5 * rate
+                                            : rate;
+        }
+    }
+
+    void MarketDataFetcher::finishMoves(uint64_t now_ms)
+    {
+        for (size_t i = 0; i < subscribed_.size(); ++i)
+        {
+            symbol_t symbol = subscribed_[i];
+            Subscription &subscription = subscriptions_[symbol];
+            if (subscription.moving_to < 0)
+            {
+                continue;
+            }
+
+            // 新连接已收到消息，或等待超时（交易对不活跃）时强制切换
+            const uint32_t target = static_cast<uint32_t>(subscription.moving_to + 1);
+            if ((routes_[symbol].load(std::memory_order_acquire) & 0xFFFF) != target)
+            {
+                if (now_ms - subscription.move_started_ms < config_.rebalance_interval_ms)
+                {
+                    continue;
+                }
+                routes_[symbol].store(target, std::memory_order_release);
+            }
+
+            removeStreams(subscription.connection, symbol, subscription.streams);
+            spdlog::debug("Moved {} from connection {} to {}", symbolToBinanceSymbol(symbol),
+                          subscription.connection, subscription.moving_to);
+            subscription.connection = subscription.moving_to;
+            subscription.moving_to = -1;
+        }
+    }
+
+    void MarketDataFetcher::rebalance(uint64_t now_ms)
     {
-        switch (symbol) {
-            case SYMBOL_BTC_USDT:
-                return "BTCUSDT";
-            case SYMBOL_ETH_USDT:
-                return "ETHUSDT";
-            case SYMBOL_BTC_ETH:
-                return "BTCETH";
-            default:
-                return "BTCUSDT";
+        if (connections_.size() < 2)
+        {
+            return;
+        }
+
+        std::vector<double> loads(connections_.size(), 0.0);
+        for (size_t i = 0; i < subscribed_.size(); ++i)
+        {
+            const Subscription &subscription = subscriptions_[subscribed_[i]];
+            int index = subscription.moving_to >= 0 ? subscription.moving_to : subscription.connection;
+            if (index >= 0)
+            {
+                loads[index] += subscription.message_rate;
+            }
+        }
+
+        // 只在已连接的连接之间迁移
+        int busiest = -1;
+        int idlest = -1;
+        for (size_t i = 0; i < connections_.size(); ++i)
+        {
+            if (!connections_[i]->isOpen())
+            {
+                continue;
+            }
+            if (busiest < 0 || loads[i] > loads[busiest])
+            {
+                busiest = static_cast<int>(i);
+            }
+            if (idlest < 0 || loads[i] < loads[idlest])
+            {
+                idlest = static_cast<int>(i);
+            }
+        }
+        if (busiest < 0 || busiest == idlest)
+        {
+            return;
+        }
+        const double gap = loads[busiest] - loads[idlest];
+        if (loads[busiest] <= 0.0 || gap <= config_.rebalance_threshold * loads[busiest])
+        {
+            return;
+        }
+
+        // 迁移后差距缩小的条件是 0 < rate < gap，选最接近 gap/2 的交易对
+        int chosen = -1;
+        double best_distance = 0.0;
+        for (size_t i = 0; i < subscribed_.size(); ++i)
+        {
+            const Subscription &subscription = subscriptions_[subscribed_[i]];
+            if (subscription.connection != busiest || subscription.moving_to >= 0 ||
+                subscription.message_rate <= 0.0 || subscription.message_rate >= gap)
+            {
+                continue;
+            }
+            std::vector<std::string> names;
+            appendStreamNames(subscribed_[i], subscription.streams, names);
+            if (connections_[idlest]->streams + names.size() > config_.max_streams_per_connection)
+            {
+                continue;
+            }
+            double distance = std::abs(subscription.message_rate - gap / 2.0);
+            if (chosen < 0 || distance < best_distance)
+            {
+                chosen = static_cast<int>(i);
+                best_distance = distance;
+            }
         }
+        if (chosen < 0)
+        {
+            return;
+        }
+
+        symbol_t symbol = subscribed_[chosen];
+        Subscription &subscription = subscriptions_[symbol];
+        subscription.moving_to = idlest;
+        subscription.move_started_ms = now_ms;
+        addStreams(idlest, symbol, subscription.streams);
+        routes_[symbol].store(static_cast<uint32_t>(busiest + 1) | (static_cast<uint32_t>(idlest + 1) << 16),
+                              std::memory_order_release);
+        spdlog::info("Rebalancing {} ({:.1f} msg/s) from connection {} ({:.1f} msg/s) to {} ({:.1f} msg/s)",
+                     symbolToBinanceSymbol(symbol), subscription.message_rate, busiest, loads[busiest],
+                     idlest, loads[idlest]);
+    }
+
+    void MarketDataFetcher::appendStreamNames(symbol_t symbol, uint32_t streams, std::vector<std::string> &names)
+    {
+        const std::string base = SymbolRegistry::instance().streamName(symbol);
+        if (streams & MARKET_STREAM_DEPTH)
+        {
+            names.push_back(base + "@depth20@100ms");
+        }
+        if (streams & MARKET_STREAM_DEPTH_DIFF)
+        {
+            names.push_back(base + "@depth@100ms");
+        }
+        if (streams & MARKET_STREAM_TRADE)
+        {
+            names.push_back(base + "@trade");
+        }
+        if (streams & MARKET_STREAM_AGG_TRADE)
+        {
+            names.push_back(base + "@aggTrade");
+        }
+    }
+
+    uint32_t MarketDataFetcher::defaultStreams() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        uint32_t streams = depth_diff_callback ? MARKET_STREAM_DEPTH_DIFF : MARKET_STREAM_DEPTH;
+        if (trade_callback)
+        {
+            streams |= MARKET_STREAM_AGG_TRADE;
+        }
+        return streams;
+    }
+
+    std::string MarketDataFetcher::symbolToBinanceSymbol(symbol_t symbol)
+    {
+        return SymbolRegistry::instance().name(symbol);
     }
 
 } // namespace crypto_quant
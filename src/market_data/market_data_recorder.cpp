@@ -0,0 +1,904 @@
+#include "market_data_recorder.h"
+#include "symbol_registry.h"
+#include "utils/network_utils.h"
+#include <spdlog/spdlog.h>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+
+namespace crypto_quant {
+
+namespace {
+
+const char kSegmentMagic[8] = {'C', 'Q', 'M', 'D', 'R', 'E', 'C', '\0'};
+const uint32_t kSegmentVersion = 1;
+const char* const kSegmentSuffix = ".cqmd";
+const size_t kPageSize = 4096;
+
+inline size_t align8(size_t value) {
+    return (value + 7) & ~static_cast<size_t>(7);
+}
+
+inline size_t headerSize(uint32_t index_capacity) {
+    size_t size = sizeof(recording_segment_header_net_t) +
+                  static_cast<size_t>(index_capacity) * sizeof(recording_index_entry_net_t);
+    return (size + kPageSize - 1) & ~(kPageSize - 1);
+}
+
+// 段头中会被并发读取的字段：8字节对齐，按原子方式读写，写入方以 release 发布
+inline uint64_t* headerField64(char* base, size_t offset) {
+    return reinterpret_cast<uint64_t*>(base + offset);
+}
+
+inline void publish64(char* base, size_t offset, uint64_t value) {
+    __atomic_store_n(headerField64(base, offset), hton64(value), __ATOMIC_RELEASE);
+}
+
+inline uint64_t load64(const char* base, size_t offset) {
+    return ntoh64(__atomic_load_n(reinterpret_cast<const uint64_t*>(base + offset), __ATOMIC_ACQUIRE));
+}
+
+inline recording_segment_header_net_t* segmentHeader(char* base) {
+    return reinterpret_cast<recording_segment_header_net_t*>(base);
+}
+
+inline const recording_segment_header_net_t* segmentHeader(const char* base) {
+    return reinterpret_cast<const recording_segment_header_net_t*>(base);
+}
+
+inline void levelToNet(const price_level_t& level, price_level_net_t* out) {
+    out->price = hton_double(level.price);
+    out->quantity = hton_double(level.quantity);
+    out->timestamp = hton64(level.timestamp);
+}
+
+inline void levelFromNet(const price_level_net_t* in, price_level_t& level) {
+    level.price = ntoh_double(in->price);
+    level.quantity = ntoh_double(in->quantity);
+    level.timestamp = ntoh64(in->timestamp);
+}
+
+} // namespace
+
+// ---------------------------------------------------------------------------
+// MarketDataRecorder
+// ---------------------------------------------------------------------------
+
+MarketDataRecorder::MarketDataRecorder(const MarketDataRecorderConfig& config)
+    : config_(config), header_size_(headerSize(config.index_capacity)), session_ms_(0), open_(false),
+      pending_offset_(0), pending_length_(0), spare_requested_(false), spare_failed_(false),
+      next_sequence_(0), stopping_(false), records_(0), bytes_(0), segments_(0),
+      rotation_stalls_(0), dropped_(0) {
+    if (config_.index_interval == 0) {
+        config_.index_interval = 1;
+    }
+}
+
+MarketDataRecorder::~MarketDataRecorder() {
+    close();
+}
+
+uint64_t MarketDataRecorder::nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()
+    ).count();
+}
+
+bool MarketDataRecorder::open() {
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    if (open_.load()) {
+        spdlog::warn("Market data recorder already open");
+        return true;
+    }
+    if (config_.segment_size < header_size_ + kPageSize) {
+        spdlog::error("Recorder segment size {} too small (header {} bytes)", config_.segment_size, header_size_);
+        return false;
+    }
+    if (::mkdir(config_.directory.c_str(), 0755) != 0 && errno != EEXIST) {
+        spdlog::error("Failed to create recording directory {}: {}", config_.directory, strerror(errno));
+        return false;
+    }
+
+    session_ms_ = nowNs() / 1000000;
+    Segment* first = createSegment(0);
+    if (!first) {
+        return false;
+    }
+    current_.reset(first);
+    {
+        std::lock_guard<std::mutex> prepare_lock(prepare_mutex_);
+        next_sequence_ = 1;
+        stopping_ = false;
+        spare_requested_ = true;
+        spare_failed_ = false;
+    }
+    prepare_thread_ = std::thread(&MarketDataRecorder::prepareLoop, this);
+    open_.store(true, std::memory_order_release);
+    spdlog::info("Market data recorder writing to {} (segment {} MB)", current_->path,
+                 config_.segment_size / (1024 * 1024));
+    return true;
+}
+
+void MarketDataRecorder::close() {
+    {
+        std::lock_guard<std::mutex> lock(write_mutex_);
+        if (!open_.exchange(false)) {
+            return;
+        }
+        std::lock_guard<std::mutex> prepare_lock(prepare_mutex_);
+        if (current_) {
+            retired_.push_back(std::move(current_));
+        }
+        stopping_ = true;
+        prepare_cv_.notify_all();
+    }
+    // 后台线程退出前收尾所有写满/当前的段
+    if (prepare_thread_.joinable()) {
+        prepare_thread_.join();
+    }
+    if (spare_) {
+        discardSegment(spare_.release());
+    }
+
+    MarketDataRecorderStats stats = getStats();
+    spdlog::info("Market data recorder closed: records={}, bytes={}, segments={}, rotation_stalls={}, dropped={}",
+                 stats.records, stats.bytes, stats.segments, stats.rotation_stalls, stats.dropped);
+}
+
+bool MarketDataRecorder::recordRaw(const char* data, size_t size, uint64_t timestamp_ns) {
+    if (!config_.record_raw) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    char* payload = beginRecord(RecordType::RAW, SYMBOL_INVALID, size, timestamp_ns);
+    if (!payload) {
+        return false;
+    }
+    memcpy(payload, data, size);
+    commitRecord(timestamp_ns);
+    return true;
+}
+
+bool MarketDataRecorder::recordOrderbook(const orderbook_t& orderbook, uint64_t timestamp_ns) {
+    if (!config_.record_normalized) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    char* payload = beginRecord(RecordType::ORDERBOOK, orderbook.symbol,
+                                sizeof(recording_orderbook_net_t), timestamp_ns);
+    if (!payload) {
+        return false;
+    }
+    // 直接在映射内存上按网络字节序填写，未使用的档位填0
+    recording_orderbook_net_t* out = reinterpret_cast<recording_orderbook_net_t*>(payload);
+    uint32_t bid_count = std::min<uint32_t>(orderbook.bid_count, 20);
+    uint32_t ask_count = std::min<uint32_t>(orderbook.ask_count, 20);
+    out->orderbook.symbol = hton32(orderbook.symbol);
+    out->orderbook.bid_count = hton32(bid_count);
+    out->orderbook.ask_count = hton32(ask_count);
+    out->orderbook.timestamp = hton64(orderbook.timestamp);
+    for (uint32_t i = 0; i < bid_count; ++i) {
+        levelToNet(orderbook.bids[i], &out->orderbook.bids[i]);
+    }
+    memset(&out->orderbook.bids[bid_count], 0, (20 - bid_count) * sizeof(price_level_net_t));
+    for (uint32_t i = 0; i < ask_count; ++i) {
+        levelToNet(orderbook.asks[i], &out->orderbook.asks[i]);
+    }
+    memset(&out->orderbook.asks[ask_count], 0, (20 - ask_count) * sizeof(price_level_net_t));
+    out->last_update_id = hton64(orderbook.last_update_id);
+    commitRecord(timestamp_ns);
+    return true;
+}
+
+bool MarketDataRecorder::recordDepthDiff(const depth_diff_t& diff, uint64_t timestamp_ns) {
+    if (!config_.record_normalized) {
+        return false;
+    }
+    size_t level_count = static_cast<size_t>(diff.bid_count) + diff.ask_count;
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    char* payload = beginRecord(RecordType::DEPTH_DIFF, diff.symbol,
+                                sizeof(recording_depth_diff_net_t) + level_count * sizeof(price_level_net_t),
+                                timestamp_ns);
+    if (!payload) {
+        return false;
+    }
+    recording_depth_diff_net_t* out = reinterpret_cast<recording_depth_diff_net_t*>(payload);
+    out->symbol = hton32(diff.symbol);
+    out->bid_count = hton32(diff.bid_count);
+    out->ask_count = hton32(diff.ask_count);
+    out->reserved = 0;
+    out->event_time = hton64(diff.event_time);
+    out->first_update_id = hton64(diff.first_update_id);
+    out->final_update_id = hton64(diff.final_update_id);
+    price_level_net_t* levels = reinterpret_cast<price_level_net_t*>(out + 1);
+    for (uint32_t i = 0; i < diff.bid_count; ++i) {
+        levelToNet(diff.bids[i], &levels[i]);
+    }
+    levels += diff.bid_count;
+    for (uint32_t i = 0; i < diff.ask_count; ++i) {
+        levelToNet(diff.asks[i], &levels[i]);
+    }
+    commitRecord(timestamp_ns);
+    return true;
+}
+
+bool MarketDataRecorder::recordTrade(const trade_t& trade, uint64_t timestamp_ns) {
+    if (!config_.record_normalized) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    char* payload = beginRecord(RecordType::TRADE, trade.symbol, sizeof(trade_net_t), timestamp_ns);
+    if (!payload) {
+        return false;
+    }
+    trade_net_t* out = reinterpret_cast<trade_net_t*>(payload);
+    out->symbol = hton32(trade.symbol);
+    out->flags = hton32((trade.aggregated ? 1u : 0u) | (trade.is_buyer_maker ? 2u : 0u));
+    out->trade_id = hton64(trade.trade_id);
+    out->first_trade_id = hton64(trade.first_trade_id);
+    out->last_trade_id = hton64(trade.last_trade_id);
+    out->trade_time = hton64(trade.trade_time);
+    out->event_time = hton64(trade.event_time);
+    out->price = hton_double(trade.price);
+    out->quantity = hton_double(trade.quantity);
+    commitRecord(timestamp_ns);
+    return true;
+}
+
+bool MarketDataRecorder::recordSnapshot(const DepthSnapshot& snapshot, uint64_t timestamp_ns) {
+    if (!config_.record_normalized) {
+        return false;
+    }
+    size_t level_count = snapshot.bids.size() + snapshot.asks.size();
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    char* payload = beginRecord(RecordType::SNAPSHOT, snapshot.symbol,
+                                sizeof(recording_snapshot_net_t) + level_count * sizeof(price_level_net_t),
+                                timestamp_ns);
+    if (!payload) {
+        return false;
+    }
+    recording_snapshot_net_t* out = reinterpret_cast<recording_snapshot_net_t*>(payload);
+    out->symbol = hton32(snapshot.symbol);
+    out->bid_count = hton32(static_cast<uint32_t>(snapshot.bids.size()));
+    out->ask_count = hton32(static_cast<uint32_t>(snapshot.asks.size()));
+    out->reserved = 0;
+    out->last_update_id = hton64(snapshot.last_update_id);
+    price_level_net_t* levels = reinterpret_cast<price_level_net_t*>(out + 1);
+    for (size_t i = 0; i < snapshot.bids.size(); ++i) {
+        levelToNet(snapshot.bids[i], levels++);
+    }
+    for (size_t i = 0; i < snapshot.asks.size(); ++i) {
+        levelToNet(snapshot.asks[i], levels++);
+    }
+    commitRecord(timestamp_ns);
+    return true;
+}
+
+char* MarketDataRecorder::beginRecord(RecordType type, symbol_t symbol, size_t payload_size, uint64_t timestamp_ns) {
+    if (!open_.load(std::memory_order_relaxed)) {
+        return nullptr;
+    }
+    size_t length = align8(sizeof(recording_record_header_net_t) + payload_size);
+    size_t symbol_length = 0;
+    if (symbol != SYMBOL_INVALID && symbol < SymbolRegistry::kMaxSymbols) {
+        symbol_length = align8(sizeof(recording_record_header_net_t) + sizeof(recording_symbol_net_t) +
+                               strlen(SymbolRegistry::instance().name(symbol)));
+    }
+    // 单条记录（连同它的 SYMBOL 记录）必须能放进一个空段
+    if (length + symbol_length > config_.segment_size - header_size_ ||
+        length > UINT32_MAX) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        spdlog::warn("Recorder dropped {} byte record larger than a segment", length);
+        return nullptr;
+    }
+
+    bool need_symbol = symbol_length != 0 && (!current_ || !current_->symbols_written[symbol]);
+    size_t required = length + (need_symbol ? symbol_length : 0);
+    if (!current_ || current_->write_offset + required > current_->capacity) {
+        if (!rotate()) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        // 新段内交易对都还没有 SYMBOL 记录
+        need_symbol = symbol_length != 0;
+    }
+    if (need_symbol) {
+        writeSymbolRecord(symbol, timestamp_ns);
+    }
+    return writeRecordHeader(type, payload_size, timestamp_ns);
+}
+
+char* MarketDataRecorder::writeRecordHeader(RecordType type, size_t payload_size, uint64_t timestamp_ns) {
+    Segment* segment = current_.get();
+    recording_record_header_net_t* header =
+        reinterpret_cast<recording_record_header_net_t*>(segment->base + segment->write_offset);
+    size_t length = sizeof(recording_record_header_net_t) + payload_size;
+    header->length = hton32(static_cast<uint32_t>(length));
+    header->type = hton16(static_cast<uint16_t>(type));
+    header->reserved = 0;
+    header->timestamp = hton64(timestamp_ns);
+    pending_offset_ = segment->write_offset;
+    pending_length_ = align8(length);
+    return reinterpret_cast<char*>(header + 1);
+}
+
+void MarketDataRecorder::commitRecord(uint64_t timestamp_ns) {
+    publishRecord(timestamp_ns);
+    records_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void MarketDataRecorder::publishRecord(uint64_t timestamp_ns) {
+    Segment* segment = current_.get();
+    recording_segment_header_net_t* header = segmentHeader(segment->base);
+
+    // 每 index_interval 条记录写一个索引项（写在 data_end 发布之前）
+    if (segment->record_count % config_.index_interval == 0 && segment->index_count < config_.index_capacity) {
+        recording_index_entry_net_t* entry =
+            reinterpret_cast<recording_index_entry_net_t*>(header + 1) + segment->index_count;
+        entry->timestamp = hton64(timestamp_ns);
+        entry->offset = hton64(pending_offset_);
+        ++segment->index_count;
+        header->index_count = hton32(segment->index_count);
+    }
+    if (segment->record_count == 0) {
+        header->first_timestamp = hton64(timestamp_ns);
+    }
+    ++segment->record_count;
+    header->record_count = hton64(segment->record_count);
+    header->last_timestamp = hton64(timestamp_ns);
+
+    segment->write_offset = pending_offset_ + pending_length_;
+    publish64(segment->base, offsetof(recording_segment_header_net_t, data_end), segment->write_offset);
+    bytes_.fetch_add(pending_length_, std::memory_order_relaxed);
+}
+
+void MarketDataRecorder::writeSymbolRecord(symbol_t symbol, uint64_t timestamp_ns) {
+    Segment* segment = current_.get();
+    const char* name = SymbolRegistry::instance().name(symbol);
+    size_t name_length = strlen(name);
+
+    char* payload = writeRecordHeader(RecordType::SYMBOL, sizeof(recording_symbol_net_t) + name_length, timestamp_ns);
+    recording_symbol_net_t* out = reinterpret_cast<recording_symbol_net_t*>(payload);
+    out->symbol = hton32(symbol);
+    out->name_length = hton32(static_cast<uint32_t>(name_length));
+    out->previous = hton64(segment->last_symbol);
+    memcpy(out + 1, name, name_length);
+
+    // 链表头在记录写完之后发布，读取方沿链读到的 SYMBOL 记录总是完整的
+    segment->last_symbol = pending_offset_;
+    segment->symbols_written[symbol] = 1;
+    ++segment->symbol_count;
+    segmentHeader(segment->base)->symbol_count = hton32(segment->symbol_count);
+    publish64(segment->base, offsetof(recording_segment_header_net_t, last_symbol), segment->last_symbol);
+    // SYMBOL 记录不计入录制的消息数
+    publishRecord(timestamp_ns);
+}
+
+bool MarketDataRecorder::rotate() {
+    std::unique_lock<std::mutex> lock(prepare_mutex_);
+    if (current_) {
+        retired_.push_back(std::move(current_));
+        prepare_cv_.notify_all();
+    }
+    // 备用段还没准备好时等后台线程创建；上次创建失败（如磁盘满）时不等待，丢弃记录，由后台线程稍后重试
+    if (!spare_ && !spare_failed_) {
+        rotation_stalls_.fetch_add(1, std::memory_order_relaxed);
+        spare_requested_ = true;
+        prepare_cv_.notify_all();
+        prepare_cv_.wait(lock, [this]() { return spare_ || spare_failed_ || stopping_; });
+    }
+    if (!spare_) {
+        spare_requested_ = true;
+        prepare_cv_.notify_all();
+        return false;
+    }
+    current_ = std::move(spare_);
+    spare_requested_ = true;
+    prepare_cv_.notify_all();
+    return true;
+}
+
+MarketDataRecorder::Segment* MarketDataRecorder::createSegment(uint64_t sequence) {
+    char name[64];
+    snprintf(name, sizeof(name), "-%013llu-%06llu", static_cast<unsigned long long>(session_ms_),
+             static_cast<unsigned long long>(sequence));
+    std::string path = config_.directory + "/" + config_.prefix + name + kSegmentSuffix;
+
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        spdlog::error("Failed to create recording segment {}: {}", path, strerror(errno));
+        return nullptr;
+    }
+    // 预先分配磁盘块：空间不足在这里报错，而不是写映射时收到 SIGBUS
+    int rc = posix_fallocate(fd, 0, static_cast<off_t>(config_.segment_size));
+    if (rc != 0) {
+        spdlog::error("Failed to allocate {} bytes for {}: {}", config_.segment_size, path, strerror(rc));
+        ::close(fd);
+        ::unlink(path.c_str());
+        return nullptr;
+    }
+    void* base = mmap(nullptr, config_.segment_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED) {
+        spdlog::error("Failed to map recording segment {}: {}", path, strerror(errno));
+        ::close(fd);
+        ::unlink(path.c_str());
+        return nullptr;
+    }
+
+    // 首次写入每页都会缺页（分配页缓存并标记脏页），在后台线程上逐页写一次，把缺页挪出写入线程
+    volatile char* page = static_cast<char*>(base);
+    for (size_t offset = 0; offset < config_.segment_size; offset += kPageSize) {
+        page[offset] = 0;
+    }
+
+    std::unique_ptr<Segment> segment(new Segment());
+    segment->fd = fd;
+    segment->base = static_cast<char*>(base);
+    segment->capacity = config_.segment_size;
+    segment->write_offset = header_size_;
+    segment->sequence = sequence;
+    segment->record_count = 0;
+    segment->index_count = 0;
+    segment->symbol_count = 0;
+    segment->last_symbol = 0;
+    segment->path = path;
+    segment->symbols_written.assign(SymbolRegistry::kMaxSymbols, 0);
+
+    recording_segment_header_net_t* header = segmentHeader(segment->base);
+    memset(header, 0, sizeof(*header));
+    memcpy(header->magic, kSegmentMagic, sizeof(kSegmentMagic));
+    header->version = hton32(kSegmentVersion);
+    header->header_size = hton32(static_cast<uint32_t>(header_size_));
+    header->sequence = hton64(sequence);
+    header->capacity = hton64(segment->capacity);
+    header->index_interval = hton32(config_.index_interval);
+    header->index_capacity = hton32(config_.index_capacity);
+    publish64(segment->base, offsetof(recording_segment_header_net_t, data_end), header_size_);
+
+    segments_.fetch_add(1, std::memory_order_relaxed);
+    spdlog::debug("Recording segment {} created", path);
+    return segment.release();
+}
+
+void MarketDataRecorder::finalizeSegment(Segment* segment) {
+    std::unique_ptr<Segment> owner(segment);
+    size_t used = segment->write_offset;
+    // 脏页由内核回写，这里只发起异步回写，不等待落盘
+    msync(segment->base, used, MS_ASYNC);
+    munmap(segment->base, segment->capacity);
+    // 截掉预分配但未使用的部分
+    if (ftruncate(segment->fd, static_cast<off_t>(used)) != 0) {
+        spdlog::warn("Failed to truncate recording segment {}: {}", segment->path, strerror(errno));
+    }
+    ::close(segment->fd);
+    spdlog::info("Recording segment {} closed: {} records, {} bytes", segment->path, segment->record_count, used);
+}
+
+void MarketDataRecorder::discardSegment(Segment* segment) {
+    std::unique_ptr<Segment> owner(segment);
+    munmap(segment->base, segment->capacity);
+    ::close(segment->fd);
+    ::unlink(segment->path.c_str());
+    segments_.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void MarketDataRecorder::prepareLoop() {
+#ifdef __linux__
+    pthread_setname_np(pthread_self(), "md-recorder");
+#endif
+    std::unique_lock<std::mutex> lock(prepare_mutex_);
+    for (;;) {
+        prepare_cv_.wait(lock, [this]() {
+            return stopping_ || !retired_.empty() || (spare_requested_ && !spare_);
+        });
+
+        // 先准备备用段，写满的段晚一点收尾不影响写入
+        if (spare_requested_ && !spare_ && !stopping_) {
+            spare_requested_ = false;
+            spare_failed_ = false;
+            uint64_t sequence = next_sequence_++;
+            lock.unlock();
+            Segment* segment = createSegment(sequence);
+            lock.lock();
+            spare_.reset(segment);
+            spare_failed_ = segment == nullptr;
+            prepare_cv_.notify_all();
+            if (!segment) {
+                // 创建失败时稍后再试，期间写入方丢弃记录
+                prepare_cv_.wait_for(lock, std::chrono::seconds(1), [this]() { return stopping_; });
+            }
+            continue;
+        }
+
+        if (!retired_.empty()) {
+            std::vector<std::unique_ptr<Segment> > retired;
+            retired.swap(retired_);
+            lock.unlock();
+            for (size_t i = 0; i < retired.size(); ++i) {
+                finalizeSegment(retired[i].release());
+            }
+            lock.lock();
+            continue;
+        }
+
+        if (stopping_) {
+            break;
+        }
+    }
+}
+
+MarketDataRecorderStats MarketDataRecorder::getStats() const {
+    MarketDataRecorderStats stats;
+    stats.records = records_.load(std::memory_order_relaxed);
+    stats.bytes = bytes_.load(std::memory_order_relaxed);
+    stats.segments = segments_.load(std::memory_order_relaxed);
+    stats.rotation_stalls = rotation_stalls_.load(std::memory_order_relaxed);
+    stats.dropped = dropped_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+// ---------------------------------------------------------------------------
+// MarketDataRecordReader
+// ---------------------------------------------------------------------------
+
+MarketDataRecordReader::MarketDataRecordReader()
+    : fd_(-1), base_(nullptr), size_(0), header_size_(0), offset_(0), corrupted_(false) {
+}
+
+MarketDataRecordReader::~MarketDataRecordReader() {
+    close();
+}
+
+bool MarketDataRecordReader::open(const std::string& path) {
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        spdlog::error("Failed to open recording {}: {}", path, strerror(errno));
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(recording_segment_header_net_t)) {
+        spdlog::error("Recording {} is too small", path);
+        ::close(fd);
+        return false;
+    }
+    size_t size = static_cast<size_t>(st.st_size);
+    void* base = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED) {
+        spdlog::error("Failed to map recording {}: {}", path, strerror(errno));
+        ::close(fd);
+        return false;
+    }
+
+    const recording_segment_header_net_t* header = segmentHeader(static_cast<const char*>(base));
+    size_t header_size = ntoh32(header->header_size);
+    if (memcmp(header->magic, kSegmentMagic, sizeof(kSegmentMagic)) != 0 ||
+        ntoh32(header->version) != kSegmentVersion ||
+        header_size < sizeof(recording_segment_header_net_t) + ntoh32(header->index_capacity) * sizeof(recording_index_entry_net_t) ||
+        header_size > size) {
+        spdlog::error("{} is not a valid market data recording", path);
+        munmap(base, size);
+        ::close(fd);
+        return false;
+    }
+
+    fd_ = fd;
+    base_ = static_cast<const char*>(base);
+    size_ = size;
+    header_size_ = header_size;
+    offset_ = header_size;
+    corrupted_ = false;
+    path_ = path;
+    symbol_map_.assign(SymbolRegistry::kMaxSymbols, SYMBOL_INVALID);
+    loadSymbols();
+    return true;
+}
+
+void MarketDataRecordReader::close() {
+    if (base_) {
+        munmap(const_cast<char*>(base_), size_);
+        base_ = nullptr;
+    }
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+    size_ = 0;
+    offset_ = 0;
+}
+
+uint64_t MarketDataRecordReader::dataEnd() const {
+    uint64_t end = load64(base_, offsetof(recording_segment_header_net_t, data_end));
+    return std::min<uint64_t>(end, size_);
+}
+
+uint64_t MarketDataRecordReader::recordCount() const {
+    return base_ ? load64(base_, offsetof(recording_segment_header_net_t, record_count)) : 0;
+}
+
+uint64_t MarketDataRecordReader::firstTimestamp() const {
+    return base_ ? ntoh64(segmentHeader(base_)->first_timestamp) : 0;
+}
+
+uint64_t MarketDataRecordReader::lastTimestamp() const {
+    return base_ ? ntoh64(segmentHeader(base_)->last_timestamp) : 0;
+}
+
+bool MarketDataRecordReader::recordAt(size_t offset, size_t end, RecordType& type, uint64_t& timestamp,
+                                      size_t& length) const {
+    if (offset % 8 != 0 || offset + sizeof(recording_record_header_net_t) > end) {
+        return false;
+    }
+    const recording_record_header_net_t* header =
+        reinterpret_cast<const recording_record_header_net_t*>(base_ + offset);
+    length = ntoh32(header->length);
+    if (length < sizeof(recording_record_header_net_t) || offset + align8(length) > end) {
+        return false;
+    }
+    type = static_cast<RecordType>(ntoh16(header->type));
+    timestamp = ntoh64(header->timestamp);
+    return true;
+}
+
+uint64_t MarketDataRecordReader::readSymbol(const char* payload, size_t payload_size) {
+    if (payload_size < sizeof(recording_symbol_net_t)) {
+        return 0;
+    }
+    const recording_symbol_net_t* in = reinterpret_cast<const recording_symbol_net_t*>(payload);
+    uint32_t file_symbol = ntoh32(in->symbol);
+    uint32_t name_length = ntoh32(in->name_length);
+    if (file_symbol < symbol_map_.size() && name_length > 0 &&
+        name_length <= payload_size - sizeof(recording_symbol_net_t)) {
+        symbol_map_[file_symbol] =
+            SymbolRegistry::instance().registerSymbol(reinterpret_cast<const char*>(in + 1), name_length);
+    }
+    return ntoh64(in->previous);
+}
+
+void MarketDataRecordReader::loadSymbols() {
+    uint64_t offset = load64(base_, offsetof(recording_segment_header_net_t, last_symbol));
+    // 链表只向前指，最多走段内记录数那么多步
+    while (offset >= header_size_ && offset < size_) {
+        RecordType type;
+        uint64_t timestamp;
+        size_t length;
+        if (!recordAt(offset, size_, type, timestamp, length) || type != RecordType::SYMBOL) {
+            spdlog::warn("Broken symbol chain in {} at offset {}", path_, offset);
+            break;
+        }
+        uint64_t previous = readSymbol(base_ + offset + sizeof(recording_record_header_net_t),
+                                       length - sizeof(recording_record_header_net_t));
+        if (previous >= offset) {
+            break;
+        }
+        offset = previous;
+    }
+}
+
+symbol_t MarketDataRecordReader::mapSymbol(uint32_t file_symbol) const {
+    return file_symbol < symbol_map_.size() ? symbol_map_[file_symbol] : SYMBOL_INVALID;
+}
+
+bool MarketDataRecordReader::next(MarketDataRecord& record) {
+    if (!base_ || corrupted_) {
+        return false;
+    }
+    size_t end = dataEnd();
+    while (offset_ < end) {
+        RecordType type;
+        uint64_t timestamp;
+        size_t length;
+        if (!recordAt(offset_, end, type, timestamp, length)) {
+            corrupted_ = true;
+            spdlog::error("Corrupted record in {} at offset {}", path_, offset_);
+            return false;
+        }
+        const char* payload = base_ + offset_ + sizeof(recording_record_header_net_t);
+        size_t payload_size = length - sizeof(recording_record_header_net_t);
+        offset_ += align8(length);
+
+        record.type = type;
+        record.timestamp = timestamp;
+        switch (type) {
+        case RecordType::SYMBOL:
+            // 正在写入的段可能在打开之后才出现新的交易对
+            readSymbol(payload, payload_size);
+            continue;
+        case RecordType::RAW:
+            record.raw = payload;
+            record.raw_size = payload_size;
+            return true;
+        case RecordType::ORDERBOOK: {
+            if (payload_size < sizeof(recording_orderbook_net_t)) {
+                break;
+            }
+            const recording_orderbook_net_t* in = reinterpret_cast<const recording_orderbook_net_t*>(payload);
+            orderbook_t& orderbook = record.orderbook;
+            orderbook.symbol = mapSymbol(ntoh32(in->orderbook.symbol));
+            orderbook.bid_count = std::min<uint32_t>(ntoh32(in->orderbook.bid_count), 20);
+            orderbook.ask_count = std::min<uint32_t>(ntoh32(in->orderbook.ask_count), 20);
+            orderbook.timestamp = ntoh64(in->orderbook.timestamp);
+            orderbook.last_update_id = ntoh64(in->last_update_id);
+            for (uint32_t i = 0; i < 20; ++i) {
+                levelFromNet(&in->orderbook.bids[i], orderbook.bids[i]);
+                levelFromNet(&in->orderbook.asks[i], orderbook.asks[i]);
+            }
+            return true;
+        }
+        case RecordType::DEPTH_DIFF: {
+            if (payload_size < sizeof(recording_depth_diff_net_t)) {
+                break;
+            }
+            const recording_depth_diff_net_t* in = reinterpret_cast<const recording_depth_diff_net_t*>(payload);
+            uint32_t bid_count = ntoh32(in->bid_count);
+            uint32_t ask_count = ntoh32(in->ask_count);
+            size_t level_count = static_cast<size_t>(bid_count) + ask_count;
+            if (level_count > (payload_size - sizeof(recording_depth_diff_net_t)) / sizeof(price_level_net_t)) {
+                break;
+            }
+            if (levels_.size() < level_count) {
+                levels_.resize(level_count);
+            }
+            const price_level_net_t* levels = reinterpret_cast<const price_level_net_t*>(in + 1);
+            for (size_t i = 0; i < level_count; ++i) {
+                levelFromNet(&levels[i], levels_[i]);
+            }
+            depth_diff_t& diff = record.diff;
+            diff.symbol = mapSymbol(ntoh32(in->symbol));
+            diff.first_update_id = ntoh64(in->first_update_id);
+            diff.final_update_id = ntoh64(in->final_update_id);
+            diff.event_time = ntoh64(in->event_time);
+            diff.bids = levels_.data();
+            diff.bid_count = bid_count;
+            diff.asks = levels_.data() + bid_count;
+            diff.ask_count = ask_count;
+            return true;
+        }
+        case RecordType::TRADE: {
+            if (payload_size < sizeof(trade_net_t)) {
+                break;
+            }
+            const trade_net_t* in = reinterpret_cast<const trade_net_t*>(payload);
+            trade_t& trade = record.trade;
+            uint32_t flags = ntoh32(in->flags);
+            trade.symbol = mapSymbol(ntoh32(in->symbol));
+            trade.aggregated = flags & 1u;
+            trade.trade_id = ntoh64(in->trade_id);
+            trade.first_trade_id = ntoh64(in->first_trade_id);
+            trade.last_trade_id = ntoh64(in->last_trade_id);
+            trade.trade_time = ntoh64(in->trade_time);
+            trade.event_time = ntoh64(in->event_time);
+            trade.price = ntoh_double(in->price);
+            trade.quantity = ntoh_double(in->quantity);
+            trade.is_buyer_maker = (flags >> 1) & 1u;
+            trade.reserved = 0;
+            return true;
+        }
+        case RecordType::SNAPSHOT: {
+            if (payload_size < sizeof(recording_snapshot_net_t)) {
+                break;
+            }
+            const recording_snapshot_net_t* in = reinterpret_cast<const recording_snapshot_net_t*>(payload);
+            uint32_t bid_count = ntoh32(in->bid_count);
+            uint32_t ask_count = ntoh32(in->ask_count);
+            size_t level_count = static_cast<size_t>(bid_count) + ask_count;
+            if (level_count > (payload_size - sizeof(recording_snapshot_net_t)) / sizeof(price_level_net_t)) {
+                break;
+            }
+            const price_level_net_t* levels = reinterpret_cast<const price_level_net_t*>(in + 1);
+            DepthSnapshot& snapshot = record.snapshot;
+            snapshot.symbol = mapSymbol(ntoh32(in->symbol));
+            snapshot.last_update_id = ntoh64(in->last_update_id);
+            snapshot.bids.resize(bid_count);
+            snapshot.asks.resize(ask_count);
+            for (uint32_t i = 0; i < bid_count; ++i) {
+                levelFromNet(levels++, snapshot.bids[i]);
+            }
+            for (uint32_t i = 0; i < ask_count; ++i) {
+                levelFromNet(levels++, snapshot.asks[i]);
+            }
+            return true;
+        }
+        default:
+            // 新版本增加的记录类型，跳过
+            continue;
+        }
+        spdlog::warn("Truncated {} record in {}", static_cast<int>(type), path_);
+    }
+    return false;
+}
+
+bool MarketDataRecordReader::seek(uint64_t timestamp_ns) {
+    if (!base_) {
+        return false;
+    }
+    corrupted_ = false;
+    size_t end = dataEnd();
+
+    // 二分查找最后一个时间戳小于目标的索引项（录制时间戳按写入顺序不减）
+    const recording_segment_header_net_t* header = segmentHeader(base_);
+    const recording_index_entry_net_t* index = reinterpret_cast<const recording_index_entry_net_t*>(header + 1);
+    size_t low = 0;
+    size_t high = std::min<size_t>(ntoh32(header->index_count), ntoh32(header->index_capacity));
+    while (low < high) {
+        size_t mid = (low + high) / 2;
+        if (ntoh64(index[mid].timestamp) < timestamp_ns) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    size_t offset = header_size_;
+    if (low > 0) {
+        uint64_t indexed = ntoh64(index[low - 1].offset);
+        if (indexed >= header_size_ && indexed < end) {
+            offset = indexed;
+        }
+    }
+
+    // 从索引项顺序找到第一条不早于目标的记录（交易对已在打开时沿 SYMBOL 链登记）
+    while (offset < end) {
+        RecordType type;
+        uint64_t timestamp;
+        size_t length;
+        if (!recordAt(offset, end, type, timestamp, length)) {
+            corrupted_ = true;
+            spdlog::error("Corrupted record in {} at offset {}", path_, offset);
+            return false;
+        }
+        if (type != RecordType::SYMBOL && timestamp >= timestamp_ns) {
+            break;
+        }
+        offset += align8(length);
+    }
+    offset_ = offset;
+    return offset < end;
+}
+
+bool MarketDataRecordReader::setPosition(uint64_t position) {
+    if (!base_ || position < header_size_ || position > dataEnd() || position % 8 != 0) {
+        return false;
+    }
+    offset_ = position;
+    corrupted_ = false;
+    return true;
+}
+
+void MarketDataRecordReader::rewind() {
+    offset_ = header_size_;
+    corrupted_ = false;
+}
+
+std::vector<std::string> MarketDataRecordReader::listSegments(const std::string& directory, const std::string& prefix) {
+    std::vector<std::string> segments;
+    DIR* dir = opendir(directory.c_str());
+    if (!dir) {
+        spdlog::error("Failed to open recording directory {}: {}", directory, strerror(errno));
+        return segments;
+    }
+    std::string head = prefix + "-";
+    size_t suffix_length = strlen(kSegmentSuffix);
+    while (struct dirent* entry = readdir(dir)) {
+        std::string name(entry->d_name);
+        if (name.size() > head.size() + suffix_length &&
+            name.compare(0, head.size(), head) == 0 &&
+            name.compare(name.size() - suffix_length, suffix_length, kSegmentSuffix) == 0) {
+            segments.push_back(directory + "/" + name);
+        }
+    }
+    closedir(dir);
+    // 文件名中的录制开始时间和段序号是定宽数字，按名称排序即录制顺序
+    std::sort(segments.begin(), segments.end());
+    return segments;
+}
+
+} // namespace crypto_quant
@@ -0,0 +1,461 @@
+#include "replay_market_data_fetcher.h"
+#include "symbol_registry.h"
+#include <spdlog/spdlog.h>
+#include <pthread.h>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace crypto_quant {
+
+namespace {
+
+inline uint64_t steadyNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()
+    ).count();
+}
+
+const uint32_t kAllStreams = MARKET_STREAM_DEPTH | MARKET_STREAM_DEPTH_DIFF | MARKET_STREAM_TRADE | MARKET_STREAM_AGG_TRADE;
+
+} // namespace
+
+ReplayMarketDataFetcher::ReplayMarketDataFetcher(const ReplayConfig& config)
+    : config_(config), running_(false), finished_(false),
+      subscriptions_(new std::atomic<uint32_t>[SymbolRegistry::kMaxSymbols]),
+      clock_ns_(0), mode_(config.mode), speed_(config.speed > 0 ? config.speed : 1.0), rebase_(false),
+      active_mode_(config.mode), active_speed_(speed_), sim_base_ns_(0), wall_base_ns_(0),
+      records_(0), orderbooks_delivered_(0), diffs_delivered_(0), trades_delivered_(0), skipped_(0), snapshots_(0),
+      max_lag_ns_(0), first_timestamp_ns_(0), wall_start_ns_(0), wall_end_ns_(0) {
+    for (size_t i = 0; i < SymbolRegistry::kMaxSymbols; ++i) {
+        subscriptions_[i].store(0, std::memory_order_relaxed);
+    }
+    orderbook_t empty;
+    memset(&empty, 0, sizeof(empty));
+    orderbooks_.assign(SymbolRegistry::kMaxSymbols, empty);
+    SnapshotCursor cursor = {0, 0};
+    snapshot_cursors_.assign(SymbolRegistry::kMaxSymbols, cursor);
+}
+
+ReplayMarketDataFetcher::~ReplayMarketDataFetcher() {
+    stop();
+}
+
+bool ReplayMarketDataFetcher::initialize() {
+    files_ = config_.files.empty()
+        ? MarketDataRecordReader::listSegments(config_.directory, config_.prefix)
+        : config_.files;
+    if (files_.empty()) {
+        spdlog::error("No recordings to replay in {} with prefix {}", config_.directory, config_.prefix);
+        return false;
+    }
+    const char* mode = config_.mode == ReplaySpeedMode::REALTIME ? "realtime" :
+                       config_.mode == ReplaySpeedMode::SCALED ? "scaled" : "as_fast_as_possible";
+    spdlog::info("ReplayMarketDataFetcher initialized: {} segments, mode={}, speed={}, parse_raw={}",
+                 files_.size(), mode, speed_, config_.parse_raw);
+    return true;
+}
+
+int ReplayMarketDataFetcher::start(symbol_t symbol) {
+    if (running_.load()) {
+        return subscribe(symbol, 0);
+    }
+    if (files_.empty() && !initialize()) {
+        return -1;
+    }
+    if (subscribe(symbol, 0) != 0) {
+        return -1;
+    }
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        active_orderbook_callback_ = orderbook_callback_;
+        active_diff_callback_ = diff_callback_;
+        active_trade_callback_ = trade_callback_;
+        active_mode_ = mode_;
+        active_speed_ = speed_;
+    }
+    clock_ns_.store(0);
+    first_timestamp_ns_.store(0);
+    finished_.store(false);
+    running_.store(true);
+    thread_ = std::thread(&ReplayMarketDataFetcher::run, this);
+    spdlog::info("Replay started for symbol: {}", SymbolRegistry::instance().name(symbol));
+    return 0;
+}
+
+void ReplayMarketDataFetcher::stop() {
+    if (!running_.exchange(false)) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        cv_.notify_all();
+    }
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    ReplayStats stats = getStats();
+    spdlog::info("Replay stopped: records={}, orderbooks={}, depth_diffs={}, trades={}, skipped={}, max_lag={}us",
+                 stats.records, stats.orderbooks, stats.depth_diffs, stats.trades, stats.skipped,
+                 stats.max_lag_ns / 1000);
+}
+
+void ReplayMarketDataFetcher::setApiKey(const std::string& /*api_key*/, const std::string& /*api_secret*/) {
+}
+
+void ReplayMarketDataFetcher::setDataSources(bool /*use_binance*/, bool /*use_coingecko*/) {
+}
+
+void ReplayMarketDataFetcher::setOrderbookCallback(std::function<void(const orderbook_t&)> callback) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    orderbook_callback_ = callback;
+}
+
+void ReplayMarketDataFetcher::setDepthDiffCallback(std::function<void(const depth_diff_t&)> callback) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    diff_callback_ = callback;
+}
+
+void ReplayMarketDataFetcher::setTradeCallback(std::function<void(const trade_t&)> callback) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    trade_callback_ = callback;
+}
+
+void ReplayMarketDataFetcher::setRecorder(std::shared_ptr<MarketDataRecorder> recorder) {
+    if (running_.load()) {
+        spdlog::warn("Replay recorder must be set before start");
+        return;
+    }
+    recorder_ = recorder;
+}
+
+int ReplayMarketDataFetcher::subscribe(symbol_t symbol, uint32_t streams) {
+    if (!SymbolRegistry::instance().contains(symbol)) {
+        spdlog::error("Invalid symbol index: {}", symbol);
+        return -1;
+    }
+    subscriptions_[symbol].store(streams != 0 ? streams : kAllStreams, std::memory_order_relaxed);
+    return 0;
+}
+
+int ReplayMarketDataFetcher::unsubscribe(symbol_t symbol) {
+    if (symbol >= SymbolRegistry::kMaxSymbols || subscriptions_[symbol].exchange(0) == 0) {
+        return -1;
+    }
+    return 0;
+}
+
+void ReplayMarketDataFetcher::setSpeed(ReplaySpeedMode mode, double speed) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    mode_ = mode;
+    speed_ = speed > 0 ? speed : 1.0;
+    rebase_.store(true, std::memory_order_release);
+    cv_.notify_all();
+}
+
+bool ReplayMarketDataFetcher::wants(symbol_t symbol, uint32_t stream) const {
+    return symbol < SymbolRegistry::kMaxSymbols &&
+           (subscriptions_[symbol].load(std::memory_order_relaxed) & stream) != 0;
+}
+
+orderbook_t ReplayMarketDataFetcher::getOrderbook(symbol_t symbol) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (symbol < orderbooks_.size()) {
+        return orderbooks_[symbol];
+    }
+    orderbook_t orderbook;
+    memset(&orderbook, 0, sizeof(orderbook));
+    orderbook.symbol = symbol;
+    return orderbook;
+}
+
+bool ReplayMarketDataFetcher::openFile(MarketDataRecordReader& reader, size_t index) const {
+    if (!reader.open(files_[index])) {
+        return false;
+    }
+    if (config_.start_time_ns == 0) {
+        return true;
+    }
+    // 整段早于回放起点时跳过
+    return reader.seek(config_.start_time_ns);
+}
+
+bool ReplayMarketDataFetcher::fetchDepthSnapshot(symbol_t symbol, int limit, DepthSnapshot& snapshot) {
+    if (symbol >= snapshot_cursors_.size()) {
+        spdlog::error("Invalid symbol index: {}", symbol);
+        return false;
+    }
+    // 录制时每次请求都录下一份快照，按顺序交还即重现实盘时的同步过程
+    std::lock_guard<std::mutex> lock(snapshot_mutex_);
+    SnapshotCursor& cursor = snapshot_cursors_[symbol];
+    MarketDataRecordReader reader;
+    MarketDataRecord record;
+    for (size_t i = cursor.file; i < files_.size(); ++i) {
+        bool opened = (i == cursor.file && cursor.position != 0)
+            ? reader.open(files_[i]) && reader.setPosition(cursor.position)
+            : openFile(reader, i);
+        if (!opened) {
+            continue;
+        }
+        while (reader.next(record)) {
+            if (config_.end_time_ns != 0 && record.timestamp > config_.end_time_ns) {
+                break;
+            }
+            if (record.type != RecordType::SNAPSHOT || record.snapshot.symbol != symbol) {
+                continue;
+            }
+            cursor.file = i;
+            cursor.position = reader.position();
+            snapshot = record.snapshot;
+            size_t max_levels = static_cast<size_t>(std::max(1, limit));
+            if (snapshot.bids.size() > max_levels) {
+                snapshot.bids.resize(max_levels);
+            }
+            if (snapshot.asks.size() > max_levels) {
+                snapshot.asks.resize(max_levels);
+            }
+            snapshot.limit = static_cast<uint32_t>(max_levels);
+            snapshots_.fetch_add(1, std::memory_order_relaxed);
+            spdlog::info("Replayed depth snapshot: symbol={}, last_update_id={}",
+                         SymbolRegistry::instance().name(symbol), snapshot.last_update_id);
+            return true;
+        }
+    }
+    spdlog::warn("No recorded depth snapshot left for {}", SymbolRegistry::instance().name(symbol));
+    return false;
+}
+
+bool ReplayMarketDataFetcher::waitUntilFinished(uint64_t timeout_ms) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return cv_.wait_for(lock, std::chrono::milliseconds(timeout_ms), [this]() {
+        return finished_.load();
+    });
+}
+
+void ReplayMarketDataFetcher::run() {
+#ifdef __linux__
+    pthread_setname_np(pthread_self(), "md-replay");
+#endif
+    wall_start_ns_.store(steadyNs());
+    sim_base_ns_ = 0;
+    MarketDataRecordReader reader;
+    MarketDataRecord record;
+    bool done = false;
+    for (size_t i = 0; i < files_.size() && !done && running_.load(); ++i) {
+        if (!openFile(reader, i)) {
+            continue;
+        }
+        while (running_.load(std::memory_order_relaxed) && reader.next(record)) {
+            if (config_.end_time_ns != 0 && record.timestamp > config_.end_time_ns) {
+                done = true;
+                break;
+            }
+            // 快照不推送，由 fetchDepthSnapshot 按需交还
+            if (record.type == RecordType::SNAPSHOT) {
+                continue;
+            }
+            records_.fetch_add(1, std::memory_order_relaxed);
+            if (!pace(record.timestamp)) {
+                break;
+            }
+            if (first_timestamp_ns_.load(std::memory_order_relaxed) == 0) {
+                first_timestamp_ns_.store(record.timestamp, std::memory_order_relaxed);
+            }
+            clock_ns_.store(record.timestamp, std::memory_order_release);
+            deliver(record);
+        }
+        if (reader.corrupted()) {
+            spdlog::warn("Replay skipped the rest of corrupted segment {}", files_[i]);
+        }
+    }
+    reader.close();
+
+    wall_end_ns_.store(steadyNs());
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        finished_.store(true, std::memory_order_release);
+        cv_.notify_all();
+    }
+    ReplayStats stats = getStats();
+    spdlog::info("Replay finished: {} records in {} ms ({}x)", stats.records, stats.wall_time_ns / 1000000,
+                 stats.wall_time_ns ? static_cast<double>(stats.replay_time_ns) / stats.wall_time_ns : 0.0);
+}
+
+bool ReplayMarketDataFetcher::pace(uint64_t timestamp_ns) {
+    // 第一条记录或速度变化后，以当前模拟时间和墙钟为新的计时基准
+    if (sim_base_ns_ == 0 || rebase_.exchange(false, std::memory_order_acq_rel)) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        active_mode_ = mode_;
+        active_speed_ = speed_;
+        uint64_t clock = clock_ns_.load(std::memory_order_relaxed);
+        sim_base_ns_ = clock != 0 ? clock : timestamp_ns;
+        wall_base_ns_ = steadyNs();
+    }
+    if (active_mode_ == ReplaySpeedMode::AS_FAST_AS_POSSIBLE) {
+        return running_.load(std::memory_order_relaxed);
+    }
+    // 录制时间戳可能因系统时钟调整而回退，此时立即推送
+    if (timestamp_ns <= sim_base_ns_) {
+        return running_.load(std::memory_order_relaxed);
+    }
+
+    double speed = active_mode_ == ReplaySpeedMode::REALTIME ? 1.0 : active_speed_;
+    uint64_t target = wall_base_ns_ + static_cast<uint64_t>((timestamp_ns - sim_base_ns_) / speed);
+    uint64_t now = steadyNs();
+    if (now >= target) {
+        uint64_t lag = now - target;
+        if (lag > max_lag_ns_.load(std::memory_order_relaxed)) {
+            max_lag_ns_.store(lag, std::memory_order_relaxed);
+        }
+        return running_.load(std::memory_order_relaxed);
+    }
+
+    // 远的用条件变量等（可被 stop / setSpeed 打断），最后约0.2毫秒让出CPU轮询，保证推送时刻的精度
+    while (now < target) {
+        uint64_t remaining = target - now;
+        if (remaining > 200000) {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait_for(lock, std::chrono::nanoseconds(remaining - 200000), [this]() {
+                return !running_.load() || rebase_.load();
+            });
+        } else {
+            std::this_thread::yield();
+        }
+        if (!running_.load(std::memory_order_relaxed)) {
+            return false;
+        }
+        if (rebase_.load(std::memory_order_acquire)) {
+            return pace(timestamp_ns);
+        }
+        now = steadyNs();
+    }
+    return true;
+}
+
+void ReplayMarketDataFetcher::deliver(const MarketDataRecord& record) {
+    switch (record.type) {
+    case RecordType::ORDERBOOK:
+        if (!config_.parse_raw) {
+            deliverOrderbook(record.orderbook, record.timestamp);
+            return;
+        }
+        break;
+    case RecordType::DEPTH_DIFF:
+        if (!config_.parse_raw) {
+            deliverDepthDiff(record.diff, record.timestamp);
+            return;
+        }
+        break;
+    case RecordType::TRADE:
+        if (!config_.parse_raw) {
+            deliverTrade(record.trade, record.timestamp);
+            return;
+        }
+        break;
+    case RecordType::RAW:
+        if (config_.parse_raw) {
+            BinanceMessageType type = parser_.parse(record.raw, record.raw_size);
+            if (type == BinanceMessageType::DEPTH) {
+                // 解析器填的是当前时间，换成录制时的接收时间，保证每次回放结果一致
+                orderbook_t orderbook = parser_.orderbook();
+                orderbook.timestamp = record.timestamp / 1000000;
+                deliverOrderbook(orderbook, record.timestamp);
+                return;
+            }
+            if (type == BinanceMessageType::DEPTH_UPDATE) {
+                deliverDepthDiff(parser_.depthDiff(), record.timestamp);
+                return;
+            }
+            if (type == BinanceMessageType::TRADE || type == BinanceMessageType::AGG_TRADE) {
+                deliverTrade(parser_.trade(), record.timestamp);
+                return;
+            }
+        }
+        break;
+    default:
+        break;
+    }
+    skipped_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void ReplayMarketDataFetcher::deliverOrderbook(const orderbook_t& orderbook, uint64_t timestamp_ns) {
+    if (!wants(orderbook.symbol, MARKET_STREAM_DEPTH)) {
+        skipped_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        orderbooks_[orderbook.symbol] = orderbook;
+    }
+    if (recorder_) {
+        recorder_->recordOrderbook(orderbook, timestamp_ns);
+    }
+    orderbooks_delivered_.fetch_add(1, std::memory_order_relaxed);
+    if (active_orderbook_callback_) {
+        try {
+            active_orderbook_callback_(orderbook);
+        } catch (const std::exception& e) {
+            spdlog::error("Error in replay orderbook callback: {}", e.what());
+        }
+    }
+}
+
+void ReplayMarketDataFetcher::deliverDepthDiff(const depth_diff_t& diff, uint64_t timestamp_ns) {
+    if (!wants(diff.symbol, MARKET_STREAM_DEPTH_DIFF)) {
+        skipped_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    if (recorder_) {
+        recorder_->recordDepthDiff(diff, timestamp_ns);
+    }
+    diffs_delivered_.fetch_add(1, std::memory_order_relaxed);
+    if (active_diff_callback_) {
+        try {
+            active_diff_callback_(diff);
+        } catch (const std::exception& e) {
+            spdlog::error("Error in replay depth diff callback: {}", e.what());
+        }
+    }
+}
+
+void ReplayMarketDataFetcher::deliverTrade(const trade_t& trade, uint64_t timestamp_ns) {
+    if (!wants(trade.symbol, trade.aggregated ? MARKET_STREAM_AGG_TRADE : MARKET_STREAM_TRADE)) {
+        skipped_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    if (recorder_) {
+        recorder_->recordTrade(trade, timestamp_ns);
+    }
+    trades_delivered_.fetch_add(1, std::memory_order_relaxed);
+    if (active_trade_callback_) {
+        try {
+            active_trade_callback_(trade);
+        } catch (const std::exception& e) {
+            spdlog::error("Error in replay trade callback: {}", e.what());
+        }
+    }
+}
+
+ReplayStats ReplayMarketDataFetcher::getStats() const {
+    ReplayStats stats;
+    stats.records = records_.load(std::memory_order_relaxed);
+    stats.orderbooks = orderbooks_delivered_.load(std::memory_order_relaxed);
+    stats.depth_diffs = diffs_delivered_.load(std::memory_order_relaxed);
+    stats.trades = trades_delivered_.load(std::memory_order_relaxed);
+    stats.skipped = skipped_.load(std::memory_order_relaxed);
+    stats.snapshots = snapshots_.load(std::memory_order_relaxed);
+    stats.max_lag_ns = max_lag_ns_.load(std::memory_order_relaxed);
+    stats.finished = finished_.load(std::memory_order_acquire);
+    uint64_t first = first_timestamp_ns_.load(std::memory_order_relaxed);
+    uint64_t clock = clock_ns_.load(std::memory_order_acquire);
+    stats.replay_time_ns = first != 0 && clock > first ? clock - first : 0;
+    uint64_t wall_start = wall_start_ns_.load(std::memory_order_relaxed);
+    uint64_t wall_end = stats.finished ? wall_end_ns_.load(std::memory_order_relaxed) : steadyNs();
+    stats.wall_time_ns = wall_start != 0 && wall_end > wall_start ? wall_end - wall_start : 0;
+    return stats;
+}
+
+} // namespace crypto_quant
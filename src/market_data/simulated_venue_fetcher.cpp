@@ -0,0 +1,267 @@
+#include "simulated_venue_fetcher.h"
+#include "symbol_registry.h"
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+namespace crypto_quant {
+
+namespace {
+
+inline uint64_t nowMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()
+    ).count();
+}
+
+} // namespace
+
+SimulatedVenueFetcher::SimulatedVenueFetcher(const SimulatedVenueConfig& config)
+    : config_(config), random_state_(config.seed ? config.seed : 1), running_(false),
+      symbols_(1, SYMBOL_BTC_USDT) {
+    if (config_.tick_size <= 0.0) {
+        config_.tick_size = 0.01;
+    }
+    if (config_.interval_ms == 0) {
+        config_.interval_ms = 1;
+    }
+}
+
+SimulatedVenueFetcher::~SimulatedVenueFetcher() {
+    if (running_.load()) {
+        stop();
+    }
+}
+
+bool SimulatedVenueFetcher::initialize() {
+    spdlog::info("SimulatedVenueFetcher initialized: interval_ms={}, spread_bps={}, max_offset_bps={}",
+                 config_.interval_ms, config_.spread_bps, config_.max_offset_bps);
+    return true;
+}
+
+int SimulatedVenueFetcher::start(symbol_t symbol) {
+    if (running_.load()) {
+        spdlog::warn("Simulated venue already running");
+        return 0;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        symbols_.assign(1, symbol);
+    }
+    running_.store(true);
+    thread_ = std::thread(&SimulatedVenueFetcher::run, this);
+    spdlog::info("Simulated venue started for symbol: {}", symbol);
+    return 0;
+}
+
+void SimulatedVenueFetcher::stop() {
+    if (!running_.load()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        running_.store(false);
+    }
+    cv_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    spdlog::info("Simulated venue stopped");
+}
+
+int SimulatedVenueFetcher::subscribe(symbol_t symbol, uint32_t /*streams*/) {
+    if (!SymbolRegistry::instance().contains(symbol)) {
+        spdlog::error("Invalid symbol index: {}", symbol);
+        return -1;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (std::find(symbols_.begin(), symbols_.end(), symbol) == symbols_.end()) {
+        symbols_.push_back(symbol);
+    }
+    return 0;
+}
+
+int SimulatedVenueFetcher::unsubscribe(symbol_t symbol) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<symbol_t>::iterator it = std::find(symbols_.begin(), symbols_.end(), symbol);
+    if (it == symbols_.end()) {
+        return -1;
+    }
+    symbols_.erase(it);
+    return 0;
+}
+
+void SimulatedVenueFetcher::setApiKey(const std::string& /*api_key*/, const std::string& /*api_secret*/) {
+}
+
+void SimulatedVenueFetcher::setDataSources(bool /*use_binance*/, bool /*use_coingecko*/) {
+}
+
+void SimulatedVenueFetcher::setOrderbookCallback(std::function<void(const orderbook_t&)> callback) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    orderbook_callback_ = callback;
+}
+
+void SimulatedVenueFetcher::setDepthDiffCallback(std::function<void(const depth_diff_t&)> callback) {
+    if (callback) {
+        spdlog::warn("Simulated venue does not publish depth diffs, use the orderbook callback");
+    }
+}
+
+void SimulatedVenueFetcher::setTradeCallback(std::function<void(const trade_t&)> callback) {
+    if (callback) {
+        spdlog::warn("Simulated venue does not publish trades");
+    }
+}
+
+void SimulatedVenueFetcher::setRecorder(std::shared_ptr<MarketDataRecorder> recorder) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    recorder_ = recorder;
+}
+
+void SimulatedVenueFetcher::setReferencePrice(std::function<double(symbol_t)> reference) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    reference_ = reference;
+}
+
+double SimulatedVenueFetcher::uniform() {
+    random_state_ ^= random_state_ << 13;
+    random_state_ ^= random_state_ >> 7;
+    random_state_ ^= random_state_ << 17;
+    return static_cast<double>(random_state_ >> 11) * (1.0 / 9007199254740992.0);
+}
+
+SimulatedVenueFetcher::SymbolState& SimulatedVenueFetcher::stateFor(symbol_t symbol) {
+    if (symbol >= states_.size()) {
+        SymbolState empty;
+        memset(&empty, 0, sizeof(empty));
+        states_.resize(symbol + 1, empty);
+    }
+    return states_[symbol];
+}
+
+orderbook_t SimulatedVenueFetcher::step(symbol_t symbol) {
+    // 参考价回调在锁外调用
+    std::function<double(symbol_t)> reference;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        reference = reference_;
+    }
+    double reference_price = reference ? reference(symbol) : 0.0;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    SymbolState& state = stateFor(symbol);
+    if (!(reference_price > 0.0)) {
+        // 没有参考价：内部中间价每步随机游走约±1个基点
+        if (state.mid <= 0.0) {
+            state.mid = 50000.0 + static_cast<double>(symbol) * 1000.0;
+        }
+        state.mid *= 1.0 + (uniform() - 0.5) * 2e-4;
+        reference_price = state.mid;
+    }
+
+    // 偏离均值回复到0，限制在 ±max_offset_bps
+    double max_offset = config_.max_offset_bps;
+    state.offset_bps = 0.8 * state.offset_bps + (uniform() - 0.5) * max_offset * 0.8;
+    state.offset_bps = std::max(-max_offset, std::min(max_offset, state.offset_bps));
+
+    // 按整数 tick 生成价格，再用 tick 的倒数相除，使价格与交易所文本解析出的 double 一致
+    const double tick = config_.tick_size;
+    const double ticks_per_unit = std::floor(1.0 / tick + 0.5);
+    const bool exact_division = std::fabs(ticks_per_unit * tick - 1.0) < 1e-9;
+    auto ticksToPrice = [tick, ticks_per_unit, exact_division](int64_t ticks) {
+        return exact_division ? static_cast<double>(ticks) / ticks_per_unit
+                              : static_cast<double>(ticks) * tick;
+    };
+
+    double mid = reference_price * (1.0 + state.offset_bps * 1e-4);
+    double half_spread = reference_price * config_.spread_bps * 0.5e-4;
+    int64_t best_bid = static_cast<int64_t>(std::floor((mid - half_spread) / tick));
+    int64_t best_ask = static_cast<int64_t>(std::ceil((mid + half_spread) / tick));
+    if (best_ask <= best_bid) {
+        best_ask = best_bid + 1;
+    }
+    int64_t step_ticks = std::max<int64_t>(
+        1, static_cast<int64_t>(std::llround(reference_price * config_.level_step_bps * 1e-4 / tick)));
+
+    orderbook_t& book = state.book;
+    memset(&book, 0, sizeof(book));
+    book.symbol = symbol;
+    book.timestamp = nowMs();
+    book.last_update_id = ++state.update_id;
+    book.bid_count = 20;
+    book.ask_count = 20;
+    for (int i = 0; i < 20; ++i) {
+        book.bids[i].price = ticksToPrice(best_bid - i * step_ticks);
+        book.bids[i].quantity = std::floor((0.01 + uniform() * 2.0) * 1e4 + 0.5) / 1e4;
+        book.bids[i].timestamp = book.timestamp;
+        book.asks[i].price = ticksToPrice(best_ask + i * step_ticks);
+        book.asks[i].quantity = std::floor((0.01 + uniform() * 2.0) * 1e4 + 0.5) / 1e4;
+        book.asks[i].timestamp = book.timestamp;
+    }
+    // 价格过低时低档位可能变为非正，截断
+    while (book.bid_count > 0 && !(book.bids[book.bid_count - 1].price > 0.0)) {
+        --book.bid_count;
+    }
+    return book;
+}
+
+orderbook_t SimulatedVenueFetcher::getOrderbook(symbol_t symbol) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (symbol < states_.size() && states_[symbol].update_id != 0) {
+        return states_[symbol].book;
+    }
+    orderbook_t orderbook;
+    memset(&orderbook, 0, sizeof(orderbook));
+    orderbook.symbol = symbol;
+    return orderbook;
+}
+
+bool SimulatedVenueFetcher::fetchDepthSnapshot(symbol_t symbol, int limit, DepthSnapshot& snapshot) {
+    if (!SymbolRegistry::instance().contains(symbol)) {
+        spdlog::error("Invalid symbol index: {}", symbol);
+        return false;
+    }
+    orderbook_t orderbook = getOrderbook(symbol);
+    if (orderbook.last_update_id == 0) {
+        orderbook = step(symbol);
+    }
+    size_t max_levels = static_cast<size_t>(std::max(1, limit));
+    snapshot.symbol = symbol;
+    snapshot.last_update_id = orderbook.last_update_id;
+    snapshot.limit = static_cast<uint32_t>(max_levels);
+    snapshot.bids.assign(orderbook.bids, orderbook.bids + std::min<size_t>(orderbook.bid_count, max_levels));
+    snapshot.asks.assign(orderbook.asks, orderbook.asks + std::min<size_t>(orderbook.ask_count, max_levels));
+    return true;
+}
+
+void SimulatedVenueFetcher::run() {
+    while (running_.load()) {
+        std::vector<symbol_t> symbols;
+        std::function<void(const orderbook_t&)> callback;
+        std::shared_ptr<MarketDataRecorder> recorder;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            symbols = symbols_;
+            callback = orderbook_callback_;
+            recorder = recorder_;
+        }
+        for (size_t i = 0; i < symbols.size(); ++i) {
+            orderbook_t orderbook = step(symbols[i]);
+            if (recorder) {
+                recorder->recordOrderbook(orderbook, MarketDataRecorder::nowNs());
+            }
+            if (callback) {
+                callback(orderbook);
+            }
+        }
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait_for(lock, std::chrono::milliseconds(config_.interval_ms),
+                     [this]() { return !running_.load(); });
+    }
+}
+
+} // namespace crypto_quant
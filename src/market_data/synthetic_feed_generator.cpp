@@ -0,0 +1,352 @@
+#include "synthetic_feed_generator.h"
+#include "symbol_registry.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+namespace crypto_quant {
+
+namespace {
+
+const double kSecondsPerYear = 365.0 * 86400.0;
+
+inline uint64_t systemNowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()
+    ).count();
+}
+
+} // namespace
+
+SyntheticFeedGenerator::SyntheticFeedGenerator(const SyntheticFeedConfig& config)
+    : config_(config), clock_ns_(systemNowNs()), has_trade_(false) {
+    arrivals_.seed(config_.seed);
+    if (config_.tick_size <= 0.0) {
+        config_.tick_size = 0.01;
+    }
+    if (!(config_.event_rate > 0.0)) {
+        config_.event_rate = 1000.0;
+    }
+    config_.levels = std::max<uint32_t>(1, std::min<uint32_t>(config_.levels, 5000));
+    ticks_per_unit_ = std::floor(1.0 / config_.tick_size + 0.5);
+    exact_division_ = std::fabs(ticks_per_unit_ * config_.tick_size - 1.0) < 1e-9;
+    jump_compensator_ = config_.jump_intensity *
+        (std::exp(config_.jump_mean + 0.5 * config_.jump_volatility * config_.jump_volatility) - 1.0);
+
+    // 每侧最多：移出的整个旧窗口 + 新窗口
+    bid_levels_.resize(config_.levels * 2);
+    ask_levels_.resize(config_.levels * 2);
+    memset(&diff_, 0, sizeof(diff_));
+    diff_.bids = bid_levels_.data();
+    diff_.asks = ask_levels_.data();
+    memset(&trade_, 0, sizeof(trade_));
+}
+
+void SyntheticFeedGenerator::addSymbol(symbol_t symbol) {
+    if (!SymbolRegistry::instance().contains(symbol)) {
+        return;
+    }
+    if (std::find(symbols_.begin(), symbols_.end(), symbol) == symbols_.end()) {
+        symbols_.push_back(symbol);
+        stateFor(symbol);
+    }
+}
+
+void SyntheticFeedGenerator::removeSymbol(symbol_t symbol) {
+    std::vector<symbol_t>::iterator it = std::find(symbols_.begin(), symbols_.end(), symbol);
+    if (it != symbols_.end()) {
+        symbols_.erase(it);
+    }
+}
+
+void SyntheticFeedGenerator::RandomStream::seed(uint64_t value) {
+    // splitmix64 打散种子，xorshift 状态不能为0
+    value += 0x9E3779B97F4A7C15ULL;
+    value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    value = (value ^ (value >> 27)) * 0x94D049BB133111EBULL;
+    value ^= value >> 31;
+    state = value ? value : 1;
+    has_spare_normal = false;
+    spare_normal = 0.0;
+}
+
+double SyntheticFeedGenerator::RandomStream::uniform() {
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return static_cast<double>(state >> 11) * (1.0 / 9007199254740992.0);
+}
+
+double SyntheticFeedGenerator::RandomStream::normal() {
+    // Marsaglia 极坐标法，一次得到两个
+    if (has_spare_normal) {
+        has_spare_normal = false;
+        return spare_normal;
+    }
+    double u, v, s;
+    do {
+        u = uniform() * 2.0 - 1.0;
+        v = uniform() * 2.0 - 1.0;
+        s = u * u + v * v;
+    } while (s >= 1.0 || s == 0.0);
+    double factor = std::sqrt(-2.0 * std::log(s) / s);
+    spare_normal = v * factor;
+    has_spare_normal = true;
+    return u * factor;
+}
+
+uint32_t SyntheticFeedGenerator::RandomStream::poisson(double mean) {
+    if (!(mean > 0.0)) {
+        return 0;
+    }
+    if (mean > 30.0) {
+        // 均值较大时用正态近似
+        double value = std::floor(mean + std::sqrt(mean) * normal() + 0.5);
+        return value > 0.0 ? static_cast<uint32_t>(value) : 0;
+    }
+    // Knuth：累乘均匀数直到低于 e^-mean
+    const double limit = std::exp(-mean);
+    uint32_t count = 0;
+    double product = uniform();
+    while (product > limit) {
+        ++count;
+        product *= uniform();
+    }
+    return count;
+}
+
+double SyntheticFeedGenerator::drawQuantity(RandomStream& random) {
+    double quantity = std::floor(config_.mean_quantity * (0.1 + 1.8 * random.uniform()) * 1e4 + 0.5) / 1e4;
+    return std::max(quantity, 1e-4);
+}
+
+double SyntheticFeedGenerator::levelPrice(const SymbolState& state, int64_t index) const {
+    int64_t ticks = index * state.step_ticks;
+    return exact_division_ ? static_cast<double>(ticks) / ticks_per_unit_
+                           : static_cast<double>(ticks) * config_.tick_size;
+}
+
+double& SyntheticFeedGenerator::quantityAt(SymbolState& state, bool bid, int64_t index) {
+    const int64_t levels = config_.levels;
+    size_t slot = static_cast<size_t>(((index % levels) + levels) % levels);
+    return bid ? state.bid_quantities[slot] : state.ask_quantities[slot];
+}
+
+SyntheticFeedGenerator::SymbolState& SyntheticFeedGenerator::stateFor(symbol_t symbol) {
+    if (symbol >= states_.size()) {
+        // 新元素值初始化（initialized 为 false）
+        states_.resize(symbol + 1);
+    }
+    SymbolState& state = states_[symbol];
+    if (state.initialized) {
+        return state;
+    }
+
+    // 与原来的模拟数据一致：没有配置起始价时按交易对错开
+    state.mid = config_.initial_price > 0.0 ? config_.initial_price
+                                             : 50000.0 + static_cast<double>(symbol) * 1000.0;
+    state.random.seed(config_.seed ^ (static_cast<uint64_t>(symbol) + 1) * 0xD1B54A32D192ED03ULL);
+    state.spread_bps = config_.spread_mean_bps;
+    state.time_ns = clock_ns_;
+    state.update_id = 1;
+    state.trade_id = 0;
+    state.step_ticks = std::max<int64_t>(
+        1, std::llround(state.mid * config_.level_step_bps * 1e-4 / config_.tick_size));
+    state.bid_quantities.assign(config_.levels, 0.0);
+    state.ask_quantities.assign(config_.levels, 0.0);
+    state.initialized = true;
+    evolve(state, 0.0);
+    for (uint32_t i = 0; i < config_.levels; ++i) {
+        quantityAt(state, true, state.bid_index - i) = drawQuantity(state.random);
+        quantityAt(state, false, state.ask_index + i) = drawQuantity(state.random);
+    }
+    return state;
+}
+
+void SyntheticFeedGenerator::evolve(SymbolState& state, double dt) {
+    if (dt > 0.0) {
+        // 中间价：对数收益 = (mu - lambda*kappa - sigma^2/2)dt + sigma*sqrt(dt)*Z + 跳跃之和
+        const double years = dt / kSecondsPerYear;
+        const double sigma = config_.volatility;
+        RandomStream& random = state.random;
+        double log_return = (config_.drift - jump_compensator_ - 0.5 * sigma * sigma) * years +
+                            sigma * std::sqrt(years) * random.normal();
+        for (uint32_t jumps = random.poisson(config_.jump_intensity * years); jumps > 0; --jumps) {
+            log_return += config_.jump_mean + config_.jump_volatility * random.normal();
+        }
+        state.mid *= std::exp(log_return);
+
+        // 价差：OU 过程按精确解离散化（到达间隔不等长）
+        const double theta = config_.spread_reversion;
+        const double mean = config_.spread_mean_bps;
+        if (theta > 0.0) {
+            double decay = std::exp(-theta * dt);
+            state.spread_bps = mean + (state.spread_bps - mean) * decay +
+                               config_.spread_volatility_bps * std::sqrt((1.0 - decay * decay) / (2.0 * theta)) * random.normal();
+        } else {
+            state.spread_bps += config_.spread_volatility_bps * std::sqrt(dt) * random.normal();
+        }
+        state.spread_bps = std::max(0.0, state.spread_bps);
+    }
+
+    // 价差至少一个档位间隔；价格过低时保持档位为正
+    const double unit = static_cast<double>(state.step_ticks) * config_.tick_size;
+    const double half_spread = state.mid * state.spread_bps * 0.5e-4;
+    const int64_t levels = config_.levels;
+    state.bid_index = static_cast<int64_t>(std::floor((state.mid - half_spread) / unit));
+    state.ask_index = static_cast<int64_t>(std::ceil((state.mid + half_spread) / unit));
+    if (state.bid_index < levels) {
+        state.bid_index = levels;
+    }
+    if (state.ask_index <= state.bid_index) {
+        state.ask_index = state.bid_index + 1;
+    }
+}
+
+void SyntheticFeedGenerator::setLevel(bool bid, double price, double quantity, uint64_t timestamp_ms) {
+    price_level_t* levels = bid ? bid_levels_.data() : ask_levels_.data();
+    uint32_t& count = bid ? diff_.bid_count : diff_.ask_count;
+    for (uint32_t i = 0; i < count; ++i) {
+        if (levels[i].price == price) {
+            levels[i].quantity = quantity;
+            return;
+        }
+    }
+    levels[count].price = price;
+    levels[count].quantity = quantity;
+    levels[count].timestamp = timestamp_ms;
+    ++count;
+}
+
+void SyntheticFeedGenerator::shiftSide(SymbolState& state, bool bid, int64_t old_low, int64_t new_low,
+                                       uint64_t timestamp_ms) {
+    if (old_low == new_low) {
+        return;
+    }
+    const int64_t levels = config_.levels;
+    const int64_t old_high = old_low + levels - 1;
+    const int64_t new_high = new_low + levels - 1;
+    // 移出窗口的档位删除
+    for (int64_t i = old_low; i <= std::min(old_high, new_low - 1); ++i) {
+        setLevel(bid, levelPrice(state, i), 0.0, timestamp_ms);
+    }
+    for (int64_t i = std::max(old_low, new_high + 1); i <= old_high; ++i) {
+        setLevel(bid, levelPrice(state, i), 0.0, timestamp_ms);
+    }
+    // 移入窗口的档位带新数量
+    for (int64_t i = new_low; i <= std::min(new_high, old_low - 1); ++i) {
+        double quantity = drawQuantity(state.random);
+        quantityAt(state, bid, i) = quantity;
+        setLevel(bid, levelPrice(state, i), quantity, timestamp_ms);
+    }
+    for (int64_t i = std::max(new_low, old_high + 1); i <= new_high; ++i) {
+        double quantity = drawQuantity(state.random);
+        quantityAt(state, bid, i) = quantity;
+        setLevel(bid, levelPrice(state, i), quantity, timestamp_ms);
+    }
+}
+
+const depth_diff_t& SyntheticFeedGenerator::step(symbol_t symbol, uint64_t time_ns) {
+    SymbolState& state = stateFor(symbol);
+    double dt = time_ns > state.time_ns ? static_cast<double>(time_ns - state.time_ns) * 1e-9 : 0.0;
+    state.time_ns = std::max(state.time_ns, time_ns);
+    const int64_t levels = config_.levels;
+    const int64_t old_bid = state.bid_index;
+    const int64_t old_ask = state.ask_index;
+    evolve(state, dt);
+
+    const uint64_t timestamp_ms = state.time_ns / 1000000ULL;
+    diff_.bid_count = 0;
+    diff_.ask_count = 0;
+    shiftSide(state, true, old_bid - levels + 1, state.bid_index - levels + 1, timestamp_ms);
+    shiftSide(state, false, old_ask, state.ask_index, timestamp_ms);
+
+    // 盘口数量变化（靠近买一卖一的档位更频繁）；价格没动时至少变化一次，每个事件都带档位
+    uint32_t updates = state.random.poisson(config_.level_updates_per_event);
+    if (updates == 0 && diff_.bid_count == 0 && diff_.ask_count == 0) {
+        updates = 1;
+    }
+    for (uint32_t i = 0; i < updates; ++i) {
+        bool bid = state.random.uniform() < 0.5;
+        double u = state.random.uniform();
+        int64_t depth = static_cast<int64_t>(u * u * levels);
+        int64_t index = bid ? state.bid_index - depth : state.ask_index + depth;
+        double quantity = drawQuantity(state.random);
+        quantityAt(state, bid, index) = quantity;
+        setLevel(bid, levelPrice(state, index), quantity, timestamp_ms);
+    }
+
+    // 成交：主动卖出打在买一，主动买入打在卖一
+    has_trade_ = state.random.uniform() < config_.trade_probability;
+    if (has_trade_) {
+        bool buyer_maker = state.random.uniform() < 0.5;
+        trade_.symbol = symbol;
+        trade_.trade_id = ++state.trade_id;
+        trade_.first_trade_id = trade_.trade_id;
+        trade_.last_trade_id = trade_.trade_id;
+        trade_.trade_time = timestamp_ms;
+        trade_.event_time = timestamp_ms;
+        trade_.price = levelPrice(state, buyer_maker ? state.bid_index : state.ask_index);
+        trade_.quantity = drawQuantity(state.random) * 0.5;
+        trade_.is_buyer_maker = buyer_maker ? 1 : 0;
+    }
+
+    diff_.symbol = symbol;
+    diff_.first_update_id = ++state.update_id;
+    diff_.final_update_id = state.update_id;
+    diff_.event_time = timestamp_ms;
+    return diff_;
+}
+
+const depth_diff_t* SyntheticFeedGenerator::next() {
+    if (symbols_.empty()) {
+        return nullptr;
+    }
+    // 泊松到达：间隔服从指数分布；多个交易对的合并流仍是泊松过程，事件随机落在某个交易对上
+    double interval_ns = -std::log(1.0 - arrivals_.uniform()) / config_.event_rate * 1e9;
+    clock_ns_ += static_cast<uint64_t>(interval_ns + 0.5);
+    size_t index = static_cast<size_t>(arrivals_.uniform() * symbols_.size());
+    return &step(symbols_[std::min(index, symbols_.size() - 1)], clock_ns_);
+}
+
+void SyntheticFeedGenerator::fillOrderbook(symbol_t symbol, orderbook_t& orderbook) {
+    SymbolState& state = stateFor(symbol);
+    memset(&orderbook, 0, sizeof(orderbook));
+    uint32_t count = std::min<uint32_t>(config_.levels, 20);
+    orderbook.symbol = symbol;
+    orderbook.timestamp = state.time_ns / 1000000ULL;
+    orderbook.last_update_id = state.update_id;
+    orderbook.bid_count = count;
+    orderbook.ask_count = count;
+    for (uint32_t i = 0; i < count; ++i) {
+        orderbook.bids[i].price = levelPrice(state, state.bid_index - i);
+        orderbook.bids[i].quantity = quantityAt(state, true, state.bid_index - i);
+        orderbook.bids[i].timestamp = orderbook.timestamp;
+        orderbook.asks[i].price = levelPrice(state, state.ask_index + i);
+        orderbook.asks[i].quantity = quantityAt(state, false, state.ask_index + i);
+        orderbook.asks[i].timestamp = orderbook.timestamp;
+    }
+}
+
+void SyntheticFeedGenerator::fillSnapshot(symbol_t symbol, size_t limit, DepthSnapshot& snapshot) {
+    SymbolState& state = stateFor(symbol);
+    size_t count = std::min<size_t>(config_.levels, std::max<size_t>(1, limit));
+    uint64_t timestamp_ms = state.time_ns / 1000000ULL;
+    snapshot.symbol = symbol;
+    snapshot.last_update_id = state.update_id;
+    snapshot.limit = static_cast<uint32_t>(std::max<size_t>(1, limit));
+    snapshot.bids.resize(count);
+    snapshot.asks.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        int64_t offset = static_cast<int64_t>(i);
+        snapshot.bids[i].price = levelPrice(state, state.bid_index - offset);
+        snapshot.bids[i].quantity = quantityAt(state, true, state.bid_index - offset);
+        snapshot.bids[i].timestamp = timestamp_ms;
+        snapshot.asks[i].price = levelPrice(state, state.ask_index + offset);
+        snapshot.asks[i].quantity = quantityAt(state, false, state.ask_index + offset);
+        snapshot.asks[i].timestamp = timestamp_ms;
+    }
+}
+
+} // namespace crypto_quant
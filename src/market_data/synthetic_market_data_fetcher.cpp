@@ -0,0 +1,266 @@
+#include "synthetic_market_data_fetcher.h"
+#include "symbol_registry.h"
+#include <spdlog/spdlog.h>
+#include <chrono>
+#include <cstring>
+
+namespace crypto_quant {
+
+namespace {
+
+// 距离推送时刻不足该值时改为让出 CPU 自旋，避免睡眠唤醒的延迟
+const uint64_t kSpinThresholdNs = 200000;
+
+inline uint64_t steadyNowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()
+    ).count();
+}
+
+inline uint64_t systemNowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()
+    ).count();
+}
+
+} // namespace
+
+SyntheticMarketDataFetcher::SyntheticMarketDataFetcher(const SyntheticMarketDataConfig& config)
+    : config_(config), generator_(config.feed), streams_(SymbolRegistry::kMaxSymbols, 0),
+      running_(false), events_(0), clock_ns_(0) {
+}
+
+SyntheticMarketDataFetcher::~SyntheticMarketDataFetcher() {
+    if (running_.load()) {
+        stop();
+    }
+}
+
+bool SyntheticMarketDataFetcher::initialize() {
+    spdlog::info("SyntheticMarketDataFetcher initialized: event_rate={}, realtime={}, volatility={}, jump_intensity={}",
+                 config_.feed.event_rate, config_.realtime, config_.feed.volatility, config_.feed.jump_intensity);
+    return true;
+}
+
+int SyntheticMarketDataFetcher::start(symbol_t symbol) {
+    if (subscribe(symbol, 0) != 0) {
+        return -1;
+    }
+    if (running_.load()) {
+        return 0;
+    }
+    running_.store(true);
+    thread_ = std::thread(&SyntheticMarketDataFetcher::run, this);
+    spdlog::info("Synthetic market data started for symbol: {}", symbol);
+    return 0;
+}
+
+void SyntheticMarketDataFetcher::stop() {
+    if (!running_.load()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        running_.store(false);
+    }
+    cv_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    spdlog::info("Synthetic market data stopped after {} events", events_.load());
+}
+
+void SyntheticMarketDataFetcher::setApiKey(const std::string& /*api_key*/, const std::string& /*api_secret*/) {
+}
+
+void SyntheticMarketDataFetcher::setDataSources(bool /*use_binance*/, bool /*use_coingecko*/) {
+}
+
+void SyntheticMarketDataFetcher::setOrderbookCallback(std::function<void(const orderbook_t&)> callback) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    orderbook_callback_ = callback;
+}
+
+void SyntheticMarketDataFetcher::setDepthDiffCallback(std::function<void(const depth_diff_t&)> callback) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    diff_callback_ = callback;
+}
+
+void SyntheticMarketDataFetcher::setTradeCallback(std::function<void(const trade_t&)> callback) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    trade_callback_ = callback;
+}
+
+void SyntheticMarketDataFetcher::setRecorder(std::shared_ptr<MarketDataRecorder> recorder) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    recorder_ = recorder;
+}
+
+int SyntheticMarketDataFetcher::subscribe(symbol_t symbol, uint32_t streams) {
+    if (!SymbolRegistry::instance().contains(symbol)) {
+        spdlog::error("Invalid symbol index: {}", symbol);
+        return -1;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (streams == 0) {
+            streams = diff_callback_ ? MARKET_STREAM_DEPTH_DIFF : MARKET_STREAM_DEPTH;
+            if (trade_callback_) {
+                streams |= MARKET_STREAM_AGG_TRADE;
+            }
+        }
+        streams_[symbol] = streams;
+        generator_.addSymbol(symbol);
+    }
+    cv_.notify_all();
+    return 0;
+}
+
+int SyntheticMarketDataFetcher::unsubscribe(symbol_t symbol) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (symbol >= streams_.size() || streams_[symbol] == 0) {
+        return -1;
+    }
+    streams_[symbol] = 0;
+    generator_.removeSymbol(symbol);
+    return 0;
+}
+
+bool SyntheticMarketDataFetcher::fetchDepthSnapshot(symbol_t symbol, int limit, DepthSnapshot& snapshot) {
+    if (!SymbolRegistry::instance().contains(symbol)) {
+        spdlog::error("Invalid symbol index: {}", symbol);
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    generator_.fillSnapshot(symbol, static_cast<size_t>(limit > 0 ? limit : 1), snapshot);
+    return true;
+}
+
+orderbook_t SyntheticMarketDataFetcher::getOrderbook(symbol_t symbol) const {
+    orderbook_t orderbook;
+    memset(&orderbook, 0, sizeof(orderbook));
+    orderbook.symbol = symbol;
+    if (!SymbolRegistry::instance().contains(symbol)) {
+        return orderbook;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    generator_.fillOrderbook(symbol, orderbook);
+    return orderbook;
+}
+
+bool SyntheticMarketDataFetcher::pace(uint64_t time_ns, uint64_t sim_base_ns, uint64_t wall_base_ns) {
+    const uint64_t due = wall_base_ns + (time_ns > sim_base_ns ? time_ns - sim_base_ns : 0);
+    while (running_.load(std::memory_order_relaxed)) {
+        uint64_t now = steadyNowNs();
+        if (now >= due) {
+            return true;
+        }
+        if (due - now > kSpinThresholdNs) {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait_for(lock, std::chrono::nanoseconds(due - now - kSpinThresholdNs / 2),
+                         [this]() { return !running_.load(); });
+        } else {
+            std::this_thread::yield();
+        }
+    }
+    return false;
+}
+
+void SyntheticMarketDataFetcher::run() {
+    std::function<void(const orderbook_t&)> orderbook_callback;
+    std::function<void(const depth_diff_t&)> diff_callback;
+    std::function<void(const trade_t&)> trade_callback;
+    std::shared_ptr<MarketDataRecorder> recorder;
+    // 增量在锁内拷贝到本地，回调时生成器可以继续被快照请求访问
+    std::vector<price_level_t> bids;
+    std::vector<price_level_t> asks;
+    orderbook_t orderbook;
+    depth_diff_t diff;
+    trade_t trade;
+    memset(&orderbook, 0, sizeof(orderbook));
+    memset(&diff, 0, sizeof(diff));
+    memset(&trade, 0, sizeof(trade));
+    const uint32_t trade_streams = MARKET_STREAM_TRADE | MARKET_STREAM_AGG_TRADE;
+
+    uint64_t sim_base_ns = 0;
+    uint64_t wall_base_ns = 0;
+    bool rebase = true;
+    while (running_.load(std::memory_order_relaxed)) {
+        uint32_t streams = 0;
+        uint64_t time_ns = 0;
+        bool has_trade = false;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            if (generator_.symbols().empty()) {
+                // 没有订阅的交易对：等待订阅，之后重新对齐墙钟
+                cv_.wait_for(lock, std::chrono::milliseconds(100), [this]() {
+                    return !running_.load() || !generator_.symbols().empty();
+                });
+                rebase = true;
+                continue;
+            }
+            if (rebase) {
+                if (config_.realtime) {
+                    generator_.setTime(systemNowNs());
+                }
+                sim_base_ns = generator_.now();
+                wall_base_ns = steadyNowNs();
+                orderbook_callback = orderbook_callback_;
+                diff_callback = diff_callback_;
+                trade_callback = trade_callback_;
+                recorder = recorder_;
+                rebase = false;
+            }
+
+            const depth_diff_t* generated = generator_.next();
+            time_ns = generator_.now();
+            streams = streams_[generated->symbol];
+            diff = *generated;
+            bids.assign(generated->bids, generated->bids + generated->bid_count);
+            asks.assign(generated->asks, generated->asks + generated->ask_count);
+            diff.bids = bids.data();
+            diff.asks = asks.data();
+            if (streams & MARKET_STREAM_DEPTH) {
+                generator_.fillOrderbook(diff.symbol, orderbook);
+            }
+            const trade_t* generated_trade = generator_.trade();
+            if (generated_trade && (streams & trade_streams)) {
+                trade = *generated_trade;
+                trade.aggregated = (streams & MARKET_STREAM_AGG_TRADE) ? 1 : 0;
+                has_trade = true;
+            }
+        }
+        clock_ns_.store(time_ns, std::memory_order_relaxed);
+        events_.fetch_add(1, std::memory_order_relaxed);
+
+        if (config_.realtime && !pace(time_ns, sim_base_ns, wall_base_ns)) {
+            break;
+        }
+        if (streams & MARKET_STREAM_DEPTH_DIFF) {
+            if (recorder) {
+                recorder->recordDepthDiff(diff, time_ns);
+            }
+            if (diff_callback) {
+                diff_callback(diff);
+            }
+        }
+        if (streams & MARKET_STREAM_DEPTH) {
+            if (recorder) {
+                recorder->recordOrderbook(orderbook, time_ns);
+            }
+            if (orderbook_callback) {
+                orderbook_callback(orderbook);
+            }
+        }
+        if (has_trade) {
+            if (recorder) {
+                recorder->recordTrade(trade, time_ns);
+            }
+            if (trade_callback) {
+                trade_callback(trade);
+            }
+        }
+    }
+}
+
+} // namespace crypto_quant
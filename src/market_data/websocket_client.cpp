@@ -1,169 +1,174 @@
+#include <algorithm>
 #include <cstdlib>
 #include <cstring>
 #include <chrono>
 #include <thread>
-#include <curl/curl.h>
-#include <nlohmann/json.hpp>
 #include <spdlog/spdlog.h>
 
 #include "websocket_client.h"
-
-using json = nlohmann::json;
+#include "symbol_registry.h"
 
 namespace crypto_quant
 {
 
-// CURL 回调函数
-size_t WebSocketClient::writeCallback(char* ptr, size_t size, size_t nmemb, void* userdata) {
-    WebSocketClient* client = static_cast<WebSocketClient*>(userdata);
-    return client->onDataReceived(ptr, size * nmemb);
-}
-
-// 处理接收到的数据
-size_t WebSocketClient::onDataReceived(char* data, size_t size) {
+// 处理一条完整的 WebSocket 消息（在事件循环线程上调用）
+void WebSocketClient::onDataReceived(const char* data, size_t size) {
     if (size == 0) {
-        return 0;
+        return;
     }
 
-    std::string data_str(data, size);
-    
-    try {
-        json j = json::parse(data_str);
-        
-        if (j.contains("stream") && j.contains("data")) {
-            std::string stream_name = j["stream"].get<std::string>();
-            
-            if (stream_name.find("@depth") != std::string::npos) {
-                orderbook_t orderbook = parseOrderbook(&j, stream_name);
-                
-                // 调用回调函数
-                std::function<void(const orderbook_t*)> callback;
-                {
-                    std::lock_guard<std::mutex> lock(mutex_);
-                    callback = callback_;
-                }
-                
-                if (callback) {
-                    callback(&orderbook);
-                }
-                
-                spdlog::debug("WebSocket orderbook data processed: {} bids, {} asks", 
-                             orderbook.bid_count, orderbook.ask_count);
-            }
+    if (recorder_) {
+        recorder_->recordRaw(data, size, MarketDataRecorder::nowNs());
+    }
+    message_data_ = data;
+    message_size_ = size;
+
+    BinanceMessageType type = parser_.parse(data, size);
+    if (timestamps_) {
+        parsed_ns_ = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+    switch (type) {
+    case BinanceMessageType::DEPTH_UPDATE: {
+        const depth_diff_t& diff = parser_.depthDiff();
+        if (diff.symbol == SYMBOL_INVALID) {
+            spdlog::debug("Depth diff for unknown stream dropped");
+            return;
+        }
+
+        std::function<void(const depth_diff_t*)> callback;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            callback = diff_callback_;
+        }
+
+        if (callback) {
+            callback(&diff);
         }
-    } catch (const json::parse_error& e) {
-        spdlog::error("JSON parse error in WebSocket: {}", e.what());
-    } catch (const json::type_error& e) {
-        spdlog::error("JSON type error in WebSocket: {}", e.what());
-    } catch (const std::exception& e) {
-        spdlog::error("Error processing WebSocket data: {}", e.what());
+
+        spdlog::debug("WebSocket depth diff processed: U={}, u={}, {} bids, {} asks",
+                     diff.first_update_id, diff.final_update_id,
+                     diff.bid_count, diff.ask_count);
+        break;
     }
-    
-    return size;
-}
+    case BinanceMessageType::DEPTH: {
+        const orderbook_t& orderbook = parser_.orderbook();
+        if (orderbook.symbol == SYMBOL_INVALID) {
+            spdlog::debug("Orderbook for unknown stream dropped");
+            return;
+        }
 
-// 解析交易所推送的订单薄数据（使用 void* 避免在头文件中暴露 json 类型）
-orderbook_t WebSocketClient::parseOrderbook(const void* json_obj, const std::string& stream_name) const {
-    const json& j = *static_cast<const json*>(json_obj);
-    orderbook_t orderbook = {};
-    memset(&orderbook, 0, sizeof(orderbook_t));
-    
-    // 确定交易对
-    if (stream_name.find("btcusdt") != std::string::npos) {
-        orderbook.symbol = SYMBOL_BTC_USDT;
-    } else if (stream_name.find("ethusdt") != std::string::npos) {
-        orderbook.symbol = SYMBOL_ETH_USDT;
-    } else if (stream_name.find("btceth") != std::string::npos) {
-        orderbook.symbol = SYMBOL_BTC_ETH;
+        // 调用回调函数
+        std::function<void(const orderbook_t*)> callback;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            callback = callback_;
+        }
+
+        if (callback) {
+            callback(&orderbook);
+        }
+
+        spdlog::debug("WebSocket orderbook data processed: {} bids, {} asks",
+                     orderbook.bid_count, orderbook.ask_count);
+        break;
     }
-    
-    orderbook.timestamp = std::chrono::duration_cast<std::chrono::milliseconds>(
-        std::chrono::system_clock::now().time_since_epoch()
-    ).count();
-    
-    json data_obj = j["data"];
-    
-    // 解析买盘
-    if (data_obj.contains("bids") && data_obj["bids"].is_array()) {
-        uint32_t bid_count = static_cast<uint32_t>(data_obj["bids"].size());
-        orderbook.bid_count = (bid_count < 20) ? bid_count : 20;
-        
-        for (uint32_t i = 0; i < orderbook.bid_count; i++) {
-            if (data_obj["bids"][i].is_array() && data_obj["bids"][i].size() >= 2) {
-                orderbook.bids[i].price = std::stod(data_obj["bids"][i][0].get<std::string>());
-                orderbook.bids[i].quantity = std::stod(data_obj["bids"][i][1].get<std::string>());
-            }
+    case BinanceMessageType::TRADE:
+    case BinanceMessageType::AGG_TRADE: {
+        const trade_t& trade = parser_.trade();
+        if (trade.symbol == SYMBOL_INVALID) {
+            spdlog::debug("Trade for unknown symbol dropped");
+            return;
+        }
+
+        std::function<void(const trade_t*)> callback;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            callback = trade_callback_;
         }
+
+        if (callback) {
+            callback(&trade);
+        }
+        break;
     }
-    
-    // 解析卖盘
-    if (data_obj.contains("asks") && data_obj["asks"].is_array()) {
-        uint32_t ask_count = static_cast<uint32_t>(data_obj["asks"].size());
-        orderbook.ask_count = (ask_count < 20) ? ask_count : 20;
-        
-        for (uint32_t i = 0; i < orderbook.ask_count; i++) {
-            if (data_obj["asks"][i].is_array() && data_obj["asks"][i].size() >= 2) {
-                orderbook.asks[i].price = std::stod(data_obj["asks"][i][0].get<std::string>());
-                orderbook.asks[i].quantity = std::stod(data_obj["asks"][i][1].get<std::string>());
-            }
+    case BinanceMessageType::RESULT:
+    case BinanceMessageType::ERROR: {
+        std::function<void(uint64_t, bool)> callback;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            callback = response_callback_;
+        }
+
+        bool ok = type == BinanceMessageType::RESULT;
+        if (!ok) {
+            spdlog::warn("WebSocket request {} failed: {}", parser_.requestId(),
+                         std::string(data, std::min<size_t>(size, 256)));
         }
+        if (callback) {
+            callback(parser_.requestId(), ok);
+        }
+        break;
+    }
+    case BinanceMessageType::INVALID:
+        recordParseError(parser_.error());
+        break;
+    default:
+        spdlog::debug("WebSocket message ignored: {}", std::string(data, std::min<size_t>(size, 128)));
+        break;
     }
-    
-    return orderbook;
 }
 
-// 工作线程函数
-void WebSocketClient::workerThread() {
-    if (!initialized_.load()) {
-        return;
+// 解析失败只计数，日志按1、10、100…次递增输出，避免坏数据刷屏
+void WebSocketClient::recordParseError(const char* what) {
+    uint64_t count = parse_errors_.fetch_add(1, std::memory_order_relaxed) + 1;
+    uint64_t power = 1;
+    while (power < count && power <= UINT64_MAX / 10) {
+        power *= 10;
     }
-    
-    spdlog::info("WebSocket thread started for URL: {}", url_);
-    
-    curl_easy_setopt(static_cast<CURL*>(curl_), CURLOPT_URL, url_.c_str());
-    curl_easy_setopt(static_cast<CURL*>(curl_), CURLOPT_WRITEFUNCTION, writeCallback);
-    curl_easy_setopt(static_cast<CURL*>(curl_), CURLOPT_WRITEDATA, this);
-    
-    // 设置 WebSocket 协议头
-    struct curl_slist* headers = nullptr;
-    headers = curl_slist_append(headers, "Connection: Upgrade");
-    headers = curl_slist_append(headers, "Upgrade: websocket");
-    headers = curl_slist_append(headers, "Sec-WebSocket-Version: 13");
-    headers = curl_slist_append(headers, "Sec-WebSocket-Key: SGVsbG8sIFdvcmxkIQ==");
-    curl_easy_setopt(static_cast<CURL*>(curl_), CURLOPT_HTTPHEADER, headers);
-    
-    CURLcode res;
-    while (is_running_.load()) {
-        res = curl_easy_perform(static_cast<CURL*>(curl_));
-        if (res != CURLE_OK) {
-            spdlog::error("WebSocket connection failed: {}", curl_easy_strerror(res));
-            // 等待5秒后重试
-            std::this_thread::sleep_for(std::chrono::seconds(5));
-        }
+    if (power == count) {
+        spdlog::warn("WebSocket message parse errors: {} (latest: {})", count, what);
+    } else {
+        spdlog::debug("WebSocket message parse error: {}", what);
     }
-    
-    curl_slist_free_all(headers);
-    spdlog::info("WebSocket thread ended");
 }
 
 // 构造函数
-WebSocketClient::WebSocketClient(const std::string& url) 
-    : url_(url), curl_(nullptr), is_running_(false), initialized_(false) {
-    curl_ = curl_easy_init();
-    if (curl_) {
+WebSocketClient::WebSocketClient(const std::string& url, std::shared_ptr<WebSocketEventLoop> loop,
+                                 const WebSocketConfig& config)
+    : url_(url), loop_(loop), owns_loop_(!loop), is_running_(false), initialized_(false),
+      parse_errors_(0), timestamps_(false), parsed_ns_(0),
+      message_data_(nullptr), message_size_(0) {
+    if (!loop_) {
+        loop_ = std::make_shared<WebSocketEventLoop>();
+    }
+    connection_ = std::make_shared<WebSocketConnection>(url, config);
+    if (connection_->isValid()) {
+        connection_->setMessageHandler([this](const char* data, size_t size, bool binary) {
+            if (!binary) {
+                onDataReceived(data, size);
+            }
+        });
+        connection_->setStateHandler([this](bool open) {
+            std::function<void(bool)> callback;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                callback = state_callback_;
+            }
+            if (callback) {
+                callback(open);
+            }
+        });
         initialized_.store(true);
         spdlog::debug("WebSocket client created for URL: {}", url_);
     } else {
-        spdlog::error("Failed to initialize CURL for WebSocket");
+        spdlog::error("Failed to initialize WebSocket client for URL: {}", url_);
     }
 }
 
 // 析构函数
 WebSocketClient::~WebSocketClient() {
     stop();
-    if (curl_) {
-        curl_easy_cleanup(static_cast<CURL*>(curl_));
-    }
 }
 
 // 设置回调函数
@@ -173,6 +178,57 @@ void WebSocketClient::setCallback(std::function<void(const orderbook_t*)> callba
     spdlog::debug("WebSocket callback set");
 }
 
+// 设置增量深度回调函数
+void WebSocketClient::setDiffCallback(std::function<void(const depth_diff_t*)> callback) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    diff_callback_ = callback;
+    spdlog::debug("WebSocket depth diff callback set");
+}
+
+// 设置逐笔成交回调函数
+void WebSocketClient::setTradeCallback(std::function<void(const trade_t*)> callback) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    trade_callback_ = callback;
+    spdlog::debug("WebSocket trade callback set");
+}
+
+// 设置连接状态回调函数
+void WebSocketClient::setStateCallback(std::function<void(bool open)> callback) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    state_callback_ = callback;
+}
+
+// 设置原始消息录制
+void WebSocketClient::setRecorder(std::shared_ptr<MarketDataRecorder> recorder) {
+    if (is_running_.load()) {
+        spdlog::warn("WebSocket recorder must be set before start");
+        return;
+    }
+    recorder_ = recorder;
+}
+
+// 解析完成时打时间戳
+void WebSocketClient::setTimestamping(bool enabled) {
+    if (is_running_.load()) {
+        spdlog::warn("WebSocket timestamping must be set before start");
+        return;
+    }
+    timestamps_ = enabled;
+}
+
+// 设置请求应答回调函数
+void WebSocketClient::setResponseCallback(std::function<void(uint64_t id, bool ok)> callback) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    response_callback_ = callback;
+}
+
+bool WebSocketClient::send(const std::string& text) {
+    if (!initialized_.load()) {
+        return false;
+    }
+    return connection_->send(text);
+}
+
 // 启动 WebSocket 连接
 bool WebSocketClient::start() {
     if (!initialized_.load()) {
@@ -186,17 +242,19 @@ bool WebSocketClient::start() {
         return true;
     }
     
-    is_running_.store(true);
-    
-    try {
-        worker_thread_ = std::thread(&WebSocketClient::workerThread, this);
-        spdlog::info("WebSocket client started");
-        return true;
-    } catch (const std::exception& e) {
-        is_running_.store(false);
-        spdlog::error("Failed to start WebSocket thread: {}", e.what());
+    // 原始流的部分深度消息不带交易对，由 URL 中的流名决定
+    parser_.setDefaultSymbol(SymbolRegistry::instance().findByStreamName(url_));
+    if (owns_loop_ && !loop_->start()) {
+        spdlog::error("Failed to start WebSocket event loop");
         return false;
     }
+    if (!loop_->add(connection_)) {
+        spdlog::error("Failed to add WebSocket connection: {}", url_);
+        return false;
+    }
+    is_running_.store(true);
+    spdlog::info("WebSocket client started");
+    return true;
 }
 
 // 停止 WebSocket 连接
@@ -205,15 +263,19 @@ bool WebSocketClient::stop() {
         return false;
     }
     
-    std::lock_guard<std::mutex> lock(mutex_);
-    if (!is_running_.load()) {
-        return true;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!is_running_.load()) {
+            return true;
+        }
+        is_running_.store(false);
     }
     
-    is_running_.store(false);
-    
-    if (worker_thread_.joinable()) {
-        worker_thread_.join();
+    // 同步移除：返回后不会再有该连接的消息回调。等待期间不能持有 mutex_，
+    // 事件循环线程分发消息时需要它
+    loop_->remove(connection_);
+    if (owns_loop_) {
+        loop_->stop();
     }
     
     spdlog::info("WebSocket client stopped");
@@ -228,4 +290,16 @@ bool WebSocketClient::isInitialized() const {
     return initialized_.load();
 }
 
+bool WebSocketClient::isConnected() const {
+    return connection_->state() == WebSocketState::OPEN;
+}
+
+WebSocketConnectionStats WebSocketClient::getStats() const {
+    return connection_->getStats();
+}
+
+uint64_t WebSocketClient::getParseErrors() const {
+    return parse_errors_.load(std::memory_order_relaxed);
+}
+
 } // namespace crypto_quant
@@ -0,0 +1,1212 @@
+#include "websocket_connection.h"
+#include <spdlog/spdlog.h>
+#include <openssl/err.h>
+#include <openssl/evp.h>
+#include <openssl/rand.h>
+#include <openssl/ssl.h>
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace crypto_quant {
+
+namespace {
+
+// RFC 6455 握手中拼接在 Sec-WebSocket-Key 之后的固定 GUID
+const char* const kWebSocketGuid = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+// 每次读取前保证的最小可写空间
+const size_t kReadChunk = 16 * 1024;
+// HTTP 升级响应头的最大长度
+const size_t kMaxHandshakeResponse = 16 * 1024;
+const uint64_t kNoDeadline = ~static_cast<uint64_t>(0);
+// 没有任何定时器时 epoll_wait 的最长等待（毫秒）
+const int kMaxWaitMs = 1000;
+
+inline uint64_t steadyMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()
+    ).count();
+}
+
+std::string base64(const unsigned char* data, size_t size) {
+    std::string out(4 * ((size + 2) / 3) + 1, '\0');
+    int length = EVP_EncodeBlock(reinterpret_cast<unsigned char*>(&out[0]), data, static_cast<int>(size));
+    out.resize(length > 0 ? static_cast<size_t>(length) : 0);
+    return out;
+}
+
+// Sec-WebSocket-Accept = base64(SHA1(key + GUID))
+std::string expectedAccept(const std::string& key) {
+    std::string input = key + kWebSocketGuid;
+    unsigned char digest[EVP_MAX_MD_SIZE];
+    unsigned int digest_size = 0;
+    if (EVP_Digest(input.data(), input.size(), digest, &digest_size, EVP_sha1(), nullptr) != 1) {
+        return std::string();
+    }
+    return base64(digest, digest_size);
+}
+
+std::string lowercase(std::string text) {
+    for (size_t i = 0; i < text.size(); ++i) {
+        text[i] = static_cast<char>(std::tolower(static_cast<unsigned char>(text[i])));
+    }
+    return text;
+}
+
+std::string trim(const std::string& text) {
+    size_t begin = text.find_first_not_of(" \t");
+    if (begin == std::string::npos) {
+        return std::string();
+    }
+    size_t end = text.find_last_not_of(" \t");
+    return text.substr(begin, end - begin + 1);
+}
+
+// OpenSSL 错误队列中最早的一条错误
+std::string sslErrorString() {
+    unsigned long code = ERR_get_error();
+    if (code == 0) {
+        return errno != 0 ? std::string(strerror(errno)) : std::string("unknown error");
+    }
+    char buffer[256];
+    ERR_error_string_n(code, buffer, sizeof(buffer));
+    ERR_clear_error();
+    return buffer;
+}
+
+} // namespace
+
+WebSocketConnection::WebSocketConnection(const std::string& url, const WebSocketConfig& config)
+    : url_(url), valid_(false), tls_(false), config_(config), address_index_(0), loop_(nullptr), fd_(-1), ssl_(nullptr),
+      state_(WebSocketState::DISCONNECTED), ssl_wants_write_(false), interest_(0),
+      rx_parsed_(0), fragment_size_(0), fragment_opcode_(OPCODE_TEXT), in_fragment_(false), tx_offset_(0),
+      now_ms_(0), connect_started_ms_(0), last_receive_ms_(0), last_read_ns_(0), reconnect_at_ms_(0),
+      reconnect_attempts_(0), ping_outstanding_(false), random_state_(0),
+      messages_received_(0), bytes_received_(0), messages_sent_(0), pings_received_(0),
+      pongs_received_(0), connects_(0), disconnects_(0), protocol_errors_(0) {
+    if (RAND_bytes(reinterpret_cast<unsigned char*>(&random_state_), sizeof(random_state_)) != 1 ||
+        random_state_ == 0) {
+        random_state_ = 0x9E3779B97F4A7C15ULL ^ reinterpret_cast<uintptr_t>(this);
+    }
+    valid_ = parseUrl(url);
+    if (!valid_) {
+        spdlog::error("Invalid WebSocket URL: {}", url);
+    }
+}
+
+WebSocketConnection::~WebSocketConnection() {
+    // 正常情况下连接已由事件循环关闭，这里只兜底释放资源
+    closeSocket();
+}
+
+bool WebSocketConnection::parseUrl(const std::string& url) {
+    std::string rest;
+    if (url.compare(0, 6, "wss://") == 0) {
+        tls_ = true;
+        rest = url.substr(6);
+    } else if (url.compare(0, 5, "ws://") == 0) {
+        tls_ = false;
+        rest = url.substr(5);
+    } else {
+        return false;
+    }
+
+    size_t slash = rest.find('/');
+    std::string authority = rest.substr(0, slash);
+    path_ = slash == std::string::npos ? "/" : rest.substr(slash);
+    port_ = tls_ ? "443" : "80";
+    if (!authority.empty() && authority[0] == '[') {
+        // IPv6 字面量 [addr]:port
+        size_t close = authority.find(']');
+        if (close == std::string::npos) {
+            return false;
+        }
+        host_ = authority.substr(1, close - 1);
+        if (close + 1 < authority.size() && authority[close + 1] == ':') {
+            port_ = authority.substr(close + 2);
+        }
+    } else {
+        size_t colon = authority.rfind(':');
+        host_ = authority.substr(0, colon);
+        if (colon != std::string::npos) {
+            port_ = authority.substr(colon + 1);
+        }
+    }
+    return !host_.empty() && !port_.empty();
+}
+
+void WebSocketConnection::setMessageHandler(MessageHandler handler) {
+    message_handler_ = handler;
+}
+
+void WebSocketConnection::setStateHandler(StateHandler handler) {
+    state_handler_ = handler;
+}
+
+bool WebSocketConnection::send(const std::string& text) {
+    if (!valid_) {
+        return false;
+    }
+    bool first;
+    {
+        std::lock_guard<std::mutex> lock(send_mutex_);
+        first = pending_sends_.empty();
+        pending_sends_.push_back(text);
+    }
+    WebSocketEventLoop* loop = loop_.load(std::memory_order_acquire);
+    if (first && loop) {
+        loop->post(WebSocketEventLoop::COMMAND_SEND, shared_from_this());
+    }
+    return true;
+}
+
+WebSocketConnectionStats WebSocketConnection::getStats() const {
+    WebSocketConnectionStats stats;
+    stats.messages_received = messages_received_.load(std::memory_order_relaxed);
+    stats.bytes_received = bytes_received_.load(std::memory_order_relaxed);
+    stats.messages_sent = messages_sent_.load(std::memory_order_relaxed);
+    stats.pings_received = pings_received_.load(std::memory_order_relaxed);
+    stats.pongs_received = pongs_received_.load(std::memory_order_relaxed);
+    stats.connects = connects_.load(std::memory_order_relaxed);
+    stats.disconnects = disconnects_.load(std::memory_order_relaxed);
+    stats.protocol_errors = protocol_errors_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void WebSocketConnection::beginConnect(uint64_t now_ms) {
+    now_ms_ = now_ms;
+    connect_started_ms_ = now_ms;
+    state_.store(WebSocketState::CONNECTING, std::memory_order_release);
+
+    // 域名解析是阻塞调用，只在建立/重连时发生
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    struct addrinfo* result = nullptr;
+    int rc = getaddrinfo(host_.c_str(), port_.c_str(), &hints, &result);
+    if (rc != 0) {
+        fail(std::string("resolve failed: ") + gai_strerror(rc));
+        return;
+    }
+
+    // 保留全部解析结果：某个地址连接失败（如只监听 IPv4 时的 ::1）时换下一个
+    addresses_.clear();
+    for (struct addrinfo* ai = result; ai; ai = ai->ai_next) {
+        ResolvedAddress address;
+        address.family = ai->ai_family;
+        address.socktype = ai->ai_socktype;
+        address.protocol = ai->ai_protocol;
+        address.address.assign(reinterpret_cast<const char*>(ai->ai_addr), ai->ai_addrlen);
+        addresses_.push_back(address);
+    }
+    freeaddrinfo(result);
+    address_index_ = 0;
+    connectNext(ECONNREFUSED);
+}
+
+void WebSocketConnection::connectNext(int last_error) {
+    while (address_index_ < addresses_.size()) {
+        const ResolvedAddress& address = addresses_[address_index_++];
+        int fd = socket(address.family, address.socktype | SOCK_NONBLOCK | SOCK_CLOEXEC, address.protocol);
+        if (fd < 0) {
+            last_error = errno;
+            continue;
+        }
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        int rc = connect(fd, reinterpret_cast<const struct sockaddr*>(address.address.data()),
+                         static_cast<socklen_t>(address.address.size()));
+        if (rc != 0 && errno != EINPROGRESS) {
+            last_error = errno;
+            close(fd);
+            continue;
+        }
+        fd_ = fd;
+
+        WebSocketEventLoop* loop = loop_.load(std::memory_order_relaxed);
+        struct epoll_event event;
+        memset(&event, 0, sizeof(event));
+        event.events = EPOLLIN | EPOLLOUT;
+        event.data.ptr = this;
+        if (epoll_ctl(loop->epoll_fd_, EPOLL_CTL_ADD, fd_, &event) != 0) {
+            fail(std::string("epoll_ctl failed: ") + strerror(errno));
+            return;
+        }
+        interest_ = event.events;
+        loop->scheduleTimer(nextDeadline());
+        spdlog::debug("WebSocket connecting: {} (address {}/{})", url_, address_index_, addresses_.size());
+        if (rc == 0) {
+            onConnected();
+        }
+        return;
+    }
+    fail(std::string("connect failed: ") + strerror(last_error));
+}
+
+void WebSocketConnection::onConnected() {
+    if (!tls_) {
+        sendUpgradeRequest();
+        return;
+    }
+    WebSocketEventLoop* loop = loop_.load(std::memory_order_relaxed);
+    ssl_ = SSL_new(config_.verify_peer ? loop->ssl_ctx_ : loop->ssl_ctx_no_verify_);
+    if (!ssl_ || SSL_set_fd(ssl_, fd_) != 1) {
+        fail("SSL_new failed: " + sslErrorString());
+        return;
+    }
+    // SNI，以及证书主机名校验
+    SSL_set_tlsext_host_name(ssl_, host_.c_str());
+    if (config_.verify_peer) {
+        SSL_set1_host(ssl_, host_.c_str());
+    }
+    SSL_set_connect_state(ssl_);
+    state_.store(WebSocketState::TLS_HANDSHAKE, std::memory_order_release);
+    continueTlsHandshake();
+}
+
+void WebSocketConnection::continueTlsHandshake() {
+    ERR_clear_error();
+    int rc = SSL_connect(ssl_);
+    if (rc == 1) {
+        ssl_wants_write_ = false;
+        spdlog::debug("WebSocket TLS established: {} ({})", url_, SSL_get_cipher_name(ssl_));
+        sendUpgradeRequest();
+        return;
+    }
+    int error = SSL_get_error(ssl_, rc);
+    if (error == SSL_ERROR_WANT_READ || error == SSL_ERROR_WANT_WRITE) {
+        ssl_wants_write_ = error == SSL_ERROR_WANT_WRITE;
+        updateInterest();
+        return;
+    }
+    std::string reason = "TLS handshake failed: " + sslErrorString();
+    if (config_.verify_peer && SSL_get_verify_result(ssl_) != X509_V_OK) {
+        reason += std::string(" (") + X509_verify_cert_error_string(SSL_get_verify_result(ssl_)) + ")";
+    }
+    fail(reason);
+}
+
+void WebSocketConnection::sendUpgradeRequest() {
+    unsigned char nonce[16];
+    if (RAND_bytes(nonce, sizeof(nonce)) != 1) {
+        fail("RAND_bytes failed");
+        return;
+    }
+    handshake_key_ = base64(nonce, sizeof(nonce));
+
+    const bool default_port = (tls_ && port_ == "443") || (!tls_ && port_ == "80");
+    std::string host_header = host_.find(':') != std::string::npos ? "[" + host_ + "]" : host_;
+    if (!default_port) {
+        host_header += ":" + port_;
+    }
+    tx_buffer_ += "GET " + path_ + " HTTP/1.1\r\n"
+                  "Host: " + host_header + "\r\n"
+                  "Upgrade: websocket\r\n"
+                  "Connection: Upgrade\r\n"
+                  "Sec-WebSocket-Key: " + handshake_key_ + "\r\n"
+                  "Sec-WebSocket-Version: 13\r\n"
+                  "User-Agent: crypto_quant\r\n"
+                  "\r\n";
+    state_.store(WebSocketState::UPGRADING, std::memory_order_release);
+    if (flushOutput()) {
+        updateInterest();
+    }
+}
+
+bool WebSocketConnection::processUpgradeResponse() {
+    const char* begin = rx_buffer_.data();
+    const char* end = begin + rx_buffer_.size();
+    static const char kTerminator[] = "\r\n\r\n";
+    const char* header_end = std::search(begin, end, kTerminator, kTerminator + 4);
+    if (header_end == end) {
+        if (rx_buffer_.size() > kMaxHandshakeResponse) {
+            fail("handshake response too large");
+            return false;
+        }
+        return true;
+    }
+
+    std::string response(begin, header_end);
+    rx_buffer_.consume(response.size() + 4);
+
+    size_t line_end = response.find("\r\n");
+    std::string status_line = response.substr(0, line_end);
+    if (status_line.compare(0, 12, "HTTP/1.1 101") != 0) {
+        fail("upgrade rejected: " + status_line);
+        return false;
+    }
+
+    bool upgrade_ok = false;
+    bool connection_ok = false;
+    std::string accept;
+    size_t pos = line_end == std::string::npos ? response.size() : line_end + 2;
+    while (pos < response.size()) {
+        size_t next = response.find("\r\n", pos);
+        if (next == std::string::npos) {
+            next = response.size();
+        }
+        std::string line = response.substr(pos, next - pos);
+        pos = next + 2;
+        size_t colon = line.find(':');
+        if (colon == std::string::npos) {
+            continue;
+        }
+        std::string name = lowercase(trim(line.substr(0, colon)));
+        std::string value = trim(line.substr(colon + 1));
+        if (name == "upgrade") {
+            upgrade_ok = lowercase(value) == "websocket";
+        } else if (name == "connection") {
+            // Connection 是逗号分隔的令牌列表
+            connection_ok = lowercase(value).find("upgrade") != std::string::npos;
+        } else if (name == "sec-websocket-accept") {
+            accept = value;
+        } else if (name == "sec-websocket-extensions" && !value.empty()) {
+            // 握手未请求任何扩展，服务端不得启用
+            fail("server enabled unrequested extension: " + value);
+            return false;
+        }
+    }
+    if (!upgrade_ok || !connection_ok) {
+        fail("invalid upgrade response headers");
+        return false;
+    }
+    if (accept != expectedAccept(handshake_key_)) {
+        fail("Sec-WebSocket-Accept mismatch");
+        return false;
+    }
+    onOpen();
+    return state_.load(std::memory_order_relaxed) == WebSocketState::OPEN;
+}
+
+void WebSocketConnection::onOpen() {
+    state_.store(WebSocketState::OPEN, std::memory_order_release);
+    last_receive_ms_ = now_ms_;
+    ping_outstanding_ = false;
+    reconnect_attempts_ = 0;
+    connects_.fetch_add(1, std::memory_order_relaxed);
+    spdlog::info("WebSocket connected: {}", url_);
+    WebSocketEventLoop* loop = loop_.load(std::memory_order_relaxed);
+    loop->scheduleTimer(nextDeadline());
+    if (state_handler_) {
+        state_handler_(true);
+    }
+    flushPendingSends();
+}
+
+void WebSocketConnection::onEvent(uint32_t events, uint64_t now_ms) {
+    now_ms_ = now_ms;
+    WebSocketState state = state_.load(std::memory_order_relaxed);
+    if (fd_ < 0) {
+        return;
+    }
+
+    if (state == WebSocketState::CONNECTING) {
+        if (events & (EPOLLOUT | EPOLLERR | EPOLLHUP)) {
+            int error = 0;
+            socklen_t length = sizeof(error);
+            getsockopt(fd_, SOL_SOCKET, SO_ERROR, &error, &length);
+            if (error != 0) {
+                // 异步连接失败：关闭该套接字，在总超时内继续尝试其余地址
+                spdlog::debug("WebSocket connect to address {}/{} failed: {} ({})",
+                              address_index_, addresses_.size(), url_, strerror(error));
+                closeSocket();
+                connectNext(error);
+                return;
+            }
+            onConnected();
+        }
+        return;
+    }
+    if (state == WebSocketState::TLS_HANDSHAKE) {
+        continueTlsHandshake();
+        return;
+    }
+    if (events & EPOLLERR) {
+        int error = 0;
+        socklen_t length = sizeof(error);
+        getsockopt(fd_, SOL_SOCKET, SO_ERROR, &error, &length);
+        fail(std::string("socket error: ") + strerror(error));
+        return;
+    }
+
+    // TLS 记录可能在读或写任一方向上等待，两个方向都尝试推进
+    ssl_wants_write_ = false;
+    if (!flushOutput()) {
+        return;
+    }
+    if (!readAvailable()) {
+        return;
+    }
+    if (state_.load(std::memory_order_relaxed) == WebSocketState::UPGRADING && !processUpgradeResponse()) {
+        return;
+    }
+    if (state_.load(std::memory_order_relaxed) == WebSocketState::OPEN && !processFrames()) {
+        return;
+    }
+    updateInterest();
+}
+
+bool WebSocketConnection::readAvailable() {
+    bool received = false;
+    while (true) {
+        // 直接读入接收缓冲的空闲区域
+        char* out = rx_buffer_.prepareWrite(kReadChunk);
+        const size_t space = rx_buffer_.writableSize();
+        ssize_t n;
+        if (ssl_) {
+            ERR_clear_error();
+            int rc = SSL_read(ssl_, out, static_cast<int>(std::min<size_t>(space, 1 << 30)));
+            if (rc <= 0) {
+                int error = SSL_get_error(ssl_, rc);
+                if (error == SSL_ERROR_WANT_READ) {
+                    break;
+                }
+                if (error == SSL_ERROR_WANT_WRITE) {
+                    ssl_wants_write_ = true;
+                    break;
+                }
+                if (error == SSL_ERROR_ZERO_RETURN) {
+                    fail("connection closed by peer (TLS close_notify)");
+                } else {
+                    fail("TLS read failed: " + sslErrorString());
+                }
+                return false;
+            }
+            n = rc;
+        } else {
+            n = recv(fd_, out, space, 0);
+            if (n < 0) {
+                if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                    break;
+                }
+                if (errno == EINTR) {
+                    continue;
+                }
+                fail(std::string("read failed: ") + strerror(errno));
+                return false;
+            }
+            if (n == 0) {
+                fail("connection closed by peer");
+                return false;
+            }
+        }
+        rx_buffer_.commitWrite(static_cast<size_t>(n));
+        bytes_received_.fetch_add(static_cast<uint64_t>(n), std::memory_order_relaxed);
+        if (!received) {
+            // 本轮读出的所有消息共用第一次读出的时间，排在后面的消息等待解析的时间计入接收到解析的延迟
+            last_read_ns_ = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count();
+        }
+        received = true;
+        if (static_cast<size_t>(n) < space && !ssl_) {
+            // 套接字已读空，省一次返回 EAGAIN 的系统调用
+            break;
+        }
+    }
+    if (received) {
+        last_receive_ms_ = now_ms_;
+        ping_outstanding_ = false;
+    }
+    return true;
+}
+
+bool WebSocketConnection::processFrames() {
+    while (fd_ >= 0) {
+        const size_t available = rx_buffer_.size() - rx_parsed_;
+        if (available < 2) {
+            break;
+        }
+        unsigned char* frame = reinterpret_cast<unsigned char*>(rx_buffer_.data() + rx_parsed_);
+        const bool fin = (frame[0] & 0x80) != 0;
+        const int opcode = frame[0] & 0x0F;
+        if (frame[0] & 0x70) {
+            protocol_errors_.fetch_add(1, std::memory_order_relaxed);
+            fail("reserved bits set without negotiated extension");
+            return false;
+        }
+        if (frame[1] & 0x80) {
+            // 服务端发往客户端的帧不得掩码
+            protocol_errors_.fetch_add(1, std::memory_order_relaxed);
+            fail("masked frame from server");
+            return false;
+        }
+
+        size_t header = 2;
+        uint64_t length = frame[1] & 0x7F;
+        if (length == 126) {
+            if (available < 4) {
+                break;
+            }
+            length = (static_cast<uint64_t>(frame[2]) << 8) | frame[3];
+            header = 4;
+        } else if (length == 127) {
+            if (available < 10) {
+                break;
+            }
+            length = 0;
+            for (int i = 0; i < 8; ++i) {
+                length = (length << 8) | frame[2 + i];
+            }
+            header = 10;
+        }
+        if (opcode >= OPCODE_CLOSE && (!fin || length > 125)) {
+            protocol_errors_.fetch_add(1, std::memory_order_relaxed);
+            fail("invalid control frame");
+            return false;
+        }
+        if (length > config_.max_message_size) {
+            protocol_errors_.fetch_add(1, std::memory_order_relaxed);
+            fail("frame exceeds max_message_size");
+            return false;
+        }
+        if (available < header + length) {
+            // 帧不完整，等待更多数据；缓冲会按需扩容到能容纳整帧
+            break;
+        }
+
+        if (!handleFrame(opcode, fin, reinterpret_cast<char*>(frame) + header, static_cast<size_t>(length),
+                         header + static_cast<size_t>(length))) {
+            return false;
+        }
+    }
+    return fd_ >= 0;
+}
+
+void WebSocketConnection::advance(size_t frame_size) {
+    if (in_fragment_) {
+        rx_parsed_ += frame_size;
+    } else {
+        rx_buffer_.consume(frame_size);
+    }
+}
+
+bool WebSocketConnection::handleFrame(int opcode, bool fin, char* payload, size_t length, size_t frame_size) {
+    switch (opcode) {
+    case OPCODE_TEXT:
+    case OPCODE_BINARY:
+        if (in_fragment_) {
+            protocol_errors_.fetch_add(1, std::memory_order_relaxed);
+            fail("new data frame inside fragmented message");
+            return false;
+        }
+        if (fin) {
+            deliver(payload, length, opcode == OPCODE_BINARY);
+            if (fd_ < 0) {
+                return false;
+            }
+            rx_buffer_.consume(frame_size);
+        } else {
+            // 首个分片：负载移到缓冲开头，后续分片依次接在后面
+            char* base = rx_buffer_.data();
+            memmove(base, payload, length);
+            fragment_size_ = length;
+            fragment_opcode_ = opcode;
+            rx_parsed_ = frame_size;
+            in_fragment_ = true;
+        }
+        return true;
+    case OPCODE_CONTINUATION: {
+        if (!in_fragment_) {
+            protocol_errors_.fetch_add(1, std::memory_order_relaxed);
+            fail("continuation frame without message");
+            return false;
+        }
+        if (fragment_size_ + length > config_.max_message_size) {
+            protocol_errors_.fetch_add(1, std::memory_order_relaxed);
+            fail("message exceeds max_message_size");
+            return false;
+        }
+        char* base = rx_buffer_.data();
+        memmove(base + fragment_size_, payload, length);
+        fragment_size_ += length;
+        rx_parsed_ += frame_size;
+        if (fin) {
+            deliver(base, fragment_size_, fragment_opcode_ == OPCODE_BINARY);
+            if (fd_ < 0) {
+                return false;
+            }
+            rx_buffer_.consume(rx_parsed_);
+            rx_parsed_ = 0;
+            fragment_size_ = 0;
+            in_fragment_ = false;
+        }
+        return true;
+    }
+    case OPCODE_PING:
+        pings_received_.fetch_add(1, std::memory_order_relaxed);
+        queueFrame(OPCODE_PONG, payload, length);
+        advance(frame_size);
+        return flushOutput();
+    case OPCODE_PONG:
+        pongs_received_.fetch_add(1, std::memory_order_relaxed);
+        advance(frame_size);
+        return true;
+    case OPCODE_CLOSE: {
+        unsigned int code = length >= 2
+            ? (static_cast<unsigned int>(static_cast<unsigned char>(payload[0])) << 8) |
+              static_cast<unsigned char>(payload[1])
+            : 1005;
+        spdlog::info("WebSocket closed by server: {} code={} reason={}", url_, code,
+                     length > 2 ? std::string(payload + 2, length - 2) : std::string());
+        // 回送 close 帧后断开，按退避重连
+        queueFrame(OPCODE_CLOSE, payload, std::min<size_t>(length, 2));
+        if (!flushOutput()) {
+            return false;
+        }
+        teardown(false);
+        scheduleReconnect();
+        return false;
+    }
+    default:
+        protocol_errors_.fetch_add(1, std::memory_order_relaxed);
+        fail("reserved opcode");
+        return false;
+    }
+}
+
+void WebSocketConnection::deliver(const char* data, size_t size, bool binary) {
+    messages_received_.fetch_add(1, std::memory_order_relaxed);
+    if (message_handler_) {
+        message_handler_(data, size, binary);
+    }
+}
+
+void WebSocketConnection::queueFrame(int opcode, const char* payload, size_t length) {
+    unsigned char header[14];
+    size_t header_size = 2;
+    header[0] = static_cast<unsigned char>(0x80 | opcode);
+    if (length < 126) {
+        header[1] = static_cast<unsigned char>(0x80 | length);
+    } else if (length <= 0xFFFF) {
+        header[1] = 0x80 | 126;
+        header[2] = static_cast<unsigned char>(length >> 8);
+        header[3] = static_cast<unsigned char>(length);
+        header_size = 4;
+    } else {
+        header[1] = 0x80 | 127;
+        for (int i = 0; i < 8; ++i) {
+            header[2 + i] = static_cast<unsigned char>(static_cast<uint64_t>(length) >> (56 - 8 * i));
+        }
+        header_size = 10;
+    }
+    // 客户端帧必须使用不可预测的掩码
+    unsigned char* mask = header + header_size;
+    if (RAND_bytes(mask, 4) != 1) {
+        random_state_ ^= random_state_ << 13;
+        random_state_ ^= random_state_ >> 7;
+        random_state_ ^= random_state_ << 17;
+        memcpy(mask, &random_state_, 4);
+    }
+    header_size += 4;
+
+    size_t offset = tx_buffer_.size();
+    tx_buffer_.append(reinterpret_cast<const char*>(header), header_size);
+    tx_buffer_.append(payload, length);
+    char* out = &tx_buffer_[offset + header_size];
+    for (size_t i = 0; i < length; ++i) {
+        out[i] = static_cast<char>(out[i] ^ mask[i & 3]);
+    }
+    if (opcode == OPCODE_TEXT || opcode == OPCODE_BINARY) {
+        messages_sent_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+bool WebSocketConnection::flushOutput() {
+    while (tx_offset_ < tx_buffer_.size() && fd_ >= 0) {
+        const char* data = tx_buffer_.data() + tx_offset_;
+        const size_t remaining = tx_buffer_.size() - tx_offset_;
+        if (ssl_) {
+            ERR_clear_error();
+            int rc = SSL_write(ssl_, data, static_cast<int>(std::min<size_t>(remaining, 1 << 30)));
+            if (rc <= 0) {
+                int error = SSL_get_error(ssl_, rc);
+                if (error == SSL_ERROR_WANT_WRITE) {
+                    ssl_wants_write_ = true;
+                    return true;
+                }
+                if (error == SSL_ERROR_WANT_READ) {
+                    return true;
+                }
+                fail("TLS write failed: " + sslErrorString());
+                return false;
+            }
+            tx_offset_ += static_cast<size_t>(rc);
+        } else {
+            ssize_t n = ::send(fd_, data, remaining, MSG_NOSIGNAL);
+            if (n < 0) {
+                if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                    return true;
+                }
+                if (errno == EINTR) {
+                    continue;
+                }
+                fail(std::string("write failed: ") + strerror(errno));
+                return false;
+            }
+            tx_offset_ += static_cast<size_t>(n);
+        }
+    }
+    if (tx_offset_ >= tx_buffer_.size()) {
+        tx_buffer_.clear();
+        tx_offset_ = 0;
+    }
+    return fd_ >= 0;
+}
+
+void WebSocketConnection::flushPendingSends() {
+    if (state_.load(std::memory_order_relaxed) != WebSocketState::OPEN) {
+        return;
+    }
+    std::vector<std::string> sends;
+    {
+        std::lock_guard<std::mutex> lock(send_mutex_);
+        sends.swap(pending_sends_);
+    }
+    if (sends.empty()) {
+        return;
+    }
+    for (size_t i = 0; i < sends.size(); ++i) {
+        queueFrame(OPCODE_TEXT, sends[i].data(), sends[i].size());
+    }
+    if (flushOutput()) {
+        updateInterest();
+    }
+}
+
+void WebSocketConnection::updateInterest() {
+    if (fd_ < 0) {
+        return;
+    }
+    uint32_t wanted = EPOLLIN;
+    WebSocketState state = state_.load(std::memory_order_relaxed);
+    if (state == WebSocketState::CONNECTING || ssl_wants_write_ || tx_offset_ < tx_buffer_.size()) {
+        wanted |= EPOLLOUT;
+    }
+    if (wanted == interest_) {
+        return;
+    }
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = wanted;
+    event.data.ptr = this;
+    WebSocketEventLoop* loop = loop_.load(std::memory_order_relaxed);
+    if (epoll_ctl(loop->epoll_fd_, EPOLL_CTL_MOD, fd_, &event) == 0) {
+        interest_ = wanted;
+    } else {
+        fail(std::string("epoll_ctl failed: ") + strerror(errno));
+    }
+}
+
+void WebSocketConnection::onTimer(uint64_t now_ms) {
+    now_ms_ = now_ms;
+    switch (state_.load(std::memory_order_relaxed)) {
+    case WebSocketState::RECONNECT_WAIT:
+        if (now_ms >= reconnect_at_ms_) {
+            beginConnect(now_ms);
+        }
+        break;
+    case WebSocketState::CONNECTING:
+    case WebSocketState::TLS_HANDSHAKE:
+    case WebSocketState::UPGRADING:
+        if (now_ms - connect_started_ms_ >= config_.connect_timeout_ms) {
+            fail("connect timeout");
+        }
+        break;
+    case WebSocketState::OPEN:
+        if (config_.idle_timeout_ms > 0 && now_ms - last_receive_ms_ >= config_.idle_timeout_ms) {
+            fail("idle timeout");
+        } else if (config_.ping_interval_ms > 0 && !ping_outstanding_ &&
+                   now_ms - last_receive_ms_ >= config_.ping_interval_ms) {
+            ping_outstanding_ = true;
+            queueFrame(OPCODE_PING, nullptr, 0);
+            if (flushOutput()) {
+                updateInterest();
+            }
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+uint64_t WebSocketConnection::nextDeadline() const {
+    switch (state_.load(std::memory_order_relaxed)) {
+    case WebSocketState::RECONNECT_WAIT:
+        return reconnect_at_ms_;
+    case WebSocketState::CONNECTING:
+    case WebSocketState::TLS_HANDSHAKE:
+    case WebSocketState::UPGRADING:
+        return connect_started_ms_ + config_.connect_timeout_ms;
+    case WebSocketState::OPEN: {
+        uint64_t deadline = kNoDeadline;
+        if (config_.idle_timeout_ms > 0) {
+            deadline = last_receive_ms_ + config_.idle_timeout_ms;
+        }
+        if (config_.ping_interval_ms > 0 && !ping_outstanding_) {
+            deadline = std::min(deadline, last_receive_ms_ + config_.ping_interval_ms);
+        }
+        return deadline;
+    }
+    default:
+        return kNoDeadline;
+    }
+}
+
+void WebSocketConnection::fail(const std::string& reason) {
+    spdlog::warn("WebSocket connection error: {} ({})", url_, reason);
+    teardown(false);
+    scheduleReconnect();
+}
+
+void WebSocketConnection::scheduleReconnect() {
+    WebSocketEventLoop* loop = loop_.load(std::memory_order_relaxed);
+    if (!loop || !loop->isRunning()) {
+        return;
+    }
+    // 指数退避，抖动范围 [0.75, 1.25)，避免多条连接同时重连
+    uint32_t shift = std::min<uint32_t>(reconnect_attempts_, 20);
+    uint64_t delay = std::min<uint64_t>(static_cast<uint64_t>(config_.reconnect_initial_ms) << shift,
+                                        config_.reconnect_max_ms);
+    ++reconnect_attempts_;
+    random_state_ ^= random_state_ << 13;
+    random_state_ ^= random_state_ >> 7;
+    random_state_ ^= random_state_ << 17;
+    double jitter = 0.75 + 0.5 * static_cast<double>(random_state_ >> 11) * (1.0 / 9007199254740992.0);
+    delay = static_cast<uint64_t>(static_cast<double>(delay) * jitter);
+
+    reconnect_at_ms_ = now_ms_ + delay;
+    state_.store(WebSocketState::RECONNECT_WAIT, std::memory_order_release);
+    loop->scheduleTimer(reconnect_at_ms_);
+    spdlog::info("WebSocket reconnecting in {} ms: {} (attempt {})", delay, url_, reconnect_attempts_);
+}
+
+void WebSocketConnection::teardown(bool graceful) {
+    // 先切换状态，发送 close 帧失败时嵌套的 fail() 不会重复回调
+    const bool was_open = state_.exchange(WebSocketState::DISCONNECTED) == WebSocketState::OPEN;
+    if (graceful && was_open && fd_ >= 0) {
+        // 正常关闭：尽力发送 close(1000)，不等待服务端回应
+        const char normal_closure[2] = {static_cast<char>(0x03), static_cast<char>(0xE8)};
+        queueFrame(OPCODE_CLOSE, normal_closure, sizeof(normal_closure));
+        flushOutput();
+        if (ssl_ && fd_ >= 0) {
+            ERR_clear_error();
+            SSL_shutdown(ssl_);
+        }
+    }
+    closeSocket();
+    state_.store(WebSocketState::DISCONNECTED, std::memory_order_release);
+    if (was_open) {
+        disconnects_.fetch_add(1, std::memory_order_relaxed);
+        if (state_handler_) {
+            state_handler_(false);
+        }
+    }
+}
+
+void WebSocketConnection::closeSocket() {
+    if (ssl_) {
+        SSL_free(ssl_);
+        ssl_ = nullptr;
+    }
+    if (fd_ >= 0) {
+        WebSocketEventLoop* loop = loop_.load(std::memory_order_relaxed);
+        if (loop && interest_ != 0) {
+            epoll_ctl(loop->epoll_fd_, EPOLL_CTL_DEL, fd_, nullptr);
+        }
+        close(fd_);
+        fd_ = -1;
+    }
+    interest_ = 0;
+    ssl_wants_write_ = false;
+    rx_buffer_.clear();
+    rx_parsed_ = 0;
+    fragment_size_ = 0;
+    in_fragment_ = false;
+    tx_buffer_.clear();
+    tx_offset_ = 0;
+    ping_outstanding_ = false;
+}
+
+WebSocketEventLoop::WebSocketEventLoop()
+    : epoll_fd_(-1), wake_fd_(-1), ssl_ctx_(nullptr), ssl_ctx_no_verify_(nullptr), running_(false),
+      connection_count_(0), next_timer_ms_(0) {
+    epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epoll_fd_ < 0 || wake_fd_ < 0) {
+        spdlog::error("Failed to create epoll/eventfd: {}", strerror(errno));
+        return;
+    }
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN;
+    event.data.ptr = nullptr;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wake_fd_, &event);
+
+    SSL_CTX* contexts[2] = {nullptr, nullptr};
+    for (int i = 0; i < 2; ++i) {
+        contexts[i] = SSL_CTX_new(TLS_client_method());
+        if (!contexts[i]) {
+            spdlog::error("SSL_CTX_new failed: {}", sslErrorString());
+            continue;
+        }
+        SSL_CTX_set_min_proto_version(contexts[i], TLS1_2_VERSION);
+        // 发送缓冲可能在重试之间扩容，允许部分写入并接受缓冲地址变化
+        SSL_CTX_set_mode(contexts[i], SSL_MODE_ENABLE_PARTIAL_WRITE | SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
+    }
+    ssl_ctx_ = contexts[0];
+    ssl_ctx_no_verify_ = contexts[1];
+    if (ssl_ctx_) {
+        SSL_CTX_set_verify(ssl_ctx_, SSL_VERIFY_PEER, nullptr);
+        if (SSL_CTX_set_default_verify_paths(ssl_ctx_) != 1) {
+            spdlog::warn("Failed to load default CA paths: {}", sslErrorString());
+        }
+    }
+    if (ssl_ctx_no_verify_) {
+        SSL_CTX_set_verify(ssl_ctx_no_verify_, SSL_VERIFY_NONE, nullptr);
+    }
+}
+
+WebSocketEventLoop::~WebSocketEventLoop() {
+    stop();
+    if (ssl_ctx_) {
+        SSL_CTX_free(ssl_ctx_);
+    }
+    if (ssl_ctx_no_verify_) {
+        SSL_CTX_free(ssl_ctx_no_verify_);
+    }
+    if (wake_fd_ >= 0) {
+        close(wake_fd_);
+    }
+    if (epoll_fd_ >= 0) {
+        close(epoll_fd_);
+    }
+}
+
+bool WebSocketEventLoop::start() {
+    if (epoll_fd_ < 0 || wake_fd_ < 0 || !ssl_ctx_ || !ssl_ctx_no_verify_) {
+        spdlog::error("WebSocket event loop not initialized");
+        return false;
+    }
+    if (running_.exchange(true)) {
+        return true;
+    }
+    thread_ = std::thread(&WebSocketEventLoop::run, this);
+    spdlog::info("WebSocket event loop started");
+    return true;
+}
+
+void WebSocketEventLoop::stop() {
+    if (!running_.exchange(false)) {
+        return;
+    }
+    wake();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    spdlog::info("WebSocket event loop stopped");
+}
+
+bool WebSocketEventLoop::add(std::shared_ptr<WebSocketConnection> connection) {
+    if (!connection || !connection->isValid()) {
+        return false;
+    }
+    WebSocketEventLoop* expected = nullptr;
+    if (!connection->loop_.compare_exchange_strong(expected, this)) {
+        spdlog::warn("WebSocket connection already attached to an event loop: {}", connection->url());
+        return false;
+    }
+    connection_count_.fetch_add(1);
+    post(COMMAND_ADD, connection);
+    return true;
+}
+
+void WebSocketEventLoop::remove(std::shared_ptr<WebSocketConnection> connection) {
+    if (!connection || connection->loop_.load() != this) {
+        return;
+    }
+    if (!running_.load()) {
+        // 循环未运行：连接只可能还在命令队列中，直接撤销
+        std::lock_guard<std::mutex> lock(command_mutex_);
+        for (size_t i = 0; i < commands_.size(); ) {
+            if (commands_[i].connection == connection) {
+                if (commands_[i].type == COMMAND_ADD) {
+                    connection_count_.fetch_sub(1);
+                }
+                commands_.erase(commands_.begin() + i);
+            } else {
+                ++i;
+            }
+        }
+        connection->loop_.store(nullptr);
+        return;
+    }
+    post(COMMAND_REMOVE, connection);
+    if (std::this_thread::get_id() == loop_thread_id_) {
+        return;
+    }
+    std::unique_lock<std::mutex> lock(command_mutex_);
+    command_cv_.wait(lock, [&connection]() { return connection->loop_.load() == nullptr; });
+}
+
+size_t WebSocketEventLoop::connectionCount() const {
+    return connection_count_.load();
+}
+
+bool WebSocketEventLoop::runInLoop(std::function<void()> task) {
+    if (!task || !running_.load()) {
+        return false;
+    }
+    {
+        std::lock_guard<std::mutex> lock(command_mutex_);
+        Command command;
+        command.type = COMMAND_TASK;
+        command.task.swap(task);
+        commands_.push_back(command);
+    }
+    wake();
+    return true;
+}
+
+void WebSocketEventLoop::post(CommandType type, std::shared_ptr<WebSocketConnection> connection) {
+    {
+        std::lock_guard<std::mutex> lock(command_mutex_);
+        Command command;
+        command.type = type;
+        command.connection = connection;
+        commands_.push_back(command);
+    }
+    wake();
+}
+
+void WebSocketEventLoop::wake() {
+    uint64_t one = 1;
+    ssize_t n = write(wake_fd_, &one, sizeof(one));
+    (void)n;
+}
+
+void WebSocketEventLoop::scheduleTimer(uint64_t deadline_ms) {
+    next_timer_ms_ = std::min(next_timer_ms_, deadline_ms);
+}
+
+void WebSocketEventLoop::processCommands(uint64_t now_ms) {
+    std::vector<Command> commands;
+    {
+        std::lock_guard<std::mutex> lock(command_mutex_);
+        commands.swap(commands_);
+    }
+    if (commands.empty()) {
+        return;
+    }
+    for (size_t i = 0; i < commands.size(); ++i) {
+        std::shared_ptr<WebSocketConnection>& connection = commands[i].connection;
+        switch (commands[i].type) {
+        case COMMAND_ADD:
+            connections_.push_back(connection);
+            connection->beginConnect(now_ms);
+            break;
+        case COMMAND_REMOVE: {
+            std::vector<std::shared_ptr<WebSocketConnection> >::iterator it =
+                std::find(connections_.begin(), connections_.end(), connection);
+            if (it != connections_.end()) {
+                connection->teardown(true);
+                connections_.erase(it);
+                connection_count_.fetch_sub(1);
+            }
+            std::lock_guard<std::mutex> lock(command_mutex_);
+            connection->loop_.store(nullptr);
+            break;
+        }
+        case COMMAND_SEND:
+            connection->flushPendingSends();
+            break;
+        case COMMAND_TASK:
+            commands[i].task();
+            break;
+        }
+    }
+    command_cv_.notify_all();
+}
+
+void WebSocketEventLoop::runTimers(uint64_t now_ms) {
+    next_timer_ms_ = kNoDeadline;
+    for (size_t i = 0; i < connections_.size(); ++i) {
+        WebSocketConnection& connection = *connections_[i];
+        if (now_ms >= connection.nextDeadline()) {
+            connection.onTimer(now_ms);
+        }
+        next_timer_ms_ = std::min(next_timer_ms_, connection.nextDeadline());
+    }
+}
+
+void WebSocketEventLoop::run() {
+    loop_thread_id_ = std::this_thread::get_id();
+    // 对端关闭后 TLS 写入会触发 SIGPIPE，在本线程屏蔽，由返回值处理
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &mask, nullptr);
+
+    const int kMaxEvents = 64;
+    struct epoll_event events[kMaxEvents];
+    next_timer_ms_ = steadyMs();
+    while (running_.load()) {
+        uint64_t now_ms = steadyMs();
+        int timeout = kMaxWaitMs;
+        if (next_timer_ms_ <= now_ms) {
+            timeout = 0;
+        } else if (next_timer_ms_ - now_ms < static_cast<uint64_t>(kMaxWaitMs)) {
+            timeout = static_cast<int>(next_timer_ms_ - now_ms);
+        }
+        int count = epoll_wait(epoll_fd_, events, kMaxEvents, timeout);
+        if (count < 0 && errno != EINTR) {
+            spdlog::error("epoll_wait failed: {}", strerror(errno));
+            break;
+        }
+        now_ms = steadyMs();
+        for (int i = 0; i < count; ++i) {
+            if (events[i].data.ptr == nullptr) {
+                uint64_t value;
+                while (read(wake_fd_, &value, sizeof(value)) > 0) {
+                }
+                continue;
+            }
+            static_cast<WebSocketConnection*>(events[i].data.ptr)->onEvent(events[i].events, now_ms);
+        }
+        processCommands(now_ms);
+        if (now_ms >= next_timer_ms_) {
+            runTimers(now_ms);
+        }
+    }
+
+    // 关闭所有连接，尚未处理的命令直接丢弃
+    for (size_t i = 0; i < connections_.size(); ++i) {
+        connections_[i]->teardown(true);
+    }
+    std::lock_guard<std::mutex> lock(command_mutex_);
+    for (size_t i = 0; i < connections_.size(); ++i) {
+        connections_[i]->loop_.store(nullptr);
+    }
+    for (size_t i = 0; i < commands_.size(); ++i) {
+        if (commands_[i].connection) {
+            commands_[i].connection->loop_.store(nullptr);
+        }
+    }
+    commands_.clear();
+    connections_.clear();
+    connection_count_.store(0);
+    command_cv_.notify_all();
+}
+
+} // namespace crypto_quant
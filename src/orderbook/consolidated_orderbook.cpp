@@ -0,0 +1,345 @@
+#include "consolidated_orderbook.h"
+#include "symbol_registry.h"
+#include <spdlog/spdlog.h>
+#include <algorithm>
+
+namespace crypto_quant {
+
+namespace {
+
+// a 是否优于 b（买盘价高为优，卖盘价低为优）
+inline bool better(bool bid, double a, double b) {
+    return bid ? a > b : a < b;
+}
+
+// 档位价格严格由优到劣且数量为正
+bool isOrdered(const price_level_t* levels, size_t count, bool bid) {
+    for (size_t i = 0; i < count; ++i) {
+        if (!(levels[i].price > 0.0) || !(levels[i].quantity > 0.0) ||
+            (i > 0 && !better(bid, levels[i - 1].price, levels[i].price))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+ConsolidatedOrderbook::ConsolidatedOrderbook()
+    : books_(SymbolRegistry::kMaxSymbols), level_changes_(0) {
+}
+
+ConsolidatedOrderbook::SymbolBook* ConsolidatedOrderbook::findBook(symbol_t symbol) const {
+    return books_.get(symbol);
+}
+
+ConsolidatedOrderbook::SymbolBook* ConsolidatedOrderbook::findOrCreateBook(symbol_t symbol) {
+    if (!SymbolRegistry::instance().contains(symbol)) {
+        return nullptr;
+    }
+    return books_.getOrCreate(symbol);
+}
+
+void ConsolidatedOrderbook::setVenueQuantity(std::vector<consolidated_level_t>& levels, bool bid,
+                                             venue_t venue, double price, double quantity) {
+    std::vector<consolidated_level_t>::iterator it = std::lower_bound(
+        levels.begin(), levels.end(), price,
+        [bid](const consolidated_level_t& level, double value) {
+            return better(bid, level.price, value);
+        });
+    const uint32_t bit = 1u << venue;
+
+    if (it == levels.end() || it->price != price) {
+        if (quantity <= 0.0) {
+            return;
+        }
+        consolidated_level_t level;
+        memset(&level, 0, sizeof(level));
+        level.price = price;
+        level.quantity = quantity;
+        level.venue_mask = bit;
+        level.venue_count = 1;
+        level.venue_quantity[venue] = quantity;
+        levels.insert(it, level);
+        return;
+    }
+
+    consolidated_level_t& level = *it;
+    if (quantity > 0.0) {
+        level.venue_quantity[venue] = quantity;
+        level.venue_mask |= bit;
+    } else {
+        level.venue_quantity[venue] = 0.0;
+        level.venue_mask &= ~bit;
+        if (level.venue_mask == 0) {
+            levels.erase(it);
+            return;
+        }
+    }
+    // 合计按场所明细重新求和，避免浮点增减的累积误差
+    double total = 0.0;
+    uint32_t count = 0;
+    for (venue_t v = 0; v < VENUE_MAX; ++v) {
+        if (level.venue_mask & (1u << v)) {
+            total += level.venue_quantity[v];
+            ++count;
+        }
+    }
+    level.quantity = total;
+    level.venue_count = count;
+}
+
+size_t ConsolidatedOrderbook::replaceVenueSide(std::vector<consolidated_level_t>& levels, bool bid,
+                                               venue_t venue,
+                                               const price_level_t* old_levels, size_t old_count,
+                                               const price_level_t* new_levels, size_t new_count) {
+    // 新旧两份都由优到劣排序，一次归并找出变化的价格
+    size_t changes = 0;
+    size_t i = 0;
+    size_t j = 0;
+    while (i < old_count || j < new_count) {
+        if (j == new_count || (i < old_count && better(bid, old_levels[i].price, new_levels[j].price))) {
+            // 价格从该场所消失
+            setVenueQuantity(levels, bid, venue, old_levels[i].price, 0.0);
+            ++i;
+            ++changes;
+        } else if (i == old_count || better(bid, new_levels[j].price, old_levels[i].price)) {
+            // 新出现的价格
+            setVenueQuantity(levels, bid, venue, new_levels[j].price, new_levels[j].quantity);
+            ++j;
+            ++changes;
+        } else {
+            if (old_levels[i].quantity != new_levels[j].quantity) {
+                setVenueQuantity(levels, bid, venue, new_levels[j].price, new_levels[j].quantity);
+                ++changes;
+            }
+            ++i;
+            ++j;
+        }
+    }
+    return changes;
+}
+
+void ConsolidatedOrderbook::publishTop(symbol_t symbol, SymbolBook& book) {
+    consolidated_top_t& top = book.top.beginWrite();
+    memset(&top, 0, sizeof(top));
+    top.symbol = symbol;
+    top.venue_mask = book.venue_mask;
+    if (!book.bids.empty()) {
+        top.bid_price = book.bids[0].price;
+        top.bid_quantity = book.bids[0].quantity;
+        top.bid_venue_mask = book.bids[0].venue_mask;
+    }
+    if (!book.asks.empty()) {
+        top.ask_price = book.asks[0].price;
+        top.ask_quantity = book.asks[0].quantity;
+        top.ask_venue_mask = book.asks[0].venue_mask;
+    }
+    top.crossed = (top.bid_price > 0.0 && top.ask_price > 0.0 && top.bid_price >= top.ask_price) ? 1 : 0;
+    for (venue_t v = 0; v < VENUE_MAX; ++v) {
+        if ((book.venue_mask & (1u << v)) && book.venue_books[v].timestamp > top.timestamp) {
+            top.timestamp = book.venue_books[v].timestamp;
+        }
+    }
+    top.sequence = book.sequence;
+    book.top.endWrite();
+}
+
+bool ConsolidatedOrderbook::update(venue_t venue, const orderbook_t& orderbook) {
+    if (venue >= VENUE_MAX) {
+        spdlog::error("Invalid venue: {}", venue);
+        return false;
+    }
+    SymbolBook* book = findOrCreateBook(orderbook.symbol);
+    if (!book) {
+        spdlog::error("Invalid symbol index: {}", orderbook.symbol);
+        return false;
+    }
+    const size_t bid_count = std::min<uint32_t>(orderbook.bid_count, ORDERBOOK_MAX_LEVELS);
+    const size_t ask_count = std::min<uint32_t>(orderbook.ask_count, ORDERBOOK_MAX_LEVELS);
+    // 归并依赖有序输入
+    if (!isOrdered(orderbook.bids, bid_count, true) || !isOrdered(orderbook.asks, ask_count, false)) {
+        spdlog::warn("Consolidated update rejected, levels not ordered: venue={}, symbol={}",
+                     venueName(venue), orderbook.symbol);
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(book->mutex);
+        orderbook_t& previous = book->venue_books[venue];
+        size_t changes = replaceVenueSide(book->bids, true, venue,
+                                          previous.bids, previous.bid_count,
+                                          orderbook.bids, bid_count);
+        changes += replaceVenueSide(book->asks, false, venue,
+                                    previous.asks, previous.ask_count,
+                                    orderbook.asks, ask_count);
+        memcpy(&previous, &orderbook, sizeof(orderbook));
+        previous.bid_count = static_cast<uint32_t>(bid_count);
+        previous.ask_count = static_cast<uint32_t>(ask_count);
+        book->venue_mask |= 1u << venue;
+        ++book->sequence;
+        publishTop(orderbook.symbol, *book);
+        level_changes_.fetch_add(changes, std::memory_order_relaxed);
+    }
+
+    symbol_t symbol = orderbook.symbol;
+    notifier_.publish(symbol, [this, symbol](orderbook_t& out) {
+        out = getOrderbook(symbol);
+    });
+    return true;
+}
+
+bool ConsolidatedOrderbook::removeVenue(venue_t venue, symbol_t symbol) {
+    if (venue >= VENUE_MAX) {
+        return false;
+    }
+    SymbolBook* book = findBook(symbol);
+    if (!book) {
+        return false;
+    }
+    {
+        std::lock_guard<std::mutex> lock(book->mutex);
+        if (!(book->venue_mask & (1u << venue))) {
+            return false;
+        }
+        orderbook_t& previous = book->venue_books[venue];
+        size_t changes = replaceVenueSide(book->bids, true, venue, previous.bids, previous.bid_count,
+                                          nullptr, 0);
+        changes += replaceVenueSide(book->asks, false, venue, previous.asks, previous.ask_count,
+                                    nullptr, 0);
+        memset(&previous, 0, sizeof(previous));
+        book->venue_mask &= ~(1u << venue);
+        ++book->sequence;
+        publishTop(symbol, *book);
+        level_changes_.fetch_add(changes, std::memory_order_relaxed);
+    }
+    spdlog::info("Venue removed from consolidated book: venue={}, symbol={}", venueName(venue), symbol);
+
+    notifier_.publish(symbol, [this, symbol](orderbook_t& out) {
+        out = getOrderbook(symbol);
+    });
+    return true;
+}
+
+void ConsolidatedOrderbook::clear() {
+    books_.forEach([](size_t index, SymbolBook& book) {
+        std::lock_guard<std::mutex> lock(book.mutex);
+        memset(static_cast<void*>(book.venue_books), 0, sizeof(book.venue_books));
+        book.venue_mask = 0;
+        book.bids.clear();
+        book.asks.clear();
+        ++book.sequence;
+        publishTop(static_cast<symbol_t>(index), book);
+    });
+}
+
+void ConsolidatedOrderbook::toOrderbook(symbol_t symbol, const SymbolBook& book, orderbook_t& orderbook) {
+    memset(&orderbook, 0, sizeof(orderbook));
+    orderbook.symbol = symbol;
+    orderbook.bid_count = static_cast<uint32_t>(std::min<size_t>(book.bids.size(), ORDERBOOK_MAX_LEVELS));
+    orderbook.ask_count = static_cast<uint32_t>(std::min<size_t>(book.asks.size(), ORDERBOOK_MAX_LEVELS));
+    for (uint32_t i = 0; i < orderbook.bid_count; ++i) {
+        orderbook.bids[i].price = book.bids[i].price;
+        orderbook.bids[i].quantity = book.bids[i].quantity;
+    }
+    for (uint32_t i = 0; i < orderbook.ask_count; ++i) {
+        orderbook.asks[i].price = book.asks[i].price;
+        orderbook.asks[i].quantity = book.asks[i].quantity;
+    }
+    for (venue_t v = 0; v < VENUE_MAX; ++v) {
+        if ((book.venue_mask & (1u << v)) && book.venue_books[v].timestamp > orderbook.timestamp) {
+            orderbook.timestamp = book.venue_books[v].timestamp;
+        }
+    }
+    orderbook.last_update_id = book.sequence;
+}
+
+orderbook_t ConsolidatedOrderbook::getOrderbook(symbol_t symbol) const {
+    orderbook_t orderbook;
+    SymbolBook* book = findBook(symbol);
+    if (!book) {
+        memset(&orderbook, 0, sizeof(orderbook));
+        orderbook.symbol = symbol;
+        return orderbook;
+    }
+    std::lock_guard<std::mutex> lock(book->mutex);
+    toOrderbook(symbol, *book, orderbook);
+    return orderbook;
+}
+
+size_t ConsolidatedOrderbook::getLevels(symbol_t symbol, bool bid, consolidated_level_t* out,
+                                        size_t max_levels) const {
+    SymbolBook* book = findBook(symbol);
+    if (!book || !out) {
+        return 0;
+    }
+    std::lock_guard<std::mutex> lock(book->mutex);
+    const std::vector<consolidated_level_t>& levels = bid ? book->bids : book->asks;
+    size_t count = std::min(levels.size(), max_levels);
+    if (count > 0) {
+        memcpy(out, levels.data(), count * sizeof(consolidated_level_t));
+    }
+    return count;
+}
+
+size_t ConsolidatedOrderbook::getLevelCount(symbol_t symbol, bool bid) const {
+    SymbolBook* book = findBook(symbol);
+    if (!book) {
+        return 0;
+    }
+    std::lock_guard<std::mutex> lock(book->mutex);
+    return bid ? book->bids.size() : book->asks.size();
+}
+
+consolidated_top_t ConsolidatedOrderbook::getTop(symbol_t symbol) const {
+    SymbolBook* book = findBook(symbol);
+    if (!book) {
+        consolidated_top_t top;
+        memset(&top, 0, sizeof(top));
+        top.symbol = symbol;
+        return top;
+    }
+    return book->top.load();
+}
+
+bool ConsolidatedOrderbook::getVenueOrderbook(venue_t venue, symbol_t symbol, orderbook_t& orderbook) const {
+    SymbolBook* book = venue < VENUE_MAX ? findBook(symbol) : nullptr;
+    if (!book) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(book->mutex);
+    if (!(book->venue_mask & (1u << venue))) {
+        return false;
+    }
+    orderbook = book->venue_books[venue];
+    return true;
+}
+
+std::shared_ptr<IOrderbookSubscription> ConsolidatedOrderbook::subscribeConflated(symbol_t symbol) {
+    return notifier_.subscribeConflated(symbol);
+}
+
+uint64_t ConsolidatedOrderbook::subscribeEveryUpdate(symbol_t symbol, OrderbookUpdateCallback callback) {
+    return notifier_.subscribeEveryUpdate(symbol, callback);
+}
+
+void ConsolidatedOrderbook::unsubscribe(uint64_t subscription_id) {
+    notifier_.unsubscribe(subscription_id);
+}
+
+uint64_t ConsolidatedOrderbook::droppedUpdates(uint64_t subscription_id) const {
+    return notifier_.droppedUpdates(subscription_id);
+}
+
+const char* ConsolidatedOrderbook::venueName(venue_t venue) {
+    switch (venue) {
+    case VENUE_BINANCE:
+        return "binance";
+    case VENUE_SIMULATED:
+        return "simulated";
+    default:
+        return "unknown";
+    }
+}
+
+} // namespace crypto_quant
@@ -0,0 +1,338 @@
+#include "depth_kernels.h"
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define CRYPTO_QUANT_X86 1
+#else
+#define CRYPTO_QUANT_X86 0
+#endif
+
+namespace crypto_quant {
+
+void orderbookToSoa(const orderbook_t& orderbook, orderbook_soa_t& soa) {
+    uint32_t bid_count = orderbook.bid_count < ORDERBOOK_MAX_LEVELS ? orderbook.bid_count : ORDERBOOK_MAX_LEVELS;
+    uint32_t ask_count = orderbook.ask_count < ORDERBOOK_MAX_LEVELS ? orderbook.ask_count : ORDERBOOK_MAX_LEVELS;
+    memset(&soa, 0, sizeof(soa));
+    for (uint32_t i = 0; i < bid_count; ++i) {
+        soa.bid_prices[i] = orderbook.bids[i].price;
+        soa.bid_quantities[i] = orderbook.bids[i].quantity;
+    }
+    for (uint32_t i = 0; i < ask_count; ++i) {
+        soa.ask_prices[i] = orderbook.asks[i].price;
+        soa.ask_quantities[i] = orderbook.asks[i].quantity;
+    }
+    soa.bid_count = bid_count;
+    soa.ask_count = ask_count;
+}
+
+namespace {
+
+// ---------------------------------------------------------------------------
+// 标量实现
+// ---------------------------------------------------------------------------
+
+double scalarCumulativeQuantity(const double* quantities, uint32_t n) {
+    double sum = 0.0;
+    for (uint32_t i = 0; i < n; ++i) {
+        sum += quantities[i];
+    }
+    return sum;
+}
+
+double scalarQuantityWithinPrice(const double* prices, const double* quantities, uint32_t n,
+                                 double limit_price, bool bid) {
+    double sum = 0.0;
+    for (uint32_t i = 0; i < n; ++i) {
+        if (bid ? prices[i] < limit_price : prices[i] > limit_price) {
+            break;
+        }
+        sum += quantities[i];
+    }
+    return sum;
+}
+
+double scalarVwap(const double* prices, const double* quantities, uint32_t n) {
+    double notional = 0.0;
+    double quantity = 0.0;
+    for (uint32_t i = 0; i < n; ++i) {
+        notional += prices[i] * quantities[i];
+        quantity += quantities[i];
+    }
+    return quantity > 0.0 ? notional / quantity : 0.0;
+}
+
+// 从第 start 档开始逐档吃单，返回追加的成交金额
+inline double finishFill(const double* prices, const double* quantities, uint32_t start, uint32_t n,
+                         double target_quantity, double& filled) {
+    double cost = 0.0;
+    for (uint32_t i = start; i < n && filled < target_quantity; ++i) {
+        double take = target_quantity - filled;
+        if (take > quantities[i]) {
+            take = quantities[i];
+        }
+        cost += take * prices[i];
+        filled += take;
+    }
+    return cost;
+}
+
+double scalarCostToFill(const double* prices, const double* quantities, uint32_t n,
+                        double target_quantity, double* filled_quantity) {
+    double filled = 0.0;
+    double cost = finishFill(prices, quantities, 0, n, target_quantity, filled);
+    if (filled_quantity) {
+        *filled_quantity = filled;
+    }
+    return cost;
+}
+
+#if CRYPTO_QUANT_X86
+
+// ---------------------------------------------------------------------------
+// SSE2 实现（每次2档）
+// ---------------------------------------------------------------------------
+
+__attribute__((target("sse2")))
+inline double hsum128(__m128d v) {
+    return _mm_cvtsd_f64(_mm_add_sd(v, _mm_unpackhi_pd(v, v)));
+}
+
+__attribute__((target("sse2")))
+double sse2CumulativeQuantity(const double* quantities, uint32_t n) {
+    __m128d acc = _mm_setzero_pd();
+    uint32_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        acc = _mm_add_pd(acc, _mm_loadu_pd(quantities + i));
+    }
+    double sum = hsum128(acc);
+    for (; i < n; ++i) {
+        sum += quantities[i];
+    }
+    return sum;
+}
+
+__attribute__((target("sse2")))
+double sse2QuantityWithinPrice(const double* prices, const double* quantities, uint32_t n,
+                               double limit_price, bool bid) {
+    // 档位有序，按比较掩码累加即可，无需分支
+    const __m128d limit = _mm_set1_pd(limit_price);
+    __m128d acc = _mm_setzero_pd();
+    uint32_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        __m128d p = _mm_loadu_pd(prices + i);
+        __m128d mask = bid ? _mm_cmpge_pd(p, limit) : _mm_cmple_pd(p, limit);
+        acc = _mm_add_pd(acc, _mm_and_pd(mask, _mm_loadu_pd(quantities + i)));
+    }
+    double sum = hsum128(acc);
+    for (; i < n; ++i) {
+        if (bid ? prices[i] >= limit_price : prices[i] <= limit_price) {
+            sum += quantities[i];
+        }
+    }
+    return sum;
+}
+
+__attribute__((target("sse2")))
+double sse2Vwap(const double* prices, const double* quantities, uint32_t n) {
+    __m128d notional = _mm_setzero_pd();
+    __m128d quantity = _mm_setzero_pd();
+    uint32_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        __m128d q = _mm_loadu_pd(quantities + i);
+        notional = _mm_add_pd(notional, _mm_mul_pd(_mm_loadu_pd(prices + i), q));
+        quantity = _mm_add_pd(quantity, q);
+    }
+    double total_notional = hsum128(notional);
+    double total_quantity = hsum128(quantity);
+    for (; i < n; ++i) {
+        total_notional += prices[i] * quantities[i];
+        total_quantity += quantities[i];
+    }
+    return total_quantity > 0.0 ? total_notional / total_quantity : 0.0;
+}
+
+__attribute__((target("sse2")))
+double sse2CostToFill(const double* prices, const double* quantities, uint32_t n,
+                      double target_quantity, double* filled_quantity) {
+    // 整块可完全成交时用向量乘加，跨越目标数量的那一块再逐档处理
+    double filled = 0.0;
+    double cost = 0.0;
+    uint32_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        __m128d q = _mm_loadu_pd(quantities + i);
+        double block_quantity = hsum128(q);
+        if (filled + block_quantity > target_quantity) {
+            break;
+        }
+        cost += hsum128(_mm_mul_pd(_mm_loadu_pd(prices + i), q));
+        filled += block_quantity;
+    }
+    cost += finishFill(prices, quantities, i, n, target_quantity, filled);
+    if (filled_quantity) {
+        *filled_quantity = filled;
+    }
+    return cost;
+}
+
+// ---------------------------------------------------------------------------
+// AVX2 实现（每次4档）
+// ---------------------------------------------------------------------------
+
+__attribute__((target("avx2")))
+inline double hsum256(__m256d v) {
+    __m128d low = _mm256_castpd256_pd128(v);
+    __m128d high = _mm256_extractf128_pd(v, 1);
+    low = _mm_add_pd(low, high);
+    return _mm_cvtsd_f64(_mm_add_sd(low, _mm_unpackhi_pd(low, low)));
+}
+
+__attribute__((target("avx2")))
+double avx2CumulativeQuantity(const double* quantities, uint32_t n) {
+    __m256d acc = _mm256_setzero_pd();
+    uint32_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        acc = _mm256_add_pd(acc, _mm256_loadu_pd(quantities + i));
+    }
+    double sum = hsum256(acc);
+    for (; i < n; ++i) {
+        sum += quantities[i];
+    }
+    return sum;
+}
+
+__attribute__((target("avx2")))
+double avx2QuantityWithinPrice(const double* prices, const double* quantities, uint32_t n,
+                               double limit_price, bool bid) {
+    const __m256d limit = _mm256_set1_pd(limit_price);
+    __m256d acc = _mm256_setzero_pd();
+    uint32_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d p = _mm256_loadu_pd(prices + i);
+        __m256d mask = bid ? _mm256_cmp_pd(p, limit, _CMP_GE_OQ) : _mm256_cmp_pd(p, limit, _CMP_LE_OQ);
+        acc = _mm256_add_pd(acc, _mm256_and_pd(mask, _mm256_loadu_pd(quantities + i)));
+    }
+    double sum = hsum256(acc);
+    for (; i < n; ++i) {
+        if (bid ? prices[i] >= limit_price : prices[i] <= limit_price) {
+            sum += quantities[i];
+        }
+    }
+    return sum;
+}
+
+__attribute__((target("avx2")))
+double avx2Vwap(const double* prices, const double* quantities, uint32_t n) {
+    __m256d notional = _mm256_setzero_pd();
+    __m256d quantity = _mm256_setzero_pd();
+    uint32_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d q = _mm256_loadu_pd(quantities + i);
+        notional = _mm256_add_pd(notional, _mm256_mul_pd(_mm256_loadu_pd(prices + i), q));
+        quantity = _mm256_add_pd(quantity, q);
+    }
+    double total_notional = hsum256(notional);
+    double total_quantity = hsum256(quantity);
+    for (; i < n; ++i) {
+        total_notional += prices[i] * quantities[i];
+        total_quantity += quantities[i];
+    }
+    return total_quantity > 0.0 ? total_notional / total_quantity : 0.0;
+}
+
+__attribute__((target("avx2")))
+double avx2CostToFill(const double* prices, const double* quantities, uint32_t n,
+                      double target_quantity, double* filled_quantity) {
+    double filled = 0.0;
+    double cost = 0.0;
+    uint32_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d q = _mm256_loadu_pd(quantities + i);
+        double block_quantity = hsum256(q);
+        if (filled + block_quantity > target_quantity) {
+            break;
+        }
+        cost += hsum256(_mm256_mul_pd(_mm256_loadu_pd(prices + i), q));
+        filled += block_quantity;
+    }
+    cost += finishFill(prices, quantities, i, n, target_quantity, filled);
+    if (filled_quantity) {
+        *filled_quantity = filled;
+    }
+    return cost;
+}
+
+#endif // CRYPTO_QUANT_X86
+
+const DepthKernels kScalarKernels = {
+    "scalar",
+    scalarCumulativeQuantity,
+    scalarQuantityWithinPrice,
+    scalarVwap,
+    scalarCostToFill
+};
+
+#if CRYPTO_QUANT_X86
+const DepthKernels kSse2Kernels = {
+    "sse2",
+    sse2CumulativeQuantity,
+    sse2QuantityWithinPrice,
+    sse2Vwap,
+    sse2CostToFill
+};
+
+const DepthKernels kAvx2Kernels = {
+    "avx2",
+    avx2CumulativeQuantity,
+    avx2QuantityWithinPrice,
+    avx2Vwap,
+    avx2CostToFill
+};
+#endif
+
+const DepthKernels& selectKernels() {
+#if CRYPTO_QUANT_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return kAvx2Kernels;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        return kSse2Kernels;
+    }
+#endif
+    return kScalarKernels;
+}
+
+} // namespace
+
+const DepthKernels& depthKernels() {
+    // C++11 保证局部静态变量初始化线程安全
+    static const DepthKernels& kernels = selectKernels();
+    return kernels;
+}
+
+const DepthKernels& scalarDepthKernels() {
+    return kScalarKernels;
+}
+
+const DepthKernels& sse2DepthKernels() {
+#if CRYPTO_QUANT_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse2")) {
+        return kSse2Kernels;
+    }
+#endif
+    return kScalarKernels;
+}
+
+const DepthKernels& avx2DepthKernels() {
+#if CRYPTO_QUANT_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return kAvx2Kernels;
+    }
+#endif
+    return kScalarKernels;
+}
+
+} // namespace crypto_quant
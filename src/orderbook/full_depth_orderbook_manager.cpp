@@ -0,0 +1,795 @@
+#include "full_depth_orderbook_manager.h"
+#include "fixed_point.h"
+#include "symbol_registry.h"
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#ifdef __linux__
+#include <pthread.h>
+#endif
+
+namespace crypto_quant {
+
+namespace {
+
+inline uint64_t nowMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()
+    ).count();
+}
+
+inline int64_t priceToTick(double price, double tick_size) {
+    return static_cast<int64_t>(std::llround(price / tick_size));
+}
+
+} // namespace
+
+const size_t FullDepthOrderbookManager::kMaxBufferedDiffs;
+
+FullDepthOrderbookManager::FullDepthOrderbookManager()
+    : books_(SymbolRegistry::kMaxSymbols), resync_running_(false) {
+}
+
+FullDepthOrderbookManager::~FullDepthOrderbookManager() {
+    stopResync();
+}
+
+FullDepthOrderbookManager::FullDepthBook* FullDepthOrderbookManager::findBook(symbol_t symbol) const {
+    return books_.get(symbol);
+}
+
+FullDepthOrderbookManager::FullDepthBook* FullDepthOrderbookManager::findOrCreateBook(symbol_t symbol) {
+    if (!SymbolRegistry::instance().contains(symbol)) {
+        return nullptr;
+    }
+    // 新订单薄优先使用注册的定点规格作为 tick
+    return books_.getOrCreate(symbol, [](size_t index, FullDepthBook& book) {
+        InstrumentSpec spec;
+        if (FixedPointRegistry::instance().getSpec(static_cast<symbol_t>(index), spec)) {
+            book.tick_size = spec.tickSize();
+        }
+    });
+}
+
+bool FullDepthOrderbookManager::initialize() {
+    // 注册了定点规格的交易对按规格的 tick 建立阶梯
+    size_t symbol_count = SymbolRegistry::instance().size();
+    for (size_t i = 0; i < symbol_count; ++i) {
+        InstrumentSpec spec;
+        if (FixedPointRegistry::instance().getSpec(static_cast<symbol_t>(i), spec)) {
+            setTickSize(static_cast<symbol_t>(i), spec.tickSize());
+        }
+    }
+    spdlog::info("FullDepthOrderbookManager initialized");
+    return true;
+}
+
+void FullDepthOrderbookManager::cleanup() {
+    // 先停止后台重新同步，快照提供者可能引用即将释放的对象
+    stopResync();
+    books_.forEach([](size_t /*index*/, FullDepthBook& book) {
+        std::lock_guard<std::mutex> lock(book.mutex);
+        book.bids.clear();
+        book.asks.clear();
+        book.last_update_id = 0;
+        book.timestamp = 0;
+        book.syncing = false;
+        book.resynced = false;
+        book.buffered.clear();
+        publishTop(book);
+        book.quarantined.store(false, std::memory_order_release);
+    });
+    spdlog::info("FullDepthOrderbookManager cleaned up");
+}
+
+void FullDepthOrderbookManager::setTickSize(symbol_t symbol, double tick_size) {
+    FullDepthBook* book = findOrCreateBook(symbol);
+    if (!book || tick_size <= 0.0) {
+        spdlog::error("Invalid tick size setting: symbol={}, tick_size={}",
+                      symbol, tick_size);
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(book->mutex);
+    book->tick_size = tick_size;
+    book->tick_missing_logged = false;
+    book->bids.clear();
+    book->asks.clear();
+    book->last_update_id = 0;
+    publishTop(*book);
+    spdlog::info("Tick size set: symbol={}, tick_size={}", symbol, tick_size);
+}
+
+bool FullDepthOrderbookManager::resolveTickSize(symbol_t symbol, FullDepthBook& book) {
+    if (book.tick_size > 0.0) {
+        return true;
+    }
+    // 定点规格可能在订单薄创建之后才注册
+    InstrumentSpec spec;
+    if (FixedPointRegistry::instance().getSpec(symbol, spec)) {
+        book.tick_size = spec.tickSize();
+        return true;
+    }
+    if (!book.tick_missing_logged) {
+        book.tick_missing_logged = true;
+        spdlog::error("Full-depth orderbook has no tick size, updates rejected: symbol={} "
+                      "(configure market_data.instruments or call setTickSize)", symbol);
+    }
+    return false;
+}
+
+void FullDepthOrderbookManager::publishTop(FullDepthBook& book) {
+    BookTop& top = book.top.beginWrite();
+    top.bid_price = book.bids.empty() ? 0.0 : book.bids.bestTick() * book.tick_size;
+    top.bid_quantity = book.bids.bestQuantity();
+    top.ask_price = book.asks.empty() ? 0.0 : book.asks.bestTick() * book.tick_size;
+    top.ask_quantity = book.asks.bestQuantity();
+    top.timestamp = book.timestamp;
+    top.last_update_id = book.last_update_id;
+    book.top.endWrite();
+}
+
+void FullDepthOrderbookManager::applyLevels(FullDepthBook& book, PriceLadder& ladder,
+                                            const price_level_t* levels, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        ladder.set(priceToTick(levels[i].price, book.tick_size), levels[i].quantity);
+    }
+}
+
+void FullDepthOrderbookManager::updateOrderbook(const orderbook_t& orderbook) {
+    FullDepthBook* book = findOrCreateBook(orderbook.symbol);
+    if (!book) {
+        spdlog::error("Invalid symbol index: {}", orderbook.symbol);
+        return;
+    }
+
+    // 部分深度快照：整体替换
+    {
+        std::lock_guard<std::mutex> lock(book->mutex);
+        if (!resolveTickSize(orderbook.symbol, *book)) {
+            return;
+        }
+        // 输入的档位直接校验（阶梯会把乱序档位排好，需在写入前发现）
+        OrderbookIntegrityIssue issue = validator_.check(orderbook, book->timestamp,
+                                                         book->last_update_id, nowMs());
+        book->bids.clear();
+        book->asks.clear();
+        applyLevels(*book, book->bids, orderbook.bids,
+                    std::min<uint32_t>(orderbook.bid_count, ORDERBOOK_MAX_LEVELS));
+        applyLevels(*book, book->asks, orderbook.asks,
+                    std::min<uint32_t>(orderbook.ask_count, ORDERBOOK_MAX_LEVELS));
+        book->last_update_id = orderbook.last_update_id;
+        book->timestamp = orderbook.timestamp;
+        publishTop(*book);
+        handleIntegrity(orderbook.symbol, *book, issue, true);
+    }
+    notifyChanged(orderbook.symbol);
+}
+
+DepthDiffResult FullDepthOrderbookManager::applyDepthDiff(const depth_diff_t& diff) {
+    FullDepthBook* book = findOrCreateBook(diff.symbol);
+    if (!book) {
+        spdlog::error("Invalid symbol index: {}", diff.symbol);
+        return DepthDiffResult::OUT_OF_SYNC;
+    }
+
+    DepthDiffResult result;
+    {
+        // 序号检查与应用在同一把锁内，后台装入快照不会插在两者之间
+        std::lock_guard<std::mutex> lock(book->mutex);
+        if (!resolveTickSize(diff.symbol, *book)) {
+            return DepthDiffResult::OUT_OF_SYNC;
+        }
+        if (book->syncing) {
+            bufferDiff(*book, diff);
+            return DepthDiffResult::BUFFERED;
+        }
+
+        uint64_t last_update_id = book->last_update_id;
+        // 已被当前订单薄覆盖的旧事件
+        if (last_update_id != 0 && diff.final_update_id <= last_update_id) {
+            return DepthDiffResult::STALE;
+        }
+
+        // 尚未同步或出现缺口（U > lastUpdateId + 1）：请求快照，期间缓存增量
+        if (last_update_id == 0 || diff.first_update_id > last_update_id + 1) {
+            spdlog::warn("Depth gap detected: symbol={}, last_update_id={}, U={}, u={}",
+                         diff.symbol, last_update_id, diff.first_update_id, diff.final_update_id);
+            if (last_update_id != 0) {
+                validator_.recordSequenceGap();
+                // 快照装入前阶梯已落后于增量流
+                quarantine(diff.symbol, *book, OrderbookIntegrityIssue::SEQUENCE_GAP);
+            }
+            if (!hasSnapshotProvider()) {
+                spdlog::error("Cannot resync orderbook: no snapshot provider, symbol={}", diff.symbol);
+                return DepthDiffResult::OUT_OF_SYNC;
+            }
+            requestResync(diff.symbol, *book);
+            bufferDiff(*book, diff);
+            return DepthDiffResult::BUFFERED;
+        }
+
+        uint64_t now = nowMs();
+        uint64_t previous_timestamp = book->timestamp;
+        mergeDiff(*book, diff);
+        book->timestamp = now;
+        publishTop(*book);
+        OrderbookIntegrityIssue issue = validator_.checkEventAge(diff.event_time, now);
+        if (issue == OrderbookIntegrityIssue::NONE) {
+            issue = checkTop(*book, previous_timestamp, last_update_id, now);
+        }
+        handleIntegrity(diff.symbol, *book, issue, false);
+
+        result = book->resynced ? DepthDiffResult::RESYNCED : DepthDiffResult::APPLIED;
+        book->resynced = false;
+    }
+    notifyChanged(diff.symbol);
+    return result;
+}
+
+void FullDepthOrderbookManager::bufferDiff(FullDepthBook& book, const depth_diff_t& diff) {
+    if (book.buffered.size() >= kMaxBufferedDiffs) {
+        // 快照迟迟未到：丢弃缓存，重放时会发现缺口并再次同步
+        spdlog::warn("Depth diff buffer overflow, dropping {} buffered diffs: symbol={}",
+                     book.buffered.size(), diff.symbol);
+        book.buffered.clear();
+    }
+    book.buffered.push_back(BufferedDiff());
+    BufferedDiff& buffered = book.buffered.back();
+    buffered.diff = diff;
+    buffered.diff.bids = nullptr;
+    buffered.diff.asks = nullptr;
+    buffered.bids.assign(diff.bids, diff.bids + diff.bid_count);
+    buffered.asks.assign(diff.asks, diff.asks + diff.ask_count);
+}
+
+void FullDepthOrderbookManager::mergeDiff(FullDepthBook& book, const depth_diff_t& diff) {
+    applyLevels(book, book.bids, diff.bids, diff.bid_count);
+    applyLevels(book, book.asks, diff.asks, diff.ask_count);
+    book.last_update_id = diff.final_update_id;
+}
+
+bool FullDepthOrderbookManager::replayBuffered(FullDepthBook& book) {
+    size_t next = 0;
+    for (; next < book.buffered.size(); ++next) {
+        BufferedDiff& buffered = book.buffered[next];
+        // 快照已包含的事件丢弃
+        if (buffered.diff.final_update_id <= book.last_update_id) {
+            continue;
+        }
+        if (buffered.diff.first_update_id > book.last_update_id + 1) {
+            break;
+        }
+        depth_diff_t diff = buffered.diff;
+        diff.bids = buffered.bids.data();
+        diff.asks = buffered.asks.data();
+        mergeDiff(book, diff);
+    }
+    book.buffered.erase(book.buffered.begin(), book.buffered.begin() + next);
+    return book.buffered.empty();
+}
+
+void FullDepthOrderbookManager::setSnapshotProvider(DepthSnapshotProvider provider) {
+    std::lock_guard<std::mutex> lock(provider_mutex_);
+    snapshot_provider_ = provider;
+    spdlog::debug("Depth snapshot provider set");
+}
+
+std::shared_ptr<IOrderbookSubscription> FullDepthOrderbookManager::subscribeConflated(symbol_t symbol) {
+    return notifier_.subscribeConflated(symbol);
+}
+
+uint64_t FullDepthOrderbookManager::subscribeEveryUpdate(symbol_t symbol,
+                                                         OrderbookUpdateCallback callback) {
+    return notifier_.subscribeEveryUpdate(symbol, callback);
+}
+
+void FullDepthOrderbookManager::unsubscribe(uint64_t subscription_id) {
+    notifier_.unsubscribe(subscription_id);
+}
+
+uint64_t FullDepthOrderbookManager::droppedUpdates(uint64_t subscription_id) const {
+    return notifier_.droppedUpdates(subscription_id);
+}
+
+bool FullDepthOrderbookManager::setHistoryCapacity(symbol_t symbol, size_t capacity) {
+    FullDepthBook* book = findOrCreateBook(symbol);
+    if (!book) {
+        spdlog::error("Invalid symbol index: {}", symbol);
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(history_mutex_);
+    if (capacity == 0) {
+        // 写线程可能正在记录，对象保留，只停止记录
+        book->history.store(nullptr, std::memory_order_release);
+        if (book->history_storage) {
+            book->history_storage->clear();
+        }
+        spdlog::info("Orderbook history disabled: symbol={}", symbol);
+        return true;
+    }
+    if (!book->history_storage) {
+        book->history_storage.reset(new OrderbookHistory());
+    }
+    book->history_storage->reset(capacity);
+    book->history.store(book->history_storage.get(), std::memory_order_release);
+    spdlog::info("Orderbook history enabled: symbol={}, capacity={}", symbol, capacity);
+    return true;
+}
+
+bool FullDepthOrderbookManager::getOrderbookAt(symbol_t symbol, uint64_t timestamp,
+                                               orderbook_t& orderbook) const {
+    FullDepthBook* book = findBook(symbol);
+    const OrderbookHistory* history = book ? book->history.load(std::memory_order_acquire) : nullptr;
+    return history ? history->getAt(timestamp, orderbook) : false;
+}
+
+size_t FullDepthOrderbookManager::forEachOrderbookInRange(
+        symbol_t symbol, uint64_t from, uint64_t to,
+        const std::function<bool(const orderbook_t&)>& fn) const {
+    FullDepthBook* book = findBook(symbol);
+    const OrderbookHistory* history = book ? book->history.load(std::memory_order_acquire) : nullptr;
+    if (!history || !fn) {
+        return 0;
+    }
+    return history->forEachInRange(from, to, fn);
+}
+
+bool FullDepthOrderbookManager::isQuarantined(symbol_t symbol) const {
+    FullDepthBook* book = findBook(symbol);
+    return book ? book->quarantined.load(std::memory_order_acquire) : false;
+}
+
+orderbook_integrity_stats_t FullDepthOrderbookManager::getIntegrityStats() const {
+    return validator_.stats();
+}
+
+OrderbookIntegrityIssue FullDepthOrderbookManager::checkTop(const FullDepthBook& book,
+                                                            uint64_t previous_timestamp,
+                                                            uint64_t previous_update_id,
+                                                            uint64_t now) {
+    double best_bid = book.bids.empty() ? 0.0 : book.bids.bestTick() * book.tick_size;
+    double best_ask = book.asks.empty() ? 0.0 : book.asks.bestTick() * book.tick_size;
+    return validator_.checkTop(best_bid, best_ask, book.timestamp, book.last_update_id,
+                               previous_timestamp, previous_update_id, now);
+}
+
+bool FullDepthOrderbookManager::hasSnapshotProvider() {
+    std::lock_guard<std::mutex> lock(provider_mutex_);
+    return static_cast<bool>(snapshot_provider_);
+}
+
+void FullDepthOrderbookManager::quarantine(symbol_t symbol, FullDepthBook& book,
+                                           OrderbookIntegrityIssue issue) {
+    if (!book.quarantined.exchange(true, std::memory_order_acq_rel)) {
+        validator_.recordQuarantined();
+        spdlog::warn("Orderbook quarantined: symbol={}, issue={}",
+                     symbol, OrderbookValidator::issueName(issue));
+    }
+}
+
+void FullDepthOrderbookManager::recover(symbol_t symbol, FullDepthBook& book) {
+    if (book.quarantined.exchange(false, std::memory_order_acq_rel)) {
+        validator_.recordRecovered();
+        spdlog::info("Orderbook recovered from quarantine: symbol={}", symbol);
+    }
+}
+
+void FullDepthOrderbookManager::handleIntegrity(symbol_t symbol, FullDepthBook& book,
+                                                OrderbookIntegrityIssue issue, bool full_snapshot) {
+    if (issue == OrderbookIntegrityIssue::NONE) {
+        if (!book.quarantined.load(std::memory_order_relaxed)) {
+            return;
+        }
+        // 合法的完整快照替换了整个订单薄：解除隔离
+        if (full_snapshot) {
+            recover(symbol, book);
+            return;
+        }
+    } else {
+        quarantine(symbol, book, issue);
+    }
+    // 增量应用在损坏的订单薄上仍然是损坏的，只能靠快照恢复（后台线程限频）
+    if (hasSnapshotProvider()) {
+        requestResync(symbol, book);
+    }
+}
+
+void FullDepthOrderbookManager::notifyChanged(symbol_t symbol) {
+    FullDepthBook* book = findBook(symbol);
+    OrderbookHistory* history = book ? book->history.load(std::memory_order_acquire) : nullptr;
+    if (history) {
+        // 开启历史时每次都要生成20档订单薄，顺带交给逐笔订阅者
+        orderbook_t orderbook = getOrderbook(symbol);
+        history->record(orderbook);
+        notifier_.publish(symbol, [&orderbook](orderbook_t& out) {
+            out = orderbook;
+        });
+        return;
+    }
+    // 只有逐笔订阅者需要时才生成20档订单薄（会重新获取订单薄锁）
+    notifier_.publish(symbol, [this, symbol](orderbook_t& out) {
+        out = getOrderbook(symbol);
+    });
+}
+
+void FullDepthOrderbookManager::requestResync(symbol_t symbol, FullDepthBook& book) {
+    if (book.syncing) {
+        return;
+    }
+    book.syncing = true;
+    enqueueResync(symbol);
+}
+
+void FullDepthOrderbookManager::enqueueResync(symbol_t symbol) {
+    std::lock_guard<std::mutex> lock(resync_mutex_);
+    resync_queue_.push_back(symbol);
+    if (!resync_running_) {
+        resync_running_ = true;
+        resync_thread_ = std::thread(&FullDepthOrderbookManager::runResync, this);
+    }
+    resync_cv_.notify_one();
+}
+
+void FullDepthOrderbookManager::stopResync() {
+    {
+        std::lock_guard<std::mutex> lock(resync_mutex_);
+        resync_running_ = false;
+        resync_queue_.clear();
+    }
+    resync_cv_.notify_all();
+    if (resync_thread_.joinable()) {
+        resync_thread_.join();
+    }
+}
+
+void FullDepthOrderbookManager::runResync() {
+#ifdef __linux__
+    pthread_setname_np(pthread_self(), "fd-resync");
+#endif
+    std::unique_lock<std::mutex> lock(resync_mutex_);
+    while (resync_running_) {
+        if (resync_queue_.empty()) {
+            resync_cv_.wait(lock);
+            continue;
+        }
+        // 取第一个已过限频间隔的请求，都未到期时等到最早到期的那个
+        uint64_t now = nowMs();
+        uint64_t wait_ms = kMinResyncIntervalMs;
+        std::deque<symbol_t>::iterator ready = resync_queue_.end();
+        for (std::deque<symbol_t>::iterator it = resync_queue_.begin(); it != resync_queue_.end(); ++it) {
+            uint64_t elapsed = now - findBook(*it)->last_resync_ms.load(std::memory_order_relaxed);
+            if (elapsed >= kMinResyncIntervalMs) {
+                ready = it;
+                break;
+            }
+            wait_ms = std::min(wait_ms, kMinResyncIntervalMs - elapsed);
+        }
+        if (ready == resync_queue_.end()) {
+            resync_cv_.wait_for(lock, std::chrono::milliseconds(wait_ms));
+            continue;
+        }
+        symbol_t symbol = *ready;
+        resync_queue_.erase(ready);
+        lock.unlock();
+        resync(symbol, *findBook(symbol));
+        lock.lock();
+    }
+}
+
+void FullDepthOrderbookManager::resync(symbol_t symbol, FullDepthBook& book) {
+    DepthSnapshotProvider provider;
+    {
+        std::lock_guard<std::mutex> lock(provider_mutex_);
+        provider = snapshot_provider_;
+    }
+    book.last_resync_ms.store(nowMs(), std::memory_order_relaxed);
+
+    // 获取快照时不持有订单薄锁，写线程继续缓存增量
+    DepthSnapshot snapshot;
+    bool fetched = provider && provider(symbol, snapshot);
+    validator_.recordResync(fetched);
+
+    {
+        std::lock_guard<std::mutex> lock(book.mutex);
+        if (!fetched) {
+            spdlog::error("Orderbook resync failed: symbol={}", symbol);
+            // 放弃缓存的增量，下一个增量重新发现缺口并再次请求（限频）
+            book.syncing = false;
+            book.buffered.clear();
+            if (book.last_update_id != 0) {
+                quarantine(symbol, book, OrderbookIntegrityIssue::SEQUENCE_GAP);
+            }
+            return;
+        }
+
+        // 阶梯整体替换为快照，再按序重放期间缓存的增量
+        uint64_t now = nowMs();
+        book.bids.clear();
+        book.asks.clear();
+        applyLevels(book, book.bids, snapshot.bids.data(), snapshot.bids.size());
+        applyLevels(book, book.asks, snapshot.asks.data(), snapshot.asks.size());
+        book.last_update_id = snapshot.last_update_id;
+        bool caught_up = replayBuffered(book);
+        book.timestamp = now;
+        publishTop(book);
+        // 快照整体替换订单薄，不与之前的时间戳、更新ID比较
+        OrderbookIntegrityIssue issue = checkTop(book, 0, 0, now);
+        if (caught_up) {
+            book.syncing = false;
+            book.resynced = true;
+            handleIntegrity(symbol, book, issue, true);
+        } else {
+            // 快照落后于缓存的增量：保持同步中，再取一次快照
+            quarantine(symbol, book, issue != OrderbookIntegrityIssue::NONE
+                                         ? issue : OrderbookIntegrityIssue::SEQUENCE_GAP);
+            enqueueResync(symbol);
+        }
+        spdlog::info("Full-depth orderbook resynced: symbol={}, last_update_id={}, replayed_to={}, "
+                     "caught_up={}, bids={}, asks={}",
+                     symbol, snapshot.last_update_id, book.last_update_id, caught_up,
+                     book.bids.size(), book.asks.size());
+    }
+    // 快照本身已经改变了订单薄
+    notifyChanged(symbol);
+}
+
+orderbook_t FullDepthOrderbookManager::getOrderbook(symbol_t symbol) const {
+    orderbook_t orderbook;
+    memset(&orderbook, 0, sizeof(orderbook));
+
+    orderbook.symbol = symbol;
+    FullDepthBook* book = findBook(symbol);
+    if (!book) {
+        if (!SymbolRegistry::instance().contains(symbol)) {
+            spdlog::error("Invalid symbol index: {}", symbol);
+        }
+        return orderbook;
+    }
+
+    // 按需从全深度阶梯生成20档订单薄
+    std::lock_guard<std::mutex> lock(book->mutex);
+    orderbook.symbol = symbol;
+    orderbook.timestamp = book->timestamp;
+    orderbook.last_update_id = book->last_update_id;
+    orderbook.bid_count = static_cast<uint32_t>(
+        getLevelsLocked(*book, book->bids, orderbook.bids, ORDERBOOK_MAX_LEVELS));
+    orderbook.ask_count = static_cast<uint32_t>(
+        getLevelsLocked(*book, book->asks, orderbook.asks, ORDERBOOK_MAX_LEVELS));
+    return orderbook;
+}
+
+double FullDepthOrderbookManager::getBestBid(symbol_t symbol) const {
+    FullDepthBook* book = findBook(symbol);
+    if (!book) {
+        return 0.0;
+    }
+    double price = 0.0;
+    book->top.read([&price](const BookTop& top) { price = top.bid_price; });
+    return price;
+}
+
+double FullDepthOrderbookManager::getBestAsk(symbol_t symbol) const {
+    FullDepthBook* book = findBook(symbol);
+    if (!book) {
+        return 0.0;
+    }
+    double price = 0.0;
+    book->top.read([&price](const BookTop& top) { price = top.ask_price; });
+    return price;
+}
+
+double FullDepthOrderbookManager::getMidPrice(symbol_t symbol) const {
+    FullDepthBook* book = findBook(symbol);
+    if (!book) {
+        return 0.0;
+    }
+    BookTop top = book->top.load();
+    if (top.bid_price > 0 && top.ask_price > 0) {
+        return (top.bid_price + top.ask_price) / 2.0;
+    }
+    return 0.0;
+}
+
+double FullDepthOrderbookManager::getSpread(symbol_t symbol) const {
+    FullDepthBook* book = findBook(symbol);
+    if (!book) {
+        return 0.0;
+    }
+    BookTop top = book->top.load();
+    if (top.bid_price > 0 && top.ask_price > 0) {
+        return top.ask_price - top.bid_price;
+    }
+    return 0.0;
+}
+
+double FullDepthOrderbookManager::sumDepth(const PriceLadder& ladder, int levels) {
+    double depth = 0.0;
+    int remaining = levels;
+    ladder.forEachLevel([&depth, &remaining](int64_t /*tick*/, double quantity) {
+        depth += quantity;
+        return --remaining > 0;
+    });
+    return depth;
+}
+
+double FullDepthOrderbookManager::getBidDepth(symbol_t symbol, int levels) const {
+    FullDepthBook* book = findBook(symbol);
+    if (!book || levels <= 0) {
+        return 0.0;
+    }
+    std::lock_guard<std::mutex> lock(book->mutex);
+    return sumDepth(book->bids, levels);
+}
+
+double FullDepthOrderbookManager::getAskDepth(symbol_t symbol, int levels) const {
+    FullDepthBook* book = findBook(symbol);
+    if (!book || levels <= 0) {
+        return 0.0;
+    }
+    std::lock_guard<std::mutex> lock(book->mutex);
+    return sumDepth(book->asks, levels);
+}
+
+// 全深度档位数不固定，阶梯本身不是连续数组，这里按档位遍历并提前终止
+double FullDepthOrderbookManager::getDepthWithinBps(symbol_t symbol, double bps, bool bid) const {
+    FullDepthBook* book = findBook(symbol);
+    if (!book || bps < 0.0) {
+        return 0.0;
+    }
+    std::lock_guard<std::mutex> lock(book->mutex);
+    if (book->bids.empty() || book->asks.empty()) {
+        return 0.0;
+    }
+    const double tick_size = book->tick_size;
+    double mid = (book->bids.bestTick() + book->asks.bestTick()) * tick_size / 2.0;
+    double limit = bid ? mid - mid * bps / 10000.0 : mid + mid * bps / 10000.0;
+    double depth = 0.0;
+    (bid ? book->bids : book->asks).forEachLevel([&](int64_t tick, double quantity) {
+        double price = tick * tick_size;
+        if (bid ? price < limit : price > limit) {
+            return false;
+        }
+        depth += quantity;
+        return true;
+    });
+    return depth;
+}
+
+double FullDepthOrderbookManager::getVwap(symbol_t symbol, int levels, bool bid) const {
+    FullDepthBook* book = findBook(symbol);
+    if (!book || levels <= 0) {
+        return 0.0;
+    }
+    std::lock_guard<std::mutex> lock(book->mutex);
+    const double tick_size = book->tick_size;
+    double notional = 0.0;
+    double quantity = 0.0;
+    int remaining = levels;
+    (bid ? book->bids : book->asks).forEachLevel([&](int64_t tick, double level_quantity) {
+        notional += tick * tick_size * level_quantity;
+        quantity += level_quantity;
+        return --remaining > 0;
+    });
+    return quantity > 0.0 ? notional / quantity : 0.0;
+}
+
+double FullDepthOrderbookManager::getCostToFill(symbol_t symbol, double quantity, bool buy,
+                                                double* filled_quantity) const {
+    if (filled_quantity) {
+        *filled_quantity = 0.0;
+    }
+    FullDepthBook* book = findBook(symbol);
+    if (!book || quantity <= 0.0) {
+        return 0.0;
+    }
+    std::lock_guard<std::mutex> lock(book->mutex);
+    const double tick_size = book->tick_size;
+    double cost = 0.0;
+    double filled = 0.0;
+    // 买入吃卖盘，卖出吃买盘
+    (buy ? book->asks : book->bids).forEachLevel([&](int64_t tick, double level_quantity) {
+        double take = std::min(quantity - filled, level_quantity);
+        cost += take * tick * tick_size;
+        filled += take;
+        return filled < quantity;
+    });
+    if (filled_quantity) {
+        *filled_quantity = filled;
+    }
+    return cost;
+}
+
+uint64_t FullDepthOrderbookManager::getTimestamp(symbol_t symbol) const {
+    FullDepthBook* book = findBook(symbol);
+    if (!book) {
+        return 0;
+    }
+    uint64_t timestamp = 0;
+    book->top.read([&timestamp](const BookTop& top) { timestamp = top.timestamp; });
+    return timestamp;
+}
+
+bool FullDepthOrderbookManager::isValid(symbol_t symbol) const {
+    FullDepthBook* book = findBook(symbol);
+    if (!book) {
+        return false;
+    }
+    if (book->quarantined.load(std::memory_order_acquire)) {
+        return false;
+    }
+    BookTop top = book->top.load();
+    return top.bid_price > 0 && top.ask_price > 0;
+}
+
+size_t FullDepthOrderbookManager::getTopOfBook(const symbol_t* symbols, size_t count,
+                                               top_of_book_t* out) const {
+    size_t valid_count = 0;
+    for (size_t i = 0; i < count; ++i) {
+        top_of_book_t& result = out[i];
+        memset(&result, 0, sizeof(result));
+        result.symbol = symbols[i];
+        FullDepthBook* book = findBook(symbols[i]);
+        if (!book) {
+            continue;
+        }
+
+        // 盘口摘要已由顺序锁发布，无需加订单薄锁
+        BookTop top = book->top.load();
+        result.timestamp = top.timestamp;
+        result.last_update_id = top.last_update_id;
+        result.bid_price = top.bid_price;
+        result.bid_quantity = top.bid_quantity;
+        result.ask_price = top.ask_price;
+        result.ask_quantity = top.ask_quantity;
+        if (top.bid_price > 0 && top.ask_price > 0 &&
+            !book->quarantined.load(std::memory_order_acquire)) {
+            result.valid = 1;
+            result.mid_price = (top.bid_price + top.ask_price) / 2.0;
+            result.spread = top.ask_price - top.bid_price;
+            ++valid_count;
+        }
+    }
+    return valid_count;
+}
+
+size_t FullDepthOrderbookManager::getLevelCount(symbol_t symbol, bool bid) const {
+    FullDepthBook* book = findBook(symbol);
+    if (!book) {
+        return 0;
+    }
+    std::lock_guard<std::mutex> lock(book->mutex);
+    return bid ? book->bids.size() : book->asks.size();
+}
+
+size_t FullDepthOrderbookManager::getLevels(symbol_t symbol, bool bid, price_level_t* out,
+                                            size_t max_levels) const {
+    FullDepthBook* book = findBook(symbol);
+    if (!book || !out) {
+        return 0;
+    }
+    std::lock_guard<std::mutex> lock(book->mutex);
+    return getLevelsLocked(*book, bid ? book->bids : book->asks, out, max_levels);
+}
+
+size_t FullDepthOrderbookManager::getLevelsLocked(const FullDepthBook& book, const PriceLadder& ladder,
+                                                  price_level_t* out, size_t max_levels) {
+    size_t count = 0;
+    if (max_levels == 0) {
+        return 0;
+    }
+    const double tick_size = book.tick_size;
+    const uint64_t timestamp = book.timestamp;
+    ladder.forEachLevel([&](int64_t tick, double quantity) {
+        out[count].price = tick * tick_size;
+        out[count].quantity = quantity;
+        out[count].timestamp = timestamp;
+        return ++count < max_levels;
+    });
+    return count;
+}
+
+} // namespace crypto_quant
@@ -0,0 +1,307 @@
+#include "l3_orderbook.h"
+#include <cmath>
+#include <cstring>
+
+namespace crypto_quant {
+
+L3Orderbook::L3Orderbook(symbol_t symbol, double tick_size)
+    : symbol_(symbol),
+      tick_size_(tick_size > 0.0 ? tick_size : 0.0),
+      bids_(true),
+      asks_(false),
+      last_timestamp_(0) {
+}
+
+void L3Orderbook::setTickSize(double tick_size) {
+    if (tick_size <= 0.0) {
+        return;
+    }
+    clear();
+    tick_size_ = tick_size;
+}
+
+bool L3Orderbook::toTick(double price, int64_t& tick) const {
+    if (!(price > 0.0) || tick_size_ <= 0.0) {
+        return false;
+    }
+    tick = static_cast<int64_t>(std::llround(price / tick_size_));
+    return tick > 0;
+}
+
+const L3Orderbook::Level* L3Orderbook::findLevel(uint32_t side, int64_t tick) const {
+    const uint32_t* index = level_index_.find(levelKey(side, tick));
+    return index ? &levels_[*index] : nullptr;
+}
+
+void L3Orderbook::publishLevel(Level& level) {
+    if (level.order_count > 0 && level.quantity <= 0.0) {
+        // 浮点累计误差使合计数量不为正：重新求和
+        level.quantity = 0.0;
+        for (uint32_t index = level.head; index != kNull; index = nodes_[index].next) {
+            level.quantity += nodes_[index].quantity;
+        }
+    }
+    ladder(level.side).set(level.tick, level.quantity);
+}
+
+void L3Orderbook::link(uint32_t node_index, uint32_t side, int64_t tick, uint64_t timestamp) {
+    uint64_t key = levelKey(side, tick);
+    uint32_t* found = level_index_.find(key);
+    uint32_t level_index;
+    if (found) {
+        level_index = *found;
+    } else {
+        level_index = levels_.acquire();
+        Level& level = levels_[level_index];
+        level.tick = tick;
+        level.quantity = 0.0;
+        level.head = kNull;
+        level.tail = kNull;
+        level.order_count = 0;
+        level.side = side;
+        level_index_.insert(key, level_index);
+    }
+
+    Level& level = levels_[level_index];
+    OrderNode& node = nodes_[node_index];
+    node.level = level_index;
+    node.prev = level.tail;
+    node.next = kNull;
+    if (level.tail != kNull) {
+        nodes_[level.tail].next = node_index;
+    } else {
+        level.head = node_index;
+    }
+    level.tail = node_index;
+    ++level.order_count;
+    level.quantity += node.quantity;
+    level.timestamp = timestamp;
+    publishLevel(level);
+}
+
+void L3Orderbook::unlink(uint32_t node_index, uint64_t timestamp) {
+    OrderNode& node = nodes_[node_index];
+    uint32_t level_index = node.level;
+    Level& level = levels_[level_index];
+
+    if (node.prev != kNull) {
+        nodes_[node.prev].next = node.next;
+    } else {
+        level.head = node.next;
+    }
+    if (node.next != kNull) {
+        nodes_[node.next].prev = node.prev;
+    } else {
+        level.tail = node.prev;
+    }
+    node.prev = kNull;
+    node.next = kNull;
+    node.level = kNull;
+
+    if (--level.order_count == 0) {
+        // 档位清空：从阶梯和索引中删除
+        level.quantity = 0.0;
+        publishLevel(level);
+        level_index_.erase(levelKey(level.side, level.tick));
+        levels_.release(level_index);
+        return;
+    }
+    level.quantity -= node.quantity;
+    level.timestamp = timestamp;
+    publishLevel(level);
+}
+
+bool L3Orderbook::add(uint64_t order_id, order_side_t side, double price, double quantity,
+                      uint64_t timestamp) {
+    int64_t tick;
+    if (!(quantity > 0.0) || !toTick(price, tick) ||
+        (side != ORDER_SIDE_BUY && side != ORDER_SIDE_SELL)) {
+        return false;
+    }
+    uint32_t node_index = nodes_.acquire();
+    if (!orders_.insert(order_id, node_index)) {
+        nodes_.release(node_index);
+        return false;
+    }
+    OrderNode& node = nodes_[node_index];
+    node.order_id = order_id;
+    node.quantity = quantity;
+    node.timestamp = timestamp;
+    link(node_index, side, tick, timestamp);
+    last_timestamp_ = timestamp;
+    return true;
+}
+
+bool L3Orderbook::modify(uint64_t order_id, double price, double quantity, uint64_t timestamp) {
+    const uint32_t* found = orders_.find(order_id);
+    if (!found) {
+        return false;
+    }
+    if (!(quantity > 0.0)) {
+        return cancel(order_id);
+    }
+    int64_t tick;
+    if (!toTick(price, tick)) {
+        return false;
+    }
+
+    uint32_t node_index = *found;
+    OrderNode& node = nodes_[node_index];
+    Level& level = levels_[node.level];
+    if (level.tick == tick && quantity <= node.quantity) {
+        // 原地减量，保留排队位置
+        level.quantity -= node.quantity - quantity;
+        node.quantity = quantity;
+        level.timestamp = timestamp;
+        publishLevel(level);
+    } else {
+        // 改价或加量：失去排队优先级，移到新档位队尾
+        uint32_t side = level.side;
+        unlink(node_index, timestamp);
+        node.quantity = quantity;
+        node.timestamp = timestamp;
+        link(node_index, side, tick, timestamp);
+    }
+    last_timestamp_ = timestamp;
+    return true;
+}
+
+bool L3Orderbook::cancel(uint64_t order_id) {
+    const uint32_t* found = orders_.find(order_id);
+    if (!found) {
+        return false;
+    }
+    uint32_t node_index = *found;
+    unlink(node_index, last_timestamp_);
+    orders_.erase(order_id);
+    nodes_.release(node_index);
+    return true;
+}
+
+bool L3Orderbook::execute(uint64_t order_id, double quantity, uint64_t timestamp) {
+    const uint32_t* found = orders_.find(order_id);
+    if (!found || !(quantity > 0.0)) {
+        return false;
+    }
+    uint32_t node_index = *found;
+    OrderNode& node = nodes_[node_index];
+    last_timestamp_ = timestamp;
+    if (quantity >= node.quantity) {
+        unlink(node_index, timestamp);
+        orders_.erase(order_id);
+        nodes_.release(node_index);
+        return true;
+    }
+    Level& level = levels_[node.level];
+    node.quantity -= quantity;
+    level.quantity -= quantity;
+    level.timestamp = timestamp;
+    publishLevel(level);
+    return true;
+}
+
+bool L3Orderbook::apply(const l3_event_t& event) {
+    switch (event.type) {
+    case L3_EVENT_ADD:
+        return add(event.order_id, static_cast<order_side_t>(event.side), event.price,
+                   event.quantity, event.timestamp);
+    case L3_EVENT_MODIFY:
+        return modify(event.order_id, event.price, event.quantity, event.timestamp);
+    case L3_EVENT_CANCEL:
+        if (event.timestamp > last_timestamp_) {
+            last_timestamp_ = event.timestamp;
+        }
+        return cancel(event.order_id);
+    case L3_EVENT_EXECUTE:
+        return execute(event.order_id, event.quantity, event.timestamp);
+    case L3_EVENT_CLEAR:
+        clear();
+        last_timestamp_ = event.timestamp;
+        return true;
+    default:
+        return false;
+    }
+}
+
+void L3Orderbook::clear() {
+    nodes_.clear();
+    levels_.clear();
+    orders_.clear();
+    level_index_.clear();
+    bids_.clear();
+    asks_.clear();
+}
+
+size_t L3Orderbook::levelCount(order_side_t side) const {
+    return ladder(side).size();
+}
+
+double L3Orderbook::bestPrice(order_side_t side) const {
+    const PriceLadder& l = ladder(side);
+    return l.empty() ? 0.0 : static_cast<double>(l.bestTick()) * tick_size_;
+}
+
+size_t L3Orderbook::ordersAtPrice(order_side_t side, double price, double* total_quantity) const {
+    if (total_quantity) {
+        *total_quantity = 0.0;
+    }
+    int64_t tick;
+    if (!toTick(price, tick)) {
+        return 0;
+    }
+    const Level* level = findLevel(side, tick);
+    if (!level) {
+        return 0;
+    }
+    if (total_quantity) {
+        *total_quantity = level->quantity;
+    }
+    return level->order_count;
+}
+
+double L3Orderbook::queueAhead(uint64_t order_id) const {
+    const uint32_t* found = orders_.find(order_id);
+    if (!found) {
+        return -1.0;
+    }
+    double ahead = 0.0;
+    for (uint32_t index = nodes_[*found].prev; index != kNull; index = nodes_[index].prev) {
+        ahead += nodes_[index].quantity;
+    }
+    return ahead;
+}
+
+bool L3Orderbook::getOrder(uint64_t order_id, order_side_t& side, double& price, double& quantity) const {
+    const uint32_t* found = orders_.find(order_id);
+    if (!found) {
+        return false;
+    }
+    const OrderNode& node = nodes_[*found];
+    const Level& level = levels_[node.level];
+    side = static_cast<order_side_t>(level.side);
+    price = static_cast<double>(level.tick) * tick_size_;
+    quantity = node.quantity;
+    return true;
+}
+
+void L3Orderbook::toOrderbook(orderbook_t& orderbook) const {
+    memset(&orderbook, 0, sizeof(orderbook));
+    orderbook.symbol = symbol_;
+    orderbook.timestamp = last_timestamp_;
+
+    for (uint32_t side = 0; side < 2; ++side) {
+        price_level_t* out = side == ORDER_SIDE_BUY ? orderbook.bids : orderbook.asks;
+        uint32_t& count = side == ORDER_SIDE_BUY ? orderbook.bid_count : orderbook.ask_count;
+        const L3Orderbook* self = this;
+        ladder(side).forEachLevel([&out, &count, self, side](int64_t tick, double quantity) {
+            price_level_t& level = out[count++];
+            level.price = static_cast<double>(tick) * self->tick_size_;
+            level.quantity = quantity;
+            const Level* found = self->findLevel(side, tick);
+            level.timestamp = found ? found->timestamp : 0;
+            return count < 20;
+        });
+    }
+}
+
+} // namespace crypto_quant
@@ -0,0 +1,145 @@
+#include "l3_orderbook_manager.h"
+#include "fixed_point.h"
+#include "symbol_registry.h"
+#include <spdlog/spdlog.h>
+
+namespace crypto_quant {
+
+L3OrderbookManager::L3OrderbookManager(std::shared_ptr<IOrderbookManager> target)
+    : target_(target), applied_(0), rejected_(0) {
+}
+
+L3OrderbookManager::BookEntry* L3OrderbookManager::findOrCreate(symbol_t symbol) {
+    if (symbol < books_.size() && books_[symbol]) {
+        return books_[symbol].get();
+    }
+    if (!SymbolRegistry::instance().contains(symbol)) {
+        return nullptr;
+    }
+    if (symbol >= books_.size()) {
+        books_.resize(symbol + 1);
+    }
+    // tick 在首个事件时从定点规格解析（setTickSize 可先行设置）
+    books_[symbol].reset(new BookEntry(symbol, 0.0));
+    return books_[symbol].get();
+}
+
+bool L3OrderbookManager::resolveTickSize(BookEntry& entry) {
+    if (entry.book.hasTickSize()) {
+        return true;
+    }
+    // 定点规格可能在订单薄创建之后才注册
+    InstrumentSpec spec;
+    if (FixedPointRegistry::instance().getSpec(entry.book.symbol(), spec)) {
+        entry.book.setTickSize(spec.tickSize());
+        return true;
+    }
+    if (!entry.tick_missing_logged) {
+        entry.tick_missing_logged = true;
+        spdlog::error("L3 orderbook has no tick size, events rejected: symbol={} "
+                      "(configure market_data.instruments or call setTickSize)", entry.book.symbol());
+    }
+    return false;
+}
+
+bool L3OrderbookManager::setTickSize(symbol_t symbol, double tick_size) {
+    BookEntry* entry = findOrCreate(symbol);
+    if (!entry || tick_size <= 0.0) {
+        spdlog::error("Cannot set L3 tick size: symbol={}, tick_size={}", symbol, tick_size);
+        return false;
+    }
+    entry->book.setTickSize(tick_size);
+    ++entry->sequence;
+    publishEntry(*entry);
+    return true;
+}
+
+bool L3OrderbookManager::applyEvent(const l3_event_t& event, BookEntry*& entry) {
+    entry = findOrCreate(event.symbol);
+    if (!entry) {
+        spdlog::error("Invalid symbol index: {}", event.symbol);
+        ++rejected_;
+        return false;
+    }
+    if (!resolveTickSize(*entry)) {
+        ++rejected_;
+        return false;
+    }
+    if (!entry->book.apply(event)) {
+        spdlog::debug("L3 event rejected: symbol={}, type={}, order_id={}",
+                      event.symbol, event.type, event.order_id);
+        ++rejected_;
+        return false;
+    }
+    ++entry->sequence;
+    ++applied_;
+    return true;
+}
+
+void L3OrderbookManager::publishEntry(BookEntry& entry) {
+    entry.dirty = false;
+    if (!target_) {
+        return;
+    }
+    orderbook_t orderbook;
+    entry.book.toOrderbook(orderbook);
+    orderbook.last_update_id = entry.sequence;
+    target_->updateOrderbook(orderbook);
+}
+
+bool L3OrderbookManager::apply(const l3_event_t& event) {
+    BookEntry* entry = nullptr;
+    if (!applyEvent(event, entry)) {
+        return false;
+    }
+    publishEntry(*entry);
+    return true;
+}
+
+size_t L3OrderbookManager::applyBatch(const l3_event_t* events, size_t count) {
+    size_t applied = 0;
+    touched_.clear();
+    for (size_t i = 0; i < count; ++i) {
+        BookEntry* entry = nullptr;
+        if (!applyEvent(events[i], entry)) {
+            continue;
+        }
+        ++applied;
+        if (!entry->dirty) {
+            entry->dirty = true;
+            touched_.push_back(events[i].symbol);
+        }
+    }
+    for (size_t i = 0; i < touched_.size(); ++i) {
+        publishEntry(*books_[touched_[i]]);
+    }
+    return applied;
+}
+
+bool L3OrderbookManager::publish(symbol_t symbol) {
+    if (symbol >= books_.size() || !books_[symbol]) {
+        return false;
+    }
+    publishEntry(*books_[symbol]);
+    return true;
+}
+
+L3Orderbook* L3OrderbookManager::getBook(symbol_t symbol) {
+    return symbol < books_.size() && books_[symbol] ? &books_[symbol]->book : nullptr;
+}
+
+const L3Orderbook* L3OrderbookManager::getBook(symbol_t symbol) const {
+    return symbol < books_.size() && books_[symbol] ? &books_[symbol]->book : nullptr;
+}
+
+orderbook_t L3OrderbookManager::getOrderbook(symbol_t symbol) const {
+    orderbook_t orderbook = {};
+    orderbook.symbol = symbol;
+    if (symbol < books_.size() && books_[symbol]) {
+        books_[symbol]->book.toOrderbook(orderbook);
+        orderbook.last_update_id = books_[symbol]->sequence;
+    }
+    return orderbook;
+}
+
+} // namespace crypto_quant
@@ -0,0 +1,324 @@
+#include "orderbook_history.h"
+#include <cstring>
+
+namespace crypto_quant {
+
+namespace {
+
+inline uint32_t clampLevels(uint32_t count) {
+    return count < ORDERBOOK_MAX_LEVELS ? count : ORDERBOOK_MAX_LEVELS;
+}
+
+// a 是否排在 b 之前（买盘价格高者在前，卖盘价格低者在前）
+inline bool before(double a, double b, bool descending) {
+    return descending ? a > b : a < b;
+}
+
+} // namespace
+
+OrderbookHistory::OrderbookHistory(size_t capacity, size_t keyframe_interval, size_t delta_levels)
+    : generation_(0) {
+    reset(capacity, keyframe_interval, delta_levels);
+}
+
+void OrderbookHistory::reset(size_t capacity, size_t keyframe_interval, size_t delta_levels) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    keyframe_interval_ = keyframe_interval > 0 ? keyframe_interval : kDefaultKeyframeInterval;
+    capacity_ = capacity;
+    // 记录环多留一个全量帧间隔：最早的 capacity 条之前的全量帧记录也还在环内
+    const size_t slots = capacity > 0 ? capacity + keyframe_interval_ : 0;
+    records_.assign(slots, Record());
+    // 差分档位池按平均差分预留（另加一条满差分），超出时 record 改存全量帧；
+    // 全量帧环容纳两倍的定期全量帧，留给差分过大或档位池不足时补存的全量帧
+    changes_.assign(slots > 0 ? capacity * delta_levels + kMaxDeltaLevels : 0, LevelChange());
+    keyframes_.assign(slots > 0 ? 2 * (slots / keyframe_interval_) + 2 : 0, Keyframe());
+    // 释放上一次分配多出的容量
+    std::vector<Record>(records_).swap(records_);
+    std::vector<LevelChange>(changes_).swap(changes_);
+    std::vector<Keyframe>(keyframes_).swap(keyframes_);
+    record_count_ = 0;
+    change_count_ = 0;
+    keyframe_count_ = 0;
+    last_keyframe_record_ = 0;
+    oldest_protected_ = 0;
+    last_timestamp_ = 0;
+    ++generation_;
+    delta_records_ = 0;
+    delta_levels_total_ = 0;
+    memset(&last_, 0, sizeof(last_));
+}
+
+void OrderbookHistory::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++generation_;
+    delta_records_ = 0;
+    delta_levels_total_ = 0;
+    record_count_ = 0;
+    change_count_ = 0;
+    keyframe_count_ = 0;
+    last_keyframe_record_ = 0;
+    oldest_protected_ = 0;
+    last_timestamp_ = 0;
+    memset(&last_, 0, sizeof(last_));
+}
+
+size_t OrderbookHistory::capacity() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return capacity_;
+}
+
+size_t OrderbookHistory::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (records_.empty()) {
+        return 0;
+    }
+    return static_cast<size_t>(record_count_ - firstValid());
+}
+
+size_t OrderbookHistory::memoryBytes() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return records_.capacity() * sizeof(Record) + changes_.capacity() * sizeof(LevelChange) +
+           keyframes_.capacity() * sizeof(Keyframe);
+}
+
+double OrderbookHistory::averageDeltaLevels() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return delta_records_ > 0 ? static_cast<double>(delta_levels_total_) / delta_records_ : 0.0;
+}
+
+bool OrderbookHistory::diffSide(const price_level_t* prev, uint32_t prev_count,
+                                const price_level_t* next, uint32_t next_count,
+                                bool descending, uint32_t side,
+                                LevelChange* changes, size_t& change_count, size_t max_changes) {
+    uint32_t i = 0;
+    uint32_t j = 0;
+    while (i < prev_count || j < next_count) {
+        LevelChange change;
+        change.side = side;
+        if (j == next_count || (i < prev_count && before(prev[i].price, next[j].price, descending))) {
+            // 价格消失：删除
+            change.level.price = prev[i].price;
+            change.level.quantity = 0.0;
+            change.level.timestamp = 0;
+            ++i;
+        } else if (i == prev_count || before(next[j].price, prev[i].price, descending)) {
+            // 新价格
+            change.level = next[j];
+            ++j;
+        } else {
+            // 同一价格：数量或时间戳变化才记录
+            bool same = prev[i].quantity == next[j].quantity && prev[i].timestamp == next[j].timestamp;
+            change.level = next[j];
+            ++i;
+            ++j;
+            if (same) {
+                continue;
+            }
+        }
+        if (change_count >= max_changes) {
+            return false;
+        }
+        changes[change_count++] = change;
+    }
+    return true;
+}
+
+void OrderbookHistory::record(const orderbook_t& orderbook) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (records_.empty()) {
+        return;
+    }
+
+    const uint64_t seq = record_count_;
+    Record& rec = records_[seq % records_.size()];
+    rec.timestamp = orderbook.timestamp > last_timestamp_ ? orderbook.timestamp : last_timestamp_;
+    rec.last_update_id = orderbook.last_update_id;
+    rec.change_begin = change_count_;
+    last_timestamp_ = rec.timestamp;
+
+    const uint32_t bid_count = clampLevels(orderbook.bid_count);
+    const uint32_t ask_count = clampLevels(orderbook.ask_count);
+
+    LevelChange changes[kMaxDeltaLevels];
+    size_t change_count = 0;
+    // 容量小于全量帧间隔时按容量插入全量帧，否则差分记录会因全量帧被覆盖而无法重建
+    const uint64_t interval = keyframe_interval_ < records_.size() ? keyframe_interval_ : records_.size();
+    bool keyframe = seq == 0 || seq - last_keyframe_record_ >= interval;
+    if (!keyframe) {
+        keyframe = !diffSide(last_.bids, last_.bid_count, orderbook.bids, bid_count, true, 0,
+                             changes, change_count, kMaxDeltaLevels) ||
+                   !diffSide(last_.asks, last_.ask_count, orderbook.asks, ask_count, false, 1,
+                             changes, change_count, kMaxDeltaLevels);
+    }
+    if (!keyframe) {
+        // 最近 capacity 条中最早可重建的一条，其重建链从全量帧的下一条记录开始；
+        // 写入差分会覆盖这条链用到的差分时改存全量帧。已无法重建的记录不再保护，
+        // 变化超出预算时全量帧环绕回后差分可以继续写入
+        if (oldest_protected_ + capacity_ <= seq) {
+            oldest_protected_ = seq + 1 - capacity_;
+        }
+        while (oldest_protected_ < seq && !reconstructible(oldest_protected_)) {
+            ++oldest_protected_;
+        }
+        if (oldest_protected_ == seq) {
+            keyframe = true;
+        } else {
+            const uint64_t needed_from =
+                recordAt(recordAt(oldest_protected_).keyframe_record + 1).change_begin;
+            keyframe = change_count_ + change_count > needed_from + changes_.size();
+        }
+    }
+
+    if (keyframe) {
+        Keyframe& frame = keyframes_[keyframe_count_ % keyframes_.size()];
+        frame.record_seq = seq;
+        memcpy(&frame.orderbook, &orderbook, sizeof(orderbook));
+        frame.orderbook.bid_count = bid_count;
+        frame.orderbook.ask_count = ask_count;
+        frame.orderbook.timestamp = rec.timestamp;
+        rec.keyframe_seq = keyframe_count_++;
+        rec.keyframe_record = seq;
+        rec.change_count = 0;
+        rec.is_keyframe = 1;
+        last_keyframe_record_ = seq;
+    } else {
+        for (size_t i = 0; i < change_count; ++i) {
+            changes_[(change_count_ + i) % changes_.size()] = changes[i];
+        }
+        change_count_ += change_count;
+        rec.keyframe_seq = recordAt(seq - 1).keyframe_seq;
+        rec.keyframe_record = recordAt(seq - 1).keyframe_record;
+        rec.change_count = static_cast<uint32_t>(change_count);
+        rec.is_keyframe = 0;
+        ++delta_records_;
+        delta_levels_total_ += change_count;
+    }
+
+    memcpy(&last_, &orderbook, sizeof(orderbook));
+    last_.bid_count = bid_count;
+    last_.ask_count = ask_count;
+    ++record_count_;
+}
+
+bool OrderbookHistory::reconstructible(uint64_t seq) const {
+    if (seq >= record_count_ || seq + records_.size() < record_count_) {
+        return false;
+    }
+    const Record& rec = recordAt(seq);
+    // 全量帧已被覆盖
+    if (rec.keyframe_seq + keyframes_.size() < keyframe_count_) {
+        return false;
+    }
+    uint64_t keyframe_record = keyframeAt(rec.keyframe_seq).record_seq;
+    if (keyframe_record == seq) {
+        return true;
+    }
+    // 全量帧之后的记录及其差分档位都必须还在
+    if (keyframe_record + 1 + records_.size() < record_count_) {
+        return false;
+    }
+    return recordAt(keyframe_record + 1).change_begin + changes_.size() >= change_count_;
+}
+
+uint64_t OrderbookHistory::firstValid() const {
+    // 可重建的记录是一个后缀，二分查找其起点
+    uint64_t lo = record_count_ > records_.size() ? record_count_ - records_.size() : 0;
+    uint64_t hi = record_count_;
+    while (lo < hi) {
+        uint64_t mid = lo + (hi - lo) / 2;
+        if (reconstructible(mid)) {
+            hi = mid;
+        } else {
+            lo = mid + 1;
+        }
+    }
+    return lo;
+}
+
+uint64_t OrderbookHistory::upperBound(uint64_t first, uint64_t timestamp) const {
+    uint64_t lo = first;
+    uint64_t hi = record_count_;
+    while (lo < hi) {
+        uint64_t mid = lo + (hi - lo) / 2;
+        if (recordAt(mid).timestamp > timestamp) {
+            hi = mid;
+        } else {
+            lo = mid + 1;
+        }
+    }
+    return lo;
+}
+
+void OrderbookHistory::reconstruct(uint64_t seq, orderbook_t& out) const {
+    const Keyframe& frame = keyframeAt(recordAt(seq).keyframe_seq);
+    // 全量帧对应的记录可能已被覆盖，时间戳等字段取自帧本身
+    memcpy(&out, &frame.orderbook, sizeof(out));
+    for (uint64_t s = frame.record_seq + 1; s <= seq; ++s) {
+        applyRecord(s, out);
+    }
+}
+
+void OrderbookHistory::applyRecord(uint64_t seq, orderbook_t& out) const {
+    const Record& rec = recordAt(seq);
+    if (rec.is_keyframe) {
+        memcpy(&out, &keyframeAt(rec.keyframe_seq).orderbook, sizeof(out));
+    } else {
+        // 差分按买盘、卖盘的顺序存放：每侧先删除再修改/插入，删除后档位数不会超过上限
+        const uint64_t end = rec.change_begin + rec.change_count;
+        uint64_t side_begin = rec.change_begin;
+        for (uint32_t side = 0; side < 2; ++side) {
+            const bool descending = side == 0;
+            price_level_t* levels = descending ? out.bids : out.asks;
+            uint32_t& count = descending ? out.bid_count : out.ask_count;
+            uint64_t side_end = side_begin;
+            while (side_end < end && changes_[side_end % changes_.size()].side == side) {
+                ++side_end;
+            }
+            for (uint32_t pass = 0; pass < 2; ++pass) {
+                for (uint64_t k = side_begin; k < side_end; ++k) {
+                    const price_level_t& level = changes_[k % changes_.size()].level;
+                    const bool remove = !(level.quantity > 0.0);
+                    if (remove != (pass == 0)) {
+                        continue;
+                    }
+                    uint32_t i = 0;
+                    while (i < count && before(levels[i].price, level.price, descending)) {
+                        ++i;
+                    }
+                    const bool found = i < count && levels[i].price == level.price;
+                    if (remove) {
+                        if (found) {
+                            memmove(&levels[i], &levels[i + 1], (count - i - 1) * sizeof(price_level_t));
+                            --count;
+                        }
+                    } else if (found) {
+                        levels[i] = level;
+                    } else if (count < ORDERBOOK_MAX_LEVELS) {
+                        memmove(&levels[i + 1], &levels[i], (count - i) * sizeof(price_level_t));
+                        levels[i] = level;
+                        ++count;
+                    }
+                }
+            }
+            side_begin = side_end;
+        }
+    }
+    out.timestamp = rec.timestamp;
+    out.last_update_id = rec.last_update_id;
+}
+
+bool OrderbookHistory::getAt(uint64_t timestamp, orderbook_t& out) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (records_.empty() || record_count_ == 0) {
+        return false;
+    }
+    uint64_t first = firstValid();
+    uint64_t seq = upperBound(first, timestamp);
+    if (seq == first) {
+        return false;
+    }
+    reconstruct(seq - 1, out);
+    return true;
+}
+
+} // namespace crypto_quant
@@ -1,193 +1,815 @@
 #include "orderbook_manager.h"
+#include "symbol_registry.h"
 #include <spdlog/spdlog.h>
 #include <algorithm>
 #include <cstring>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#endif
 
 namespace crypto_quant {
 
-OrderbookManager::OrderbookManager() {
-        orderbooks_.resize(3);
-        // 初始化每个订单薄
-        for (auto& orderbook : orderbooks_) {
-            memset(&orderbook, 0, sizeof(orderbook));
-            orderbook.timestamp = std::chrono::duration_cast<std::chrono::milliseconds>(
-                std::chrono::system_clock::now().time_since_epoch()
-            ).count();
+namespace {
+
+// 读区间内可能看到写入中的计数，访问数组前必须截断
+inline uint32_t clampLevels(uint32_t count) {
+    return count < ORDERBOOK_MAX_LEVELS ? count : ORDERBOOK_MAX_LEVELS;
+}
+
+inline uint64_t nowMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()
+    ).count();
+}
+
+// 把一组价格档位更新合并进深订单薄的一侧（从最差价到最优价存放）
+// descending 为true表示买盘（价格从高到低）
+void applyLevelUpdates(std::vector<price_level_t>& levels, double& boundary,
+                       const price_level_t* updates, uint32_t update_count,
+                       bool descending, uint64_t event_time) {
+    // worse(a, b)：价格 a 比 b 离盘口更远
+    auto worse = [descending](double a, double b) {
+        return descending ? a < b : a > b;
+    };
+    for (uint32_t u = 0; u < update_count; ++u) {
+        const price_level_t& update = updates[u];
+
+        // 查找插入位置：第一个不比更新价格差的档位
+        std::vector<price_level_t>::iterator pos = std::lower_bound(
+            levels.begin(), levels.end(), update.price,
+            [&worse](const price_level_t& level, double price) { return worse(level.price, price); });
+        bool found = pos != levels.end() && pos->price == update.price;
+
+        if (update.quantity <= 0.0) {
+            // 删除档位
+            if (found) {
+                levels.erase(pos);
+            }
+            continue;
+        }
+
+        if (found) {
+            pos->quantity = update.quantity;
+            pos->timestamp = event_time;
+            continue;
         }
+
+        // 边界之外的档位状态未知，新增档位不能插到已丢弃的档位之前
+        if (boundary > 0.0 && worse(update.price, boundary)) {
+            continue;
+        }
+        size_t index = static_cast<size_t>(pos - levels.begin());
+        if (levels.size() >= OrderbookManager::kMaxDepthLevels) {
+            // 超出档位上限：丢弃最差的一档，边界收紧到保留的最差一档
+            if (index == 0) {
+                boundary = levels.front().price;
+                continue;
+            }
+            levels.erase(levels.begin());
+            --index;
+            boundary = levels.front().price;
+        }
+        price_level_t level;
+        level.price = update.price;
+        level.quantity = update.quantity;
+        level.timestamp = event_time;
+        levels.insert(levels.begin() + index, level);
+    }
+}
+
+// 从最优价开始的档位（快照或完整订单薄）装入深订单薄的一侧
+// 档位数达到 limit（0表示未知）时更深的档位可能被截断，比最差一档更差的价格视为未知
+void loadLevels(std::vector<price_level_t>& levels, double& boundary,
+                const price_level_t* source, size_t count, size_t limit) {
+    size_t kept = std::min(count, OrderbookManager::kMaxDepthLevels);
+    levels.resize(kept);
+    for (size_t i = 0; i < kept; ++i) {
+        levels[kept - 1 - i] = source[i];
+    }
+    bool truncated = count > 0 && (limit == 0 || count >= limit || kept < count);
+    boundary = truncated ? source[kept - 1].price : 0.0;
+}
+
+// 深订单薄一侧的最优若干档按从优到差写入订单薄数组
+void copyTopLevels(const std::vector<price_level_t>& levels, price_level_t* out, uint32_t& count) {
+    size_t size = levels.size();
+    count = static_cast<uint32_t>(std::min<size_t>(size, ORDERBOOK_MAX_LEVELS));
+    for (uint32_t i = 0; i < count; ++i) {
+        out[i] = levels[size - 1 - i];
+    }
+}
+
+} // namespace
+
+const size_t OrderbookManager::kMaxDepthLevels;
+const size_t OrderbookManager::kMaxBufferedDiffs;
+
+OrderbookManager::OrderbookManager(OrderbookNotifier* notifier)
+        : books_(SymbolRegistry::kMaxSymbols),
+          kernels_(&depthKernels()),
+          notifier_(notifier ? notifier : &own_notifier_),
+          resync_running_(false) {
+        spdlog::debug("Depth kernels: {}", kernels_->isa);
+    }
+
+OrderbookManager::~OrderbookManager() {
+        stopResync();
+    }
+
+const OrderbookManager::BookSlot* OrderbookManager::findSlot(symbol_t symbol) const {
+        const SymbolBook* book = books_.get(symbol);
+        return book ? &book->slot : nullptr;
+    }
+
+OrderbookManager::SymbolBook* OrderbookManager::findOrCreateBook(symbol_t symbol) {
+        if (!SymbolRegistry::instance().contains(symbol)) {
+            return nullptr;
+        }
+        // 新块中的订单薄在发布前填好交易对ID
+        return books_.getOrCreate(symbol, [](size_t index, SymbolBook& book) {
+            BookState& state = book.slot.beginWrite();
+            state.book.symbol = static_cast<symbol_t>(index);
+            book.slot.endWrite();
+            book.quarantined.store(false, std::memory_order_release);
+        });
     }
 
 bool OrderbookManager::initialize() {
-        std::lock_guard<std::mutex> lock(mutex_);
         spdlog::info("OrderbookManager initialized");
         return true;
     }
 
 void OrderbookManager::cleanup() {
-        std::lock_guard<std::mutex> lock(mutex_);
-        orderbooks_.clear();
+        // 先停止后台重新同步，快照提供者可能引用即将释放的对象
+        stopResync();
+        // 槽位在读者可见期间不释放，只清空内容
+        books_.forEach([](size_t index, SymbolBook& book) {
+            std::lock_guard<std::mutex> lock(book.write_mutex);
+            BookState& state = book.slot.beginWrite();
+            memset(static_cast<void*>(&state), 0, sizeof(state));
+            state.book.symbol = static_cast<symbol_t>(index);
+            book.slot.endWrite();
+            book.bids = DepthSide();
+            book.asks = DepthSide();
+            book.last_update_id = 0;
+            book.syncing = false;
+            book.resynced = false;
+            book.buffered.clear();
+            book.quarantined.store(false, std::memory_order_release);
+        });
         spdlog::info("OrderbookManager cleaned up");
     }
 
 void OrderbookManager::updateOrderbook(const orderbook_t& orderbook) {
-        std::lock_guard<std::mutex> lock(mutex_);
-        
-        int symbol_index = static_cast<int>(orderbook.symbol);
-        if (symbol_index < 0 || symbol_index >= static_cast<int>(orderbooks_.size())) {
-            spdlog::error("Invalid symbol index: {}", symbol_index);
+        SymbolBook* book = findOrCreateBook(orderbook.symbol);
+        if (!book) {
+            spdlog::error("Invalid symbol index: {}", orderbook.symbol);
             return;
         }
-        
-        // 更新订单薄数据
-        orderbooks_[symbol_index] = orderbook;
-        
+        BookSlot* slot = &book->slot;
+        std::lock_guard<std::mutex> lock(book->write_mutex);
+
+        // 更新订单薄数据，同时刷新 SoA 视图
+        BookState& state = slot->beginWrite();
+        uint64_t previous_timestamp = state.book.timestamp;
+        uint64_t previous_update_id = state.book.last_update_id;
+        memcpy(&state.book, &orderbook, sizeof(orderbook));
+        orderbookToSoa(state.book, state.soa);
+        OrderbookIntegrityIssue issue = validator_.check(state.book, previous_timestamp,
+                                                         previous_update_id, nowMs());
+        slot->endWrite();
+        // 完整订单薄同时替换深订单薄，之后的增量在它之上合并
+        loadLevels(book->bids.levels, book->bids.boundary, orderbook.bids, clampLevels(orderbook.bid_count),
+                   ORDERBOOK_MAX_LEVELS);
+        loadLevels(book->asks.levels, book->asks.boundary, orderbook.asks, clampLevels(orderbook.ask_count),
+                   ORDERBOOK_MAX_LEVELS);
+        book->last_update_id = orderbook.last_update_id;
+        handleIntegrity(orderbook.symbol, *book, issue, true);
+        notifyChanged(orderbook.symbol, *book);
+
         spdlog::debug("Orderbook updated: symbol={}, bid_count={}, ask_count={}, timestamp={}",
-                    static_cast<int>(orderbook.symbol), orderbook.bid_count, 
+                    orderbook.symbol, orderbook.bid_count,
                     orderbook.ask_count, orderbook.timestamp);
     }
 
 orderbook_t OrderbookManager::getOrderbook(symbol_t symbol) const {
-        std::lock_guard<std::mutex> lock(mutex_);
-        
-        int symbol_index = static_cast<int>(symbol);
-        if (symbol_index < 0 || symbol_index >= static_cast<int>(orderbooks_.size())) {
-            spdlog::error("Invalid symbol index: {}", symbol_index);
-            return orderbook_t{};
+        const BookSlot* slot = findSlot(symbol);
+        if (!slot) {
+            // 已注册但尚未收到数据的交易对返回空订单薄
+            if (!SymbolRegistry::instance().contains(symbol)) {
+                spdlog::error("Invalid symbol index: {}", symbol);
+            }
+            orderbook_t orderbook = {};
+            orderbook.symbol = symbol;
+            return orderbook;
         }
-        
-        return orderbooks_[symbol_index];
+
+        // 只拷贝 AoS 部分
+        orderbook_t orderbook;
+        slot->read([&orderbook](const BookState& state) {
+            memcpy(&orderbook, &state.book, sizeof(orderbook));
+        });
+        return orderbook;
     }
 
 double OrderbookManager::getBestBid(symbol_t symbol) const {
-        std::lock_guard<std::mutex> lock(mutex_);
-        
-        int symbol_index = static_cast<int>(symbol);
-        if (symbol_index < 0 || symbol_index >= static_cast<int>(orderbooks_.size())) {
+        const BookSlot* slot = findSlot(symbol);
+        if (!slot) {
             return 0.0;
         }
-        
-        const auto& orderbook = orderbooks_[symbol_index];
-        if (orderbook.bid_count > 0) {
-            return orderbook.bids[0].price;
-        }
-        
-        return 0.0;
+
+        double price = 0.0;
+        slot->read([&price](const BookState& state) {
+            price = state.book.bid_count > 0 ? state.book.bids[0].price : 0.0;
+        });
+        return price;
     }
 
 double OrderbookManager::getBestAsk(symbol_t symbol) const {
-        std::lock_guard<std::mutex> lock(mutex_);
-        
-        int symbol_index = static_cast<int>(symbol);
-        if (symbol_index < 0 || symbol_index >= static_cast<int>(orderbooks_.size())) {
+        const BookSlot* slot = findSlot(symbol);
+        if (!slot) {
             return 0.0;
         }
-        
-        const auto& orderbook = orderbooks_[symbol_index];
-        if (orderbook.ask_count > 0) {
-            return orderbook.asks[0].price;
-        }
-        
-        return 0.0;
+
+        double price = 0.0;
+        slot->read([&price](const BookState& state) {
+            price = state.book.ask_count > 0 ? state.book.asks[0].price : 0.0;
+        });
+        return price;
     }
 
 double OrderbookManager::getMidPrice(symbol_t symbol) const {
-        std::lock_guard<std::mutex> lock(mutex_);
-        
-        int symbol_index = static_cast<int>(symbol);
-        if (symbol_index < 0 || symbol_index >= static_cast<int>(orderbooks_.size())) {
+        const BookSlot* slot = findSlot(symbol);
+        if (!slot) {
             return 0.0;
         }
-        
-        const auto& orderbook = orderbooks_[symbol_index];
-        if (orderbook.bid_count > 0 && orderbook.ask_count > 0) {
-            return (orderbook.bids[0].price + orderbook.asks[0].price) / 2.0;
-        }
-        
-        return 0.0;
+
+        double mid = 0.0;
+        slot->read([&mid](const BookState& state) {
+            mid = 0.0;
+            if (state.book.bid_count > 0 && state.book.ask_count > 0) {
+                mid = (state.book.bids[0].price + state.book.asks[0].price) / 2.0;
+            }
+        });
+        return mid;
     }
 
 double OrderbookManager::getSpread(symbol_t symbol) const {
-        std::lock_guard<std::mutex> lock(mutex_);
-        
-        int symbol_index = static_cast<int>(symbol);
-        if (symbol_index < 0 || symbol_index >= static_cast<int>(orderbooks_.size())) {
+        const BookSlot* slot = findSlot(symbol);
+        if (!slot) {
             return 0.0;
         }
-        
-        const auto& orderbook = orderbooks_[symbol_index];
-        if (orderbook.bid_count > 0 && orderbook.ask_count > 0) {
-            return orderbook.asks[0].price - orderbook.bids[0].price;
-        }
-        
-        return 0.0;
+
+        double spread = 0.0;
+        slot->read([&spread](const BookState& state) {
+            spread = 0.0;
+            if (state.book.bid_count > 0 && state.book.ask_count > 0) {
+                spread = state.book.asks[0].price - state.book.bids[0].price;
+            }
+        });
+        return spread;
     }
 
 double OrderbookManager::getBidDepth(symbol_t symbol, int levels) const {
-        std::lock_guard<std::mutex> lock(mutex_);
-        
-        int symbol_index = static_cast<int>(symbol);
-        if (symbol_index < 0 || symbol_index >= static_cast<int>(orderbooks_.size())) {
+        const BookSlot* slot = findSlot(symbol);
+        if (!slot || levels <= 0) {
             return 0.0;
         }
-        
-        const auto& orderbook = orderbooks_[symbol_index];
+
         double depth = 0.0;
-        
-        int count = std::min(levels, static_cast<int>(orderbook.bid_count));
-        for (int i = 0; i < count; ++i) {
-            depth += orderbook.bids[i].quantity;
-        }
-        
+        const DepthKernels* kernels = kernels_;
+        slot->read([&depth, levels, kernels](const BookState& state) {
+            uint32_t count = std::min(static_cast<uint32_t>(levels), clampLevels(state.soa.bid_count));
+            depth = kernels->cumulativeQuantity(state.soa.bid_quantities, count);
+        });
         return depth;
     }
 
 double OrderbookManager::getAskDepth(symbol_t symbol, int levels) const {
-        std::lock_guard<std::mutex> lock(mutex_);
-        
-        int symbol_index = static_cast<int>(symbol);
-        if (symbol_index < 0 || symbol_index >= static_cast<int>(orderbooks_.size())) {
+        const BookSlot* slot = findSlot(symbol);
+        if (!slot || levels <= 0) {
             return 0.0;
         }
-        
-        const auto& orderbook = orderbooks_[symbol_index];
+
         double depth = 0.0;
-        
-        int count = std::min(levels, static_cast<int>(orderbook.ask_count));
-        for (int i = 0; i < count; ++i) {
-            depth += orderbook.asks[i].quantity;
+        const DepthKernels* kernels = kernels_;
+        slot->read([&depth, levels, kernels](const BookState& state) {
+            uint32_t count = std::min(static_cast<uint32_t>(levels), clampLevels(state.soa.ask_count));
+            depth = kernels->cumulativeQuantity(state.soa.ask_quantities, count);
+        });
+        return depth;
+    }
+
+double OrderbookManager::getDepthWithinBps(symbol_t symbol, double bps, bool bid) const {
+        const BookSlot* slot = findSlot(symbol);
+        if (!slot || bps < 0.0) {
+            return 0.0;
         }
-        
+
+        double depth = 0.0;
+        const DepthKernels* kernels = kernels_;
+        slot->read([&depth, bps, bid, kernels](const BookState& state) {
+            depth = 0.0;
+            uint32_t bid_count = clampLevels(state.soa.bid_count);
+            uint32_t ask_count = clampLevels(state.soa.ask_count);
+            if (bid_count == 0 || ask_count == 0) {
+                return;
+            }
+            double mid = (state.soa.bid_prices[0] + state.soa.ask_prices[0]) / 2.0;
+            double offset = mid * bps / 10000.0;
+            if (bid) {
+                depth = kernels->quantityWithinPrice(state.soa.bid_prices, state.soa.bid_quantities,
+                                                     bid_count, mid - offset, true);
+            } else {
+                depth = kernels->quantityWithinPrice(state.soa.ask_prices, state.soa.ask_quantities,
+                                                     ask_count, mid + offset, false);
+            }
+        });
         return depth;
     }
 
+double OrderbookManager::getVwap(symbol_t symbol, int levels, bool bid) const {
+        const BookSlot* slot = findSlot(symbol);
+        if (!slot || levels <= 0) {
+            return 0.0;
+        }
+
+        double vwap = 0.0;
+        const DepthKernels* kernels = kernels_;
+        slot->read([&vwap, levels, bid, kernels](const BookState& state) {
+            uint32_t count = std::min(static_cast<uint32_t>(levels),
+                                      clampLevels(bid ? state.soa.bid_count : state.soa.ask_count));
+            vwap = bid ? kernels->vwap(state.soa.bid_prices, state.soa.bid_quantities, count)
+                       : kernels->vwap(state.soa.ask_prices, state.soa.ask_quantities, count);
+        });
+        return vwap;
+    }
+
+double OrderbookManager::getCostToFill(symbol_t symbol, double quantity, bool buy,
+                                       double* filled_quantity) const {
+        if (filled_quantity) {
+            *filled_quantity = 0.0;
+        }
+        const BookSlot* slot = findSlot(symbol);
+        if (!slot || quantity <= 0.0) {
+            return 0.0;
+        }
+
+        // 买入吃卖盘，卖出吃买盘
+        double cost = 0.0;
+        double filled = 0.0;
+        const DepthKernels* kernels = kernels_;
+        slot->read([&cost, &filled, quantity, buy, kernels](const BookState& state) {
+            if (buy) {
+                cost = kernels->costToFill(state.soa.ask_prices, state.soa.ask_quantities,
+                                           clampLevels(state.soa.ask_count), quantity, &filled);
+            } else {
+                cost = kernels->costToFill(state.soa.bid_prices, state.soa.bid_quantities,
+                                           clampLevels(state.soa.bid_count), quantity, &filled);
+            }
+        });
+        if (filled_quantity) {
+            *filled_quantity = filled;
+        }
+        return cost;
+    }
+
 uint64_t OrderbookManager::getTimestamp(symbol_t symbol) const {
-        std::lock_guard<std::mutex> lock(mutex_);
-        
-        int symbol_index = static_cast<int>(symbol);
-        if (symbol_index < 0 || symbol_index >= static_cast<int>(orderbooks_.size())) {
+        const BookSlot* slot = findSlot(symbol);
+        if (!slot) {
             return 0;
         }
-        
-        return orderbooks_[symbol_index].timestamp;
+
+        uint64_t timestamp = 0;
+        slot->read([&timestamp](const BookState& state) {
+            timestamp = state.book.timestamp;
+        });
+        return timestamp;
     }
 
 bool OrderbookManager::isValid(symbol_t symbol) const {
-        std::lock_guard<std::mutex> lock(mutex_);
-        
-        int symbol_index = static_cast<int>(symbol);
-        if (symbol_index < 0 || symbol_index >= static_cast<int>(orderbooks_.size())) {
+        const BookSlot* slot = findSlot(symbol);
+        if (!slot) {
             return false;
         }
-        
-        const auto& orderbook = orderbooks_[symbol_index];
-        
-        // 检查是否有有效的买卖盘
-        if (orderbook.bid_count > 0 && orderbook.ask_count > 0) {
-            // 检查价格是否合理
-            if (orderbook.bids[0].price > 0 && orderbook.asks[0].price > 0) {
-                return true; // 有效
+
+        if (books_.get(symbol)->quarantined.load(std::memory_order_acquire)) {
+            return false;
+        }
+
+        bool valid = false;
+        slot->read([&valid](const BookState& state) {
+            // 检查是否有有效的买卖盘，且价格是否合理
+            valid = state.book.bid_count > 0 && state.book.ask_count > 0 &&
+                    state.book.bids[0].price > 0 && state.book.asks[0].price > 0;
+        });
+        return valid;
+    }
+
+size_t OrderbookManager::getTopOfBook(const symbol_t* symbols, size_t count, top_of_book_t* out) const {
+        size_t valid_count = 0;
+        for (size_t i = 0; i < count; ++i) {
+            top_of_book_t& top = out[i];
+            memset(&top, 0, sizeof(top));
+            top.symbol = symbols[i];
+            const SymbolBook* book = books_.get(symbols[i]);
+            if (!book) {
+                continue;
+            }
+            const BookSlot* slot = &book->slot;
+
+            slot->read([&top](const BookState& state) {
+                const orderbook_t& orderbook = state.book;
+                top.timestamp = orderbook.timestamp;
+                top.last_update_id = orderbook.last_update_id;
+                top.valid = orderbook.bid_count > 0 && orderbook.ask_count > 0 ? 1 : 0;
+                top.bid_price = orderbook.bid_count > 0 ? orderbook.bids[0].price : 0.0;
+                top.bid_quantity = orderbook.bid_count > 0 ? orderbook.bids[0].quantity : 0.0;
+                top.ask_price = orderbook.ask_count > 0 ? orderbook.asks[0].price : 0.0;
+                top.ask_quantity = orderbook.ask_count > 0 ? orderbook.asks[0].quantity : 0.0;
+            });
+            if (top.valid && book->quarantined.load(std::memory_order_acquire)) {
+                top.valid = 0;
+            }
+            if (top.valid) {
+                top.mid_price = (top.bid_price + top.ask_price) / 2.0;
+                top.spread = top.ask_price - top.bid_price;
+                ++valid_count;
+            }
+        }
+        return valid_count;
+    }
+
+DepthDiffResult OrderbookManager::applyDepthDiff(const depth_diff_t& diff) {
+        SymbolBook* book = findOrCreateBook(diff.symbol);
+        if (!book) {
+            spdlog::error("Invalid symbol index: {}", diff.symbol);
+            return DepthDiffResult::OUT_OF_SYNC;
+        }
+
+        // 序号检查与应用在同一写入区内，后台装入快照不会插在两者之间
+        std::lock_guard<std::mutex> lock(book->write_mutex);
+        if (book->syncing) {
+            bufferDiff(*book, diff);
+            return DepthDiffResult::BUFFERED;
+        }
+
+        uint64_t last_update_id = book->last_update_id;
+        // 已被当前订单薄覆盖的旧事件
+        if (last_update_id != 0 && diff.final_update_id <= last_update_id) {
+            return DepthDiffResult::STALE;
+        }
+
+        // 尚未同步或出现缺口（U > lastUpdateId + 1）：请求快照，期间缓存增量
+        if (last_update_id == 0 || diff.first_update_id > last_update_id + 1) {
+            spdlog::warn("Depth gap detected: symbol={}, last_update_id={}, U={}, u={}",
+                         diff.symbol, last_update_id,
+                         diff.first_update_id, diff.final_update_id);
+            if (last_update_id != 0) {
+                validator_.recordSequenceGap();
+                // 快照装入前订单薄已落后于增量流
+                quarantine(diff.symbol, *book, OrderbookIntegrityIssue::SEQUENCE_GAP);
+            }
+            if (!hasSnapshotProvider()) {
+                spdlog::error("Cannot resync orderbook: no snapshot provider, symbol={}", diff.symbol);
+                return DepthDiffResult::OUT_OF_SYNC;
             }
+            requestResync(diff.symbol, *book);
+            bufferDiff(*book, diff);
+            return DepthDiffResult::BUFFERED;
         }
-        
-        return false; // 无效
+
+        uint64_t now = nowMs();
+        OrderbookIntegrityIssue issue = validator_.checkEventAge(diff.event_time, now);
+        mergeDiff(*book, diff);
+        OrderbookIntegrityIssue book_issue = publishDepth(diff.symbol, *book, false, now);
+        handleIntegrity(diff.symbol, *book, issue != OrderbookIntegrityIssue::NONE ? issue : book_issue,
+                        false);
+        notifyChanged(diff.symbol, *book);
+
+        DepthDiffResult result = book->resynced ? DepthDiffResult::RESYNCED : DepthDiffResult::APPLIED;
+        book->resynced = false;
+        spdlog::debug("Depth diff applied: symbol={}, U={}, u={}, bids={}, asks={}",
+                      diff.symbol, diff.first_update_id,
+                      diff.final_update_id, diff.bid_count, diff.ask_count);
+        return result;
+    }
+
+void OrderbookManager::bufferDiff(SymbolBook& book, const depth_diff_t& diff) {
+        if (book.buffered.size() >= kMaxBufferedDiffs) {
+            // 快照迟迟未到：丢弃缓存，重放时会发现缺口并再次同步
+            spdlog::warn("Depth diff buffer overflow, dropping {} buffered diffs: symbol={}",
+                         book.buffered.size(), diff.symbol);
+            book.buffered.clear();
+        }
+        book.buffered.push_back(BufferedDiff());
+        BufferedDiff& buffered = book.buffered.back();
+        buffered.diff = diff;
+        buffered.diff.bids = nullptr;
+        buffered.diff.asks = nullptr;
+        buffered.bids.assign(diff.bids, diff.bids + diff.bid_count);
+        buffered.asks.assign(diff.asks, diff.asks + diff.ask_count);
+    }
+
+void OrderbookManager::mergeDiff(SymbolBook& book, const depth_diff_t& diff) {
+        applyLevelUpdates(book.bids.levels, book.bids.boundary, diff.bids, diff.bid_count,
+                          true, diff.event_time);
+        applyLevelUpdates(book.asks.levels, book.asks.boundary, diff.asks, diff.ask_count,
+                          false, diff.event_time);
+        book.last_update_id = diff.final_update_id;
+    }
+
+bool OrderbookManager::replayBuffered(SymbolBook& book) {
+        size_t next = 0;
+        for (; next < book.buffered.size(); ++next) {
+            BufferedDiff& buffered = book.buffered[next];
+            // 快照已包含的事件丢弃
+            if (buffered.diff.final_update_id <= book.last_update_id) {
+                continue;
+            }
+            if (buffered.diff.first_update_id > book.last_update_id + 1) {
+                break;
+            }
+            depth_diff_t diff = buffered.diff;
+            diff.bids = buffered.bids.data();
+            diff.asks = buffered.asks.data();
+            mergeDiff(book, diff);
+        }
+        book.buffered.erase(book.buffered.begin(), book.buffered.begin() + next);
+        return book.buffered.empty();
+    }
+
+OrderbookIntegrityIssue OrderbookManager::publishDepth(symbol_t symbol, SymbolBook& book, bool full_snapshot,
+                                                       uint64_t now) {
+        BookState& state = book.slot.beginWrite();
+        orderbook_t& orderbook = state.book;
+        uint64_t previous_timestamp = orderbook.timestamp;
+        uint64_t previous_update_id = orderbook.last_update_id;
+        if (full_snapshot) {
+            memset(&orderbook, 0, sizeof(orderbook));
+            orderbook.symbol = symbol;
+        }
+        copyTopLevels(book.bids.levels, orderbook.bids, orderbook.bid_count);
+        copyTopLevels(book.asks.levels, orderbook.asks, orderbook.ask_count);
+        orderbook.last_update_id = book.last_update_id;
+        orderbook.timestamp = now;
+        orderbookToSoa(orderbook, state.soa);
+        // 快照整体替换订单薄，不与之前的时间戳、更新ID比较
+        OrderbookIntegrityIssue issue = full_snapshot
+            ? validator_.check(orderbook, 0, 0, now)
+            : validator_.check(orderbook, previous_timestamp, previous_update_id, now);
+        book.slot.endWrite();
+        return issue;
+    }
+
+void OrderbookManager::setSnapshotProvider(DepthSnapshotProvider provider) {
+        std::lock_guard<std::mutex> lock(provider_mutex_);
+        snapshot_provider_ = provider;
+        spdlog::debug("Depth snapshot provider set");
+    }
+
+std::shared_ptr<IOrderbookSubscription> OrderbookManager::subscribeConflated(symbol_t symbol) {
+        return notifier_->subscribeConflated(symbol);
+    }
+
+uint64_t OrderbookManager::subscribeEveryUpdate(symbol_t symbol, OrderbookUpdateCallback callback) {
+        return notifier_->subscribeEveryUpdate(symbol, callback);
+    }
+
+void OrderbookManager::unsubscribe(uint64_t subscription_id) {
+        notifier_->unsubscribe(subscription_id);
+    }
+
+uint64_t OrderbookManager::droppedUpdates(uint64_t subscription_id) const {
+        return notifier_->droppedUpdates(subscription_id);
+    }
+
+bool OrderbookManager::isQuarantined(symbol_t symbol) const {
+        const SymbolBook* book = books_.get(symbol);
+        return book ? book->quarantined.load(std::memory_order_acquire) : false;
+    }
+
+orderbook_integrity_stats_t OrderbookManager::getIntegrityStats() const {
+        return validator_.stats();
+    }
+
+bool OrderbookManager::hasSnapshotProvider() {
+        std::lock_guard<std::mutex> lock(provider_mutex_);
+        return static_cast<bool>(snapshot_provider_);
+    }
+
+void OrderbookManager::quarantine(symbol_t symbol, SymbolBook& book, OrderbookIntegrityIssue issue) {
+        if (!book.quarantined.exchange(true, std::memory_order_acq_rel)) {
+            validator_.recordQuarantined();
+            spdlog::warn("Orderbook quarantined: symbol={}, issue={}",
+                         symbol, OrderbookValidator::issueName(issue));
+        }
+    }
+
+void OrderbookManager::handleIntegrity(symbol_t symbol, SymbolBook& book, OrderbookIntegrityIssue issue,
+                                       bool full_snapshot) {
+        bool quarantined = book.quarantined.load(std::memory_order_relaxed);
+        if (issue == OrderbookIntegrityIssue::NONE) {
+            if (!quarantined) {
+                return;
+            }
+            // 合法的完整快照替换了整个订单薄：解除隔离
+            if (full_snapshot) {
+                book.quarantined.store(false, std::memory_order_release);
+                validator_.recordRecovered();
+                spdlog::info("Orderbook recovered from quarantine: symbol={}", symbol);
+                return;
+            }
+        } else {
+            quarantine(symbol, book, issue);
+        }
+        // 增量应用在损坏的订单薄上仍然是损坏的，只能靠快照恢复（后台线程限频）
+        if (hasSnapshotProvider()) {
+            requestResync(symbol, book);
+        }
+    }
+
+bool OrderbookManager::setHistoryCapacity(symbol_t symbol, size_t capacity) {
+        SymbolBook* book = findOrCreateBook(symbol);
+        if (!book) {
+            spdlog::error("Invalid symbol index: {}", symbol);
+            return false;
+        }
+
+        std::lock_guard<std::mutex> lock(history_mutex_);
+        if (capacity == 0) {
+            // 写线程可能正在记录，对象保留，只停止记录
+            book->history.store(nullptr, std::memory_order_release);
+            if (book->history_storage) {
+                book->history_storage->clear();
+            }
+            spdlog::info("Orderbook history disabled: symbol={}", symbol);
+            return true;
+        }
+        if (!book->history_storage) {
+            book->history_storage.reset(new OrderbookHistory());
+        }
+        book->history_storage->reset(capacity);
+        book->history.store(book->history_storage.get(), std::memory_order_release);
+        spdlog::info("Orderbook history enabled: symbol={}, capacity={}", symbol, capacity);
+        return true;
+    }
+
+const OrderbookHistory* OrderbookManager::findHistory(symbol_t symbol) const {
+        const SymbolBook* book = books_.get(symbol);
+        return book ? book->history.load(std::memory_order_acquire) : nullptr;
+    }
+
+bool OrderbookManager::getOrderbookAt(symbol_t symbol, uint64_t timestamp, orderbook_t& orderbook) const {
+        const OrderbookHistory* history = findHistory(symbol);
+        return history ? history->getAt(timestamp, orderbook) : false;
+    }
+
+size_t OrderbookManager::forEachOrderbookInRange(symbol_t symbol, uint64_t from, uint64_t to,
+                                                 const std::function<bool(const orderbook_t&)>& fn) const {
+        const OrderbookHistory* history = findHistory(symbol);
+        if (!history || !fn) {
+            return 0;
+        }
+        return history->forEachInRange(from, to, fn);
+    }
+
+void OrderbookManager::notifyChanged(symbol_t symbol, SymbolBook& book) {
+        const BookSlot& slot = book.slot;
+        OrderbookHistory* history = book.history.load(std::memory_order_acquire);
+        if (history) {
+            // 写线程自己发布的数据，读取不会重试
+            orderbook_t orderbook;
+            slot.read([&orderbook](const BookState& state) {
+                memcpy(&orderbook, &state.book, sizeof(orderbook));
+            });
+            history->record(orderbook);
+        }
+        notifier_->publish(symbol, [&slot](orderbook_t& out) {
+            slot.read([&out](const BookState& state) {
+                memcpy(&out, &state.book, sizeof(out));
+            });
+        });
+    }
+
+void OrderbookManager::requestResync(symbol_t symbol, SymbolBook& book) {
+        if (book.syncing) {
+            return;
+        }
+        book.syncing = true;
+        enqueueResync(symbol);
+    }
+
+void OrderbookManager::enqueueResync(symbol_t symbol) {
+        std::lock_guard<std::mutex> lock(resync_mutex_);
+        resync_queue_.push_back(symbol);
+        if (!resync_running_) {
+            resync_running_ = true;
+            resync_thread_ = std::thread(&OrderbookManager::runResync, this);
+        }
+        resync_cv_.notify_one();
+    }
+
+void OrderbookManager::stopResync() {
+        {
+            std::lock_guard<std::mutex> lock(resync_mutex_);
+            resync_running_ = false;
+            resync_queue_.clear();
+        }
+        resync_cv_.notify_all();
+        if (resync_thread_.joinable()) {
+            resync_thread_.join();
+        }
+    }
+
+void OrderbookManager::runResync() {
+#ifdef __linux__
+        // 线程继承创建者（可能是已绑核的分片线程）的绑核设置，改回进程的可用核
+        cpu_set_t cpuset;
+        CPU_ZERO(&cpuset);
+        if (sched_getaffinity(getpid(), sizeof(cpuset), &cpuset) == 0) {
+            pthread_setaffinity_np(pthread_self(), sizeof(cpuset), &cpuset);
+        }
+        pthread_setname_np(pthread_self(), "ob-resync");
+#endif
+        std::unique_lock<std::mutex> lock(resync_mutex_);
+        while (resync_running_) {
+            if (resync_queue_.empty()) {
+                resync_cv_.wait(lock);
+                continue;
+            }
+            // 取第一个已过限频间隔的请求，都未到期时等到最早到期的那个
+            uint64_t now = nowMs();
+            uint64_t wait_ms = kMinResyncIntervalMs;
+            std::deque<symbol_t>::iterator ready = resync_queue_.end();
+            for (std::deque<symbol_t>::iterator it = resync_queue_.begin(); it != resync_queue_.end(); ++it) {
+                uint64_t elapsed = now - books_.get(*it)->last_resync_ms.load(std::memory_order_relaxed);
+                if (elapsed >= kMinResyncIntervalMs) {
+                    ready = it;
+                    break;
+                }
+                wait_ms = std::min(wait_ms, kMinResyncIntervalMs - elapsed);
+            }
+            if (ready == resync_queue_.end()) {
+                resync_cv_.wait_for(lock, std::chrono::milliseconds(wait_ms));
+                continue;
+            }
+            symbol_t symbol = *ready;
+            resync_queue_.erase(ready);
+            lock.unlock();
+            resync(symbol, *books_.get(symbol));
+            lock.lock();
+        }
+    }
+
+void OrderbookManager::resync(symbol_t symbol, SymbolBook& book) {
+        DepthSnapshotProvider provider;
+        {
+            std::lock_guard<std::mutex> lock(provider_mutex_);
+            provider = snapshot_provider_;
+        }
+        book.last_resync_ms.store(nowMs(), std::memory_order_relaxed);
+
+        // 获取快照时不持有写入区，写线程继续缓存增量
+        DepthSnapshot snapshot;
+        bool fetched = provider && provider(symbol, snapshot);
+        validator_.recordResync(fetched);
+
+        std::lock_guard<std::mutex> lock(book.write_mutex);
+        if (!fetched) {
+            spdlog::error("Orderbook resync failed: symbol={}", symbol);
+            // 放弃缓存的增量，下一个增量重新发现缺口并再次请求（限频）
+            book.syncing = false;
+            book.buffered.clear();
+            if (book.last_update_id != 0) {
+                quarantine(symbol, book, OrderbookIntegrityIssue::SEQUENCE_GAP);
+            }
+            return;
+        }
+
+        // 深订单薄整体替换为快照（保留全部档位），再按序重放期间缓存的增量
+        loadLevels(book.bids.levels, book.bids.boundary, snapshot.bids.data(), snapshot.bids.size(),
+                   snapshot.limit);
+        loadLevels(book.asks.levels, book.asks.boundary, snapshot.asks.data(), snapshot.asks.size(),
+                   snapshot.limit);
+        book.last_update_id = snapshot.last_update_id;
+        bool caught_up = replayBuffered(book);
+        OrderbookIntegrityIssue issue = publishDepth(symbol, book, true, nowMs());
+        if (caught_up) {
+            book.syncing = false;
+            book.resynced = true;
+            handleIntegrity(symbol, book, issue, true);
+        } else {
+            // 快照落后于缓存的增量：保持同步中，再取一次快照
+            quarantine(symbol, book, issue != OrderbookIntegrityIssue::NONE ? issue
+                                                                            : OrderbookIntegrityIssue::SEQUENCE_GAP);
+            enqueueResync(symbol);
+        }
+        notifyChanged(symbol, book);
+
+        spdlog::info("Orderbook resynced from snapshot: symbol={}, last_update_id={}, replayed_to={}, caught_up={}",
+                     symbol, snapshot.last_update_id, book.last_update_id, caught_up);
     }
-}
\ No newline at end of file
+}
@@ -0,0 +1,310 @@
+#include "orderbook_notifier.h"
+#include <spdlog/spdlog.h>
+#include <chrono>
+#include <cstring>
+#ifdef __linux__
+#include <pthread.h>
+#endif
+
+namespace crypto_quant {
+
+ConflatedSubscription::ConflatedSubscription(uint64_t id, symbol_t symbol)
+    : id_(id), symbol_(symbol), waiting_(false), closed_(false) {
+    for (size_t i = 0; i < kWordCount; ++i) {
+        dirty_[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+void ConflatedSubscription::markDirty(symbol_t symbol) {
+    if (symbol >= SymbolRegistry::kMaxSymbols) {
+        return;
+    }
+    std::atomic<uint64_t>& word = dirty_[symbol / 64];
+    uint64_t bit = 1ULL << (symbol % 64);
+    // 已标记过：消费者尚未取走，直接合并
+    if (word.load(std::memory_order_relaxed) & bit) {
+        return;
+    }
+    word.fetch_or(bit, std::memory_order_seq_cst);
+    // 与 wait 中先置 waiting_ 再检查位图配对，避免丢失唤醒
+    if (waiting_.load(std::memory_order_seq_cst)) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        cv_.notify_one();
+    }
+}
+
+bool ConflatedSubscription::hasPending() const {
+    for (size_t i = 0; i < kWordCount; ++i) {
+        if (dirty_[i].load(std::memory_order_seq_cst) != 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+size_t ConflatedSubscription::poll(symbol_t* symbols, size_t max_count) {
+    size_t count = 0;
+    for (size_t i = 0; i < kWordCount && count < max_count; ++i) {
+        if (dirty_[i].load(std::memory_order_relaxed) == 0) {
+            continue;
+        }
+        uint64_t bits = dirty_[i].exchange(0, std::memory_order_acquire);
+        while (bits != 0 && count < max_count) {
+            int bit = __builtin_ctzll(bits);
+            symbols[count++] = static_cast<symbol_t>(i * 64 + bit);
+            bits &= bits - 1;
+        }
+        // 输出已满，未取走的位放回去
+        if (bits != 0) {
+            dirty_[i].fetch_or(bits, std::memory_order_relaxed);
+        }
+    }
+    return count;
+}
+
+size_t ConflatedSubscription::wait(symbol_t* symbols, size_t max_count, int timeout_ms) {
+    size_t count = poll(symbols, max_count);
+    if (count > 0 || timeout_ms <= 0 || closed_.load()) {
+        return count;
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        waiting_.store(true, std::memory_order_seq_cst);
+        cv_.wait_for(lock, std::chrono::milliseconds(timeout_ms), [this]() {
+            return closed_.load() || hasPending();
+        });
+        waiting_.store(false, std::memory_order_relaxed);
+    }
+    return poll(symbols, max_count);
+}
+
+void ConflatedSubscription::close() {
+    closed_.store(true);
+    std::lock_guard<std::mutex> lock(mutex_);
+    cv_.notify_all();
+}
+
+EveryUpdateChannel::EveryUpdateChannel(uint64_t id, OrderbookUpdateCallback callback, size_t capacity)
+    : id_(id), callback_(callback), queue_(capacity), running_(false), waiting_(false), dropped_(0) {
+}
+
+void EveryUpdateChannel::start(const std::shared_ptr<EveryUpdateChannel>& self) {
+    self->running_.store(true);
+    self->thread_ = std::thread(&EveryUpdateChannel::run, self);
+}
+
+void EveryUpdateChannel::stop() {
+    if (!running_.exchange(false)) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(wait_mutex_);
+        cv_.notify_all();
+    }
+    if (!thread_.joinable()) {
+        return;
+    }
+    // 在回调内退订：线程返回后自行退出，它持有的引用让通道活到那时
+    if (thread_.get_id() == std::this_thread::get_id()) {
+        thread_.detach();
+    } else {
+        thread_.join();
+    }
+}
+
+void EveryUpdateChannel::run(std::shared_ptr<EveryUpdateChannel> self) {
+#ifdef __linux__
+    pthread_setname_np(pthread_self(), "ob-notify");
+#endif
+    EveryUpdateChannel& channel = *self;
+    orderbook_t orderbook;
+    while (channel.running_.load()) {
+        if (channel.queue_.tryPop([&orderbook](orderbook_t& queued) {
+                memcpy(&orderbook, &queued, sizeof(orderbook));
+            })) {
+            channel.callback_(orderbook);
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(channel.wait_mutex_);
+        channel.waiting_.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        channel.cv_.wait(lock, [&channel]() {
+            return !channel.running_.load() || channel.queue_.sizeApprox() != 0;
+        });
+        channel.waiting_.store(false, std::memory_order_relaxed);
+    }
+}
+
+const size_t OrderbookNotifier::kDeliveryQueueCapacity;
+const size_t OrderbookNotifier::kReaderStripes;
+
+OrderbookNotifier::OrderbookNotifier()
+    : list_(nullptr), next_id_(1), dropped_(0) {
+    for (size_t i = 0; i < kReaderStripes; ++i) {
+        readers_[i].active.store(0, std::memory_order_relaxed);
+    }
+}
+
+OrderbookNotifier::~OrderbookNotifier() {
+    // 析构时不再有写线程发布，也不再有订阅/退订
+    const SubscriberList* list = list_.load();
+    if (list) {
+        for (size_t i = 0; i < list->size(); ++i) {
+            if ((*list)[i].channel) {
+                (*list)[i].channel->stop();
+            }
+        }
+    }
+    for (size_t i = 0; i < retired_.size(); ++i) {
+        delete retired_[i].list;
+    }
+    delete list;
+}
+
+size_t OrderbookNotifier::stripeIndex() {
+    static std::atomic<size_t> next_stripe(0);
+    static thread_local size_t stripe = next_stripe.fetch_add(1, std::memory_order_relaxed) % kReaderStripes;
+    return stripe;
+}
+
+void OrderbookNotifier::replaceList(SubscriberList* list) {
+    if (list->empty()) {
+        delete list;
+        list = nullptr;
+    }
+    const SubscriberList* old = list_.exchange(list, std::memory_order_seq_cst);
+    if (old) {
+        // 写线程可能仍在遍历旧列表，等所有条带都归零过一次后释放
+        RetiredList retired;
+        retired.list = old;
+        retired.pending = (1u << kReaderStripes) - 1;
+        retired_.push_back(retired);
+    }
+    reclaimRetired();
+}
+
+void OrderbookNotifier::reclaimRetired() {
+    uint32_t idle = 0;
+    for (size_t i = 0; i < kReaderStripes; ++i) {
+        if (readers_[i].active.load(std::memory_order_seq_cst) == 0) {
+            idle |= 1u << i;
+        }
+    }
+    // 条带归零时，替换前进入该条带的读者都已离开；之后进入的读者只能读到新列表
+    size_t kept = 0;
+    for (size_t i = 0; i < retired_.size(); ++i) {
+        retired_[i].pending &= ~idle;
+        if (retired_[i].pending == 0) {
+            delete retired_[i].list;
+        } else {
+            retired_[kept++] = retired_[i];
+        }
+    }
+    retired_.resize(kept);
+}
+
+std::shared_ptr<IOrderbookSubscription> OrderbookNotifier::subscribeConflated(symbol_t symbol) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const SubscriberList* current = list_.load(std::memory_order_relaxed);
+    SubscriberList* list = current ? new SubscriberList(*current) : new SubscriberList();
+
+    Subscriber subscriber;
+    subscriber.id = next_id_++;
+    subscriber.symbol = symbol;
+    subscriber.conflated = std::make_shared<ConflatedSubscription>(subscriber.id, symbol);
+    list->push_back(subscriber);
+    replaceList(list);
+
+    spdlog::debug("Conflated orderbook subscription added: id={}, symbol={}", subscriber.id, symbol);
+    return subscriber.conflated;
+}
+
+uint64_t OrderbookNotifier::subscribeEveryUpdate(symbol_t symbol, OrderbookUpdateCallback callback) {
+    if (!callback) {
+        return 0;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    const SubscriberList* current = list_.load(std::memory_order_relaxed);
+    SubscriberList* list = current ? new SubscriberList(*current) : new SubscriberList();
+
+    Subscriber subscriber;
+    subscriber.id = next_id_++;
+    subscriber.symbol = symbol;
+    subscriber.channel = std::make_shared<EveryUpdateChannel>(subscriber.id, callback, kDeliveryQueueCapacity);
+    list->push_back(subscriber);
+    // 投递线程先于列表发布启动，写线程看到该订阅者时通道已就绪
+    EveryUpdateChannel::start(subscriber.channel);
+    replaceList(list);
+
+    spdlog::debug("Orderbook subscription added: id={}, symbol={}", subscriber.id, symbol);
+    return subscriber.id;
+}
+
+void OrderbookNotifier::unsubscribe(uint64_t subscription_id) {
+    std::shared_ptr<EveryUpdateChannel> channel;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!removeSubscriber(subscription_id, channel)) {
+            return;
+        }
+    }
+    spdlog::debug("Orderbook subscription removed: id={}", subscription_id);
+    if (!channel) {
+        return;
+    }
+    // 等待正在执行的回调结束；在回调内退订时只停止之后的投递
+    channel->stop();
+    if (channel->dropped() > 0) {
+        spdlog::warn("Orderbook subscription {} dropped {} updates (delivery queue full)",
+                     subscription_id, channel->dropped());
+    }
+    // 退订通常发生在写线程离开旧列表之后，趁此回收，尽早释放通道的队列
+    std::lock_guard<std::mutex> lock(mutex_);
+    reclaimRetired();
+}
+
+uint64_t OrderbookNotifier::droppedUpdates(uint64_t subscription_id) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const SubscriberList* list = list_.load(std::memory_order_relaxed);
+    if (!list) {
+        return 0;
+    }
+    for (size_t i = 0; i < list->size(); ++i) {
+        const Subscriber& subscriber = (*list)[i];
+        if (subscriber.id == subscription_id) {
+            return subscriber.channel ? subscriber.channel->dropped() : 0;
+        }
+    }
+    return 0;
+}
+
+bool OrderbookNotifier::removeSubscriber(uint64_t subscription_id,
+                                         std::shared_ptr<EveryUpdateChannel>& channel) {
+    const SubscriberList* current = list_.load(std::memory_order_relaxed);
+    if (!current) {
+        return false;
+    }
+
+    SubscriberList* list = new SubscriberList();
+    list->reserve(current->size());
+    for (size_t i = 0; i < current->size(); ++i) {
+        const Subscriber& subscriber = (*current)[i];
+        if (subscriber.id == subscription_id) {
+            if (subscriber.conflated) {
+                subscriber.conflated->close();
+            }
+            channel = subscriber.channel;
+            continue;
+        }
+        list->push_back(subscriber);
+    }
+    if (list->size() == current->size()) {
+        delete list;
+        return false;
+    }
+    replaceList(list);
+    return true;
+}
+
+} // namespace crypto_quant
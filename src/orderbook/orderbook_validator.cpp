@@ -0,0 +1,143 @@
+#include "orderbook_validator.h"
+
+namespace crypto_quant {
+
+OrderbookValidator::OrderbookValidator(const OrderbookValidatorConfig& config)
+    : max_age_ms_(config.max_age_ms), checked_(0), crossed_(0), non_monotonic_(0),
+      stale_timestamp_(0), sequence_gap_(0), quarantined_(0), resync_requested_(0),
+      resync_failed_(0), recovered_(0) {
+}
+
+OrderbookIntegrityIssue OrderbookValidator::record(OrderbookIntegrityIssue issue) {
+    switch (issue) {
+    case OrderbookIntegrityIssue::CROSSED:
+        crossed_.fetch_add(1, std::memory_order_relaxed);
+        break;
+    case OrderbookIntegrityIssue::NON_MONOTONIC:
+        non_monotonic_.fetch_add(1, std::memory_order_relaxed);
+        break;
+    case OrderbookIntegrityIssue::STALE_TIMESTAMP:
+        stale_timestamp_.fetch_add(1, std::memory_order_relaxed);
+        break;
+    case OrderbookIntegrityIssue::SEQUENCE_GAP:
+        sequence_gap_.fetch_add(1, std::memory_order_relaxed);
+        break;
+    case OrderbookIntegrityIssue::NONE:
+        break;
+    }
+    return issue;
+}
+
+OrderbookIntegrityIssue OrderbookValidator::checkSequence(uint64_t timestamp, uint64_t update_id,
+                                                          uint64_t previous_timestamp,
+                                                          uint64_t previous_update_id,
+                                                          uint64_t now_ms) {
+    // 更新ID回退（两者都已知时）
+    if (update_id != 0 && previous_update_id != 0 && update_id < previous_update_id) {
+        return OrderbookIntegrityIssue::SEQUENCE_GAP;
+    }
+    if (timestamp < previous_timestamp) {
+        return OrderbookIntegrityIssue::STALE_TIMESTAMP;
+    }
+    uint64_t max_age = max_age_ms_.load(std::memory_order_relaxed);
+    if (max_age != 0 && timestamp != 0 && now_ms > timestamp && now_ms - timestamp > max_age) {
+        return OrderbookIntegrityIssue::STALE_TIMESTAMP;
+    }
+    return OrderbookIntegrityIssue::NONE;
+}
+
+OrderbookIntegrityIssue OrderbookValidator::check(const orderbook_t& orderbook,
+                                                  uint64_t previous_timestamp,
+                                                  uint64_t previous_update_id,
+                                                  uint64_t now_ms) {
+    checked_.fetch_add(1, std::memory_order_relaxed);
+
+    const uint32_t bid_count = orderbook.bid_count;
+    const uint32_t ask_count = orderbook.ask_count;
+    // 档位数超出数组容量的订单薄无法逐档检查，按结构损坏处理
+    if (bid_count > ORDERBOOK_MAX_LEVELS || ask_count > ORDERBOOK_MAX_LEVELS) {
+        return record(OrderbookIntegrityIssue::NON_MONOTONIC);
+    }
+
+    // 买盘严格递减、卖盘严格递增，价格和数量为正（NaN 也在这里被拒绝）
+    for (uint32_t i = 0; i < bid_count; ++i) {
+        const price_level_t& level = orderbook.bids[i];
+        if (!(level.price > 0.0) || !(level.quantity > 0.0) ||
+            (i > 0 && !(level.price < orderbook.bids[i - 1].price))) {
+            return record(OrderbookIntegrityIssue::NON_MONOTONIC);
+        }
+    }
+    for (uint32_t i = 0; i < ask_count; ++i) {
+        const price_level_t& level = orderbook.asks[i];
+        if (!(level.price > 0.0) || !(level.quantity > 0.0) ||
+            (i > 0 && !(level.price > orderbook.asks[i - 1].price))) {
+            return record(OrderbookIntegrityIssue::NON_MONOTONIC);
+        }
+    }
+
+    if (bid_count > 0 && ask_count > 0 && orderbook.bids[0].price >= orderbook.asks[0].price) {
+        return record(OrderbookIntegrityIssue::CROSSED);
+    }
+
+    return record(checkSequence(orderbook.timestamp, orderbook.last_update_id,
+                                previous_timestamp, previous_update_id, now_ms));
+}
+
+OrderbookIntegrityIssue OrderbookValidator::checkTop(double best_bid, double best_ask,
+                                                     uint64_t timestamp, uint64_t update_id,
+                                                     uint64_t previous_timestamp,
+                                                     uint64_t previous_update_id,
+                                                     uint64_t now_ms) {
+    checked_.fetch_add(1, std::memory_order_relaxed);
+    if (best_bid > 0.0 && best_ask > 0.0 && best_bid >= best_ask) {
+        return record(OrderbookIntegrityIssue::CROSSED);
+    }
+    return record(checkSequence(timestamp, update_id, previous_timestamp, previous_update_id, now_ms));
+}
+
+OrderbookIntegrityIssue OrderbookValidator::checkEventAge(uint64_t event_time, uint64_t now_ms) {
+    uint64_t max_age = max_age_ms_.load(std::memory_order_relaxed);
+    if (max_age != 0 && event_time != 0 && now_ms > event_time && now_ms - event_time > max_age) {
+        return record(OrderbookIntegrityIssue::STALE_TIMESTAMP);
+    }
+    return OrderbookIntegrityIssue::NONE;
+}
+
+void OrderbookValidator::recordResync(bool success) {
+    resync_requested_.fetch_add(1, std::memory_order_relaxed);
+    if (!success) {
+        resync_failed_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+orderbook_integrity_stats_t OrderbookValidator::stats() const {
+    orderbook_integrity_stats_t stats;
+    stats.checked = checked_.load(std::memory_order_relaxed);
+    stats.crossed = crossed_.load(std::memory_order_relaxed);
+    stats.non_monotonic = non_monotonic_.load(std::memory_order_relaxed);
+    stats.stale_timestamp = stale_timestamp_.load(std::memory_order_relaxed);
+    stats.sequence_gap = sequence_gap_.load(std::memory_order_relaxed);
+    stats.quarantined = quarantined_.load(std::memory_order_relaxed);
+    stats.resync_requested = resync_requested_.load(std::memory_order_relaxed);
+    stats.resync_failed = resync_failed_.load(std::memory_order_relaxed);
+    stats.recovered = recovered_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+const char* OrderbookValidator::issueName(OrderbookIntegrityIssue issue) {
+    switch (issue) {
+    case OrderbookIntegrityIssue::NONE:
+        return "none";
+    case OrderbookIntegrityIssue::CROSSED:
+        return "crossed";
+    case OrderbookIntegrityIssue::NON_MONOTONIC:
+        return "non_monotonic";
+    case OrderbookIntegrityIssue::STALE_TIMESTAMP:
+        return "stale_timestamp";
+    case OrderbookIntegrityIssue::SEQUENCE_GAP:
+        return "sequence_gap";
+    }
+    return "unknown";
+}
+
+} // namespace crypto_quant
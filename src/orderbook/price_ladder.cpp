@@ -0,0 +1,179 @@
+#include "price_ladder.h"
+
+namespace crypto_quant {
+
+PriceLadder::PriceLadder(bool is_bid, size_t window_ticks)
+    : is_bid_(is_bid),
+      window_(((window_ticks + 63) / 64) * 64),
+      base_(0),
+      count_(0),
+      best_(0) {
+    if (window_ == 0) {
+        window_ = kDefaultWindowTicks;
+    }
+    quantities_.assign(window_, 0.0);
+    occupied_.assign(window_ / 64, 0);
+}
+
+double PriceLadder::bestQuantity() const {
+    if (count_ == 0) {
+        return 0.0;
+    }
+    return get(best_);
+}
+
+double PriceLadder::get(int64_t tick) const {
+    if (inWindow(tick)) {
+        return quantities_[static_cast<size_t>(tick - base_)];
+    }
+    std::map<int64_t, double>::const_iterator it = overflow_.find(tick);
+    return it != overflow_.end() ? it->second : 0.0;
+}
+
+void PriceLadder::set(int64_t tick, double quantity) {
+    if (quantity <= 0.0) {
+        remove(tick);
+        return;
+    }
+
+    // 空阶梯或新的最优价落在窗口之外：以该价格重新定位窗口
+    if (count_ == 0 || (better(tick, best_) && !inWindow(tick))) {
+        recenter(tick);
+        best_ = tick;
+    }
+
+    if (inWindow(tick)) {
+        size_t index = static_cast<size_t>(tick - base_);
+        uint64_t mask = 1ULL << (index & 63);
+        if ((occupied_[index >> 6] & mask) == 0) {
+            occupied_[index >> 6] |= mask;
+            ++count_;
+        }
+        quantities_[index] = quantity;
+        if (better(tick, best_)) {
+            best_ = tick;
+        }
+        return;
+    }
+
+    // 窗口外的深档位
+    std::pair<std::map<int64_t, double>::iterator, bool> inserted =
+        overflow_.insert(std::make_pair(tick, quantity));
+    if (inserted.second) {
+        ++count_;
+    } else {
+        inserted.first->second = quantity;
+    }
+}
+
+void PriceLadder::remove(int64_t tick) {
+    if (!inWindow(tick)) {
+        if (overflow_.erase(tick) > 0) {
+            --count_;
+        }
+        return;
+    }
+
+    size_t index = static_cast<size_t>(tick - base_);
+    uint64_t mask = 1ULL << (index & 63);
+    if ((occupied_[index >> 6] & mask) == 0) {
+        return;
+    }
+    occupied_[index >> 6] &= ~mask;
+    quantities_[index] = 0.0;
+    --count_;
+
+    if (tick != best_ || count_ == 0) {
+        return;
+    }
+
+    // 删除的是最优价：在窗口内向劣价方向找下一档，找不到则从溢出表取并重新定位窗口
+    int64_t next = 0;
+    if (scanWorse(tick, next)) {
+        best_ = next;
+        return;
+    }
+    best_ = is_bid_ ? overflow_.rbegin()->first : overflow_.begin()->first;
+    recenter(best_);
+}
+
+void PriceLadder::clear() {
+    for (size_t w = 0; w < occupied_.size(); ++w) {
+        uint64_t word = occupied_[w];
+        while (word) {
+            size_t bit = static_cast<size_t>(__builtin_ctzll(word));
+            quantities_[(w << 6) + bit] = 0.0;
+            word &= word - 1;
+        }
+        occupied_[w] = 0;
+    }
+    overflow_.clear();
+    count_ = 0;
+    best_ = 0;
+}
+
+void PriceLadder::recenter(int64_t best_tick) {
+    // 最优价放在窗口靠近优价一端，预留1/8窗口给价格改善
+    int64_t margin = static_cast<int64_t>(window_ / 8);
+    int64_t new_base = is_bid_ ? best_tick - static_cast<int64_t>(window_) + margin
+                               : best_tick - margin;
+    if (new_base == base_) {
+        return;
+    }
+
+    // 窗口内的档位先移入溢出表
+    for (size_t w = 0; w < occupied_.size(); ++w) {
+        uint64_t word = occupied_[w];
+        while (word) {
+            size_t index = (w << 6) + static_cast<size_t>(__builtin_ctzll(word));
+            overflow_[base_ + static_cast<int64_t>(index)] = quantities_[index];
+            quantities_[index] = 0.0;
+            word &= word - 1;
+        }
+        occupied_[w] = 0;
+    }
+
+    // 再把落入新窗口的档位移回稠密数组
+    base_ = new_base;
+    std::map<int64_t, double>::iterator it = overflow_.lower_bound(base_);
+    while (it != overflow_.end() && it->first < base_ + static_cast<int64_t>(window_)) {
+        size_t index = static_cast<size_t>(it->first - base_);
+        quantities_[index] = it->second;
+        occupied_[index >> 6] |= 1ULL << (index & 63);
+        overflow_.erase(it++);
+    }
+}
+
+bool PriceLadder::scanWorse(int64_t from_tick, int64_t& found) const {
+    int64_t index = from_tick - base_;
+    if (is_bid_) {
+        // 买盘：向低价方向
+        int64_t i = index - 1;
+        while (i >= 0) {
+            size_t w = static_cast<size_t>(i) >> 6;
+            unsigned bit = static_cast<unsigned>(i & 63);
+            uint64_t mask = bit == 63 ? ~0ULL : ((1ULL << (bit + 1)) - 1);
+            uint64_t word = occupied_[w] & mask;
+            if (word) {
+                found = base_ + static_cast<int64_t>((w << 6) + 63 - __builtin_clzll(word));
+                return true;
+            }
+            i = static_cast<int64_t>(w << 6) - 1;
+        }
+    } else {
+        // 卖盘：向高价方向
+        int64_t i = index + 1;
+        while (i < static_cast<int64_t>(window_)) {
+            size_t w = static_cast<size_t>(i) >> 6;
+            uint64_t word = occupied_[w] & (~0ULL << (i & 63));
+            if (word) {
+                found = base_ + static_cast<int64_t>((w << 6) + __builtin_ctzll(word));
+                return true;
+            }
+            i = static_cast<int64_t>((w + 1) << 6);
+        }
+    }
+    return false;
+}
+
+} // namespace crypto_quant
@@ -0,0 +1,416 @@
+#include "sharded_orderbook_manager.h"
+#include "symbol_registry.h"
+#include <spdlog/spdlog.h>
+#include <pthread.h>
+#include <sched.h>
+#include <chrono>
+#include <cstring>
+
+namespace crypto_quant {
+
+namespace {
+
+// 把当前线程绑定到指定CPU核，失败只记录警告
+void pinCurrentThread(int cpu) {
+#ifdef __linux__
+    cpu_set_t cpuset;
+    CPU_ZERO(&cpuset);
+    CPU_SET(cpu, &cpuset);
+    int rc = pthread_setaffinity_np(pthread_self(), sizeof(cpuset), &cpuset);
+    if (rc != 0) {
+        spdlog::warn("Failed to pin orderbook shard thread to cpu {}: {}", cpu, rc);
+    }
+#else
+    (void)cpu;
+#endif
+}
+
+// 当前线程可用的CPU核；有多个核时去掉0号核
+std::vector<int> defaultCpus() {
+    std::vector<int> cpus;
+#ifdef __linux__
+    cpu_set_t cpuset;
+    CPU_ZERO(&cpuset);
+    if (sched_getaffinity(0, sizeof(cpuset), &cpuset) == 0) {
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+            if (CPU_ISSET(cpu, &cpuset)) {
+                cpus.push_back(cpu);
+            }
+        }
+    }
+#endif
+    if (cpus.size() > 1 && cpus[0] == 0) {
+        cpus.erase(cpus.begin());
+    }
+    return cpus;
+}
+
+} // namespace
+
+ShardedOrderbookManager::Shard::Shard()
+    : index(0), enqueued(0), processed(0), diffs_applied(0), diffs_stale(0),
+      diffs_resynced(0), diffs_out_of_sync(0), diffs_buffered(0), queue_full(0) {
+}
+
+ShardedOrderbookManager::ShardedOrderbookManager(const ShardedOrderbookConfig& config)
+    : config_(config), running_(false) {
+    size_t shard_count = config_.shard_count;
+    if (shard_count == 0) {
+        shard_count = std::thread::hardware_concurrency();
+        if (shard_count == 0) {
+            shard_count = 1;
+        }
+    }
+    for (size_t i = 0; i < shard_count; ++i) {
+        std::unique_ptr<Shard> shard(new Shard());
+        shard->index = i;
+        shard->manager.reset(new OrderbookManager(&notifier_));
+        shard->queue.reset(new MpmcQueue<ShardMessage>(config_.queue_capacity));
+        shards_.push_back(std::move(shard));
+    }
+    if (config_.pin_threads) {
+        cpus_ = config_.cpus.empty() ? defaultCpus() : config_.cpus;
+    }
+    // 线程在构造时启动，initialize 之前写入的更新也会被处理
+    startThreads();
+}
+
+ShardedOrderbookManager::~ShardedOrderbookManager() {
+    stopThreads();
+    // 释放队列中残留差分的堆上档位
+    for (size_t i = 0; i < shards_.size(); ++i) {
+        while (shards_[i]->queue->tryPop([](ShardMessage& message) {
+            if (message.type == MESSAGE_DEPTH_DIFF) {
+                delete[] message.overflow;
+            }
+        })) {
+        }
+    }
+}
+
+void ShardedOrderbookManager::startThreads() {
+    std::lock_guard<std::mutex> lock(lifecycle_mutex_);
+    if (running_.load()) {
+        return;
+    }
+    running_.store(true);
+    for (size_t i = 0; i < shards_.size(); ++i) {
+        Shard* shard = shards_[i].get();
+        shard->thread = std::thread([this, shard]() { runShard(*shard); });
+    }
+}
+
+void ShardedOrderbookManager::stopThreads() {
+    std::lock_guard<std::mutex> lock(lifecycle_mutex_);
+    if (!running_.load()) {
+        return;
+    }
+    running_.store(false);
+    for (size_t i = 0; i < shards_.size(); ++i) {
+        if (shards_[i]->thread.joinable()) {
+            shards_[i]->thread.join();
+        }
+    }
+}
+
+bool ShardedOrderbookManager::initialize() {
+    for (size_t i = 0; i < shards_.size(); ++i) {
+        if (!shards_[i]->manager->initialize()) {
+            return false;
+        }
+    }
+    spdlog::info("ShardedOrderbookManager initialized: shards={}, queue_capacity={}",
+                 shards_.size(), shards_[0]->queue->capacity());
+    return true;
+}
+
+void ShardedOrderbookManager::cleanup() {
+    flush();
+    for (size_t i = 0; i < shards_.size(); ++i) {
+        shards_[i]->manager->cleanup();
+    }
+    spdlog::info("ShardedOrderbookManager cleaned up");
+}
+
+void ShardedOrderbookManager::runShard(Shard& shard) {
+    if (!cpus_.empty()) {
+        pinCurrentThread(cpus_[shard.index % cpus_.size()]);
+    }
+#ifdef __linux__
+    char name[16];
+    snprintf(name, sizeof(name), "ob-shard-%zu", shard.index);
+    pthread_setname_np(pthread_self(), name);
+#endif
+    spdlog::debug("Orderbook shard {} started", shard.index);
+
+    int idle_rounds = 0;
+    for (;;) {
+        bool popped = shard.queue->tryPop([this, &shard](ShardMessage& message) {
+            processMessage(shard, message);
+        });
+        if (popped) {
+            shard.processed.fetch_add(1, std::memory_order_release);
+            idle_rounds = 0;
+            continue;
+        }
+        // 停止时先处理完队列
+        if (!running_.load(std::memory_order_relaxed)) {
+            break;
+        }
+        // 空闲：先短暂自旋，之后让出CPU或休眠
+        if (++idle_rounds < 64) {
+            cpu_relax();
+        } else if (config_.idle_sleep_us > 0 && idle_rounds > 1024) {
+            std::this_thread::sleep_for(std::chrono::microseconds(config_.idle_sleep_us));
+        } else {
+            std::this_thread::yield();
+        }
+    }
+    spdlog::debug("Orderbook shard {} stopped", shard.index);
+}
+
+void ShardedOrderbookManager::processMessage(Shard& shard, ShardMessage& message) {
+    if (message.type == MESSAGE_ORDERBOOK) {
+        shard.manager->updateOrderbook(message.orderbook);
+        return;
+    }
+
+    depth_diff_t& diff = message.diff;
+    const price_level_t* levels = message.overflow ? message.overflow : message.levels;
+    diff.bids = levels;
+    diff.asks = levels + diff.bid_count;
+    DepthDiffResult result = shard.manager->applyDepthDiff(diff);
+    delete[] message.overflow;
+    message.overflow = nullptr;
+
+    switch (result) {
+    case DepthDiffResult::APPLIED:
+        shard.diffs_applied.fetch_add(1, std::memory_order_relaxed);
+        break;
+    case DepthDiffResult::STALE:
+        shard.diffs_stale.fetch_add(1, std::memory_order_relaxed);
+        break;
+    case DepthDiffResult::RESYNCED:
+        shard.diffs_resynced.fetch_add(1, std::memory_order_relaxed);
+        break;
+    case DepthDiffResult::OUT_OF_SYNC:
+        shard.diffs_out_of_sync.fetch_add(1, std::memory_order_relaxed);
+        break;
+    case DepthDiffResult::BUFFERED:
+        shard.diffs_buffered.fetch_add(1, std::memory_order_relaxed);
+        break;
+    case DepthDiffResult::QUEUED:
+        break;
+    }
+}
+
+template <typename Fill>
+void ShardedOrderbookManager::enqueue(Shard& shard, Fill fill) {
+    if (!shard.queue->tryPush(fill)) {
+        // 队列满：等待分片线程腾出位置，不丢弃更新
+        shard.queue_full.fetch_add(1, std::memory_order_relaxed);
+        SpinBackoff backoff;
+        while (!shard.queue->tryPush(fill)) {
+            backoff.pause();
+        }
+    }
+    shard.enqueued.fetch_add(1, std::memory_order_release);
+}
+
+void ShardedOrderbookManager::updateOrderbook(const orderbook_t& orderbook) {
+    if (!SymbolRegistry::instance().contains(orderbook.symbol)) {
+        spdlog::error("Invalid symbol index: {}", orderbook.symbol);
+        return;
+    }
+    enqueue(shardFor(orderbook.symbol), [&orderbook](ShardMessage& message) {
+        message.type = MESSAGE_ORDERBOOK;
+        message.overflow = nullptr;
+        memcpy(&message.orderbook, &orderbook, sizeof(orderbook));
+    });
+}
+
+DepthDiffResult ShardedOrderbookManager::applyDepthDiff(const depth_diff_t& diff) {
+    if (!SymbolRegistry::instance().contains(diff.symbol)) {
+        spdlog::error("Invalid symbol index: {}", diff.symbol);
+        return DepthDiffResult::OUT_OF_SYNC;
+    }
+
+    // 档位由调用方持有，入队前拷贝；超出内联容量时先在队列外分配
+    size_t level_count = static_cast<size_t>(diff.bid_count) + diff.ask_count;
+    price_level_t* overflow = nullptr;
+    if (level_count > kInlineLevels) {
+        overflow = new price_level_t[level_count];
+        memcpy(overflow, diff.bids, diff.bid_count * sizeof(price_level_t));
+        memcpy(overflow + diff.bid_count, diff.asks, diff.ask_count * sizeof(price_level_t));
+    }
+    enqueue(shardFor(diff.symbol), [&diff, overflow](ShardMessage& message) {
+        message.type = MESSAGE_DEPTH_DIFF;
+        message.diff = diff;
+        message.diff.bids = nullptr;
+        message.diff.asks = nullptr;
+        message.overflow = overflow;
+        if (!overflow) {
+            memcpy(message.levels, diff.bids, diff.bid_count * sizeof(price_level_t));
+            memcpy(message.levels + diff.bid_count, diff.asks, diff.ask_count * sizeof(price_level_t));
+        }
+    });
+    return DepthDiffResult::QUEUED;
+}
+
+void ShardedOrderbookManager::flush() {
+    for (size_t i = 0; i < shards_.size(); ++i) {
+        Shard& shard = *shards_[i];
+        uint64_t target = shard.enqueued.load(std::memory_order_acquire);
+        SpinBackoff backoff;
+        while (shard.processed.load(std::memory_order_acquire) < target) {
+            if (!running_.load()) {
+                break;
+            }
+            backoff.pause();
+        }
+    }
+}
+
+ShardStats ShardedOrderbookManager::getShardStats(size_t shard_index) const {
+    ShardStats stats;
+    memset(&stats, 0, sizeof(stats));
+    if (shard_index >= shards_.size()) {
+        return stats;
+    }
+    const Shard& shard = *shards_[shard_index];
+    stats.enqueued = shard.enqueued.load();
+    stats.processed = shard.processed.load();
+    stats.diffs_applied = shard.diffs_applied.load();
+    stats.diffs_stale = shard.diffs_stale.load();
+    stats.diffs_resynced = shard.diffs_resynced.load();
+    stats.diffs_out_of_sync = shard.diffs_out_of_sync.load();
+    stats.diffs_buffered = shard.diffs_buffered.load();
+    stats.queue_full = shard.queue_full.load();
+    return stats;
+}
+
+void ShardedOrderbookManager::setValidatorConfig(const OrderbookValidatorConfig& config) {
+    for (size_t i = 0; i < shards_.size(); ++i) {
+        shards_[i]->manager->setValidatorConfig(config);
+    }
+}
+
+orderbook_t ShardedOrderbookManager::getOrderbook(symbol_t symbol) const {
+    return shardFor(symbol).manager->getOrderbook(symbol);
+}
+
+double ShardedOrderbookManager::getBestBid(symbol_t symbol) const {
+    return shardFor(symbol).manager->getBestBid(symbol);
+}
+
+double ShardedOrderbookManager::getBestAsk(symbol_t symbol) const {
+    return shardFor(symbol).manager->getBestAsk(symbol);
+}
+
+double ShardedOrderbookManager::getMidPrice(symbol_t symbol) const {
+    return shardFor(symbol).manager->getMidPrice(symbol);
+}
+
+double ShardedOrderbookManager::getSpread(symbol_t symbol) const {
+    return shardFor(symbol).manager->getSpread(symbol);
+}
+
+double ShardedOrderbookManager::getBidDepth(symbol_t symbol, int levels) const {
+    return shardFor(symbol).manager->getBidDepth(symbol, levels);
+}
+
+double ShardedOrderbookManager::getAskDepth(symbol_t symbol, int levels) const {
+    return shardFor(symbol).manager->getAskDepth(symbol, levels);
+}
+
+double ShardedOrderbookManager::getDepthWithinBps(symbol_t symbol, double bps, bool bid) const {
+    return shardFor(symbol).manager->getDepthWithinBps(symbol, bps, bid);
+}
+
+double ShardedOrderbookManager::getVwap(symbol_t symbol, int levels, bool bid) const {
+    return shardFor(symbol).manager->getVwap(symbol, levels, bid);
+}
+
+double ShardedOrderbookManager::getCostToFill(symbol_t symbol, double quantity, bool buy,
+                                              double* filled_quantity) const {
+    return shardFor(symbol).manager->getCostToFill(symbol, quantity, buy, filled_quantity);
+}
+
+uint64_t ShardedOrderbookManager::getTimestamp(symbol_t symbol) const {
+    return shardFor(symbol).manager->getTimestamp(symbol);
+}
+
+bool ShardedOrderbookManager::isValid(symbol_t symbol) const {
+    return shardFor(symbol).manager->isValid(symbol);
+}
+
+size_t ShardedOrderbookManager::getTopOfBook(const symbol_t* symbols, size_t count,
+                                             top_of_book_t* out) const {
+    size_t valid_count = 0;
+    for (size_t i = 0; i < count; ++i) {
+        valid_count += shardFor(symbols[i]).manager->getTopOfBook(&symbols[i], 1, &out[i]);
+    }
+    return valid_count;
+}
+
+void ShardedOrderbookManager::setSnapshotProvider(DepthSnapshotProvider provider) {
+    // 快照由各分片管理器的后台重新同步线程获取，分片线程只缓存期间的增量，不被 REST 请求阻塞
+    for (size_t i = 0; i < shards_.size(); ++i) {
+        shards_[i]->manager->setSnapshotProvider(provider);
+    }
+}
+
+std::shared_ptr<IOrderbookSubscription> ShardedOrderbookManager::subscribeConflated(symbol_t symbol) {
+    return notifier_.subscribeConflated(symbol);
+}
+
+uint64_t ShardedOrderbookManager::subscribeEveryUpdate(symbol_t symbol, OrderbookUpdateCallback callback) {
+    return notifier_.subscribeEveryUpdate(symbol, callback);
+}
+
+void ShardedOrderbookManager::unsubscribe(uint64_t subscription_id) {
+    notifier_.unsubscribe(subscription_id);
+}
+
+uint64_t ShardedOrderbookManager::droppedUpdates(uint64_t subscription_id) const {
+    return notifier_.droppedUpdates(subscription_id);
+}
+
+bool ShardedOrderbookManager::isQuarantined(symbol_t symbol) const {
+    return shardFor(symbol).manager->isQuarantined(symbol);
+}
+
+orderbook_integrity_stats_t ShardedOrderbookManager::getIntegrityStats() const {
+    orderbook_integrity_stats_t total;
+    memset(&total, 0, sizeof(total));
+    for (size_t i = 0; i < shards_.size(); ++i) {
+        orderbook_integrity_stats_t stats = shards_[i]->manager->getIntegrityStats();
+        total.checked += stats.checked;
+        total.crossed += stats.crossed;
+        total.non_monotonic += stats.non_monotonic;
+        total.stale_timestamp += stats.stale_timestamp;
+        total.sequence_gap += stats.sequence_gap;
+        total.quarantined += stats.quarantined;
+        total.resync_requested += stats.resync_requested;
+        total.resync_failed += stats.resync_failed;
+        total.recovered += stats.recovered;
+    }
+    return total;
+}
+
+bool ShardedOrderbookManager::setHistoryCapacity(symbol_t symbol, size_t capacity) {
+    return shardFor(symbol).manager->setHistoryCapacity(symbol, capacity);
+}
+
+bool ShardedOrderbookManager::getOrderbookAt(symbol_t symbol, uint64_t timestamp,
+                                             orderbook_t& orderbook) const {
+    return shardFor(symbol).manager->getOrderbookAt(symbol, timestamp, orderbook);
+}
+
+size_t ShardedOrderbookManager::forEachOrderbookInRange(
+        symbol_t symbol, uint64_t from, uint64_t to,
+        const std::function<bool(const orderbook_t&)>& fn) const {
+    return shardFor(symbol).manager->forEachOrderbookInRange(symbol, from, to, fn);
+}
+
+} // namespace crypto_quant
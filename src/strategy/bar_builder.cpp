@@ -0,0 +1,204 @@
+#include "bar_builder.h"
+#include "symbol_registry.h"
+#include <spdlog/spdlog.h>
+#include <cmath>
+#include <cstring>
+
+namespace crypto_quant {
+
+namespace {
+
+const char* barTypeName(BarType type) {
+    switch (type) {
+    case BarType::TIME:
+        return "time";
+    case BarType::VOLUME:
+        return "volume";
+    case BarType::TICK:
+        return "tick";
+    case BarType::DOLLAR:
+        return "dollar";
+    }
+    return "unknown";
+}
+
+} // namespace
+
+BarBuilder::BarBuilder() : bar_count_(0) {
+}
+
+int BarBuilder::addSpec(const BarSpec& spec) {
+    if (!(spec.threshold > 0.0) || !std::isfinite(spec.threshold)) {
+        spdlog::error("Invalid {} bar threshold: {}", barTypeName(spec.type), spec.threshold);
+        return -1;
+    }
+    SpecState state;
+    state.spec = spec;
+    state.interval_ms = 0;
+    if (spec.type == BarType::TIME) {
+        state.interval_ms = static_cast<uint64_t>(std::llround(spec.threshold));
+        if (state.interval_ms == 0) {
+            spdlog::error("Time bar interval must be at least 1 ms: {}", spec.threshold);
+            return -1;
+        }
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    specs_.push_back(state);
+    spdlog::info("Bar spec {} added: type={}, threshold={}", specs_.size() - 1, barTypeName(spec.type), spec.threshold);
+    return static_cast<int>(specs_.size() - 1);
+}
+
+size_t BarBuilder::specCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return specs_.size();
+}
+
+void BarBuilder::setBarCallback(std::function<void(const bar_t&)> callback) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    callback_ = callback;
+}
+
+void BarBuilder::onTrade(const trade_t& trade) {
+    if (trade.symbol >= SymbolRegistry::kMaxSymbols || !(trade.quantity > 0.0) || !(trade.price > 0.0)) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (size_t i = 0; i < specs_.size(); ++i) {
+        addTrade(static_cast<uint32_t>(i), specs_[i], trade);
+    }
+}
+
+void BarBuilder::addTrade(uint32_t index, SpecState& state, const trade_t& trade) {
+    if (state.bars.size() <= trade.symbol) {
+        OpenBar empty;
+        memset(&empty, 0, sizeof(empty));
+        state.bars.resize(trade.symbol + 1, empty);
+    }
+    OpenBar& open = state.bars[trade.symbol];
+    bar_t& bar = open.bar;
+
+    uint64_t bucket = 0;
+    if (state.spec.type == BarType::TIME) {
+        bucket = trade.trade_time - trade.trade_time % state.interval_ms;
+        if (bucket < open.closed_until) {
+            bucket = open.closed_until;
+        }
+        if (bar.trade_count != 0 && bucket > bar.open_time) {
+            closeBar(open);
+        }
+    }
+
+    const double notional = trade.price * trade.quantity;
+    if (bar.trade_count == 0) {
+        bar.symbol = trade.symbol;
+        bar.spec = index;
+        bar.type = state.spec.type;
+        if (state.spec.type == BarType::TIME) {
+            bar.open_time = bucket;
+            bar.close_time = bucket + state.interval_ms - 1;
+        } else {
+            bar.open_time = trade.trade_time;
+            bar.close_time = trade.trade_time;
+        }
+        bar.open = trade.price;
+        bar.high = trade.price;
+        bar.low = trade.price;
+        bar.volume = 0.0;
+        bar.quote_volume = 0.0;
+        bar.buy_volume = 0.0;
+    } else {
+        if (trade.price > bar.high) {
+            bar.high = trade.price;
+        }
+        if (trade.price < bar.low) {
+            bar.low = trade.price;
+        }
+        if (state.spec.type != BarType::TIME && trade.trade_time > bar.close_time) {
+            bar.close_time = trade.trade_time;
+        }
+    }
+    bar.close = trade.price;
+    ++bar.trade_count;
+    bar.volume += trade.quantity;
+    bar.quote_volume += notional;
+    if (trade.is_buyer_maker == 0) {
+        bar.buy_volume += trade.quantity;
+    }
+    bar.vwap = bar.quote_volume / bar.volume;
+
+    switch (state.spec.type) {
+    case BarType::VOLUME:
+        if (bar.volume >= state.spec.threshold) {
+            closeBar(open);
+        }
+        break;
+    case BarType::TICK:
+        if (bar.trade_count >= state.spec.threshold) {
+            closeBar(open);
+        }
+        break;
+    case BarType::DOLLAR:
+        if (bar.quote_volume >= state.spec.threshold) {
+            closeBar(open);
+        }
+        break;
+    case BarType::TIME:
+        break;
+    }
+}
+
+void BarBuilder::closeBar(OpenBar& open) {
+    if (open.bar.type == BarType::TIME) {
+        open.closed_until = open.bar.close_time + 1;
+    }
+    ++bar_count_;
+    if (callback_) {
+        callback_(open.bar);
+    }
+    open.bar.trade_count = 0;
+}
+
+void BarBuilder::flush(uint64_t now_ms) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (size_t i = 0; i < specs_.size(); ++i) {
+        SpecState& state = specs_[i];
+        if (state.spec.type != BarType::TIME) {
+            continue;
+        }
+        for (size_t symbol = 0; symbol < state.bars.size(); ++symbol) {
+            OpenBar& open = state.bars[symbol];
+            if (open.bar.trade_count != 0 && now_ms > open.bar.close_time) {
+                closeBar(open);
+            }
+        }
+    }
+}
+
+bool BarBuilder::getCurrentBar(symbol_t symbol, uint32_t spec, bar_t& bar) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (spec >= specs_.size() || symbol >= specs_[spec].bars.size()) {
+        return false;
+    }
+    const OpenBar& open = specs_[spec].bars[symbol];
+    if (open.bar.trade_count == 0) {
+        return false;
+    }
+    bar = open.bar;
+    return true;
+}
+
+void BarBuilder::reset(symbol_t symbol) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (size_t i = 0; i < specs_.size(); ++i) {
+        if (symbol < specs_[i].bars.size()) {
+            specs_[i].bars[symbol].bar.trade_count = 0;
+        }
+    }
+}
+
+uint64_t BarBuilder::barCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return bar_count_;
+}
+
+} // namespace crypto_quant
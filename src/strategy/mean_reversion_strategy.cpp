@@ -1,4 +1,5 @@
 #include "crypto_quant.h"
+#include "symbol_registry.h"
 #include <spdlog/spdlog.h>
 #include <algorithm>
 #include <cmath>
@@ -16,11 +17,6 @@ private:
 
 public:
     MeanReversionStrategy() : status_(StrategyStatus::STOPPED) {
-        price_history_.resize(3);
-        price_count_.resize(3, 0);
-        for (auto& history : price_history_) {
-            history.reserve(100);
-        }
     }
 
     bool initialize() override {
@@ -35,7 +31,7 @@ public:
         for (auto& history : price_history_) {
             history.clear();
         }
-        price_count_.assign(3, 0);
+        price_count_.assign(price_count_.size(), 0);
         status_ = StrategyStatus::STOPPED;
         spdlog::info("MeanReversionStrategy cleaned up");
     }
@@ -47,10 +43,15 @@ public:
             return SignalType::NONE;
         }
 
-        int symbol_index = static_cast<int>(orderbook.symbol);
-        if (symbol_index < 0 || symbol_index >= 3) {
+        size_t symbol_index = orderbook.symbol;
+        if (symbol_index >= SymbolRegistry::kMaxSymbols) {
             return SignalType::NONE;
         }
+        // 按交易对ID按需扩容
+        if (symbol_index >= price_history_.size()) {
+            price_history_.resize(symbol_index + 1);
+            price_count_.resize(symbol_index + 1, 0);
+        }
 
         // 更新价格历史
         double mid_price = (orderbook.bids[0].price + orderbook.asks[0].price) / 2.0;
@@ -122,4 +123,8 @@ public:
     }
 };
 
-} // namespace crypto_quant
\ No newline at end of file
+std::shared_ptr<IStrategy> CryptoQuantFactory::createMeanReversionStrategy() {
+    return std::shared_ptr<IStrategy>(new MeanReversionStrategy());
+}
+
+} // namespace crypto_quant
@@ -0,0 +1,224 @@
+#include "microstructure_features.h"
+#include "fixed_point.h"
+#include "symbol_registry.h"
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace crypto_quant {
+
+namespace {
+
+const double kLn2 = 0.69314718055994530942;
+
+// 经过 dt 毫秒后的衰减系数
+inline double decayFactor(double dt_ms, double tau_ms) {
+    return dt_ms > 0.0 ? std::exp(-dt_ms / tau_ms) : 1.0;
+}
+
+} // namespace
+
+MicrostructureFeatureEngine::MicrostructureFeatureEngine(const MicrostructureConfig& config)
+    : config_(config), symbols_(SymbolRegistry::kMaxSymbols), subscription_id_(0) {
+    config_.imbalance_levels = std::max(1, std::min(config_.imbalance_levels, 20));
+    if (config_.flow_half_life_ms <= 0.0) {
+        config_.flow_half_life_ms = 1000.0;
+    }
+    if (config_.spread_half_life_ms <= 0.0) {
+        config_.spread_half_life_ms = 60000.0;
+    }
+    flow_tau_ms_ = config_.flow_half_life_ms / kLn2;
+    spread_tau_ms_ = config_.spread_half_life_ms / kLn2;
+}
+
+MicrostructureFeatureEngine::~MicrostructureFeatureEngine() {
+    detach();
+}
+
+bool MicrostructureFeatureEngine::update(const orderbook_t& orderbook, microstructure_features_t* features) {
+    if (!SymbolRegistry::instance().contains(orderbook.symbol)) {
+        spdlog::error("Invalid symbol index: {}", orderbook.symbol);
+        return false;
+    }
+    SymbolFeatures* entry = symbols_.getOrCreate(orderbook.symbol, [](size_t index, SymbolFeatures& symbol) {
+        memset(&symbol.state, 0, sizeof(symbol.state));
+        symbol.update_count = 0;
+        InstrumentSpec spec;
+        if (FixedPointRegistry::instance().getSpec(static_cast<symbol_t>(index), spec)) {
+            symbol.state.tick_size = spec.tickSize();
+        }
+    });
+    FlowState& state = entry->state;
+    ++entry->update_count;
+
+    microstructure_features_t& out = entry->published.beginWrite();
+    out.symbol = orderbook.symbol;
+    out.timestamp = orderbook.timestamp;
+    out.update_count = entry->update_count;
+    if (orderbook.bid_count == 0 || orderbook.ask_count == 0) {
+        // 单边订单薄：保留上一次的特征，只标记无效；流量状态在恢复双边后重新开始
+        out.valid = 0;
+        entry->published.endWrite();
+        state.has_previous = false;
+        if (features) {
+            *features = entry->published.load();
+        }
+        return true;
+    }
+
+    const double bid_price = orderbook.bids[0].price;
+    const double bid_quantity = orderbook.bids[0].quantity;
+    const double ask_price = orderbook.asks[0].price;
+    const double ask_quantity = orderbook.asks[0].quantity;
+
+    double ofi = 0.0;
+    double bid_depletion = 0.0;
+    double ask_depletion = 0.0;
+    double dt_ms = 0.0;
+    if (state.has_previous) {
+        dt_ms = orderbook.timestamp > state.timestamp
+                    ? static_cast<double>(orderbook.timestamp - state.timestamp) : 0.0;
+        // OFI：买一价上升/不变时计入新买量，下降/不变时扣除旧买量；卖侧对称
+        if (bid_price >= state.bid_price) {
+            ofi += bid_quantity;
+        }
+        if (bid_price <= state.bid_price) {
+            ofi -= state.bid_quantity;
+        }
+        if (ask_price <= state.ask_price) {
+            ofi -= ask_quantity;
+        }
+        if (ask_price >= state.ask_price) {
+            ofi += state.ask_quantity;
+        }
+        // 队列消耗：同价位数量减少，或整档被吃掉/撤掉使最优价后退
+        if (bid_price == state.bid_price) {
+            bid_depletion = std::max(0.0, state.bid_quantity - bid_quantity);
+        } else if (bid_price < state.bid_price) {
+            bid_depletion = state.bid_quantity;
+        }
+        if (ask_price == state.ask_price) {
+            ask_depletion = std::max(0.0, state.ask_quantity - ask_quantity);
+        } else if (ask_price > state.ask_price) {
+            ask_depletion = state.ask_quantity;
+        }
+    }
+
+    const double flow_decay = decayFactor(dt_ms, flow_tau_ms_);
+    state.ofi_flow = state.ofi_flow * flow_decay + ofi;
+    state.bid_depleted = state.bid_depleted * flow_decay + bid_depletion;
+    state.ask_depleted = state.ask_depleted * flow_decay + ask_depletion;
+
+    const double spread = ask_price - bid_price;
+    if (!state.has_previous || state.spread_ewma <= 0.0) {
+        state.spread_ewma = spread;
+    } else {
+        double alpha = 1.0 - decayFactor(dt_ms, spread_tau_ms_);
+        state.spread_ewma += alpha * (spread - state.spread_ewma);
+    }
+
+    // 多档不平衡：每侧前N档按档位衰减加权
+    double weighted_bid = 0.0;
+    double weighted_ask = 0.0;
+    double weight = 1.0;
+    const uint32_t levels = static_cast<uint32_t>(config_.imbalance_levels);
+    for (uint32_t i = 0; i < levels; ++i) {
+        if (i < orderbook.bid_count) {
+            weighted_bid += weight * orderbook.bids[i].quantity;
+        }
+        if (i < orderbook.ask_count) {
+            weighted_ask += weight * orderbook.asks[i].quantity;
+        }
+        weight *= config_.level_decay;
+    }
+
+    const double top_quantity = bid_quantity + ask_quantity;
+    const double mid = (bid_price + ask_price) * 0.5;
+    out.valid = 1;
+    out.mid_price = mid;
+    out.microprice = top_quantity > 0.0
+                         ? (bid_price * ask_quantity + ask_price * bid_quantity) / top_quantity : mid;
+    out.spread = spread;
+    out.spread_bps = mid > 0.0 ? spread / mid * 1e4 : 0.0;
+    out.spread_ewma = state.spread_ewma;
+    out.imbalance_l1 = top_quantity > 0.0 ? (bid_quantity - ask_quantity) / top_quantity : 0.0;
+    out.imbalance_multi = weighted_bid + weighted_ask > 0.0
+                              ? (weighted_bid - weighted_ask) / (weighted_bid + weighted_ask) : 0.0;
+    out.ofi = ofi;
+    out.ofi_flow = state.ofi_flow;
+    // 衰减累计量除以时间常数即为单位时间的速率
+    out.bid_depletion_rate = state.bid_depleted / flow_tau_ms_ * 1000.0;
+    out.ask_depletion_rate = state.ask_depleted / flow_tau_ms_ * 1000.0;
+
+    const double ratio = state.spread_ewma > 0.0 ? spread / state.spread_ewma : 1.0;
+    if ((state.tick_size > 0.0 && spread <= state.tick_size * 1.5) || ratio <= config_.tight_ratio) {
+        out.spread_regime = SPREAD_REGIME_TIGHT;
+    } else if (ratio >= config_.wide_ratio) {
+        out.spread_regime = SPREAD_REGIME_WIDE;
+    } else {
+        out.spread_regime = SPREAD_REGIME_NORMAL;
+    }
+    if (features) {
+        memcpy(static_cast<void*>(features), &out, sizeof(out));
+    }
+    entry->published.endWrite();
+
+    state.has_previous = true;
+    state.bid_price = bid_price;
+    state.bid_quantity = bid_quantity;
+    state.ask_price = ask_price;
+    state.ask_quantity = ask_quantity;
+    state.timestamp = std::max(state.timestamp, orderbook.timestamp);
+    return true;
+}
+
+bool MicrostructureFeatureEngine::getFeatures(symbol_t symbol, microstructure_features_t& features) const {
+    const SymbolFeatures* entry = symbols_.get(symbol);
+    if (!entry) {
+        return false;
+    }
+    features = entry->published.load();
+    return features.update_count != 0;
+}
+
+void MicrostructureFeatureEngine::reset(symbol_t symbol) {
+    SymbolFeatures* entry = symbols_.get(symbol);
+    if (!entry) {
+        return;
+    }
+    double tick_size = entry->state.tick_size;
+    memset(&entry->state, 0, sizeof(entry->state));
+    entry->state.tick_size = tick_size;
+    entry->update_count = 0;
+    microstructure_features_t empty;
+    memset(static_cast<void*>(&empty), 0, sizeof(empty));
+    empty.symbol = symbol;
+    entry->published.store(empty);
+}
+
+bool MicrostructureFeatureEngine::attach(std::shared_ptr<IOrderbookManager> manager, symbol_t symbol) {
+    if (!manager) {
+        return false;
+    }
+    detach();
+    std::lock_guard<std::mutex> lock(attach_mutex_);
+    manager_ = manager;
+    subscription_id_ = manager->subscribeEveryUpdate(symbol, [this](const orderbook_t& orderbook) {
+        update(orderbook);
+    });
+    spdlog::info("Microstructure feature engine attached: symbol={}, subscription={}",
+                 symbol, subscription_id_);
+    return true;
+}
+
+void MicrostructureFeatureEngine::detach() {
+    std::lock_guard<std::mutex> lock(attach_mutex_);
+    if (manager_) {
+        manager_->unsubscribe(subscription_id_);
+        manager_.reset();
+        subscription_id_ = 0;
+    }
+}
+
+} // namespace crypto_quant
@@ -1,4 +1,5 @@
 #include "crypto_quant.h"
+#include "symbol_registry.h"
 #include <spdlog/spdlog.h>
 #include <algorithm>
 #include <cmath>
@@ -14,50 +15,27 @@ private:
     std::vector<int> price_count_;
     mutable std::mutex mutex_;
 
-public:
-    MomentumStrategy() : status_(StrategyStatus::STOPPED) {
-        price_history_.resize(3);
-        price_count_.resize(3, 0);
-        for (auto& history : price_history_) {
-            history.reserve(100);
-        }
-    }
-
-    bool initialize() override {
-        std::lock_guard<std::mutex> lock(mutex_);
-        status_ = StrategyStatus::STOPPED;
-        spdlog::info("MomentumStrategy initialized");
-        return true;
-    }
-
-    void cleanup() override {
-        std::lock_guard<std::mutex> lock(mutex_);
-        for (auto& history : price_history_) {
-            history.clear();
-        }
-        price_count_.assign(3, 0);
-        status_ = StrategyStatus::STOPPED;
-        spdlog::info("MomentumStrategy cleaned up");
-    }
-
-    SignalType processMarketData(const orderbook_t& orderbook) override {
-        std::lock_guard<std::mutex> lock(mutex_);
-        
+    // 更新价格历史并计算动量信号（调用方持有 mutex_）；features 非空时用订单流确认
+    SignalType evaluate(symbol_t symbol, double price, const microstructure_features_t* features) {
         if (status_ != StrategyStatus::RUNNING) {
             return SignalType::NONE;
         }
 
-        int symbol_index = static_cast<int>(orderbook.symbol);
-        if (symbol_index < 0 || symbol_index >= 3) {
+        size_t symbol_index = symbol;
+        if (symbol_index >= SymbolRegistry::kMaxSymbols) {
             return SignalType::NONE;
         }
+        // 按交易对ID按需扩容
+        if (symbol_index >= price_history_.size()) {
+            price_history_.resize(symbol_index + 1);
+            price_count_.resize(symbol_index + 1, 0);
+        }
 
         // 更新价格历史
-        double mid_price = (orderbook.bids[0].price + orderbook.asks[0].price) / 2.0;
         auto& history = price_history_[symbol_index];
         auto& count = price_count_[symbol_index];
 
-        history.push_back(mid_price);
+        history.push_back(price);
         if (history.size() > 100) {
             history.erase(history.begin());
         } else {
@@ -88,9 +66,16 @@ public:
         
         // 生成交易信号
         if (momentum > params_.momentum_threshold) {
+            // 卖压累计（OFI 为负）或盘口明显偏向卖方时不追涨
+            if (features && (features->ofi_flow < 0.0 || features->imbalance_multi < -params_.imbalance_threshold)) {
+                return SignalType::NONE;
+            }
             spdlog::info("MomentumStrategy: BUY signal, momentum={:.4f}", momentum);
             return SignalType::BUY;
         } else if (momentum < -params_.momentum_threshold) {
+            if (features && (features->ofi_flow > 0.0 || features->imbalance_multi > params_.imbalance_threshold)) {
+                return SignalType::NONE;
+            }
             spdlog::info("MomentumStrategy: SELL signal, momentum={:.4f}", momentum);
             return SignalType::SELL;
         }
@@ -98,6 +83,46 @@ public:
         return SignalType::NONE;
     }
 
+public:
+    MomentumStrategy() : status_(StrategyStatus::STOPPED) {
+    }
+
+    bool initialize() override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        status_ = StrategyStatus::STOPPED;
+        spdlog::info("MomentumStrategy initialized");
+        return true;
+    }
+
+    void cleanup() override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto& history : price_history_) {
+            history.clear();
+        }
+        price_count_.assign(price_count_.size(), 0);
+        status_ = StrategyStatus::STOPPED;
+        spdlog::info("MomentumStrategy cleaned up");
+    }
+
+    SignalType processMarketData(const orderbook_t& orderbook) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (orderbook.bid_count == 0 || orderbook.ask_count == 0) {
+            return SignalType::NONE;
+        }
+        double mid_price = (orderbook.bids[0].price + orderbook.asks[0].price) / 2.0;
+        return evaluate(orderbook.symbol, mid_price, nullptr);
+    }
+
+    // 策略引擎入口：价格序列用微观价格，信号须与订单流方向一致
+    SignalType processFeatures(const orderbook_t& orderbook,
+                               const microstructure_features_t& features) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!features.valid) {
+            return SignalType::NONE;
+        }
+        return evaluate(orderbook.symbol, features.microprice, &features);
+    }
+
     StrategyStatus getStatus() const override {
         std::lock_guard<std::mutex> lock(mutex_);
         return status_;
@@ -120,4 +145,8 @@ public:
     }
 };
 
+std::shared_ptr<IStrategy> CryptoQuantFactory::createMomentumStrategy() {
+    return std::shared_ptr<IStrategy>(new MomentumStrategy());
+}
+
 }
@@ -1,7 +1,9 @@
 #include "crypto_quant.h"
+#include "symbol_registry.h"
 #include <spdlog/spdlog.h>
 #include <algorithm>
 #include <cmath>
+#include <unordered_map>
 
 namespace crypto_quant {
 // RSI策略实现
@@ -11,8 +13,22 @@ private:
     StrategyStatus status_;
     std::vector<std::vector<double>> price_history_;
     std::vector<int> price_count_;
+    // K 线收盘价序列，按（交易对, K 线规格）分开
+    std::unordered_map<uint64_t, std::vector<double>> bar_history_;
     mutable std::mutex mutex_;
 
+    // 由价格序列的 RSI 生成信号
+    SignalType signalFromRSI(double rsi, const char* source) {
+        if (rsi < params_.rsi_oversold) {
+            spdlog::info("RSIStrategy: BUY signal ({}), RSI={:.2f}", source, rsi);
+            return SignalType::BUY;
+        } else if (rsi > params_.rsi_overbought) {
+            spdlog::info("RSIStrategy: SELL signal ({}), RSI={:.2f}", source, rsi);
+            return SignalType::SELL;
+        }
+        return SignalType::NONE;
+    }
+
     double calculateRSI(const std::vector<double>& prices, int period) {
         if (prices.size() < static_cast<size_t>(period + 1)) {
             return 50.0;  // 默认中性值
@@ -42,11 +58,6 @@ private:
 
 public:
     RSIStrategy() : status_(StrategyStatus::STOPPED) {
-        price_history_.resize(3);
-        price_count_.resize(3, 0);
-        for (auto& history : price_history_) {
-            history.reserve(100);
-        }
     }
 
     bool initialize() override {
@@ -61,7 +72,8 @@ public:
         for (auto& history : price_history_) {
             history.clear();
         }
-        price_count_.assign(3, 0);
+        price_count_.assign(price_count_.size(), 0);
+        bar_history_.clear();
         status_ = StrategyStatus::STOPPED;
         spdlog::info("RSIStrategy cleaned up");
     }
@@ -73,10 +85,15 @@ public:
             return SignalType::NONE;
         }
 
-        int symbol_index = static_cast<int>(orderbook.symbol);
-        if (symbol_index < 0 || symbol_index >= 3) {
+        size_t symbol_index = orderbook.symbol;
+        if (symbol_index >= SymbolRegistry::kMaxSymbols) {
             return SignalType::NONE;
         }
+        // 按交易对ID按需扩容
+        if (symbol_index >= price_history_.size()) {
+            price_history_.resize(symbol_index + 1);
+            price_count_.resize(symbol_index + 1, 0);
+        }
 
         // 更新价格历史
         double mid_price = (orderbook.bids[0].price + orderbook.asks[0].price) / 2.0;
@@ -97,17 +114,29 @@ public:
 
         // 计算RSI
         double rsi = calculateRSI(history, params_.rsi_period);
-        
-        // 生成交易信号
-        if (rsi < params_.rsi_oversold) {
-            spdlog::info("RSIStrategy: BUY signal, RSI={:.2f}", rsi);
-            return SignalType::BUY;
-        } else if (rsi > params_.rsi_overbought) {
-            spdlog::info("RSIStrategy: SELL signal, RSI={:.2f}", rsi);
-            return SignalType::SELL;
+        return signalFromRSI(rsi, "book");
+    }
+
+    // 收盘 K 线：在收盘价序列上计算 RSI，不受盘口逐笔跳动的噪声影响
+    SignalType processBar(const bar_t& bar) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        if (status_ != StrategyStatus::RUNNING || bar.trade_count == 0) {
+            return SignalType::NONE;
         }
 
-        return SignalType::NONE;
+        auto& history = bar_history_[(static_cast<uint64_t>(bar.symbol) << 32) | bar.spec];
+        history.push_back(bar.close);
+        if (history.size() > 100) {
+            history.erase(history.begin());
+        }
+
+        if (history.size() < static_cast<size_t>(params_.rsi_period + 1)) {
+            return SignalType::NONE;
+        }
+
+        double rsi = calculateRSI(history, params_.rsi_period);
+        return signalFromRSI(rsi, "bar");
     }
 
     StrategyStatus getStatus() const override {
@@ -132,4 +161,8 @@ public:
     }
 };
 
-}
\ No newline at end of file
+std::shared_ptr<IStrategy> CryptoQuantFactory::createRSIStrategy() {
+    return std::shared_ptr<IStrategy>(new RSIStrategy());
+}
+
+}
@@ -15,9 +15,8 @@ bool StrategyEngine::initialize() {
 
 void StrategyEngine::cleanup() {
         std::lock_guard<std::mutex> lock(mutex_);
-        if (status_.load() != StrategyStatus::STOPPED) {
-            stop();
-        }
+        // stop() 会再次加锁，这里直接置状态
+        status_.store(StrategyStatus::STOPPED);
         initialized_.store(false);
         spdlog::info("StrategyEngine cleaned up");
     }
@@ -58,11 +57,28 @@ StrategyStatus StrategyEngine::getStatus() const {
         return status_.load();
     }
 
+bool StrategyEngine::getFeatures(symbol_t symbol, microstructure_features_t& features) const {
+        return features_.getFeatures(symbol, features);
+    }
+
 void StrategyEngine::processMarketData(const orderbook_t& orderbook) {
         std::lock_guard<std::mutex> lock(mutex_);
         if (status_.load() == StrategyStatus::RUNNING && strategy_) {
-            SignalType signal = strategy_->processMarketData(orderbook);
+            microstructure_features_t features;
+            if (!features_.update(orderbook, &features)) {
+                return;
+            }
+            SignalType signal = strategy_->processFeatures(orderbook, features);
             spdlog::debug("Strategy processed market data, signal: {}", static_cast<int>(signal));
         }
     }
+
+void StrategyEngine::processBar(const bar_t& bar) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (status_.load() == StrategyStatus::RUNNING && strategy_) {
+            SignalType signal = strategy_->processBar(bar);
+            spdlog::debug("Strategy processed bar: symbol={}, spec={}, signal: {}",
+                          bar.symbol, bar.spec, static_cast<int>(signal));
+        }
+    }
 }
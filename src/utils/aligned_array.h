@@ -0,0 +1,70 @@
+#ifndef ALIGNED_ARRAY_H
+#define ALIGNED_ARRAY_H
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+namespace crypto_quant {
+
+// 按类型对齐要求分配的定长数组
+// C++11 的 new[] 不保证超过16字节的对齐（alignas(64) 会被忽略），
+// 因此缓存行对齐的对象数组统一通过 posix_memalign 分配。
+template <typename T>
+class AlignedArray {
+public:
+    AlignedArray() : data_(nullptr), size_(0) {}
+
+    explicit AlignedArray(size_t size) : data_(nullptr), size_(0) {
+        reset(size);
+    }
+
+    ~AlignedArray() {
+        release();
+    }
+
+    // 重新分配并默认构造 size 个元素
+    void reset(size_t size) {
+        release();
+        if (size == 0) {
+            return;
+        }
+        void* mem = nullptr;
+        size_t alignment = alignof(T) < sizeof(void*) ? sizeof(void*) : alignof(T);
+        if (posix_memalign(&mem, alignment, sizeof(T) * size) != 0) {
+            throw std::bad_alloc();
+        }
+        data_ = static_cast<T*>(mem);
+        for (size_t i = 0; i < size; ++i) {
+            new (&data_[i]) T();
+        }
+        size_ = size;
+    }
+
+    T& operator[](size_t index) { return data_[index]; }
+    const T& operator[](size_t index) const { return data_[index]; }
+
+    T* data() { return data_; }
+    const T* data() const { return data_; }
+    size_t size() const { return size_; }
+
+private:
+    void release() {
+        for (size_t i = 0; i < size_; ++i) {
+            data_[i].~T();
+        }
+        free(data_);
+        data_ = nullptr;
+        size_ = 0;
+    }
+
+    T* data_;
+    size_t size_;
+
+    AlignedArray(const AlignedArray&) = delete;
+    AlignedArray& operator=(const AlignedArray&) = delete;
+};
+
+} // namespace crypto_quant
+
+#endif // ALIGNED_ARRAY_H
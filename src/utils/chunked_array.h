@@ -0,0 +1,100 @@
+#ifndef CHUNKED_ARRAY_H
+#define CHUNKED_ARRAY_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+
+#include "utils/aligned_array.h"
+
+namespace crypto_quant {
+
+// 按块懒分配的定容数组（按交易对ID索引）
+// 每块 kChunkSize 个元素，首次写入某个下标时才分配所在的块；
+// 块一旦发布就不再移动或释放，已取得的元素指针在数组生命周期内一直有效，
+// 读者通过原子指针无锁访问。适合交易对数量多但大部分未使用的场景。
+template <typename T, size_t kChunkSize = 64>
+class ChunkedArray {
+public:
+    typedef AlignedArray<T> Chunk;
+
+    explicit ChunkedArray(size_t capacity)
+        : capacity_(capacity),
+          chunk_count_((capacity + kChunkSize - 1) / kChunkSize),
+          chunks_(new std::atomic<Chunk*>[chunk_count_]) {
+        for (size_t i = 0; i < chunk_count_; ++i) {
+            chunks_[i].store(nullptr, std::memory_order_relaxed);
+        }
+    }
+
+    ~ChunkedArray() {
+        for (size_t i = 0; i < chunk_count_; ++i) {
+            delete chunks_[i].load(std::memory_order_relaxed);
+        }
+    }
+
+    size_t capacity() const { return capacity_; }
+
+    // 已分配时返回元素指针，否则返回nullptr（不分配）
+    T* get(size_t index) const {
+        if (index >= capacity_) {
+            return nullptr;
+        }
+        Chunk* chunk = chunks_[index / kChunkSize].load(std::memory_order_acquire);
+        return chunk ? &(*chunk)[index % kChunkSize] : nullptr;
+    }
+
+    // 返回元素指针，所在块未分配时先分配；新块的每个元素在发布前调用 init(index, T&)
+    template <typename Init>
+    T* getOrCreate(size_t index, Init init) {
+        T* element = get(index);
+        if (element || index >= capacity_) {
+            return element;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::atomic<Chunk*>& slot = chunks_[index / kChunkSize];
+        Chunk* chunk = slot.load(std::memory_order_acquire);
+        if (!chunk) {
+            chunk = new Chunk(kChunkSize);
+            size_t base = index / kChunkSize * kChunkSize;
+            for (size_t i = 0; i < kChunkSize; ++i) {
+                init(base + i, (*chunk)[i]);
+            }
+            slot.store(chunk, std::memory_order_release);
+        }
+        return &(*chunk)[index % kChunkSize];
+    }
+
+    T* getOrCreate(size_t index) {
+        return getOrCreate(index, [](size_t, T&) {});
+    }
+
+    // 遍历所有已分配的元素 fn(index, T&)
+    template <typename Fn>
+    void forEach(Fn fn) const {
+        for (size_t c = 0; c < chunk_count_; ++c) {
+            Chunk* chunk = chunks_[c].load(std::memory_order_acquire);
+            if (!chunk) {
+                continue;
+            }
+            for (size_t i = 0; i < kChunkSize && c * kChunkSize + i < capacity_; ++i) {
+                fn(c * kChunkSize + i, (*chunk)[i]);
+            }
+        }
+    }
+
+private:
+    size_t capacity_;
+    size_t chunk_count_;
+    std::unique_ptr<std::atomic<Chunk*>[]> chunks_;
+    std::mutex mutex_;
+
+    ChunkedArray(const ChunkedArray&) = delete;
+    ChunkedArray& operator=(const ChunkedArray&) = delete;
+};
+
+} // namespace crypto_quant
+
+#endif // CHUNKED_ARRAY_H
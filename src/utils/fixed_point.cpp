@@ -0,0 +1,298 @@
+#include "fixed_point.h"
+#include "symbol_registry.h"
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+namespace crypto_quant {
+
+namespace {
+
+const int64_t kPow10Int[19] = {
+    1LL, 10LL, 100LL, 1000LL, 10000LL, 100000LL, 1000000LL, 10000000LL,
+    100000000LL, 1000000000LL, 10000000000LL, 100000000000LL, 1000000000000LL,
+    10000000000000LL, 100000000000000LL, 1000000000000000LL,
+    10000000000000000LL, 100000000000000000LL, 1000000000000000000LL
+};
+
+// 可精确表示的10的幂（double）
+const double kPow10Double[23] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+inline bool isDigit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+// 整数四舍五入除法（远离零）
+inline int64_t roundDiv(int64_t value, int64_t divisor) {
+    int64_t q = value / divisor;
+    int64_t r = value % divisor;
+    if (r * 2 >= divisor) {
+        ++q;
+    } else if (r * 2 <= -divisor) {
+        --q;
+    }
+    return q;
+}
+
+} // namespace
+
+int64_t pow10Int(int exponent) {
+    if (exponent < 0 || exponent > 18) {
+        return 0;
+    }
+    return kPow10Int[exponent];
+}
+
+double InstrumentSpec::tickSize() const {
+    return static_cast<double>(tick_units) / kPow10Double[price_decimals];
+}
+
+double InstrumentSpec::lotSize() const {
+    return static_cast<double>(lot_units) / kPow10Double[quantity_decimals];
+}
+
+bool parseDecimalFixed(const char* begin, const char* end, int decimals, int64_t& out) {
+    if (begin >= end || decimals < 0 || decimals > 18) {
+        return false;
+    }
+
+    const char* p = begin;
+    bool negative = false;
+    if (*p == '-' || *p == '+') {
+        negative = (*p == '-');
+        ++p;
+    }
+
+    int64_t value = 0;
+    int integer_digits = 0;
+    while (p < end && isDigit(*p)) {
+        if (++integer_digits > 18 - decimals) {
+            return false; // 溢出
+        }
+        value = value * 10 + (*p - '0');
+        ++p;
+    }
+
+    int fraction_digits = 0;
+    bool round_up = false;
+    if (p < end && *p == '.') {
+        ++p;
+        while (p < end && isDigit(*p)) {
+            if (fraction_digits < decimals) {
+                value = value * 10 + (*p - '0');
+            } else if (fraction_digits == decimals) {
+                // 第一位被舍弃的数字决定是否进位
+                round_up = (*p >= '5');
+            }
+            ++fraction_digits;
+            ++p;
+        }
+    }
+    if (p != end || (integer_digits == 0 && fraction_digits == 0)) {
+        return false;
+    }
+
+    for (int i = fraction_digits; i < decimals; ++i) {
+        value *= 10;
+    }
+    if (round_up) {
+        ++value;
+    }
+    out = negative ? -value : value;
+    return true;
+}
+
+bool parseDecimalDouble(const char* begin, const char* end, double& out) {
+    if (begin >= end) {
+        return false;
+    }
+
+    const char* p = begin;
+    bool negative = false;
+    if (*p == '-' || *p == '+') {
+        negative = (*p == '-');
+        ++p;
+    }
+
+    uint64_t mantissa = 0;
+    int significant = 0;
+    int fraction_digits = 0;
+    bool any_digit = false;
+    while (p < end && isDigit(*p)) {
+        if (mantissa != 0 || *p != '0') {
+            ++significant;
+        }
+        mantissa = mantissa * 10 + static_cast<uint64_t>(*p - '0');
+        any_digit = true;
+        ++p;
+        if (significant > 15) {
+            break;
+        }
+    }
+    if (p < end && *p == '.' && significant <= 15) {
+        ++p;
+        while (p < end && isDigit(*p)) {
+            if (mantissa != 0 || *p != '0') {
+                ++significant;
+            }
+            mantissa = mantissa * 10 + static_cast<uint64_t>(*p - '0');
+            ++fraction_digits;
+            any_digit = true;
+            ++p;
+            if (significant > 15) {
+                break;
+            }
+        }
+    }
+
+    // 快速路径：尾数和10的幂都能被 double 精确表示，一次除法即正确舍入
+    if (p == end && any_digit && significant <= 15 && fraction_digits <= 22) {
+        double value = static_cast<double>(mantissa) / kPow10Double[fraction_digits];
+        out = negative ? -value : value;
+        return true;
+    }
+
+    // 慢速路径：指数、超长尾数等
+    char buf[64];
+    size_t len = static_cast<size_t>(end - begin);
+    if (len >= sizeof(buf)) {
+        return false;
+    }
+    memcpy(buf, begin, len);
+    buf[len] = '\0';
+    char* parse_end = nullptr;
+    out = strtod(buf, &parse_end);
+    return parse_end == buf + len;
+}
+
+size_t formatDecimalFixed(int64_t value, int decimals, char* buf) {
+    char digits[24];
+    size_t n = 0;
+    bool negative = value < 0;
+    uint64_t magnitude = negative ? static_cast<uint64_t>(-(value + 1)) + 1 : static_cast<uint64_t>(value);
+    do {
+        digits[n++] = static_cast<char>('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude != 0);
+    // 补足前导零，保证至少有一位整数
+    while (n < static_cast<size_t>(decimals) + 1) {
+        digits[n++] = '0';
+    }
+
+    size_t len = 0;
+    if (negative) {
+        buf[len++] = '-';
+    }
+    for (size_t i = n; i-- > 0;) {
+        buf[len++] = digits[i];
+        if (i == static_cast<size_t>(decimals) && decimals > 0) {
+            buf[len++] = '.';
+        }
+    }
+    buf[len] = '\0';
+    return len;
+}
+
+// 解析形如 "0.01" 的步长：返回小数位数与该精度下的单位数
+static bool parseStep(const std::string& step, int& decimals, int64_t& units) {
+    const char* begin = step.c_str();
+    const char* end = begin + step.size();
+    const char* dot = static_cast<const char*>(memchr(begin, '.', step.size()));
+
+    // 去掉小数部分末尾多余的零
+    const char* last = end;
+    if (dot) {
+        while (last > dot + 1 && *(last - 1) == '0') {
+            --last;
+        }
+        if (last == dot + 1) {
+            last = dot;
+        }
+    }
+    decimals = (dot && last > dot) ? static_cast<int>(last - dot - 1) : 0;
+    return parseDecimalFixed(begin, end, decimals, units) && units > 0;
+}
+
+bool makeInstrumentSpec(const std::string& tick_size, const std::string& lot_size, InstrumentSpec& spec) {
+    InstrumentSpec result;
+    if (!parseStep(tick_size, result.price_decimals, result.tick_units) ||
+        !parseStep(lot_size, result.quantity_decimals, result.lot_units)) {
+        return false;
+    }
+    spec = result;
+    return true;
+}
+
+FixedPointRegistry& FixedPointRegistry::instance() {
+    static FixedPointRegistry registry;
+    return registry;
+}
+
+FixedPointRegistry::FixedPointRegistry() : specs_(SymbolRegistry::kMaxSymbols) {
+}
+
+void FixedPointRegistry::setSpec(symbol_t symbol, const InstrumentSpec& spec) {
+    if (!SymbolRegistry::instance().contains(symbol) || !spec.valid()) {
+        return;
+    }
+    SpecEntry entry;
+    entry.present = true;
+    entry.spec = spec;
+    specs_.getOrCreate(symbol)->store(entry);
+}
+
+bool FixedPointRegistry::getSpec(symbol_t symbol, InstrumentSpec& spec) const {
+    const Seqlock<SpecEntry>* slot = specs_.get(symbol);
+    if (!slot) {
+        return false;
+    }
+    SpecEntry entry = slot->load();
+    if (!entry.present) {
+        return false;
+    }
+    spec = entry.spec;
+    return true;
+}
+
+bool FixedPointRegistry::priceToTicks(symbol_t symbol, double price, int64_t& ticks) const {
+    InstrumentSpec spec;
+    if (!getSpec(symbol, spec)) {
+        return false;
+    }
+    int64_t scaled = static_cast<int64_t>(std::llround(price * kPow10Double[spec.price_decimals]));
+    ticks = roundDiv(scaled, spec.tick_units);
+    return true;
+}
+
+bool FixedPointRegistry::quantityToLots(symbol_t symbol, double quantity, int64_t& lots) const {
+    InstrumentSpec spec;
+    if (!getSpec(symbol, spec)) {
+        return false;
+    }
+    int64_t scaled = static_cast<int64_t>(std::llround(quantity * kPow10Double[spec.quantity_decimals]));
+    lots = roundDiv(scaled, spec.lot_units);
+    return true;
+}
+
+bool FixedPointRegistry::ticksToPrice(symbol_t symbol, int64_t ticks, double& price) const {
+    InstrumentSpec spec;
+    if (!getSpec(symbol, spec)) {
+        return false;
+    }
+    price = static_cast<double>(ticks * spec.tick_units) / kPow10Double[spec.price_decimals];
+    return true;
+}
+
+bool FixedPointRegistry::lotsToQuantity(symbol_t symbol, int64_t lots, double& quantity) const {
+    InstrumentSpec spec;
+    if (!getSpec(symbol, spec)) {
+        return false;
+    }
+    quantity = static_cast<double>(lots * spec.lot_units) / kPow10Double[spec.quantity_decimals];
+    return true;
+}
+
+} // namespace crypto_quant
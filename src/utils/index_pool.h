@@ -0,0 +1,65 @@
+#ifndef INDEX_POOL_H
+#define INDEX_POOL_H
+
+#include <stdint.h>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace crypto_quant {
+
+// 按下标引用的对象池
+// 对象分块分配（每块 kBlockSize 个），块不移动也不释放，释放的下标进入空闲栈复用。
+// 热路径上的分配/释放都是O(1)且不调用 malloc；用32位下标代替指针，节点更紧凑。
+template <typename T, size_t kBlockSize = 4096>
+class IndexPool {
+public:
+    static const uint32_t kNull = ~0u;
+
+    IndexPool() : allocated_(0) {}
+
+    uint32_t acquire() {
+        if (!free_.empty()) {
+            uint32_t index = free_.back();
+            free_.pop_back();
+            return index;
+        }
+        if (allocated_ == blocks_.size() * kBlockSize) {
+            blocks_.push_back(std::unique_ptr<T[]>(new T[kBlockSize]));
+        }
+        return static_cast<uint32_t>(allocated_++);
+    }
+
+    void release(uint32_t index) {
+        free_.push_back(index);
+    }
+
+    // 释放全部对象（保留已分配的块）
+    void clear() {
+        free_.clear();
+        allocated_ = 0;
+    }
+
+    // 预先分配至少 count 个对象的空间
+    void reserve(size_t count) {
+        while (blocks_.size() * kBlockSize < count) {
+            blocks_.push_back(std::unique_ptr<T[]>(new T[kBlockSize]));
+        }
+        free_.reserve(count);
+    }
+
+    T& operator[](uint32_t index) { return blocks_[index / kBlockSize][index % kBlockSize]; }
+    const T& operator[](uint32_t index) const { return blocks_[index / kBlockSize][index % kBlockSize]; }
+
+    // 正在使用的对象数
+    size_t size() const { return allocated_ - free_.size(); }
+
+private:
+    std::vector<std::unique_ptr<T[]> > blocks_;
+    std::vector<uint32_t> free_;
+    size_t allocated_;
+};
+
+} // namespace crypto_quant
+
+#endif // INDEX_POOL_H
@@ -0,0 +1,125 @@
+#ifndef MPMC_QUEUE_H
+#define MPMC_QUEUE_H
+
+#include <stdint.h>
+#include <atomic>
+#include <cstddef>
+
+#include "utils/aligned_array.h"
+#include "utils/seqlock.h"
+
+namespace crypto_quant {
+
+// 有界多生产者多消费者队列（Vyukov 算法）
+// 每个单元带一个序号：生产者/消费者各自 CAS 抢占位置，写入或读取数据后发布序号，
+// 不同位置上的读写互不干扰。容量向上取整为2的幂，队列满/空时立即返回false。
+// 单元数据原地读写（tryPush/tryPop 接受填充/消费函数），大结构体不必多拷贝一次。
+template <typename T>
+class MpmcQueue {
+public:
+    explicit MpmcQueue(size_t capacity)
+        : cells_(roundUpPowerOfTwo(capacity)),
+          mask_(cells_.size() - 1),
+          enqueue_pos_(0),
+          dequeue_pos_(0) {
+        for (size_t i = 0; i < cells_.size(); ++i) {
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    size_t capacity() const { return cells_.size(); }
+
+    // fill(T&) 在抢占到的单元上原地写入
+    template <typename Fill>
+    bool tryPush(Fill fill) {
+        Cell* cell;
+        size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+        for (;;) {
+            cell = &cells_[pos & mask_];
+            size_t seq = cell->sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = enqueue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+        fill(cell->data);
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool tryPush(const T& value) {
+        return tryPush([&value](T& data) { data = value; });
+    }
+
+    // consume(T&) 在单元上原地读取，返回后单元即交还给生产者
+    template <typename Consume>
+    bool tryPop(Consume consume) {
+        Cell* cell;
+        size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+        for (;;) {
+            cell = &cells_[pos & mask_];
+            size_t seq = cell->sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+            if (diff == 0) {
+                if (dequeue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = dequeue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+        consume(cell->data);
+        cell->sequence.store(pos + mask_ + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool tryPop(T& value) {
+        return tryPop([&value](T& data) { value = data; });
+    }
+
+    // 近似元素个数（并发下仅供统计）
+    size_t sizeApprox() const {
+        size_t enqueue = enqueue_pos_.load(std::memory_order_relaxed);
+        size_t dequeue = dequeue_pos_.load(std::memory_order_relaxed);
+        return enqueue > dequeue ? enqueue - dequeue : 0;
+    }
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T data;
+    };
+
+    static size_t roundUpPowerOfTwo(size_t value) {
+        size_t result = 2;
+        while (result < value) {
+            result <<= 1;
+        }
+        return result;
+    }
+
+    AlignedArray<Cell> cells_;
+    size_t mask_;
+    // 生产者、消费者位置用填充隔开，避免伪共享
+    // （不用 alignas：C++11 的 new 不保证超对齐，队列对象可能在堆上分配）
+    char pad0_[CRYPTO_QUANT_CACHELINE_SIZE];
+    std::atomic<size_t> enqueue_pos_;
+    char pad1_[CRYPTO_QUANT_CACHELINE_SIZE];
+    std::atomic<size_t> dequeue_pos_;
+    char pad2_[CRYPTO_QUANT_CACHELINE_SIZE];
+
+    MpmcQueue(const MpmcQueue&) = delete;
+    MpmcQueue& operator=(const MpmcQueue&) = delete;
+};
+
+} // namespace crypto_quant
+
+#endif // MPMC_QUEUE_H
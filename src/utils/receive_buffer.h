@@ -0,0 +1,104 @@
+#ifndef RECEIVE_BUFFER_H
+#define RECEIVE_BUFFER_H
+
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+namespace crypto_quant {
+
+// 可复用、可增长的网络接收缓冲
+// 未解析的字节位于 [read_, write_)，调用方直接在 data() 上原地解析，解析完再 consume()。
+// 写入前按需把未读数据移回开头，仍不够时按倍数扩容；容量只增不减，稳定后不再分配。
+// 新分配的空间不做初始化，读入时直接写入，不经过中间缓冲。
+class ReceiveBuffer {
+public:
+    explicit ReceiveBuffer(size_t initial_capacity = 64 * 1024)
+        : buffer_(nullptr), capacity_(0), read_(0), write_(0) {
+        reserve(initial_capacity);
+    }
+
+    ~ReceiveBuffer() {
+        free(buffer_);
+    }
+
+    char* data() { return buffer_ + read_; }
+    const char* data() const { return buffer_ + read_; }
+    size_t size() const { return write_ - read_; }
+    bool empty() const { return read_ == write_; }
+    size_t capacity() const { return capacity_; }
+
+    // 返回至少 min_space 字节的可写区域，实际可写长度见 writableSize()
+    // data() 之前返回的指针在此之后失效，调用方应保存相对 data() 的偏移
+    char* prepareWrite(size_t min_space) {
+        if (capacity_ - write_ < min_space) {
+            if (read_ > 0) {
+                compact();
+            }
+            if (capacity_ - write_ < min_space) {
+                size_t wanted = capacity_ ? capacity_ : min_space;
+                while (wanted - write_ < min_space) {
+                    wanted *= 2;
+                }
+                reserve(wanted);
+            }
+        }
+        return buffer_ + write_;
+    }
+
+    size_t writableSize() const { return capacity_ - write_; }
+
+    // 提交写入 prepareWrite() 区域的字节
+    void commitWrite(size_t length) {
+        write_ += length;
+    }
+
+    // 丢弃开头 length 字节；全部读完时游标归零，下次写入无需搬移
+    void consume(size_t length) {
+        read_ += length;
+        if (read_ >= write_) {
+            read_ = 0;
+            write_ = 0;
+        }
+    }
+
+    void clear() {
+        read_ = 0;
+        write_ = 0;
+    }
+
+private:
+    void compact() {
+        size_t length = write_ - read_;
+        if (length > 0) {
+            memmove(buffer_, buffer_ + read_, length);
+        }
+        read_ = 0;
+        write_ = length;
+    }
+
+    void reserve(size_t capacity) {
+        if (capacity <= capacity_) {
+            return;
+        }
+        char* grown = static_cast<char*>(realloc(buffer_, capacity));
+        if (!grown) {
+            throw std::bad_alloc();
+        }
+        buffer_ = grown;
+        capacity_ = capacity;
+    }
+
+    char* buffer_;
+    size_t capacity_;
+    size_t read_;
+    size_t write_;
+
+    ReceiveBuffer(const ReceiveBuffer&) = delete;
+    ReceiveBuffer& operator=(const ReceiveBuffer&) = delete;
+};
+
+} // namespace crypto_quant
+
+#endif // RECEIVE_BUFFER_H
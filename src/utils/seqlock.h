@@ -0,0 +1,131 @@
+#ifndef SEQLOCK_H
+#define SEQLOCK_H
+
+#include <atomic>
+#include <cstring>
+#include <stdint.h>
+#include <thread>
+#include <type_traits>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+// 缓存行大小（避免伪共享）
+#define CRYPTO_QUANT_CACHELINE_SIZE 64
+
+namespace crypto_quant {
+
+// 自旋等待时的CPU提示
+static inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+    _mm_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield" ::: "memory");
+#endif
+}
+
+// 自旋退避：短暂自旋后让出CPU，避免写者被抢占时读者空转耗尽时间片
+class SpinBackoff {
+public:
+    SpinBackoff() : spins_(0) {}
+
+    void pause() {
+        if (++spins_ < kSpinLimit) {
+            cpu_relax();
+        } else {
+            std::this_thread::yield();
+        }
+    }
+
+private:
+    static const int kSpinLimit = 64;
+    int spins_;
+};
+
+// 顺序锁（Seqlock）
+// 写者之间通过序号上的CAS互斥，写者从不等待读者；
+// 读者无锁，拷贝数据后校验序号，若期间发生写入则重试。
+// T 必须是可平凡拷贝的POD类型（如 orderbook_t）。
+template <typename T>
+class alignas(CRYPTO_QUANT_CACHELINE_SIZE) Seqlock {
+public:
+    Seqlock() : seq_(0) {
+        memset(static_cast<void*>(&value_), 0, sizeof(value_));
+    }
+
+    // 开始原地写入：序号变为奇数，返回可写引用
+    T& beginWrite() {
+        SpinBackoff backoff;
+        uint32_t seq = seq_.load(std::memory_order_relaxed);
+        for (;;) {
+            if ((seq & 1) == 0 &&
+                seq_.compare_exchange_weak(seq, seq + 1, std::memory_order_acquire,
+                                           std::memory_order_relaxed)) {
+                break;
+            }
+            backoff.pause();
+            seq = seq_.load(std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_release);
+        return value_;
+    }
+
+    // 结束写入：序号变回偶数，发布新数据
+    void endWrite() {
+        seq_.store(seq_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    // 整体写入
+    void store(const T& value) {
+        T& dst = beginWrite();
+        memcpy(static_cast<void*>(&dst), &value, sizeof(T));
+        endWrite();
+    }
+
+    // 读取一致的快照
+    T load() const {
+        T out;
+        read([&out](const T& value) { memcpy(static_cast<void*>(&out), &value, sizeof(T)); });
+        return out;
+    }
+
+    // 在读区间内执行 fn(const T&)，若读到不一致的数据则重试。
+    // fn 可能被调用多次，且可能看到写入中的数据，只能产生可丢弃的结果。
+    template <typename Fn>
+    void read(Fn fn) const {
+        SpinBackoff backoff;
+        for (;;) {
+            uint32_t seq1 = seq_.load(std::memory_order_acquire);
+            if (seq1 & 1) {
+                backoff.pause();
+                continue;
+            }
+            fn(value_);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            uint32_t seq2 = seq_.load(std::memory_order_relaxed);
+            if (seq1 == seq2) {
+                return;
+            }
+            backoff.pause();
+        }
+    }
+
+    // 当前序号（每次写入加2）
+    uint32_t sequence() const {
+        return seq_.load(std::memory_order_acquire);
+    }
+
+private:
+    static_assert(std::is_trivially_copyable<T>::value, "Seqlock requires a trivially copyable type");
+
+    std::atomic<uint32_t> seq_;
+    T value_;
+
+    Seqlock(const Seqlock&) = delete;
+    Seqlock& operator=(const Seqlock&) = delete;
+};
+
+} // namespace crypto_quant
+
+#endif // SEQLOCK_H
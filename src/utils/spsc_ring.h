@@ -0,0 +1,107 @@
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <stdint.h>
+#include <atomic>
+#include <cstddef>
+
+#include "utils/aligned_array.h"
+#include "utils/seqlock.h"
+
+namespace crypto_quant {
+
+// 有界单生产者单消费者环形队列
+// 只有一个线程写、一个线程读：写位置只由生产者修改，读位置只由消费者修改，不需要CAS。
+// 两端各自缓存对方的位置，只有缓存值显示队列满/空时才重新读取对方的原子变量，
+// 稳态下每次操作只访问自己的缓存行。容量向上取整为2的幂，队列满/空时立即返回false。
+// 单元数据原地读写（tryPush/tryPop 接受填充/消费函数），大结构体不必多拷贝一次。
+template <typename T>
+class SpscRing {
+public:
+    explicit SpscRing(size_t capacity)
+        : slots_(roundUpPowerOfTwo(capacity)),
+          mask_(slots_.size() - 1),
+          head_(0),
+          cached_tail_(0),
+          tail_(0),
+          cached_head_(0) {}
+
+    size_t capacity() const { return slots_.size(); }
+
+    // 生产者线程调用；fill(T&) 在空闲单元上原地写入
+    template <typename Fill>
+    bool tryPush(Fill fill) {
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - cached_head_ > mask_) {
+            cached_head_ = head_.load(std::memory_order_acquire);
+            if (tail - cached_head_ > mask_) {
+                return false;
+            }
+        }
+        fill(slots_[tail & mask_]);
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool tryPush(const T& value) {
+        return tryPush([&value](T& slot) { slot = value; });
+    }
+
+    // 消费者线程调用；consume(T&) 在单元上原地读取，返回后单元即交还给生产者
+    template <typename Consume>
+    bool tryPop(Consume consume) {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        if (head == cached_tail_) {
+            cached_tail_ = tail_.load(std::memory_order_acquire);
+            if (head == cached_tail_) {
+                return false;
+            }
+        }
+        consume(slots_[head & mask_]);
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool tryPop(T& value) {
+        return tryPop([&value](T& slot) { value = slot; });
+    }
+
+    // 近似元素个数（任意线程可调用，并发下仅供统计）
+    size_t sizeApprox() const {
+        size_t head = head_.load(std::memory_order_acquire);
+        size_t tail = tail_.load(std::memory_order_acquire);
+        return tail > head ? tail - head : 0;
+    }
+
+    bool empty() const {
+        return sizeApprox() == 0;
+    }
+
+private:
+    static size_t roundUpPowerOfTwo(size_t value) {
+        size_t result = 2;
+        while (result < value) {
+            result <<= 1;
+        }
+        return result;
+    }
+
+    AlignedArray<T> slots_;
+    size_t mask_;
+    // 消费者一侧：读位置和缓存的写位置；生产者一侧：写位置和缓存的读位置
+    // 两侧用填充隔开避免伪共享（不用 alignas，原因同 MpmcQueue）
+    char pad0_[CRYPTO_QUANT_CACHELINE_SIZE];
+    std::atomic<size_t> head_;
+    size_t cached_tail_;
+    char pad1_[CRYPTO_QUANT_CACHELINE_SIZE];
+    std::atomic<size_t> tail_;
+    size_t cached_head_;
+    char pad2_[CRYPTO_QUANT_CACHELINE_SIZE];
+
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+};
+
+} // namespace crypto_quant
+
+#endif // SPSC_RING_H
@@ -0,0 +1,141 @@
+#include "symbol_registry.h"
+#include <spdlog/spdlog.h>
+#include <cstring>
+
+namespace crypto_quant {
+
+SymbolRegistry& SymbolRegistry::instance() {
+    static SymbolRegistry registry;
+    return registry;
+}
+
+SymbolRegistry::SymbolRegistry() : count_(0) {
+    memset(entries_, 0, sizeof(entries_));
+    for (size_t i = 0; i < kTableSize; ++i) {
+        table_[i].store(0, std::memory_order_relaxed);
+    }
+    // 预注册的交易对，ID 与 SYMBOL_* 常量一致
+    registerSymbol("BTCUSDT", 7);
+    registerSymbol("ETHUSDT", 7);
+    registerSymbol("BTCETH", 6);
+}
+
+size_t SymbolRegistry::normalize(const char* name, size_t length, char* out) {
+    size_t n = 0;
+    for (size_t i = 0; i < length; ++i) {
+        char c = name[i];
+        if (c >= 'a' && c <= 'z') {
+            c = static_cast<char>(c - 'a' + 'A');
+        } else if (c == '_' || c == '/' || c == '-') {
+            continue;
+        } else if (!((c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9'))) {
+            return 0;
+        }
+        if (n >= kMaxNameLength) {
+            return 0;
+        }
+        out[n++] = c;
+    }
+    out[n] = '\0';
+    return n;
+}
+
+// FNV-1a
+uint32_t SymbolRegistry::hash(const char* name, size_t length) {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < length; ++i) {
+        h ^= static_cast<uint8_t>(name[i]);
+        h *= 16777619u;
+    }
+    return h;
+}
+
+symbol_t SymbolRegistry::lookup(const char* normalized, size_t length) const {
+    size_t index = hash(normalized, length) & (kTableSize - 1);
+    for (size_t probe = 0; probe < kTableSize; ++probe) {
+        uint32_t slot = table_[index].load(std::memory_order_acquire);
+        if (slot == 0) {
+            return SYMBOL_INVALID;
+        }
+        const Entry& entry = entries_[slot - 1];
+        if (memcmp(entry.name, normalized, length) == 0 && entry.name[length] == '\0') {
+            return slot - 1;
+        }
+        index = (index + 1) & (kTableSize - 1);
+    }
+    return SYMBOL_INVALID;
+}
+
+symbol_t SymbolRegistry::registerSymbol(const char* name, size_t length) {
+    char normalized[kMaxNameLength + 1];
+    size_t n = normalize(name, length, normalized);
+    if (n == 0) {
+        spdlog::error("Invalid symbol name: {}", std::string(name, length));
+        return SYMBOL_INVALID;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    symbol_t existing = lookup(normalized, n);
+    if (existing != SYMBOL_INVALID) {
+        return existing;
+    }
+
+    size_t id = count_.load(std::memory_order_relaxed);
+    if (id >= kMaxSymbols) {
+        spdlog::error("Symbol registry full, cannot register {}", normalized);
+        return SYMBOL_INVALID;
+    }
+
+    // 先写好条目，再发布哈希槽和数量
+    Entry& entry = entries_[id];
+    memcpy(entry.name, normalized, n + 1);
+    for (size_t i = 0; i <= n; ++i) {
+        char c = normalized[i];
+        entry.stream[i] = (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+    }
+
+    size_t index = hash(normalized, n) & (kTableSize - 1);
+    while (table_[index].load(std::memory_order_relaxed) != 0) {
+        index = (index + 1) & (kTableSize - 1);
+    }
+    table_[index].store(static_cast<uint32_t>(id + 1), std::memory_order_release);
+    count_.store(id + 1, std::memory_order_release);
+
+    spdlog::debug("Symbol registered: {} -> {}", entry.name, id);
+    return static_cast<symbol_t>(id);
+}
+
+symbol_t SymbolRegistry::find(const char* name, size_t length) const {
+    char normalized[kMaxNameLength + 1];
+    size_t n = normalize(name, length, normalized);
+    if (n == 0) {
+        return SYMBOL_INVALID;
+    }
+    return lookup(normalized, n);
+}
+
+symbol_t SymbolRegistry::findByStreamName(const char* stream, size_t length) const {
+    const char* at = static_cast<const char*>(memchr(stream, '@', length));
+    if (at) {
+        length = static_cast<size_t>(at - stream);
+    }
+    // URL 形式（".../ws/btcusdt@depth"）只取最后一段
+    const char* begin = stream;
+    for (size_t i = length; i > 0; --i) {
+        if (stream[i - 1] == '/') {
+            begin = stream + i;
+            break;
+        }
+    }
+    return find(begin, length - static_cast<size_t>(begin - stream));
+}
+
+const char* SymbolRegistry::name(symbol_t symbol) const {
+    return contains(symbol) ? entries_[symbol].name : "";
+}
+
+const char* SymbolRegistry::streamName(symbol_t symbol) const {
+    return contains(symbol) ? entries_[symbol].stream : "";
+}
+
+} // namespace crypto_quant
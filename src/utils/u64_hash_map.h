@@ -0,0 +1,147 @@
+#ifndef U64_HASH_MAP_H
+#define U64_HASH_MAP_H
+
+#include <stdint.h>
+#include <cstddef>
+#include <vector>
+
+namespace crypto_quant {
+
+// uint64 键的开放寻址哈希表（线性探测，删除时后移补位，不留墓碑）
+// 键 kEmptyKey 保留为空槽标记，不能插入。容量为2的幂，负载超过一半时翻倍。
+// 键值就地存放在同一个数组中，查找通常只访问一两个缓存行。
+template <typename V>
+class U64HashMap {
+public:
+    static const uint64_t kEmptyKey = ~0ULL;
+
+    explicit U64HashMap(size_t initial_capacity = 1024) : size_(0) {
+        size_t capacity = 16;
+        while (capacity < initial_capacity * 2) {
+            capacity <<= 1;
+        }
+        slots_.assign(capacity, Slot());
+        mask_ = capacity - 1;
+    }
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    // 返回值指针，不存在返回nullptr
+    V* find(uint64_t key) {
+        size_t index = hash(key) & mask_;
+        for (;;) {
+            Slot& slot = slots_[index];
+            if (slot.key == key) {
+                return &slot.value;
+            }
+            if (slot.key == kEmptyKey) {
+                return nullptr;
+            }
+            index = (index + 1) & mask_;
+        }
+    }
+
+    const V* find(uint64_t key) const {
+        return const_cast<U64HashMap*>(this)->find(key);
+    }
+
+    // 插入新键，键已存在或为 kEmptyKey 时返回false
+    bool insert(uint64_t key, const V& value) {
+        if (key == kEmptyKey) {
+            return false;
+        }
+        if ((size_ + 1) * 2 > slots_.size()) {
+            grow();
+        }
+        size_t index = hash(key) & mask_;
+        for (;;) {
+            Slot& slot = slots_[index];
+            if (slot.key == key) {
+                return false;
+            }
+            if (slot.key == kEmptyKey) {
+                slot.key = key;
+                slot.value = value;
+                ++size_;
+                return true;
+            }
+            index = (index + 1) & mask_;
+        }
+    }
+
+    bool erase(uint64_t key) {
+        size_t index = hash(key) & mask_;
+        for (;;) {
+            Slot& slot = slots_[index];
+            if (slot.key == kEmptyKey) {
+                return false;
+            }
+            if (slot.key == key) {
+                break;
+            }
+            index = (index + 1) & mask_;
+        }
+        // 把后续探测链上的元素前移填补空位
+        size_t hole = index;
+        size_t next = (hole + 1) & mask_;
+        while (slots_[next].key != kEmptyKey) {
+            size_t home = hash(slots_[next].key) & mask_;
+            // home 不在 (hole, next] 内时，该元素可以移到 hole
+            if (((next - home) & mask_) >= ((next - hole) & mask_)) {
+                slots_[hole] = slots_[next];
+                hole = next;
+            }
+            next = (next + 1) & mask_;
+        }
+        slots_[hole].key = kEmptyKey;
+        --size_;
+        return true;
+    }
+
+    void clear() {
+        for (size_t i = 0; i < slots_.size(); ++i) {
+            slots_[i].key = kEmptyKey;
+        }
+        size_ = 0;
+    }
+
+private:
+    struct Slot {
+        uint64_t key;
+        V value;
+
+        Slot() : key(kEmptyKey), value() {}
+    };
+
+    // splitmix64 的混合函数，连续的订单ID也能均匀分布
+    static size_t hash(uint64_t key) {
+        key ^= key >> 30;
+        key *= 0xbf58476d1ce4e5b9ULL;
+        key ^= key >> 27;
+        key *= 0x94d049bb133111ebULL;
+        key ^= key >> 31;
+        return static_cast<size_t>(key);
+    }
+
+    void grow() {
+        std::vector<Slot> old;
+        old.swap(slots_);
+        slots_.assign(old.size() * 2, Slot());
+        mask_ = slots_.size() - 1;
+        size_ = 0;
+        for (size_t i = 0; i < old.size(); ++i) {
+            if (old[i].key != kEmptyKey) {
+                insert(old[i].key, old[i].value);
+            }
+        }
+    }
+
+    std::vector<Slot> slots_;
+    size_t mask_;
+    size_t size_;
+};
+
+} // namespace crypto_quant
+
+#endif // U64_HASH_MAP_H